@@ -42,6 +42,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Guid/FileInfo.h>
+#include <Guid/Acpi.h>
 #include "./PeachOS64Bit/src/config.h"
 #include <Library/BaseMemoryLib.h>
 #include <Protocol/LoadedImage.h>
@@ -158,6 +159,43 @@ EFI_STATUS SetupMemoryMaps()
   return EFI_SUCCESS;
 }
 
+/**
+ * Stores the physical address of the ACPI RSDP where the kernel expects it,
+ * the kernel finds the other processors through the ACPI tables.
+ * Stores zero when the firmware has no ACPI tables.
+ */
+EFI_STATUS SetupAcpi()
+{
+  EFI_STATUS status;
+  EFI_PHYSICAL_ADDRESS RsdpLocation = PEACHOS_ACPI_RSDP_LOCATION;
+  status = gBS->AllocatePages(AllocateAddress, EfiLoaderData, 1, &RsdpLocation);
+  if (EFI_ERROR(status))
+  {
+    Print(L"Error allocating memory for the ACPI RSDP pointer: %r\n", status);
+    return status;
+  }
+
+  VOID* Rsdp = NULL;
+  for (UINTN i = 0; i < systemTable->NumberOfTableEntries; i++)
+  {
+    EFI_CONFIGURATION_TABLE* table = &systemTable->ConfigurationTable[i];
+    if (CompareGuid(&table->VendorGuid, &gEfiAcpi20TableGuid))
+    {
+      // Prefer ACPI 2.0, it gives us the 64 bit XSDT
+      Rsdp = table->VendorTable;
+      break;
+    }
+
+    if (CompareGuid(&table->VendorGuid, &gEfiAcpi10TableGuid))
+    {
+      Rsdp = table->VendorTable;
+    }
+  }
+
+  *((UINT64*) RsdpLocation) = (UINT64) Rsdp;
+  return EFI_SUCCESS;
+}
+
 EFI_STATUS ReadFileFromCurrentFilesystem(CHAR16* FileName, VOID** Buffer_Out, UINTN *BufferSize_Out)
 {
   EFI_STATUS Status = 0;
@@ -332,6 +370,9 @@ UefiMain (
   EFI_STATUS Status = 0;
 
   Print(L"Peach OS UEFI bootloader.");
+  // Pass the ACPI tables on, before the memory map is taken so the page is not handed out as free memory
+  SetupAcpi();
+
   // Setup and load E820 Entries
   SetupMemoryMaps();
   
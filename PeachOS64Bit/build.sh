@@ -3,5 +3,5 @@ export PREFIX="$HOME/opt64/cross"
 export TARGET=x86_64-elf-cpp
 export PATH="$PREFIX/bin:$PATH"
 
-mkdir -p ./bin ./build ./build/graphics ./build/graphics/image ./build/lib ./build/lib/vector ./build/loader ./build/loader/formats ./build/isr80h ./build/keyboard ./build/gdt ./build/disk ./build/task ./build/fs ./build/fs/fat ./build/memory ./build/io ./build/memory/paging ./build/memory/heap ./build/string ./build/idt  
+mkdir -p ./bin ./build ./build/graphics ./build/graphics/image ./build/lib ./build/lib/vector ./build/loader ./build/loader/formats ./build/isr80h ./build/keyboard ./build/gdt ./build/disk ./build/task ./build/fs ./build/fs/fat ./build/memory ./build/io ./build/memory/paging ./build/memory/heap ./build/string ./build/idt ./build/cpu ./build/timer ./build/lib/spinlock ./build/lib/lockstat ./build/lib/mutex ./build/acpi ./build/apic ./build/smp ./build/pci ./build/virtio ./programs/latency/build ./programs/spin/build ./programs/schedbench/build ./programs/parbench/build ./programs/lockstat/build ./programs/futexbench/build ./programs/spawnbench/build ./programs/irqstat/build ./programs/diskbench/build ./programs/writebench/build ./programs/iostat/build 
 make all
@@ -0,0 +1,297 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "pthread.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "time.h"
+#include "memory.h"
+
+/**
+ * Disk read benchmark: diskbench [disk] [reads] [span in MB] [compare disk]
+ * Reads the first part of the disk sequentially in 64KB requests, then does
+ * 4KB reads at random places in it, straight from the device, with one
+ * thread per outstanding request. The same number of random reads is done
+ * at each queue depth from one to DISKBENCH_MAX_DEPTH so the gain of having
+ * several commands in flight shows, along with the latency of the reads.
+ * The compare disk, the legacy ATA disk zero unless told otherwise, is
+ * measured the same way afterwards. Under QEMU give it a SATA, virtio or
+ * NVMe disk, the boot disk stays disk zero:
+ *   -device ich9-ahci,id=ahci -drive id=sata,file=disk.img,if=none,format=raw
+ *   -device ide-hd,drive=sata,bus=ahci.0
+ * or
+ *   -drive file=disk.img,if=virtio,format=raw
+ * or, with -smp to have a queue pair per processor
+ *   -drive file=disk.img,if=none,id=nvm,format=raw -device nvme,serial=peach,drive=nvm
+ */
+#define DISKBENCH_MAX_DEPTH 32
+#define DISKBENCH_SECTORS_PER_READ 8
+#define DISKBENCH_SECTORS_PER_MB 2048
+#define DISKBENCH_SECTORS_PER_STREAM_READ 128
+
+// Latencies are counted in power of two buckets of microseconds
+#define DISKBENCH_LATENCY_BUCKETS 32
+
+struct diskbench_worker
+{
+    pthread_t thread;
+    void* buffer;
+    uint32_t seed;
+    int disk;
+    int reads;
+    int errors;
+    int64_t latency_total_us;
+    int64_t latency_max_us;
+    int latency_buckets[DISKBENCH_LATENCY_BUCKETS];
+};
+
+static uint32_t diskbench_span_reads = 0;
+
+// Xorshift, each thread walks its own sequence
+static uint32_t diskbench_random(uint32_t* seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static int64_t diskbench_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void diskbench_record_latency(struct diskbench_worker* worker, int64_t us)
+{
+    int bucket = 0;
+    while (bucket < DISKBENCH_LATENCY_BUCKETS - 1 && (1LL << bucket) < us)
+    {
+        bucket++;
+    }
+
+    worker->latency_buckets[bucket]++;
+    worker->latency_total_us += us;
+    if (us > worker->latency_max_us)
+    {
+        worker->latency_max_us = us;
+    }
+}
+
+static void* diskbench_worker(void* arg)
+{
+    struct diskbench_worker* worker = arg;
+    for (int i = 0; i < worker->reads; i++)
+    {
+        unsigned int lba = (diskbench_random(&worker->seed) % diskbench_span_reads) * DISKBENCH_SECTORS_PER_READ;
+        int64_t start = diskbench_now_us();
+        if (peachos_disk_read(worker->disk, lba, DISKBENCH_SECTORS_PER_READ, worker->buffer) < 0)
+        {
+            worker->errors++;
+        }
+        diskbench_record_latency(worker, diskbench_now_us() - start);
+    }
+
+    return NULL;
+}
+
+static void diskbench_sequential(int disk, int span_mb, void* buffer)
+{
+    int errors = 0;
+    unsigned int sectors = (unsigned int) span_mb * DISKBENCH_SECTORS_PER_MB;
+    int64_t start = diskbench_now_us();
+    for (unsigned int lba = 0; lba < sectors; lba += DISKBENCH_SECTORS_PER_STREAM_READ)
+    {
+        if (peachos_disk_read(disk, lba, DISKBENCH_SECTORS_PER_STREAM_READ, buffer) < 0)
+        {
+            errors++;
+        }
+    }
+
+    int64_t elapsed = diskbench_now_us() - start;
+    if (elapsed < 1)
+    {
+        elapsed = 1;
+    }
+
+    int kbps = (int) ((int64_t) span_mb * 1024 * 1000000 / elapsed);
+    printf("sequential 64KB: %iKB/s, %i errors\n", kbps, errors);
+}
+
+/**
+ * The upper bound of the bucket the percentile of the reads falls in
+ */
+static int64_t diskbench_percentile_us(int* buckets, int total, int percent)
+{
+    int wanted = (total * percent + 99) / 100;
+    int seen = 0;
+    for (int i = 0; i < DISKBENCH_LATENCY_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= wanted)
+        {
+            return 1LL << i;
+        }
+    }
+
+    return 1LL << (DISKBENCH_LATENCY_BUCKETS - 1);
+}
+
+static void diskbench_random_depths(int disk, int reads, struct diskbench_worker* workers)
+{
+    for (int depth = 1; depth <= DISKBENCH_MAX_DEPTH; depth *= 2)
+    {
+        int started = 0;
+        int errors = 0;
+        int64_t start = diskbench_now_us();
+        for (int i = 0; i < depth; i++)
+        {
+            workers[i].seed = 0x9E3779B9 * (i + 1) + depth;
+            workers[i].disk = disk;
+            workers[i].reads = reads / depth;
+            workers[i].errors = 0;
+            workers[i].latency_total_us = 0;
+            workers[i].latency_max_us = 0;
+            memset(workers[i].latency_buckets, 0, sizeof(workers[i].latency_buckets));
+            if (pthread_create(&workers[i].thread, NULL, diskbench_worker, &workers[i]) < 0)
+            {
+                printf("Failed to start thread %i\n", i);
+                break;
+            }
+            started++;
+        }
+
+        int buckets[DISKBENCH_LATENCY_BUCKETS] = {0};
+        int64_t latency_total_us = 0;
+        int64_t latency_max_us = 0;
+        for (int i = 0; i < started; i++)
+        {
+            pthread_join(workers[i].thread, NULL);
+            errors += workers[i].errors;
+            latency_total_us += workers[i].latency_total_us;
+            if (workers[i].latency_max_us > latency_max_us)
+            {
+                latency_max_us = workers[i].latency_max_us;
+            }
+
+            for (int b = 0; b < DISKBENCH_LATENCY_BUCKETS; b++)
+            {
+                buckets[b] += workers[i].latency_buckets[b];
+            }
+        }
+
+        int64_t elapsed = diskbench_now_us() - start;
+        if (elapsed < 1)
+        {
+            elapsed = 1;
+        }
+
+        int done = started * (reads / depth);
+        int iops = (int) ((int64_t) done * 1000000 / elapsed);
+        printf("depth %i: %i IOPS, %iKB/s, %i errors\n", depth, iops, iops * 4, errors);
+        if (done > 0)
+        {
+            printf("  latency avg %ius, p50 <%ius, p99 <%ius, max %ius\n",
+                   (int) (latency_total_us / done),
+                   (int) diskbench_percentile_us(buckets, done, 50),
+                   (int) diskbench_percentile_us(buckets, done, 99),
+                   (int) latency_max_us);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int disk = 1;
+    int compare_disk = 0;
+    int reads = 2048;
+    int span_mb = 64;
+    if (argc > 1)
+    {
+        disk = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        reads = atoi(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        span_mb = atoi(argv[3]);
+    }
+
+    if (argc > 4)
+    {
+        compare_disk = atoi(argv[4]);
+    }
+
+    if (reads < DISKBENCH_MAX_DEPTH)
+    {
+        reads = DISKBENCH_MAX_DEPTH;
+    }
+
+    if (span_mb < 1)
+    {
+        span_mb = 1;
+    }
+
+    diskbench_span_reads = (uint32_t) span_mb * DISKBENCH_SECTORS_PER_MB / DISKBENCH_SECTORS_PER_READ;
+
+    struct diskbench_worker workers[DISKBENCH_MAX_DEPTH];
+    for (int i = 0; i < DISKBENCH_MAX_DEPTH; i++)
+    {
+        workers[i].buffer = malloc(DISKBENCH_SECTORS_PER_READ * 512);
+        if (!workers[i].buffer)
+        {
+            printf("Out of memory\n");
+            return -1;
+        }
+    }
+
+    void* stream_buffer = malloc(DISKBENCH_SECTORS_PER_STREAM_READ * 512);
+    if (!stream_buffer)
+    {
+        printf("Out of memory\n");
+        return -1;
+    }
+
+    int disks[] = { disk, compare_disk };
+    int total_disks = disk == compare_disk ? 1 : 2;
+    for (int i = 0; i < total_disks; i++)
+    {
+        printf("disk %i, %iMB sequentially then %i random 4KB reads per depth\n", disks[i], span_mb, reads);
+        diskbench_sequential(disks[i], span_mb, stream_buffer);
+        diskbench_random_depths(disks[i], reads, workers);
+    }
+
+    return 0;
+}
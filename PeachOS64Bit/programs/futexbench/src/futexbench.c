@@ -0,0 +1,119 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "pthread.h"
+#include "stdlib.h"
+#include "stdio.h"
+
+/**
+ * Contended lock benchmark: futexbench [threads] [thousands of iterations]
+ * Every thread takes the same pthread mutex, bumps a shared counter and lets
+ * go, the given number of times. The same work is first done by one thread
+ * alone to show the uncontended cost, where no system command is made.
+ */
+#define FUTEXBENCH_MAX_THREADS 15
+
+static pthread_mutex_t futexbench_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile uint64_t futexbench_counter = 0;
+static int futexbench_iterations = 0;
+
+static void* futexbench_worker(void* arg)
+{
+    for (int i = 0; i < futexbench_iterations; i++)
+    {
+        pthread_mutex_lock(&futexbench_lock);
+        futexbench_counter++;
+        pthread_mutex_unlock(&futexbench_lock);
+    }
+
+    return NULL;
+}
+
+static void futexbench_report(const char* name, uint64_t cycles, uint64_t operations)
+{
+    printf("%s: %i lock/unlock pairs, %i cycles each\n", name, (int) operations, (int) (cycles / operations));
+}
+
+int main(int argc, char** argv)
+{
+    int threads = 4;
+    int thousands = 100;
+    if (argc > 1)
+    {
+        threads = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        thousands = atoi(argv[2]);
+    }
+
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    if (threads > FUTEXBENCH_MAX_THREADS)
+    {
+        threads = FUTEXBENCH_MAX_THREADS;
+    }
+
+    if (thousands < 1)
+    {
+        thousands = 1;
+    }
+
+    futexbench_iterations = thousands * 1000;
+
+    uint64_t start = peachos_read_tsc();
+    futexbench_worker(NULL);
+    futexbench_report("uncontended", peachos_read_tsc() - start, futexbench_iterations);
+
+    futexbench_counter = 0;
+    pthread_t workers[FUTEXBENCH_MAX_THREADS];
+    start = peachos_read_tsc();
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&workers[i], NULL, futexbench_worker, NULL) < 0)
+        {
+            printf("Failed to start thread %i\n", i);
+            threads = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    uint64_t expected = (uint64_t) threads * futexbench_iterations;
+    futexbench_report("contended", peachos_read_tsc() - start, expected);
+    printf("%i threads, counter %s\n", threads, futexbench_counter == expected ? "correct" : "WRONG");
+    return 0;
+}
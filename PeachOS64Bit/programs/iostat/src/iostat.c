@@ -0,0 +1,191 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "time.h"
+
+/**
+ * Disk I/O statistics: iostat, or iostat trace [ms]
+ * Without arguments prints every disk, what its users asked for next to
+ * what reached the device, which shows what the block cache saved, and for
+ * real disks the busy time, average queue and service time and a latency
+ * histogram. A partition sends its commands to the disk it lives on so its
+ * device columns stay at zero. With trace it records the requests of every
+ * disk for the given time, 1000ms by default, and prints them oldest first.
+ */
+#define IOSTAT_TRACE_MAX 1024
+
+static int iostat_avg_us(uint64_t total_ns, uint64_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    return (int) (total_ns / count / 1000);
+}
+
+static void iostat_print(struct disk_stats_info* info)
+{
+    printf("disk %i", info->id);
+    if (info->device_id != info->id)
+    {
+        printf(" (on disk %i)", info->device_id);
+    }
+    printf(": asked %i reads %iKB, %i writes %iKB\n",
+           (int) info->reads_requested,
+           (int) (info->read_sectors_requested / 2),
+           (int) info->writes_requested,
+           (int) (info->write_sectors_requested / 2));
+
+    uint64_t requests = info->reads + info->writes;
+    if (requests == 0)
+    {
+        return;
+    }
+
+    printf("  device %i reads %iKB, %i writes %iKB, %i errors, %i in flight\n",
+           (int) info->reads,
+           (int) (info->read_sectors / 2),
+           (int) info->writes,
+           (int) (info->write_sectors / 2),
+           (int) info->errors,
+           info->in_flight);
+    printf("  busy %ims, queue %ius and service %ius a request on average\n",
+           (int) (info->busy_ns / 1000000),
+           iostat_avg_us(info->queue_ns, requests),
+           iostat_avg_us(info->service_ns, requests));
+
+    // Each bucket covers twice the latency of the one before, starting under 2us
+    printf("  latency histogram:");
+    for (int bucket = 0; bucket < PEACHOS_DISK_STATS_HISTOGRAM_BUCKETS; bucket++)
+    {
+        printf(" %i", (int) info->latency_histogram[bucket]);
+    }
+    printf("\n");
+}
+
+static int iostat_stats()
+{
+    struct disk_stats_info info;
+    for (int disk = 0; peachos_disk_stats(disk, &info) >= 0; disk++)
+    {
+        iostat_print(&info);
+    }
+
+    return 0;
+}
+
+static int64_t iostat_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int iostat_trace(int ms)
+{
+    struct disk_trace_entry* entries = malloc(IOSTAT_TRACE_MAX * sizeof(struct disk_trace_entry));
+    if (!entries)
+    {
+        printf("Out of memory\n");
+        return -1;
+    }
+
+    // Skip whatever an earlier trace left in the ring
+    uint64_t since = 0;
+    int total;
+    while ((total = peachos_disk_trace(0, since, entries, IOSTAT_TRACE_MAX)) > 0)
+    {
+        since = entries[total - 1].sequence + 1;
+    }
+
+    // The sleep doubles as the measure of the time stamp counter
+    int64_t start_ns = iostat_now_ns();
+    uint64_t start_tsc = peachos_read_tsc();
+    peachos_disk_trace(1, since, NULL, 0);
+
+    struct timespec sleep = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&sleep, NULL);
+
+    total = peachos_disk_trace(0, since, entries, IOSTAT_TRACE_MAX);
+    int64_t elapsed_ns = iostat_now_ns() - start_ns;
+    uint64_t elapsed_tsc = peachos_read_tsc() - start_tsc;
+    uint64_t cycles_per_us = elapsed_ns > 1000 ? elapsed_tsc / (elapsed_ns / 1000) : 1;
+    if (cycles_per_us == 0)
+    {
+        cycles_per_us = 1;
+    }
+
+    printf("%i requests in %ims, times in us from the start of the trace\n", total, ms);
+    for (int i = 0; i < total; i++)
+    {
+        struct disk_trace_entry* entry = &entries[i];
+        printf("%i disk %i %s lba %i sectors %i at %i queued %i service %i%s\n",
+               (int) entry->sequence,
+               entry->disk_id,
+               entry->op == PEACHOS_DISK_TRACE_WRITE ? "write" : "read",
+               (int) entry->lba,
+               entry->total,
+               (int) ((entry->start_tsc - start_tsc) / cycles_per_us),
+               (int) ((entry->dispatch_tsc - entry->start_tsc) / cycles_per_us),
+               (int) ((entry->end_tsc - entry->dispatch_tsc) / cycles_per_us),
+               entry->result < 0 ? " failed" : "");
+    }
+
+    if (total == IOSTAT_TRACE_MAX)
+    {
+        printf("The trace filled up, later requests are not shown\n");
+    }
+
+    free(entries);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strncmp(argv[1], "trace", 5) == 0)
+    {
+        int ms = 1000;
+        if (argc > 2)
+        {
+            ms = atoi(argv[2]);
+        }
+
+        if (ms < 1)
+        {
+            ms = 1;
+        }
+
+        return iostat_trace(ms);
+    }
+
+    return iostat_stats();
+}
@@ -0,0 +1,63 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdio.h"
+
+/**
+ * Prints how often each interrupt vector fired, the time its kernel handler
+ * took and a histogram of entry to end of interrupt latency. Vectors that
+ * never fired are skipped, cycle counts are shown in thousands.
+ */
+int main(int argc, char** argv)
+{
+    struct irq_stats_info info;
+    for (int vector = 0; vector < PEACHOS_IRQ_STATS_VECTORS; vector++)
+    {
+        if (peachos_irq_stats(vector, &info) < 0 || info.count == 0)
+        {
+            continue;
+        }
+
+        printf("vector %i: %i interrupts, %ik cycles handling, %ik max handler, %ik max latency\n",
+               vector,
+               (int) info.count,
+               (int) (info.handler_cycles / 1000),
+               (int) (info.max_handler_cycles / 1000),
+               (int) (info.max_latency_cycles / 1000));
+
+        // Each bucket covers four times the latency of the one before
+        printf("  latency histogram:");
+        for (int bucket = 0; bucket < PEACHOS_IRQ_STATS_HISTOGRAM_BUCKETS; bucket++)
+        {
+            printf(" %i", (int) info.latency_histogram[bucket]);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdio.h"
+
+/**
+ * Measures how long it takes the kernel to run us after a key press wakes us.
+ * The system is idle between key presses so this includes leaving the idle
+ * task and restarting the scheduler tick. Press 'q' to quit.
+ */
+int main(int argc, char** argv)
+{
+    printf("Press keys to measure wake up latency, q to quit\n");
+    while(1)
+    {
+        int key = peachos_getkeyblock();
+        int cycles = (int) peachos_wake_latency();
+        printf("wake latency: %i cycles\n", cycles);
+        if (key == 'q')
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
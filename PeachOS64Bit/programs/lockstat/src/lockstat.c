@@ -0,0 +1,57 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdio.h"
+
+/**
+ * Prints the contention counters and hold time histogram of every named
+ * kernel lock. Cycle counts are shown in thousands.
+ */
+int main(int argc, char** argv)
+{
+    struct lock_stats_info info;
+    for (int index = 0; peachos_lock_stats(index, &info) >= 0; index++)
+    {
+        printf("%s: %i acquired, %i contended, %ik cycles waiting, %ik max hold\n",
+               info.name,
+               (int) info.acquisitions,
+               (int) info.contentions,
+               (int) (info.wait_cycles / 1000),
+               (int) (info.max_hold_cycles / 1000));
+
+        // Each bucket covers four times the hold time of the one before
+        printf("  hold histogram:");
+        for (int bucket = 0; bucket < PEACHOS_LOCK_STATS_HISTOGRAM_BUCKETS; bucket++)
+        {
+            printf(" %i", (int) info.hold_histogram[bucket]);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+
+/**
+ * Parallel speedup benchmark: parbench [workers] [millions of iterations]
+ * Splits a fixed amount of work over the given number of background workers,
+ * each prints the cycles it took. With enough processors every worker
+ * finishes in roughly total / workers time, on one processor they take turns.
+ * Workers are started as "parbench -w <id> <millions>".
+ */
+static void parbench_work(int id, int millions)
+{
+    uint64_t start = peachos_read_tsc();
+    volatile unsigned long counter = 0;
+    for (int i = 0; i < millions; i++)
+    {
+        for (int j = 0; j < 1000000; j++)
+        {
+            counter++;
+        }
+    }
+
+    uint64_t cycles = peachos_read_tsc() - start;
+    printf("worker %i: %i million iterations in %i million cycles\n", id, millions, (int) (cycles / 1000000));
+}
+
+static void parbench_append(char* command, const char* text)
+{
+    strcpy(command + strlen(command), text);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 3 && strncmp(argv[1], "-w", 2) == 0)
+    {
+        parbench_work(atoi(argv[2]), atoi(argv[3]));
+        return 0;
+    }
+
+    int workers = 4;
+    int millions = 2000;
+    if (argc > 1)
+    {
+        workers = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        millions = atoi(argv[2]);
+    }
+
+    if (workers < 1)
+    {
+        workers = 1;
+    }
+
+    int share = millions / workers;
+    for (int i = 0; i < workers; i++)
+    {
+        char command[64];
+        strcpy(command, "parbench.elf -w ");
+        parbench_append(command, itoa(i));
+        parbench_append(command, " ");
+        parbench_append(command, itoa(share));
+        if (peachos_spawn_run(command) < 0)
+        {
+            printf("Failed to start worker %i\n", i);
+            return -1;
+        }
+    }
+
+    printf("Started %i workers with %i million iterations each\n", workers, share);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+#include "stdio.h"
+
+/**
+ * Scheduling latency benchmark: schedbench [cpu hogs] [samples]
+ * Starts the given number of spin programs in the background and then measures
+ * how many cycles pass between a key press waking us and us getting the CPU.
+ * Compare a run with zero hogs against one with several.
+ */
+int main(int argc, char** argv)
+{
+    int hogs = 4;
+    int samples = 10;
+    if (argc > 1)
+    {
+        hogs = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        samples = atoi(argv[2]);
+    }
+
+    for (int i = 0; i < hogs; i++)
+    {
+        if (peachos_spawn_run("spin.elf 0 5000") < 0)
+        {
+            printf("Failed to start cpu hog %i\n", i);
+            return -1;
+        }
+    }
+
+    printf("Started %i cpu hogs, press a key %i times\n", hogs, samples);
+
+    size_t min = 0;
+    size_t max = 0;
+    size_t total = 0;
+    for (int i = 0; i < samples; i++)
+    {
+        peachos_getkeyblock();
+        size_t cycles = peachos_wake_latency();
+        if (i == 0 || cycles < min)
+        {
+            min = cycles;
+        }
+
+        if (cycles > max)
+        {
+            max = cycles;
+        }
+
+        total += cycles;
+        printf("sample %i: %i cycles\n", i, (int) cycles);
+    }
+
+    if (samples > 0)
+    {
+        printf("wake to run latency with %i hogs: min %i avg %i max %i cycles\n", hogs, (int) min, (int) (total / samples), (int) max);
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+
+/**
+ * Process spawn throughput: spawnbench [total] [in flight]
+ * Starts the given number of short lived copies of itself, keeping up to
+ * "in flight" of them alive at once and waiting for the oldest before
+ * starting another. Children are started as "spawnbench -c" and exit at once.
+ */
+#define SPAWNBENCH_MAX_IN_FLIGHT 64
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strncmp(argv[1], "-c", 2) == 0)
+    {
+        return 0;
+    }
+
+    int total = 1000;
+    int in_flight = 8;
+    if (argc > 1)
+    {
+        total = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        in_flight = atoi(argv[2]);
+    }
+
+    if (in_flight < 1)
+    {
+        in_flight = 1;
+    }
+
+    if (in_flight > SPAWNBENCH_MAX_IN_FLIGHT)
+    {
+        in_flight = SPAWNBENCH_MAX_IN_FLIGHT;
+    }
+
+    int pids[SPAWNBENCH_MAX_IN_FLIGHT];
+    int started = 0;
+    int reaped = 0;
+    int highest_pid = 0;
+    uint64_t start = peachos_read_tsc();
+    while (reaped < total)
+    {
+        // Keep the pipeline full, then wait for the oldest child
+        while (started < total && started - reaped < in_flight)
+        {
+            int pid = peachos_spawn_run("spawnbench.elf -c");
+            if (pid < 0)
+            {
+                printf("Spawn %i failed\n", started);
+                return -1;
+            }
+
+            if (pid > highest_pid)
+            {
+                highest_pid = pid;
+            }
+
+            pids[started % in_flight] = pid;
+            started++;
+        }
+
+        peachos_wait(pids[reaped % in_flight]);
+        reaped++;
+    }
+
+    uint64_t cycles = peachos_read_tsc() - start;
+    printf("%i processes spawned and reaped, %i in flight\n", total, in_flight);
+    printf("%i thousand cycles per process, highest pid %i\n", (int) (cycles / total / 1000), highest_pid);
+    return 0;
+}
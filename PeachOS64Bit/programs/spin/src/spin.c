@@ -0,0 +1,61 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+
+/**
+ * A CPU hog for scheduler testing: spin [nice] [millions of iterations]
+ * Never blocks, so the scheduler should sink it below interactive tasks.
+ */
+int main(int argc, char** argv)
+{
+    int nice = 0;
+    int millions = 5000;
+    if (argc > 1)
+    {
+        nice = atoi(argv[1]);
+    }
+
+    if (argc > 2)
+    {
+        millions = atoi(argv[2]);
+    }
+
+    peachos_set_nice(nice);
+
+    volatile unsigned long counter = 0;
+    for (int i = 0; i < millions; i++)
+    {
+        for (int j = 0; j < 1000000; j++)
+        {
+            counter++;
+        }
+    }
+
+    return 0;
+}
@@ -30,6 +30,7 @@ section .asm
 
 global print:function
 global peachos_getkey:function
+global peachos_getkeyblock:function
 global peachos_malloc:function
 global peachos_free:function
 global peachos_putchar:function
@@ -43,6 +44,26 @@ global peachos_fread:function
 global peachos_fseek:function
 global peachos_fstat:function
 global peachos_realloc:function
+global peachos_wake_latency:function
+global peachos_set_nice:function
+global peachos_spawn:function
+global peachos_read_tsc:function
+global peachos_lock_stats:function
+global peachos_thread_create:function
+global peachos_thread_exit:function
+global peachos_thread_join:function
+global peachos_thread_self:function
+global peachos_futex_wait:function
+global peachos_futex_wake:function
+global peachos_wait:function
+global peachos_clock_gettime:function
+global peachos_nanosleep:function
+global peachos_irq_stats:function
+global peachos_disk_read:function
+global peachos_disk_write:function
+global peachos_disk_sync:function
+global peachos_disk_stats:function
+global peachos_disk_trace:function
 
 ; void print(const char* filename)
 print:
@@ -58,6 +79,12 @@ peachos_getkey:
     int 0x80
     ret
 
+; int peachos_getkeyblock()
+peachos_getkeyblock:
+    mov rax, 16 ; Command getkey block, sleeps in the kernel until a key is pressed
+    int 0x80
+    ret
+
 ; void peachos_putchar(char c)
 peachos_putchar:
     mov rax, 3 ; Command putchar
@@ -168,4 +195,178 @@ peachos_realloc:
     int 0x80
     add rsp, 16
     ; RAX = new the pointer address
-    ret
\ No newline at end of file
+    ret
+
+; size_t peachos_wake_latency()
+peachos_wake_latency:
+    mov rax, 17     ; Command 17 wake latency
+    int 0x80
+    ret
+
+; int peachos_set_nice(int nice)
+peachos_set_nice:
+    mov rax, 18     ; Command 18 set nice
+    push qword rdi  ; nice
+    int 0x80
+    add rsp, 8
+    ret
+
+; int peachos_spawn(struct command_argument* arguments)
+peachos_spawn:
+    mov rax, 19     ; Command 19 process spawn, starts a program in the background
+    push qword rdi  ; arguments
+    int 0x80
+    add rsp, 8
+    ret
+
+; uint64_t peachos_read_tsc()
+; The time stamp counter is readable from user land, no system command needed
+peachos_read_tsc:
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+    ret
+
+; int peachos_lock_stats(int index, struct lock_stats_info* info_out)
+peachos_lock_stats:
+    mov rax, 20     ; Command 20 lock stats
+    push qword rsi  ; info_out
+    push qword rdi  ; index
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_thread_create(void* entry, void* arg1, void* arg2)
+peachos_thread_create:
+    mov rax, 21     ; Command 21 thread create, the thread starts at entry(arg1, arg2)
+    push qword rdx  ; arg2
+    push qword rsi  ; arg1
+    push qword rdi  ; entry
+    int 0x80
+    add rsp, 24
+    ret
+
+; void peachos_thread_exit(uint64_t exit_code)
+peachos_thread_exit:
+    mov rax, 22     ; Command 22 thread exit, does not return
+    push qword rdi  ; exit_code
+    int 0x80
+    add rsp, 8
+    ret
+
+; int peachos_thread_join(int thread_id, uint64_t* exit_code_out)
+peachos_thread_join:
+    mov rax, 23     ; Command 23 thread join
+    push qword rsi  ; exit_code_out
+    push qword rdi  ; thread_id
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_thread_self()
+peachos_thread_self:
+    mov rax, 24     ; Command 24 thread self
+    int 0x80
+    ret
+
+; int peachos_futex_wait(volatile uint32_t* address, uint32_t expected)
+peachos_futex_wait:
+    mov rax, 25     ; Command 25 futex wait, sleeps only while *address == expected
+    push qword rsi  ; expected
+    push qword rdi  ; address
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_futex_wake(volatile uint32_t* address, int count)
+peachos_futex_wake:
+    mov rax, 26     ; Command 26 futex wake
+    push qword rsi  ; count
+    push qword rdi  ; address
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_wait(int process_id)
+peachos_wait:
+    mov rax, 27     ; Command 27 process wait
+    push qword rdi  ; process_id
+    int 0x80
+    add rsp, 8
+    ret
+
+; int peachos_clock_gettime(int clock_id, struct timespec* ts)
+peachos_clock_gettime:
+    mov rax, 28     ; Command 28 clock gettime
+    push qword rsi  ; ts
+    push qword rdi  ; clock_id
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_nanosleep(const struct timespec* ts)
+peachos_nanosleep:
+    mov rax, 29     ; Command 29 nanosleep
+    push qword rdi  ; ts
+    int 0x80
+    add rsp, 8
+    ret
+
+; int peachos_irq_stats(int vector, struct irq_stats_info* info_out)
+peachos_irq_stats:
+    mov rax, 30     ; Command 30 irq stats
+    push qword rsi  ; info_out
+    push qword rdi  ; vector
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_disk_read(int disk_id, uint64_t lba, int total, void* buf)
+peachos_disk_read:
+    mov rax, 31     ; Command 31 disk read
+    push qword rcx  ; buf
+    push qword rdx  ; total
+    push qword rsi  ; lba
+    push qword rdi  ; disk_id
+    int 0x80
+    add rsp, 32
+    ret
+
+; int peachos_disk_write(int disk_id, uint64_t lba, int total, void* buf)
+peachos_disk_write:
+    mov rax, 32     ; Command 32 disk write
+    push qword rcx  ; buf
+    push qword rdx  ; total
+    push qword rsi  ; lba
+    push qword rdi  ; disk_id
+    int 0x80
+    add rsp, 32
+    ret
+
+; int peachos_disk_sync(int disk_id)
+peachos_disk_sync:
+    mov rax, 33     ; Command 33 disk sync
+    push qword rdi  ; disk_id
+    int 0x80
+    add rsp, 8
+    ret
+
+; int peachos_disk_stats(int disk_id, struct disk_stats_info* info_out)
+peachos_disk_stats:
+    mov rax, 34     ; Command 34 disk stats
+    push qword rsi  ; info_out
+    push qword rdi  ; disk_id
+    int 0x80
+    add rsp, 16
+    ret
+
+; int peachos_disk_trace(int enable, uint64_t since, struct disk_trace_entry* entries_out, int max)
+peachos_disk_trace:
+    mov rax, 35     ; Command 35 disk trace
+    push qword rcx  ; max
+    push qword rdx  ; entries_out
+    push qword rsi  ; since
+    push qword rdi  ; enable
+    int 0x80
+    add rsp, 32
+    ret
@@ -74,17 +74,6 @@ struct command_argument* peachos_parse_command(const char* command, int max)
 out:
     return root_command;
 }
-int peachos_getkeyblock()
-{
-    int val = 0;
-    do
-    {
-        val = peachos_getkey();
-    }
-    while(val == 0);
-    return val;
-}
-
 void peachos_terminal_readline(char* out, int max, bool output_while_typing)
 {
     int i = 0;
@@ -130,4 +119,17 @@ int peachos_system_run(const char* command)
     }
 
     return peachos_system(root_command_argument);
-}
\ No newline at end of file
+}
+
+int peachos_spawn_run(const char* command)
+{
+    char buf[1024];
+    strncpy(buf, command, sizeof(buf));
+    struct command_argument* root_command_argument = peachos_parse_command(buf, sizeof(buf));
+    if (!root_command_argument)
+    {
+        return -1;
+    }
+
+    return peachos_spawn(root_command_argument);
+}
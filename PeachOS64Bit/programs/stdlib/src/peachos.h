@@ -28,6 +28,7 @@
 #ifndef PEACHOS_H
 #define PEACHOS_H
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 
@@ -46,6 +47,90 @@ struct process_arguments
 // Forward declare file stat.
 struct file_stat;
 
+#define PEACHOS_LOCK_STATS_HISTOGRAM_BUCKETS 16
+#define PEACHOS_LOCK_STATS_NAME_MAX 32
+
+// Statistics of one kernel lock, keep in sync with the kernel
+struct lock_stats_info
+{
+    char name[PEACHOS_LOCK_STATS_NAME_MAX];
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_cycles;
+    uint64_t max_hold_cycles;
+
+    // Bucket N counts hold times of 4^N up to 4^(N+1) cycles
+    uint64_t hold_histogram[PEACHOS_LOCK_STATS_HISTOGRAM_BUCKETS];
+};
+
+#define PEACHOS_IRQ_STATS_VECTORS 256
+#define PEACHOS_IRQ_STATS_HISTOGRAM_BUCKETS 16
+
+struct irq_stats_info
+{
+    uint64_t count;
+
+    // Cycles spent in the kernel handler of the vector
+    uint64_t handler_cycles;
+    uint64_t max_handler_cycles;
+
+    // Bucket N counts entry to end of interrupt times of 4^N up to 4^(N+1) cycles
+    uint64_t max_latency_cycles;
+    uint64_t latency_histogram[PEACHOS_IRQ_STATS_HISTOGRAM_BUCKETS];
+};
+
+#define PEACHOS_DISK_STATS_HISTOGRAM_BUCKETS 24
+
+// I/O statistics of one disk, keep in sync with the kernel
+struct disk_stats_info
+{
+    int id;
+
+    // The real disk a partition lives on, its device commands are counted there
+    int device_id;
+    int type;
+    int in_flight;
+
+    // What users of the disk asked for, the block cache serves some of it
+    uint64_t reads_requested;
+    uint64_t read_sectors_requested;
+    uint64_t writes_requested;
+    uint64_t write_sectors_requested;
+
+    // Requests that reached the device
+    uint64_t reads;
+    uint64_t read_sectors;
+    uint64_t writes;
+    uint64_t write_sectors;
+    uint64_t errors;
+
+    // Summed over every request
+    uint64_t queue_ns;
+    uint64_t service_ns;
+    uint64_t busy_ns;
+
+    // Bucket N counts latencies of 2^N up to 2^(N+1) microseconds
+    uint64_t latency_histogram[PEACHOS_DISK_STATS_HISTOGRAM_BUCKETS];
+};
+
+#define PEACHOS_DISK_TRACE_WRITE 1
+
+// One traced request, keep in sync with the kernel
+struct disk_trace_entry
+{
+    uint64_t sequence;
+    int disk_id;
+    int op;
+    int result;
+    int total;
+    uint64_t lba;
+
+    // Time stamp counter at submission, dispatch and completion
+    uint64_t start_tsc;
+    uint64_t dispatch_tsc;
+    uint64_t end_tsc;
+};
+
 void print(const char* filename);
 int peachos_getkey();
 
@@ -67,4 +152,61 @@ long peachos_fread(void* buffer, size_t size, size_t count, long fd);
 long peachos_fseek(long fd, long offset, long whence);
 long peachos_fstat(long fd, struct file_stat* file_stat_out);
 void* peachos_realloc(void* old_ptr, size_t new_size);
+
+// CPU cycles between the last time this process was woken and it running again
+size_t peachos_wake_latency();
+
+// Sets the nice level of the calling task, -20 (most important) to 19
+int peachos_set_nice(int nice);
+
+// Starts a program without giving it the keyboard, returns its process id
+int peachos_spawn(struct command_argument* arguments);
+int peachos_spawn_run(const char* command);
+// Sleeps until the process has exited, returns straight away when it already has
+int peachos_wait(int process_id);
+
+// Reads the processor time stamp counter
+uint64_t peachos_read_tsc();
+
+// Copies the statistics of the kernel lock at index, negative once past the last lock
+int peachos_lock_stats(int index, struct lock_stats_info* info_out);
+
+// Copies the interrupt statistics of the vector, negative when the vector is out of range
+int peachos_irq_stats(int vector, struct irq_stats_info* info_out);
+
+// Reads sectors of a disk straight from the device, buf must come from malloc
+int peachos_disk_read(int disk_id, uint64_t lba, int total, void* buf);
+
+// Writes sectors of a disk into the block cache, returns once they are cached
+int peachos_disk_write(int disk_id, uint64_t lba, int total, void* buf);
+
+// Writes back the cached sectors of the disk and empties the write cache of the device
+int peachos_disk_sync(int disk_id);
+
+// Copies the I/O statistics of the disk, negative once past the last disk
+int peachos_disk_stats(int disk_id, struct disk_stats_info* info_out);
+
+// Turns tracing on (1), off (0) or leaves it (-1), then copies up to max
+// traced requests from sequence number since on, returns how many it copied
+int peachos_disk_trace(int enable, uint64_t since, struct disk_trace_entry* entries_out, int max);
+
+// Starts a thread of this process at entry(arg1, arg2), returns its thread id or a negative error
+int peachos_thread_create(void* entry, void* arg1, void* arg2);
+// Ends the calling thread, the last thread to exit ends the process
+void peachos_thread_exit(uint64_t exit_code);
+// Waits for the thread to exit, exit_code_out may be NULL
+int peachos_thread_join(int thread_id, uint64_t* exit_code_out);
+// Thread id of the caller, the main thread is zero
+int peachos_thread_self();
+
+// Sleeps until woken through the same address, returns straight away unless *address == expected
+int peachos_futex_wait(volatile uint32_t* address, uint32_t expected);
+// Wakes up to count threads sleeping on the address, returns how many were woken
+int peachos_futex_wake(volatile uint32_t* address, int count);
+
+struct timespec;
+// Reads the clock, only the monotonic clock is supported
+int peachos_clock_gettime(int clock_id, struct timespec* ts);
+// Sleeps for at least the given time, rounded up to the timer tick
+int peachos_nanosleep(const struct timespec* ts);
 #endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "pthread.h"
+#include "peachos.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Every thread starts here, it turns a return from the start routine into an exit
+ */
+static void pthread_start(void* (*start_routine)(void*), void* arg)
+{
+    pthread_exit(start_routine(arg));
+}
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start_routine)(void*), void* arg)
+{
+    if (attr || !start_routine)
+    {
+        return -1;
+    }
+
+    int res = peachos_thread_create(pthread_start, start_routine, arg);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    if (thread)
+    {
+        *thread = res;
+    }
+    return 0;
+}
+
+int pthread_join(pthread_t thread, void** retval)
+{
+    uint64_t exit_code = 0;
+    int res = peachos_thread_join(thread, &exit_code);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    if (retval)
+    {
+        *retval = (void*)(uintptr_t) exit_code;
+    }
+    return 0;
+}
+
+void pthread_exit(void* retval)
+{
+    peachos_thread_exit((uint64_t)(uintptr_t) retval);
+    while (1)
+    {
+    }
+}
+
+pthread_t pthread_self()
+{
+    return peachos_thread_self();
+}
+
+int pthread_equal(pthread_t t1, pthread_t t2)
+{
+    return t1 == t2;
+}
+
+// The lock states of pthread_mutex_t
+#define PTHREAD_MUTEX_UNLOCKED 0
+#define PTHREAD_MUTEX_LOCKED 1
+#define PTHREAD_MUTEX_CONTENDED 2
+
+int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
+{
+    if (attr)
+    {
+        return -1;
+    }
+
+    mutex->state = PTHREAD_MUTEX_UNLOCKED;
+    return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t* mutex)
+{
+    return 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    uint32_t expected = PTHREAD_MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &expected, PTHREAD_MUTEX_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Takes the mutex marked as contended, used once we know others are about.
+ * The unlocker then always wakes somebody, which may be a needless wake but
+ * never a lost one.
+ */
+static void pthread_mutex_lock_contended(pthread_mutex_t* mutex)
+{
+    while (__atomic_exchange_n(&mutex->state, PTHREAD_MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != PTHREAD_MUTEX_UNLOCKED)
+    {
+        peachos_futex_wait(&mutex->state, PTHREAD_MUTEX_CONTENDED);
+    }
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    // The fast path is a single compare and exchange, no system command
+    if (pthread_mutex_trylock(mutex) == 0)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock_contended(mutex);
+    return 0;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t* mutex)
+{
+    if (__atomic_exchange_n(&mutex->state, PTHREAD_MUTEX_UNLOCKED, __ATOMIC_RELEASE) == PTHREAD_MUTEX_CONTENDED)
+    {
+        peachos_futex_wake(&mutex->state, 1);
+    }
+
+    return 0;
+}
+
+int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
+{
+    if (attr)
+    {
+        return -1;
+    }
+
+    cond->sequence = 0;
+    cond->waiters = 0;
+    return 0;
+}
+
+int pthread_cond_destroy(pthread_cond_t* cond)
+{
+    return 0;
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    // Read before unlocking, a signal after this changes the sequence and the wait returns at once
+    uint32_t sequence = __atomic_load_n(&cond->sequence, __ATOMIC_ACQUIRE);
+    __atomic_add_fetch(&cond->waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(mutex);
+
+    peachos_futex_wait(&cond->sequence, sequence);
+
+    __atomic_sub_fetch(&cond->waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock_contended(mutex);
+    return 0;
+}
+
+int pthread_cond_signal(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    if (__atomic_load_n(&cond->waiters, __ATOMIC_RELAXED))
+    {
+        peachos_futex_wake(&cond->sequence, 1);
+    }
+
+    return 0;
+}
+
+int pthread_cond_broadcast(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    if (__atomic_load_n(&cond->waiters, __ATOMIC_RELAXED))
+    {
+        peachos_futex_wake(&cond->sequence, __INT_MAX__);
+    }
+
+    return 0;
+}
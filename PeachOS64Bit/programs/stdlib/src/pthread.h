@@ -0,0 +1,105 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef PEACHOS_PTHREAD_H
+#define PEACHOS_PTHREAD_H
+
+#include <stdint.h>
+
+typedef int pthread_t;
+
+// No thread attributes are supported yet, pass NULL
+typedef struct pthread_attr pthread_attr_t;
+
+// No mutex or condition variable attributes either
+typedef struct pthread_mutexattr pthread_mutexattr_t;
+typedef struct pthread_condattr pthread_condattr_t;
+
+/**
+ * A futex based lock, taking and releasing it only enters the kernel when
+ * another thread is waiting. State 0 is unlocked, 1 locked, 2 locked with
+ * threads possibly sleeping on it.
+ */
+typedef struct
+{
+    volatile uint32_t state;
+} pthread_mutex_t;
+
+/**
+ * Waiters sleep on the sequence number, every signal bumps it
+ */
+typedef struct
+{
+    volatile uint32_t sequence;
+    volatile uint32_t waiters;
+} pthread_cond_t;
+
+#define PTHREAD_MUTEX_INITIALIZER {0}
+#define PTHREAD_COND_INITIALIZER {0, 0}
+
+/**
+ * Starts start_routine(arg) in a new thread of the process. The thread
+ * shares our memory and files and has its own stack.
+ * \return Returns zero on success or a negative error code
+ */
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start_routine)(void*), void* arg);
+
+/**
+ * Waits for the thread to finish, retval receives what it returned
+ */
+int pthread_join(pthread_t thread, void** retval);
+
+/**
+ * Ends the calling thread, returning from the start routine does the same
+ */
+void pthread_exit(void* retval);
+
+pthread_t pthread_self();
+int pthread_equal(pthread_t t1, pthread_t t2);
+
+int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr);
+int pthread_mutex_destroy(pthread_mutex_t* mutex);
+int pthread_mutex_lock(pthread_mutex_t* mutex);
+
+/**
+ * \return Returns zero when the mutex was taken, -1 when it is held
+ */
+int pthread_mutex_trylock(pthread_mutex_t* mutex);
+int pthread_mutex_unlock(pthread_mutex_t* mutex);
+
+int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr);
+int pthread_cond_destroy(pthread_cond_t* cond);
+
+/**
+ * Releases the mutex and sleeps until signalled, the mutex is held again on
+ * return. Wake ups may be spurious, check the condition in a loop.
+ */
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+int pthread_cond_signal(pthread_cond_t* cond);
+int pthread_cond_broadcast(pthread_cond_t* cond);
+
+#endif
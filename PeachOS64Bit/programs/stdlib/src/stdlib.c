@@ -28,6 +28,7 @@
 #include "stdlib.h"
 #include "peachos.h"
 #include "memory.h"
+#include "string.h"
 
 char* itoa(int i)
 {
@@ -56,6 +57,25 @@ char* itoa(int i)
     return &text[loc];
 }
 
+int atoi(const char* str)
+{
+    int res = 0;
+    bool neg = false;
+    if (*str == '-')
+    {
+        neg = true;
+        str++;
+    }
+
+    while (isdigit(*str))
+    {
+        res = res * 10 + tonumericdigit(*str);
+        str++;
+    }
+
+    return neg ? -res : res;
+}
+
 void* malloc(size_t size)
 {
     return peachos_malloc(size);
@@ -34,4 +34,5 @@ void* realloc(void* ptr, size_t new_size);
 void* malloc(size_t size);
 void free(void* ptr);
 char* itoa(int i);
+int atoi(const char* str);
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef PEACHOS_TIME_H
+#define PEACHOS_TIME_H
+
+#include <stdint.h>
+
+// Nanoseconds since boot, keeps counting while the system is idle
+#define CLOCK_MONOTONIC 1
+
+typedef int clockid_t;
+
+struct timespec
+{
+    int64_t tv_sec;
+    int64_t tv_nsec;
+};
+
+int clock_gettime(clockid_t clock_id, struct timespec* ts);
+
+/**
+ * Sleeps for at least the requested time. The kernel wakes sleepers on
+ * its timer tick so short sleeps last up to one tick. The remaining time
+ * is never written as sleeps cannot be interrupted, rem may be NULL.
+ */
+int nanosleep(const struct timespec* req, struct timespec* rem);
+
+#endif
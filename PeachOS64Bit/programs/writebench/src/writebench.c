@@ -0,0 +1,241 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "peachos.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "time.h"
+#include "memory.h"
+
+/**
+ * Disk write benchmark: writebench disk [span in MB] [KB per write] [writes through]
+ * OVERWRITES the first part of the disk, there is no default disk for that
+ * reason. Writes the span sequentially into the block cache and times how
+ * long the writes take to return, then how long the sync takes to put them
+ * on the disk in large batches. For comparison the given number of writes
+ * are then made durable one at a time with a sync after each. At the end
+ * the span is read back straight from the device and checked. Under QEMU
+ * give it a scratch disk, the boot disk stays disk zero:
+ *   -drive file=scratch.img,if=virtio,format=raw
+ */
+#define WRITEBENCH_SECTORS_PER_MB 2048
+#define WRITEBENCH_SECTORS_PER_VERIFY_READ 128
+
+static int64_t writebench_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int writebench_kbps(int64_t kb, int64_t elapsed_us)
+{
+    if (elapsed_us < 1)
+    {
+        elapsed_us = 1;
+    }
+
+    return (int) (kb * 1000000 / elapsed_us);
+}
+
+/**
+ * Every sector says where it belongs and which pass wrote it
+ */
+static void writebench_fill(uint32_t* buffer, unsigned int lba, int sectors, uint32_t pass)
+{
+    for (int sector = 0; sector < sectors; sector++)
+    {
+        for (int word = 0; word < 512 / sizeof(uint32_t); word++)
+        {
+            *buffer++ = ((lba + sector) << 8) ^ pass ^ word;
+        }
+    }
+}
+
+static void writebench_cached(int disk, unsigned int sectors, int sectors_per_write, void* buffer, uint32_t pass)
+{
+    int errors = 0;
+    int64_t start = writebench_now_us();
+    for (unsigned int lba = 0; lba < sectors; lba += sectors_per_write)
+    {
+        writebench_fill(buffer, lba, sectors_per_write, pass);
+        if (peachos_disk_write(disk, lba, sectors_per_write, buffer) < 0)
+        {
+            errors++;
+        }
+    }
+    int64_t written = writebench_now_us();
+
+    int res = peachos_disk_sync(disk);
+    int64_t synced = writebench_now_us();
+
+    int64_t kb = sectors / 2;
+    printf("cached writes: %iKB/s, %i errors\n", writebench_kbps(kb, written - start), errors);
+    printf("sync: %ims%s\n", (int) ((synced - written) / 1000), res < 0 ? ", failed" : "");
+    printf("write and sync: %iKB/s\n", writebench_kbps(kb, synced - start));
+}
+
+static void writebench_through(int disk, int writes, int sectors_per_write, void* buffer, uint32_t pass)
+{
+    int errors = 0;
+    int64_t start = writebench_now_us();
+    for (int i = 0; i < writes; i++)
+    {
+        unsigned int lba = (unsigned int) i * sectors_per_write;
+        writebench_fill(buffer, lba, sectors_per_write, pass);
+        if (peachos_disk_write(disk, lba, sectors_per_write, buffer) < 0 || peachos_disk_sync(disk) < 0)
+        {
+            errors++;
+        }
+    }
+
+    int64_t elapsed = writebench_now_us() - start;
+    int64_t kb = (int64_t) writes * sectors_per_write / 2;
+    printf("sync after every write: %iKB/s, %i errors\n", writebench_kbps(kb, elapsed), errors);
+}
+
+/**
+ * Reads the span back from the device, past the cache, and compares it
+ * \param through_sectors The start of the span was written again by the second pass
+ */
+static int writebench_verify(int disk, unsigned int sectors, unsigned int through_sectors, uint32_t pass, uint32_t through_pass)
+{
+    int mismatches = 0;
+    void* buffer = malloc(WRITEBENCH_SECTORS_PER_VERIFY_READ * 512);
+    void* expected = malloc(512);
+    if (!buffer || !expected)
+    {
+        printf("Out of memory\n");
+        return -1;
+    }
+
+    for (unsigned int lba = 0; lba < sectors; lba += WRITEBENCH_SECTORS_PER_VERIFY_READ)
+    {
+        int count = WRITEBENCH_SECTORS_PER_VERIFY_READ;
+        if (lba + count > sectors)
+        {
+            count = sectors - lba;
+        }
+
+        if (peachos_disk_read(disk, lba, count, buffer) < 0)
+        {
+            mismatches += count;
+            continue;
+        }
+
+        for (int sector = 0; sector < count; sector++)
+        {
+            unsigned int at = lba + sector;
+            writebench_fill(expected, at, 1, at < through_sectors ? through_pass : pass);
+            if (memcmp(buffer + sector * 512, expected, 512) != 0)
+            {
+                mismatches++;
+            }
+        }
+    }
+
+    free(expected);
+    free(buffer);
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage: writebench disk [span MB] [KB per write] [writes through]\n");
+        printf("The start of the disk is overwritten\n");
+        return -1;
+    }
+
+    int disk = atoi(argv[1]);
+    int span_mb = 16;
+    int write_kb = 4;
+    int through_writes = 256;
+    if (argc > 2)
+    {
+        span_mb = atoi(argv[2]);
+    }
+
+    if (argc > 3)
+    {
+        write_kb = atoi(argv[3]);
+    }
+
+    if (argc > 4)
+    {
+        through_writes = atoi(argv[4]);
+    }
+
+    if (span_mb < 1)
+    {
+        span_mb = 1;
+    }
+
+    // Whole sectors, at most 64KB a call
+    if (write_kb < 1)
+    {
+        write_kb = 1;
+    }
+
+    if (write_kb > 64)
+    {
+        write_kb = 64;
+    }
+
+    int sectors_per_write = write_kb * 2;
+    unsigned int sectors = (unsigned int) span_mb * WRITEBENCH_SECTORS_PER_MB;
+    if (through_writes < 0 || (unsigned int) through_writes * sectors_per_write > sectors)
+    {
+        through_writes = sectors / sectors_per_write;
+    }
+
+    void* buffer = malloc(sectors_per_write * 512);
+    if (!buffer)
+    {
+        printf("Out of memory\n");
+        return -1;
+    }
+
+    printf("Disk %i, %iMB in %iKB writes\n", disk, span_mb, write_kb);
+    uint32_t pass = (uint32_t) writebench_now_us();
+    writebench_cached(disk, sectors, sectors_per_write, buffer, pass);
+    writebench_through(disk, through_writes, sectors_per_write, buffer, pass + 1);
+
+    int mismatches = writebench_verify(disk, sectors, (unsigned int) through_writes * sectors_per_write, pass, pass + 1);
+    if (mismatches == 0)
+    {
+        printf("verify: ok\n");
+    }
+    else
+    {
+        printf("verify: %i sectors wrong\n", mismatches);
+    }
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "acpi.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "memory/memory.h"
+#include "memory/paging/paging.h"
+
+static struct acpi_rsdp* acpi_rsdp = NULL;
+
+// Either the XSDT (64 bit entries) or the RSDT (32 bit entries)
+static struct acpi_sdt_header* acpi_root = NULL;
+static bool acpi_root_is_xsdt = false;
+
+/**
+ * ACPI tables live in firmware reserved memory that is not part of the
+ * E820 map, identity map them into the kernel before touching them.
+ */
+static void acpi_map(void* address, size_t size)
+{
+    void* start = paging_align_to_lower_page(address);
+    void* end = paging_align_address(address + size);
+    paging_map_to(kernel_desc(), start, start, end, PAGING_IS_PRESENT | PAGING_IS_WRITEABLE);
+}
+
+static bool acpi_checksum_ok(void* data, size_t size)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        sum += ((uint8_t*) data)[i];
+    }
+
+    return sum == 0;
+}
+
+static struct acpi_rsdp* acpi_rsdp_search()
+{
+    // The UEFI bootloader passes the RSDP from the EFI configuration table
+    uint64_t rsdp_address = *((uint64_t*) PEACHOS_ACPI_RSDP_LOCATION);
+    if (rsdp_address)
+    {
+        acpi_map((void*) rsdp_address, sizeof(struct acpi_rsdp));
+        return (struct acpi_rsdp*) rsdp_address;
+    }
+
+    // Legacy firmware keeps it on a 16 byte boundary in the BIOS area
+    for (uintptr_t address = ACPI_RSDP_SEARCH_START; address < ACPI_RSDP_SEARCH_END; address += 16)
+    {
+        struct acpi_rsdp* rsdp = (struct acpi_rsdp*) address;
+        if (memcmp(rsdp->signature, (void*) ACPI_RSDP_SIGNATURE, sizeof(rsdp->signature)) == 0 &&
+            acpi_checksum_ok(rsdp, 20))
+        {
+            return rsdp;
+        }
+    }
+
+    return NULL;
+}
+
+static struct acpi_sdt_header* acpi_map_table(uint64_t address)
+{
+    struct acpi_sdt_header* header = (struct acpi_sdt_header*) address;
+    acpi_map(header, sizeof(struct acpi_sdt_header));
+
+    // Now the header is readable we know how much to map
+    acpi_map(header, header->length);
+    return header;
+}
+
+int acpi_init()
+{
+    int res = 0;
+    acpi_rsdp = acpi_rsdp_search();
+    if (!acpi_rsdp)
+    {
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    if (acpi_rsdp->revision >= 2 && acpi_rsdp->xsdt_address)
+    {
+        acpi_root = acpi_map_table(acpi_rsdp->xsdt_address);
+        acpi_root_is_xsdt = true;
+    }
+    else
+    {
+        acpi_root = acpi_map_table(acpi_rsdp->rsdt_address);
+    }
+
+    if (!acpi_checksum_ok(acpi_root, acpi_root->length))
+    {
+        acpi_root = NULL;
+        res = -EINFORMAT;
+        goto out;
+    }
+
+out:
+    return res;
+}
+
+struct acpi_sdt_header* acpi_find_table(const char* signature)
+{
+    if (!acpi_root)
+    {
+        return NULL;
+    }
+
+    size_t entry_size = acpi_root_is_xsdt ? sizeof(uint64_t) : sizeof(uint32_t);
+    size_t total_entries = (acpi_root->length - sizeof(struct acpi_sdt_header)) / entry_size;
+    void* entries = (void*)((uintptr_t) acpi_root + sizeof(struct acpi_sdt_header));
+    for (size_t i = 0; i < total_entries; i++)
+    {
+        uint64_t address = acpi_root_is_xsdt ? ((uint64_t*) entries)[i] : ((uint32_t*) entries)[i];
+        struct acpi_sdt_header* header = acpi_map_table(address);
+        if (memcmp(header->signature, (void*) signature, sizeof(header->signature)) == 0)
+        {
+            return header;
+        }
+    }
+
+    return NULL;
+}
+
+int acpi_madt_parse(struct acpi_madt_info* info)
+{
+    memset(info, 0, sizeof(struct acpi_madt_info));
+    struct acpi_madt* madt = (struct acpi_madt*) acpi_find_table(ACPI_MADT_SIGNATURE);
+    if (!madt)
+    {
+        return -ENOTFOUND;
+    }
+
+    info->local_apic_address = madt->local_apic_address;
+    for (int i = 0; i < ACPI_ISA_IRQS; i++)
+    {
+        info->isa_irqs[i].gsi = i;
+    }
+
+    uintptr_t current = (uintptr_t) madt + sizeof(struct acpi_madt);
+    uintptr_t end = (uintptr_t) madt + madt->header.length;
+    while (current < end)
+    {
+        struct acpi_madt_entry* entry = (struct acpi_madt_entry*) current;
+        if (entry->length == 0)
+        {
+            // Corrupt table, do not loop forever
+            break;
+        }
+
+        switch (entry->type)
+        {
+        case ACPI_MADT_ENTRY_LOCAL_APIC:
+        {
+            struct acpi_madt_local_apic* lapic = (struct acpi_madt_local_apic*) entry;
+            bool usable = lapic->flags & (ACPI_MADT_LOCAL_APIC_ENABLED | ACPI_MADT_LOCAL_APIC_ONLINE_CAPABLE);
+            if (usable && info->total_cpus < PEACHOS_MAX_CPUS)
+            {
+                info->cpu_apic_ids[info->total_cpus++] = lapic->apic_id;
+            }
+        }
+        break;
+
+        case ACPI_MADT_ENTRY_IO_APIC:
+        {
+            struct acpi_madt_io_apic* ioapic = (struct acpi_madt_io_apic*) entry;
+            if (info->total_io_apics < PEACHOS_MAX_IO_APICS)
+            {
+                struct acpi_io_apic_info* out = &info->io_apics[info->total_io_apics++];
+                out->id = ioapic->io_apic_id;
+                out->address = ioapic->address;
+                out->gsi_base = ioapic->gsi_base;
+            }
+        }
+        break;
+
+        case ACPI_MADT_ENTRY_INTERRUPT_OVERRIDE:
+        {
+            struct acpi_madt_interrupt_override* override = (struct acpi_madt_interrupt_override*) entry;
+            // Bus zero is ISA, the only bus overrides are defined for
+            if (override->bus == 0 && override->source < ACPI_ISA_IRQS)
+            {
+                info->isa_irqs[override->source].gsi = override->gsi;
+                info->isa_irqs[override->source].flags = override->flags;
+            }
+        }
+        break;
+
+        case ACPI_MADT_ENTRY_LOCAL_APIC_ADDRESS_OVERRIDE:
+            info->local_apic_address = ((struct acpi_madt_local_apic_address_override*) entry)->address;
+            break;
+        }
+
+        current += entry->length;
+    }
+
+    return 0;
+}
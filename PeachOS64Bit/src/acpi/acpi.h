@@ -0,0 +1,185 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_ACPI_H
+#define KERNEL_ACPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define ACPI_RSDP_SIGNATURE "RSD PTR "
+#define ACPI_MADT_SIGNATURE "APIC"
+
+// Legacy BIOS area searched for the RSDP when the bootloader did not pass one
+#define ACPI_RSDP_SEARCH_START 0xE0000
+#define ACPI_RSDP_SEARCH_END 0x100000
+
+// MADT entry types
+#define ACPI_MADT_ENTRY_LOCAL_APIC 0
+#define ACPI_MADT_ENTRY_IO_APIC 1
+#define ACPI_MADT_ENTRY_INTERRUPT_OVERRIDE 2
+#define ACPI_MADT_ENTRY_LOCAL_APIC_ADDRESS_OVERRIDE 5
+
+// Local APIC entry flags
+#define ACPI_MADT_LOCAL_APIC_ENABLED 0x01
+#define ACPI_MADT_LOCAL_APIC_ONLINE_CAPABLE 0x02
+
+// MPS INTI flags of an interrupt source override, zero means the bus default
+#define ACPI_MADT_POLARITY_MASK 0x03
+#define ACPI_MADT_POLARITY_ACTIVE_LOW 0x03
+#define ACPI_MADT_TRIGGER_MASK 0x0C
+#define ACPI_MADT_TRIGGER_LEVEL 0x0C
+
+// The legacy ISA interrupt lines that an interrupt source override can remap
+#define ACPI_ISA_IRQS 16
+
+struct acpi_rsdp
+{
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+
+    // ACPI 2.0 and later
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} __attribute__((packed));
+
+struct acpi_sdt_header
+{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+struct acpi_madt
+{
+    struct acpi_sdt_header header;
+    uint32_t local_apic_address;
+    uint32_t flags;
+    // Variable length entries follow
+} __attribute__((packed));
+
+struct acpi_madt_entry
+{
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed));
+
+struct acpi_madt_local_apic
+{
+    struct acpi_madt_entry entry;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_io_apic
+{
+    struct acpi_madt_entry entry;
+    uint8_t io_apic_id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;
+} __attribute__((packed));
+
+struct acpi_madt_interrupt_override
+{
+    struct acpi_madt_entry entry;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed));
+
+struct acpi_madt_local_apic_address_override
+{
+    struct acpi_madt_entry entry;
+    uint16_t reserved;
+    uint64_t address;
+} __attribute__((packed));
+
+struct acpi_io_apic_info
+{
+    uint8_t id;
+    uint64_t address;
+
+    // The first global system interrupt wired to this I/O APIC
+    uint32_t gsi_base;
+};
+
+/**
+ * Where an ISA interrupt line arrives at the I/O APICs. Lines without an
+ * override are identity mapped, edge triggered and active high.
+ */
+struct acpi_isa_irq_info
+{
+    uint32_t gsi;
+    uint16_t flags;
+};
+
+/**
+ * The processors and interrupt controllers described by the MADT
+ */
+struct acpi_madt_info
+{
+    uint64_t local_apic_address;
+    int total_cpus;
+    uint8_t cpu_apic_ids[PEACHOS_MAX_CPUS];
+
+    int total_io_apics;
+    struct acpi_io_apic_info io_apics[PEACHOS_MAX_IO_APICS];
+    struct acpi_isa_irq_info isa_irqs[ACPI_ISA_IRQS];
+};
+
+/**
+ * Finds the RSDP and maps the root table, returns -ENOTFOUND if there is no ACPI
+ */
+int acpi_init();
+
+/**
+ * Returns the mapped table with the given four character signature or NULL
+ */
+struct acpi_sdt_header* acpi_find_table(const char* signature);
+
+/**
+ * Parses the MADT into the info structure
+ */
+int acpi_madt_parse(struct acpi_madt_info* info);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "ioapic.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "acpi/acpi.h"
+#include "memory/memory.h"
+#include "memory/paging/paging.h"
+
+struct ioapic
+{
+    volatile uint32_t* base;
+    uint32_t gsi_base;
+    int total_pins;
+};
+
+static struct ioapic ioapics[PEACHOS_MAX_IO_APICS];
+static int total_ioapics = 0;
+
+// Where each ISA line arrives and how, copied out of the MADT
+static struct acpi_isa_irq_info ioapic_isa_irqs[ACPI_ISA_IRQS];
+
+static uint32_t ioapic_read(struct ioapic* ioapic, uint8_t reg)
+{
+    ioapic->base[IOAPIC_REGISTER_SELECT / sizeof(uint32_t)] = reg;
+    return ioapic->base[IOAPIC_REGISTER_WINDOW / sizeof(uint32_t)];
+}
+
+static void ioapic_write(struct ioapic* ioapic, uint8_t reg, uint32_t value)
+{
+    ioapic->base[IOAPIC_REGISTER_SELECT / sizeof(uint32_t)] = reg;
+    ioapic->base[IOAPIC_REGISTER_WINDOW / sizeof(uint32_t)] = value;
+}
+
+static void ioapic_write_redirection(struct ioapic* ioapic, int pin, uint64_t entry)
+{
+    uint8_t reg = IOAPIC_REGISTER_REDIRECTION_BASE + pin * 2;
+
+    // Mask first so the entry never fires half written
+    ioapic_write(ioapic, reg, IOAPIC_REDIRECTION_MASKED);
+    ioapic_write(ioapic, reg + 1, entry >> 32);
+    ioapic_write(ioapic, reg, entry & 0xFFFFFFFF);
+}
+
+static struct ioapic* ioapic_for_gsi(uint32_t gsi, int* pin_out)
+{
+    for (int i = 0; i < total_ioapics; i++)
+    {
+        struct ioapic* ioapic = &ioapics[i];
+        if (gsi >= ioapic->gsi_base && gsi < ioapic->gsi_base + ioapic->total_pins)
+        {
+            *pin_out = gsi - ioapic->gsi_base;
+            return ioapic;
+        }
+    }
+
+    return NULL;
+}
+
+int ioapic_init(struct acpi_madt_info* info)
+{
+    memcpy(ioapic_isa_irqs, info->isa_irqs, sizeof(ioapic_isa_irqs));
+    for (int i = 0; i < info->total_io_apics; i++)
+    {
+        struct ioapic* ioapic = &ioapics[total_ioapics];
+        void* base = (void*) info->io_apics[i].address;
+
+        // Device memory, must never be cached
+        paging_map(kernel_desc(), base, base, PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_CACHE_DISABLED);
+        ioapic->base = base;
+        ioapic->gsi_base = info->io_apics[i].gsi_base;
+
+        // Bits 16 to 23 of the version register hold the index of the last entry
+        ioapic->total_pins = ((ioapic_read(ioapic, IOAPIC_REGISTER_VERSION) >> 16) & 0xFF) + 1;
+        for (int pin = 0; pin < ioapic->total_pins; pin++)
+        {
+            ioapic_write_redirection(ioapic, pin, IOAPIC_REDIRECTION_MASKED);
+        }
+        total_ioapics++;
+    }
+
+    return total_ioapics ? 0 : -ENOTFOUND;
+}
+
+bool ioapic_present()
+{
+    return total_ioapics > 0;
+}
+
+int ioapic_route(uint32_t gsi, uint8_t vector, uint8_t apic_id, uint32_t flags)
+{
+    int pin = 0;
+    struct ioapic* ioapic = ioapic_for_gsi(gsi, &pin);
+    if (!ioapic)
+    {
+        return -EINVARG;
+    }
+
+    // Fixed delivery to a physical destination
+    uint64_t entry = vector | flags | ((uint64_t) apic_id << IOAPIC_REDIRECTION_DESTINATION_SHIFT);
+    ioapic_write_redirection(ioapic, pin, entry);
+    return 0;
+}
+
+int ioapic_mask(uint32_t gsi)
+{
+    int pin = 0;
+    struct ioapic* ioapic = ioapic_for_gsi(gsi, &pin);
+    if (!ioapic)
+    {
+        return -EINVARG;
+    }
+
+    ioapic_write_redirection(ioapic, pin, IOAPIC_REDIRECTION_MASKED);
+    return 0;
+}
+
+int ioapic_route_isa(int irq, uint8_t vector, uint8_t apic_id)
+{
+    if (irq < 0 || irq >= ACPI_ISA_IRQS)
+    {
+        return -EINVARG;
+    }
+
+    // ISA lines are edge triggered and active high unless the firmware says otherwise
+    uint32_t flags = 0;
+    struct acpi_isa_irq_info* isa = &ioapic_isa_irqs[irq];
+    if ((isa->flags & ACPI_MADT_POLARITY_MASK) == ACPI_MADT_POLARITY_ACTIVE_LOW)
+    {
+        flags |= IOAPIC_REDIRECTION_ACTIVE_LOW;
+    }
+
+    if ((isa->flags & ACPI_MADT_TRIGGER_MASK) == ACPI_MADT_TRIGGER_LEVEL)
+    {
+        flags |= IOAPIC_REDIRECTION_LEVEL;
+    }
+
+    return ioapic_route(isa->gsi, vector, apic_id, flags);
+}
+
+int ioapic_mask_isa(int irq)
+{
+    if (irq < 0 || irq >= ACPI_ISA_IRQS)
+    {
+        return -EINVARG;
+    }
+
+    return ioapic_mask(ioapic_isa_irqs[irq].gsi);
+}
@@ -0,0 +1,72 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_IOAPIC_H
+#define KERNEL_IOAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Memory mapped registers, every other register is reached through the select/window pair
+#define IOAPIC_REGISTER_SELECT 0x00
+#define IOAPIC_REGISTER_WINDOW 0x10
+
+// Indirect registers
+#define IOAPIC_REGISTER_ID 0x00
+#define IOAPIC_REGISTER_VERSION 0x01
+#define IOAPIC_REGISTER_REDIRECTION_BASE 0x10
+
+// Redirection table entry bits, the destination APIC id sits in bits 56 to 63
+#define IOAPIC_REDIRECTION_ACTIVE_LOW (1 << 13)
+#define IOAPIC_REDIRECTION_LEVEL (1 << 15)
+#define IOAPIC_REDIRECTION_MASKED (1 << 16)
+#define IOAPIC_REDIRECTION_DESTINATION_SHIFT 56
+
+struct acpi_madt_info;
+
+/**
+ * Maps every I/O APIC from the MADT and masks all their inputs
+ * \return Returns -ENOTFOUND when the machine has no I/O APIC
+ */
+int ioapic_init(struct acpi_madt_info* info);
+
+bool ioapic_present();
+
+/**
+ * Routes the global system interrupt to the vector on the processor with
+ * the given APIC id and unmasks it. Flags are IOAPIC_REDIRECTION_ bits.
+ */
+int ioapic_route(uint32_t gsi, uint8_t vector, uint8_t apic_id, uint32_t flags);
+int ioapic_mask(uint32_t gsi);
+
+/**
+ * As above for a legacy ISA line, following the interrupt source overrides of the MADT
+ */
+int ioapic_route_isa(int irq, uint8_t vector, uint8_t apic_id);
+int ioapic_mask_isa(int irq);
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "lapic.h"
+#include "config.h"
+#include "kernel.h"
+#include "cpu/cpu.h"
+#include "timer/timer.h"
+#include "memory/paging/paging.h"
+
+// How long the timer calibration runs for in microseconds
+#define LAPIC_CALIBRATION_US 10000
+
+static volatile uint32_t* lapic_base = NULL;
+
+// Local APIC timer counts per scheduler tick with a divider of 16
+static uint32_t lapic_timer_ticks_per_tick = 0;
+
+static uint32_t lapic_read(uint32_t reg)
+{
+    return lapic_base[reg / sizeof(uint32_t)];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value)
+{
+    lapic_base[reg / sizeof(uint32_t)] = value;
+}
+
+void lapic_init(uint64_t base_address)
+{
+    if (!base_address)
+    {
+        base_address = cpu_read_msr(CPU_MSR_APIC_BASE) & ~0xFFFULL;
+    }
+
+    lapic_base = (volatile uint32_t*) base_address;
+    lapic_map(kernel_desc());
+    lapic_cpu_init();
+}
+
+void lapic_map(struct paging_desc* desc)
+{
+    if (!lapic_base)
+    {
+        return;
+    }
+
+    // Device memory, must never be cached
+    paging_map(desc, (void*) lapic_base, (void*) lapic_base, PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_CACHE_DISABLED);
+}
+
+void lapic_cpu_init()
+{
+    lapic_write(LAPIC_REGISTER_SPURIOUS, LAPIC_SPURIOUS_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_REGISTER_LVT_TIMER, LAPIC_TIMER_MASKED);
+}
+
+bool lapic_present()
+{
+    return lapic_base != NULL;
+}
+
+uint8_t lapic_id()
+{
+    return lapic_read(LAPIC_REGISTER_ID) >> 24;
+}
+
+void lapic_eoi()
+{
+    lapic_write(LAPIC_REGISTER_EOI, 0);
+}
+
+static void lapic_send_command(uint8_t apic_id, uint32_t command)
+{
+    lapic_write(LAPIC_REGISTER_ICR_HIGH, ((uint32_t) apic_id) << 24);
+    lapic_write(LAPIC_REGISTER_ICR_LOW, command);
+    while (lapic_read(LAPIC_REGISTER_ICR_LOW) & LAPIC_ICR_DELIVERY_PENDING)
+    {
+        __builtin_ia32_pause();
+    }
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector)
+{
+    lapic_send_command(apic_id, LAPIC_ICR_DELIVERY_FIXED | LAPIC_ICR_LEVEL_ASSERT | vector);
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send_command(apic_id, LAPIC_ICR_DELIVERY_INIT | LAPIC_ICR_LEVEL_ASSERT);
+}
+
+void lapic_send_startup(uint8_t apic_id, uint8_t page)
+{
+    lapic_send_command(apic_id, LAPIC_ICR_DELIVERY_STARTUP | LAPIC_ICR_LEVEL_ASSERT | page);
+}
+
+void lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_REGISTER_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_REGISTER_LVT_TIMER, LAPIC_TIMER_MASKED);
+    lapic_write(LAPIC_REGISTER_TIMER_INITIAL_COUNT, 0xFFFFFFFF);
+    timer_pit_delay_us(LAPIC_CALIBRATION_US);
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_REGISTER_TIMER_CURRENT_COUNT);
+    lapic_write(LAPIC_REGISTER_TIMER_INITIAL_COUNT, 0);
+
+    uint64_t per_second = (uint64_t) elapsed * (1000000 / LAPIC_CALIBRATION_US);
+    lapic_timer_ticks_per_tick = per_second / PEACHOS_TIMER_HZ;
+}
+
+void lapic_timer_start_periodic()
+{
+    lapic_write(LAPIC_REGISTER_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_REGISTER_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REGISTER_TIMER_INITIAL_COUNT, lapic_timer_ticks_per_tick);
+}
+
+void lapic_timer_stop()
+{
+    lapic_write(LAPIC_REGISTER_LVT_TIMER, LAPIC_TIMER_MASKED);
+    lapic_write(LAPIC_REGISTER_TIMER_INITIAL_COUNT, 0);
+}
@@ -0,0 +1,110 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_LAPIC_H
+#define KERNEL_LAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Register offsets from the local APIC base
+#define LAPIC_REGISTER_ID 0x20
+#define LAPIC_REGISTER_EOI 0xB0
+#define LAPIC_REGISTER_SPURIOUS 0xF0
+#define LAPIC_REGISTER_ICR_LOW 0x300
+#define LAPIC_REGISTER_ICR_HIGH 0x310
+#define LAPIC_REGISTER_LVT_TIMER 0x320
+#define LAPIC_REGISTER_TIMER_INITIAL_COUNT 0x380
+#define LAPIC_REGISTER_TIMER_CURRENT_COUNT 0x390
+#define LAPIC_REGISTER_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_SPURIOUS_ENABLE 0x100
+
+// Interrupt command register bits
+#define LAPIC_ICR_DELIVERY_FIXED 0x000
+#define LAPIC_ICR_DELIVERY_INIT 0x500
+#define LAPIC_ICR_DELIVERY_STARTUP 0x600
+#define LAPIC_ICR_DELIVERY_PENDING 0x1000
+#define LAPIC_ICR_LEVEL_ASSERT 0x4000
+
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_MASKED 0x10000
+#define LAPIC_TIMER_DIVIDE_BY_16 0x03
+
+// Vectors owned by the local APIC, kept above the PIC range
+#define LAPIC_VECTOR_BASE 0xF0
+#define LAPIC_TIMER_VECTOR 0xF0
+#define LAPIC_RESCHEDULE_VECTOR 0xF1
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+/**
+ * Maps the local APIC registers and enables the APIC of the bootstrap processor
+ */
+void lapic_init(uint64_t base_address);
+
+struct paging_desc;
+
+/**
+ * Maps the local APIC registers into the page tables, the scheduler
+ * touches them on the way back to a task. Does nothing without an APIC.
+ */
+void lapic_map(struct paging_desc* desc);
+
+/**
+ * Enables the local APIC of the calling processor
+ */
+void lapic_cpu_init();
+
+/**
+ * True once the local APIC is mapped and accepts interrupts, message
+ * signalled interrupts can be relied on from then on
+ */
+bool lapic_present();
+
+uint8_t lapic_id();
+void lapic_eoi();
+
+/**
+ * Sends an interrupt to the processor with the given APIC id
+ */
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector);
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uint8_t page);
+
+/**
+ * Measures the local APIC timer against the PIT, must be called once on
+ * the bootstrap processor before any timer is started.
+ */
+void lapic_timer_calibrate();
+
+/**
+ * Starts the periodic local APIC timer at PEACHOS_TIMER_HZ on this processor
+ */
+void lapic_timer_start_periodic();
+void lapic_timer_stop();
+
+#endif
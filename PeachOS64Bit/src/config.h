@@ -33,6 +33,7 @@
 #define KERNEL_DATA_SELECTOR 0x10
 
 #define KERNEL_LONG_MODE_CODE_SELECTOR 0x18
+#define KERNEL_LONG_MODE_DATA_SELECTOR 0x20
 #define KERNEL_LONG_MODE_TSS_SELECTOR 0x38
 
 #define KERNEL_LONG_MODE_CODE_GDT_INDEX  3
@@ -50,6 +51,10 @@
 // Where to find the E820 records
 #define PEACHOS_MEMORY_MAP_LOCATION 0x210008
 
+// The bootloader stores the physical address of the ACPI RSDP here,
+// zero if the firmware did not provide one
+#define PEACHOS_ACPI_RSDP_LOCATION 0x20F000
+
 // 100MB heap size
 #define PEACHOS_HEAP_MINIMUM_SIZE_BYTES 104857600
 #define PEACHOS_HEAP_BLOCK_SIZE 4096
@@ -66,6 +71,21 @@
 
 #define PEACHOS_SECTOR_SIZE 512
 
+// Size of a block cache buffer, a multiple of the sector size
+#define PEACHOS_BCACHE_BLOCK_SIZE 4096
+
+// Buffers in the block cache, allocated once at boot
+#define PEACHOS_BCACHE_BUFFERS 256
+
+// How long written blocks may stay dirty in the cache before writeback puts them on the disk
+#define PEACHOS_BCACHE_WRITEBACK_MS 1000
+
+// Past this many dirty buffers writeback starts straight away rather than waiting for the period
+#define PEACHOS_BCACHE_DIRTY_LIMIT (PEACHOS_BCACHE_BUFFERS / 2)
+
+// Requests the disk trace ring keeps, across every disk
+#define PEACHOS_DISK_TRACE_ENTRIES 1024
+
 #define PEACHOS_MAX_FILESYSTEMS 12
 #define PEACHOS_MAX_FILE_DESCRIPTORS 512
 
@@ -79,7 +99,12 @@
 #define PEACHOS_PROGRAM_VIRTUAL_STACK_ADDRESS_END PEACHOS_PROGRAM_VIRTUAL_STACK_ADDRESS_START - PEACHOS_USER_PROGRAM_STACK_SIZE
 
 #define PEACHOS_MAX_PROGRAM_ALLOCATIONS 1024
-#define PEACHOS_MAX_PROCESSES 12
+// Process ids are handed out below this, the id bitmap only grows as far as it has to
+#define PEACHOS_PROCESS_ID_MAX 4194304
+
+// Threads a process may have at once including the main thread, exited threads count until joined
+#define PEACHOS_MAX_PROCESS_THREADS 16
+#define PEACHOS_USER_THREAD_STACK_SIZE 1024 * 16
 
 #define USER_DATA_SEGMENT 0x33 // Also includes requested privilage level 3 
 #define USER_CODE_SEGMENT 0x2B // Also includes RPL3
@@ -88,5 +113,23 @@
 
 #define PEACHOS_KEYBOARD_BUFFER_SIZE 1024
 
+// Frequency of the periodic scheduler tick
+#define PEACHOS_TIMER_HZ 100
+
+// Maximum number of processors brought online
+#define PEACHOS_MAX_CPUS 16
+
+// I/O APICs taken from the ACPI MADT, most machines have one or two
+#define PEACHOS_MAX_IO_APICS 8
+
+// Per CPU stack the processor boots on, it is left behind once tasks run
+#define PEACHOS_KERNEL_STACK_SIZE 1024 * 1024
+
+// Kernel stack of every task including the guard page, installed as TSS RSP0 while the task runs
+#define PEACHOS_TASK_KERNEL_STACK_SIZE 1024 * 64
+
+// Keep contention counters and hold time histograms for kernel locks, zero compiles them out
+#define PEACHOS_LOCK_STATS 1
+
 #define WINDOW_MAX_TITLE 128
 #endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+; PeachOS 64-Bit Kernel Project
+; Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+;
+; This file is part of the PeachOS 64-Bit Kernel.
+;
+; This program is free software; you can redistribute it and/or
+; modify it under the terms of the GNU General Public License
+; version 2 as published by the Free Software Foundation.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+; See the GNU General Public License version 2 for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program; if not, see <https://www.gnu.org/licenses/>.
+;
+; For full source code, documentation, and structured learning,
+; see the official kernel development course part one:
+; https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+;
+; Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+;
+; Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+;
+
+[BITS 64]
+section .asm
+
+global cpu_cpuid
+global cpu_read_cr0
+global cpu_write_cr0
+global cpu_read_cr4
+global cpu_write_cr4
+global cpu_xsetbv
+global cpu_read_tsc
+global cpu_read_msr
+global cpu_write_msr
+global cpu_irq_save
+global cpu_irq_restore
+
+; void cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx);
+cpu_cpuid:
+    push rbx        ; RBX is callee saved and CPUID overwrites it
+    mov r10, rdx    ; eax output pointer
+    mov r11, rcx    ; ebx output pointer
+    mov eax, edi    ; Leaf
+    mov ecx, esi    ; Sub leaf
+    cpuid
+    mov [r10], eax
+    mov [r11], ebx
+    mov [r8], ecx
+    mov [r9], edx
+    pop rbx
+    ret
+
+; uint64_t cpu_read_cr0()
+cpu_read_cr0:
+    mov rax, cr0
+    ret
+
+; void cpu_write_cr0(uint64_t value)
+cpu_write_cr0:
+    mov cr0, rdi
+    ret
+
+; uint64_t cpu_read_cr4()
+cpu_read_cr4:
+    mov rax, cr4
+    ret
+
+; void cpu_write_cr4(uint64_t value)
+cpu_write_cr4:
+    mov cr4, rdi
+    ret
+
+; void cpu_xsetbv(uint32_t index, uint64_t value)
+cpu_xsetbv:
+    mov ecx, edi    ; Extended control register index
+    mov rax, rsi    ; Low 32 bits in EAX
+    mov rdx, rsi
+    shr rdx, 32     ; High 32 bits in EDX
+    xsetbv
+    ret
+
+; uint64_t cpu_read_tsc()
+cpu_read_tsc:
+    rdtsc           ; EDX:EAX = time stamp counter
+    shl rdx, 32
+    or rax, rdx
+    ret
+
+; uint64_t cpu_read_msr(uint32_t msr)
+cpu_read_msr:
+    mov ecx, edi
+    rdmsr           ; EDX:EAX = MSR
+    shl rdx, 32
+    or rax, rdx
+    ret
+
+; void cpu_write_msr(uint32_t msr, uint64_t value)
+cpu_write_msr:
+    mov ecx, edi
+    mov rax, rsi    ; Low 32 bits in EAX
+    mov rdx, rsi
+    shr rdx, 32     ; High 32 bits in EDX
+    wrmsr
+    ret
+
+; uint64_t cpu_irq_save()
+; Disables interrupts and returns the flags register from before
+cpu_irq_save:
+    pushfq
+    cli
+    pop rax
+    ret
+
+; void cpu_irq_restore(uint64_t flags)
+; Interrupts are only enabled again if they were enabled when saved
+cpu_irq_restore:
+    push rdi
+    popfq
+    ret
@@ -0,0 +1,82 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_CPU_H
+#define KERNEL_CPU_H
+
+#include <stdint.h>
+
+// CR0 bits
+#define CPU_CR0_MONITOR_COPROCESSOR 0x02
+#define CPU_CR0_EMULATION           0x04
+#define CPU_CR0_TASK_SWITCHED       0x08
+#define CPU_CR0_NUMERIC_ERROR       0x20
+
+// CR4 bits
+#define CPU_CR4_OSFXSR              0x200
+#define CPU_CR4_OSXMMEXCPT          0x400
+#define CPU_CR4_OSXSAVE             0x40000
+
+// CPUID leaf 1 feature bits
+#define CPUID_FEATURE_ECX_XSAVE     (1 << 26)
+#define CPUID_FEATURE_ECX_AVX       (1 << 28)
+#define CPUID_FEATURE_EDX_FXSR      (1 << 24)
+#define CPUID_FEATURE_EDX_SSE       (1 << 25)
+
+// Model specific registers
+#define CPU_MSR_APIC_BASE           0x1B
+#define CPU_MSR_GS_BASE             0xC0000101
+#define CPU_MSR_KERNEL_GS_BASE      0xC0000102
+
+// Extended control register zero, which state components XSAVE manages
+#define CPU_XCR0_X87                0x01
+#define CPU_XCR0_SSE                0x02
+#define CPU_XCR0_AVX                0x04
+
+void cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx);
+uint64_t cpu_read_cr0();
+void cpu_write_cr0(uint64_t value);
+uint64_t cpu_read_cr4();
+void cpu_write_cr4(uint64_t value);
+void cpu_xsetbv(uint32_t index, uint64_t value);
+
+/**
+ * Returns the time stamp counter, the number of CPU cycles since reset
+ */
+uint64_t cpu_read_tsc();
+
+uint64_t cpu_read_msr(uint32_t msr);
+void cpu_write_msr(uint32_t msr, uint64_t value);
+
+/**
+ * Disables interrupts on this processor
+ * \return Returns the flags register to pass to cpu_irq_restore()
+ */
+uint64_t cpu_irq_save();
+void cpu_irq_restore(uint64_t flags);
+
+#endif
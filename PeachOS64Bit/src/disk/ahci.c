@@ -0,0 +1,872 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "ahci.h"
+#include "disk.h"
+#include "blkqueue.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "pci/pci.h"
+#include "apic/lapic.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "string/string.h"
+#include "task/task.h"
+#include "timer/timer.h"
+
+static struct ahci_hba* ahci_hbas = NULL;
+
+static uint32_t ahci_hba_read(struct ahci_hba* hba, uint32_t reg)
+{
+    return *(volatile uint32_t*)(hba->abar + reg);
+}
+
+static void ahci_hba_write(struct ahci_hba* hba, uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t*)(hba->abar + reg) = value;
+}
+
+static uint32_t ahci_port_read(struct ahci_port* port, uint32_t reg)
+{
+    return *(volatile uint32_t*)(port->registers + reg);
+}
+
+static void ahci_port_write(struct ahci_port* port, uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t*)(port->registers + reg) = value;
+}
+
+static uint64_t ahci_physical(void* address)
+{
+    return (uint64_t) paging_get_physical_address(kernel_desc(), address);
+}
+
+/**
+ * \return Returns false when the HBA cannot address the memory
+ */
+static bool ahci_reachable(struct ahci_hba* hba, uint64_t physical, size_t size)
+{
+    return physical && (hba->supports_64bit || physical + size <= 0x100000000ULL);
+}
+
+static bool ahci_port_wait_clear(struct ahci_port* port, uint32_t reg, uint32_t bits)
+{
+    for (int ms = 0; ms < AHCI_TIMEOUT_MS; ms++)
+    {
+        if (!(ahci_port_read(port, reg) & bits))
+        {
+            return true;
+        }
+
+        timer_pit_delay_us(1000);
+    }
+
+    return false;
+}
+
+/**
+ * Stops the command list and FIS receive engines, the HBA forgets every issued command
+ */
+static int ahci_port_stop(struct ahci_port* port)
+{
+    uint32_t cmd = ahci_port_read(port, AHCI_PORT_CMD);
+    ahci_port_write(port, AHCI_PORT_CMD, cmd & ~(AHCI_PORT_CMD_ST | AHCI_PORT_CMD_FRE));
+    return ahci_port_wait_clear(port, AHCI_PORT_CMD, AHCI_PORT_CMD_CR | AHCI_PORT_CMD_FR) ? 0 : -EIO;
+}
+
+static void ahci_port_start(struct ahci_port* port)
+{
+    // The command engine may only start once the drive is idle
+    ahci_port_wait_clear(port, AHCI_PORT_TFD, AHCI_PORT_TFD_BSY | AHCI_PORT_TFD_DRQ);
+    uint32_t cmd = ahci_port_read(port, AHCI_PORT_CMD);
+    ahci_port_write(port, AHCI_PORT_CMD, cmd | AHCI_PORT_CMD_FRE);
+    ahci_port_write(port, AHCI_PORT_CMD, cmd | AHCI_PORT_CMD_FRE | AHCI_PORT_CMD_ST);
+}
+
+/**
+ * Gives the port its command list, received FIS area and a command table per slot.
+ * Tables never cross a page as the pages need not be physically contiguous.
+ * Each page goes on the port the moment it is had, so ahci_port_free() finds it when we fail.
+ */
+static int ahci_port_alloc(struct ahci_port* port)
+{
+    struct ahci_hba* hba = port->hba;
+
+    // The command list needs 1KB alignment and the received FIS 256 bytes, one page holds both
+    void* page = kzalloc(PAGING_PAGE_SIZE);
+    if (!page)
+    {
+        return -ENOMEM;
+    }
+
+    port->command_list = page;
+    void* received_fis = page + AHCI_MAX_SLOTS * sizeof(struct ahci_command_header);
+    uint64_t list_physical = ahci_physical(page);
+    uint64_t fis_physical = ahci_physical(received_fis);
+    if (!ahci_reachable(hba, list_physical, PAGING_PAGE_SIZE))
+    {
+        return -ENOMEM;
+    }
+
+    int tables_per_page = PAGING_PAGE_SIZE / AHCI_COMMAND_TABLE_SIZE;
+    for (int slot = 0; slot < hba->command_slots; slot += tables_per_page)
+    {
+        void* tables = kzalloc(PAGING_PAGE_SIZE);
+        if (!tables)
+        {
+            return -ENOMEM;
+        }
+
+        port->tables[slot] = tables;
+        if (!ahci_reachable(hba, ahci_physical(tables), PAGING_PAGE_SIZE))
+        {
+            return -ENOMEM;
+        }
+
+        for (int i = 0; i < tables_per_page && slot + i < hba->command_slots; i++)
+        {
+            struct ahci_command_table* table = tables + i * AHCI_COMMAND_TABLE_SIZE;
+            uint64_t physical = ahci_physical(table);
+            port->tables[slot + i] = table;
+            port->command_list[slot + i].table_address_low = physical;
+            port->command_list[slot + i].table_address_high = physical >> 32;
+        }
+    }
+
+    ahci_port_write(port, AHCI_PORT_CLB, list_physical);
+    ahci_port_write(port, AHCI_PORT_CLBU, list_physical >> 32);
+    ahci_port_write(port, AHCI_PORT_FB, fis_physical);
+    ahci_port_write(port, AHCI_PORT_FBU, fis_physical >> 32);
+    return 0;
+}
+
+/**
+ * Frees what ahci_port_alloc() got, the command engines must be stopped
+ */
+static void ahci_port_free(struct ahci_port* port)
+{
+    // The first table of each page is where the page starts
+    int tables_per_page = PAGING_PAGE_SIZE / AHCI_COMMAND_TABLE_SIZE;
+    for (int slot = 0; slot < AHCI_MAX_SLOTS; slot += tables_per_page)
+    {
+        if (port->tables[slot])
+        {
+            kfree(port->tables[slot]);
+        }
+    }
+
+    if (port->command_list)
+    {
+        kfree(port->command_list);
+    }
+}
+
+/**
+ * Fills in the command table and header of the slot, nothing is issued yet
+ */
+static int ahci_port_prepare(struct ahci_port* port, int slot, uint8_t command, uint64_t lba, int total, void* buf)
+{
+    struct ahci_command_table* table = port->tables[slot];
+    size_t size = total * PEACHOS_SECTOR_SIZE;
+    int prds = 0;
+    while (size > 0)
+    {
+        uint64_t physical = ahci_physical(buf);
+        size_t chunk = PAGING_PAGE_SIZE - ((uintptr_t) buf % PAGING_PAGE_SIZE);
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        // Addresses must be word aligned
+        if (!ahci_reachable(port->hba, physical, chunk) || (physical & 1) || prds >= AHCI_MAX_PRDS)
+        {
+            return -EIO;
+        }
+
+        table->prdt[prds].address_low = physical;
+        table->prdt[prds].address_high = physical >> 32;
+        table->prdt[prds].reserved = 0;
+        table->prdt[prds].byte_count = chunk - 1;
+        prds++;
+        buf += chunk;
+        size -= chunk;
+    }
+
+    struct ahci_fis_h2d* fis = (struct ahci_fis_h2d*) table->command_fis;
+    memset(fis, 0, sizeof(struct ahci_fis_h2d));
+    fis->type = AHCI_FIS_TYPE_REG_H2D;
+    fis->flags = AHCI_FIS_H2D_COMMAND;
+    fis->command = command;
+    fis->device = ATA_DEVICE_LBA;
+    fis->lba0 = lba & 0xFF;
+    fis->lba1 = (lba >> 8) & 0xFF;
+    fis->lba2 = (lba >> 16) & 0xFF;
+    fis->lba3 = (lba >> 24) & 0xFF;
+    fis->lba4 = (lba >> 32) & 0xFF;
+    fis->lba5 = (lba >> 40) & 0xFF;
+    bool queued = command == ATA_COMMAND_READ_FPDMA_QUEUED || command == ATA_COMMAND_WRITE_FPDMA_QUEUED;
+    if (queued)
+    {
+        // Queued commands carry the count in the features and their tag in the count
+        fis->feature_low = total & 0xFF;
+        fis->feature_high = (total >> 8) & 0xFF;
+        fis->count_low = slot << 3;
+    }
+    else
+    {
+        fis->count_low = total & 0xFF;
+        fis->count_high = (total >> 8) & 0xFF;
+    }
+
+    struct ahci_command_header* header = &port->command_list[slot];
+    header->flags = (sizeof(struct ahci_fis_h2d) / sizeof(uint32_t)) & AHCI_COMMAND_HEADER_FIS_LENGTH_MASK;
+    if (command == ATA_COMMAND_WRITE_DMA_EXT || command == ATA_COMMAND_WRITE_FPDMA_QUEUED)
+    {
+        // The HBA moves the data from memory to the device
+        header->flags |= AHCI_COMMAND_HEADER_WRITE;
+    }
+    header->prdt_length = prds;
+    header->prd_byte_count = 0;
+    return 0;
+}
+
+/**
+ * Hands the prepared slot to the HBA, the port lock must be held
+ * \param queued True for an NCQ command
+ */
+static void ahci_port_issue(struct ahci_port* port, int slot, bool queued)
+{
+    uint32_t bit = 1U << slot;
+    port->issued |= bit;
+    if (queued)
+    {
+        // The tag must be active before the command is
+        ahci_port_write(port, AHCI_PORT_SACT, bit);
+    }
+    ahci_port_write(port, AHCI_PORT_CI, bit);
+}
+
+/**
+ * A command failed. Queued commands cannot be told apart without reading the
+ * NCQ error log, so every outstanding one fails and the engine is restarted.
+ */
+static void ahci_port_recover(struct ahci_port* port)
+{
+    port->failed |= port->issued;
+    port->completed |= port->issued;
+    port->issued = 0;
+
+    ahci_port_stop(port);
+    ahci_port_write(port, AHCI_PORT_SERR, 0xFFFFFFFF);
+    ahci_port_write(port, AHCI_PORT_IS, 0xFFFFFFFF);
+    ahci_port_start(port);
+}
+
+/**
+ * Moves the slots the HBA has finished with over to completed, the port lock must be held
+ */
+static void ahci_port_reap(struct ahci_port* port)
+{
+    uint32_t status = ahci_port_read(port, AHCI_PORT_IS);
+    ahci_port_write(port, AHCI_PORT_IS, status);
+    if (status & AHCI_PORT_IS_ERRORS)
+    {
+        ahci_port_recover(port);
+        return;
+    }
+
+    // A queued command is done once its tag leaves SACT, a plain one once it leaves CI
+    uint32_t active = ahci_port_read(port, AHCI_PORT_SACT) | ahci_port_read(port, AHCI_PORT_CI);
+    uint32_t finished = port->issued & ~active;
+    port->issued &= ~finished;
+    port->completed |= finished;
+}
+
+static uint8_t ahci_rw_command(struct ahci_port* port, bool write)
+{
+    if (write)
+    {
+        return port->ncq ? ATA_COMMAND_WRITE_FPDMA_QUEUED : ATA_COMMAND_WRITE_DMA_EXT;
+    }
+
+    return port->ncq ? ATA_COMMAND_READ_FPDMA_QUEUED : ATA_COMMAND_READ_DMA_EXT;
+}
+
+/**
+ * Issues the parts of the pending request queue commands into the free
+ * slots, the port lock must be held
+ * \param done Receives the commands with nothing left to issue or wait for
+ */
+static void ahci_port_issue_pending(struct ahci_port* port, struct blk_command** done)
+{
+    while (port->pending && !port->flushing)
+    {
+        struct blk_command* command = port->pending;
+        uint32_t free = port->slot_mask & ~port->busy;
+        if (command->result < 0)
+        {
+            // Part of it failed, the rest is not worth issuing
+            command->issued = command->total;
+        }
+        else if (free)
+        {
+            int slot = __builtin_ctz(free);
+            int count = command->total - command->issued;
+            if (count > AHCI_MAX_SECTORS)
+            {
+                count = AHCI_MAX_SECTORS;
+            }
+
+            uint8_t ata_command = ahci_rw_command(port, command->op == BLK_REQUEST_WRITE);
+            void* buf = command->buf + command->issued * PEACHOS_SECTOR_SIZE;
+            if (ahci_port_prepare(port, slot, ata_command, command->lba + command->issued, count, buf) < 0)
+            {
+                command->result = -EIO;
+                continue;
+            }
+
+            port->busy |= 1U << slot;
+            port->commands[slot] = command;
+            command->outstanding++;
+            command->issued += count;
+            ahci_port_issue(port, slot, port->ncq);
+        }
+
+        if (command->issued < command->total)
+        {
+            if (!free)
+            {
+                // The rest goes out as slots come back
+                break;
+            }
+            continue;
+        }
+
+        port->pending = command->next;
+        if (!port->pending)
+        {
+            port->pending_tail = NULL;
+        }
+
+        command->next = NULL;
+        if (!command->outstanding)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+}
+
+/**
+ * Frees the finished slots that carried request queue commands and issues
+ * what is pending into them, the port lock must be held
+ * \param done Receives the commands that are finished, to be completed once the lock is dropped
+ */
+static void ahci_port_collect(struct ahci_port* port, struct blk_command** done)
+{
+    uint32_t finished = port->completed;
+    uint32_t freed = 0;
+    while (finished)
+    {
+        int slot = __builtin_ctz(finished);
+        uint32_t bit = 1U << slot;
+        finished &= ~bit;
+        struct blk_command* command = port->commands[slot];
+        if (!command)
+        {
+            // A reader of our own collects it
+            continue;
+        }
+
+        if (port->failed & bit)
+        {
+            command->result = -EIO;
+        }
+
+        port->commands[slot] = NULL;
+        port->completed &= ~bit;
+        port->failed &= ~bit;
+        port->busy &= ~bit;
+        freed |= bit;
+        command->outstanding--;
+        if (!command->outstanding && command->issued == command->total)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+
+    if (freed)
+    {
+        // Readers of our own and a flush may be waiting for a free slot
+        ahci_port_issue_pending(port, done);
+        waitqueue_wake_all(&port->waiters);
+    }
+}
+
+static void ahci_interrupt_handler(struct interrupt_frame* frame)
+{
+    struct blk_command* done = NULL;
+    for (struct ahci_hba* hba = ahci_hbas; hba; hba = hba->next)
+    {
+        uint32_t pending = ahci_hba_read(hba, AHCI_HBA_IS);
+        for (int i = 0; i < AHCI_MAX_PORTS; i++)
+        {
+            struct ahci_port* port = hba->ports[i];
+            if (!port || !(pending & (1U << i)))
+            {
+                continue;
+            }
+
+            spin_lock(&port->lock);
+            ahci_port_reap(port);
+            ahci_port_collect(port, &done);
+            if (port->completed)
+            {
+                waitqueue_wake_all(&port->waiters);
+            }
+            spin_unlock(&port->lock);
+        }
+
+        // The ports are quiet, the HBA may send the next message
+        ahci_hba_write(hba, AHCI_HBA_IS, pending);
+    }
+
+    // Completing them dispatches more, which takes the port locks
+    blk_command_complete(done);
+}
+
+/**
+ * Waits for the HBA to finish something. The port lock is held on entry
+ * and on return, a task sleeps without it until the interrupt wakes it.
+ */
+static void ahci_port_wait(struct ahci_port* port, uint64_t* flags)
+{
+    if (port->hba->vector && lapic_present() && task_can_sleep())
+    {
+        waitqueue_add(&port->waiters, task_current());
+        spin_unlock_irqrestore(&port->lock, *flags);
+        task_next();
+        *flags = spin_lock_irqsave(&port->lock);
+        return;
+    }
+
+    // Boot code, or nothing would wake us, watch the HBA instead
+    __builtin_ia32_pause();
+    ahci_port_reap(port);
+}
+
+static int ahci_transfer(struct ahci_port* port, bool write, uint64_t lba, int total, void* buf)
+{
+    int res = 0;
+    uint32_t mine = 0;
+    struct blk_command* done = NULL;
+    uint8_t command = ahci_rw_command(port, write);
+    uint64_t flags = spin_lock_irqsave(&port->lock);
+    while (total > 0 || mine)
+    {
+        uint32_t finished = mine & port->completed;
+        if (finished)
+        {
+            if (finished & port->failed)
+            {
+                // Stop issuing, what is in flight still has to come back
+                res = -EIO;
+                total = 0;
+            }
+
+            port->completed &= ~finished;
+            port->failed &= ~finished;
+            port->busy &= ~finished;
+            mine &= ~finished;
+
+            // Request queue commands and readers waiting for a free slot can have these
+            ahci_port_issue_pending(port, &done);
+            waitqueue_wake_all(&port->waiters);
+            continue;
+        }
+
+        uint32_t free = port->slot_mask & ~port->busy;
+        if (total > 0 && free)
+        {
+            int slot = __builtin_ctz(free);
+            int count = total > AHCI_MAX_SECTORS ? AHCI_MAX_SECTORS : total;
+            if (ahci_port_prepare(port, slot, command, lba, count, buf) < 0)
+            {
+                res = -EIO;
+                total = 0;
+                continue;
+            }
+
+            port->busy |= 1U << slot;
+            mine |= 1U << slot;
+            ahci_port_issue(port, slot, port->ncq);
+            lba += count;
+            total -= count;
+            buf += count * PEACHOS_SECTOR_SIZE;
+            continue;
+        }
+
+        ahci_port_wait(port, &flags);
+    }
+    spin_unlock_irqrestore(&port->lock, flags);
+    blk_command_complete(done);
+    return res;
+}
+
+int ahci_read(struct ahci_port* port, uint64_t lba, int total, void* buf)
+{
+    return ahci_transfer(port, false, lba, total, buf);
+}
+
+int ahci_write(struct ahci_port* port, uint64_t lba, int total, void* buf)
+{
+    return ahci_transfer(port, true, lba, total, buf);
+}
+
+int ahci_submit(struct ahci_port* port, struct blk_command* command)
+{
+    struct blk_command* done = NULL;
+    if (!port->hba->vector || !lapic_present())
+    {
+        // Nothing would tell us it finished
+        return -EUNIMP;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&port->lock);
+    command->next = NULL;
+    if (port->pending_tail)
+    {
+        port->pending_tail->next = command;
+    }
+    else
+    {
+        port->pending = command;
+    }
+    port->pending_tail = command;
+    ahci_port_issue_pending(port, &done);
+    spin_unlock_irqrestore(&port->lock, flags);
+
+    // Only when it could not be issued at all
+    blk_command_complete(done);
+    return 0;
+}
+
+void ahci_poll(struct ahci_port* port)
+{
+    struct blk_command* done = NULL;
+    uint64_t flags = spin_lock_irqsave(&port->lock);
+    ahci_port_reap(port);
+    ahci_port_collect(port, &done);
+    spin_unlock_irqrestore(&port->lock, flags);
+    blk_command_complete(done);
+}
+
+int ahci_flush(struct ahci_port* port)
+{
+    int res = 0;
+    uint32_t mine = 0;
+    struct blk_command* done = NULL;
+    uint64_t flags = spin_lock_irqsave(&port->lock);
+    port->flushing++;
+
+    // Take the slots as they come free so new readers cannot keep us waiting
+    while (mine != port->slot_mask)
+    {
+        uint32_t free = port->slot_mask & ~port->busy;
+        port->busy |= free;
+        mine |= free;
+        if (mine != port->slot_mask)
+        {
+            ahci_port_wait(port, &flags);
+        }
+    }
+
+    int slot = __builtin_ctz(port->slot_mask);
+    uint32_t bit = 1U << slot;
+    res = ahci_port_prepare(port, slot, ATA_COMMAND_FLUSH_CACHE_EXT, 0, 0, NULL);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    ahci_port_issue(port, slot, false);
+    while (!(port->completed & bit))
+    {
+        ahci_port_wait(port, &flags);
+    }
+
+    if (port->failed & bit)
+    {
+        res = -EIO;
+    }
+    port->completed &= ~bit;
+    port->failed &= ~bit;
+
+out:
+    port->busy &= ~mine;
+    port->flushing--;
+    ahci_port_issue_pending(port, &done);
+    waitqueue_wake_all(&port->waiters);
+    spin_unlock_irqrestore(&port->lock, flags);
+    blk_command_complete(done);
+    return res;
+}
+
+/**
+ * Runs IDENTIFY DEVICE on slot zero, polled as the port is not yet in use
+ */
+static int ahci_port_identify(struct ahci_port* port, uint16_t* identify)
+{
+    int res = 0;
+    uint64_t flags = spin_lock_irqsave(&port->lock);
+    res = ahci_port_prepare(port, 0, ATA_COMMAND_IDENTIFY, 0, 1, identify);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    ahci_port_issue(port, 0, false);
+    for (int ms = 0; ms < AHCI_TIMEOUT_MS && !(port->completed & 1); ms++)
+    {
+        timer_pit_delay_us(1000);
+        ahci_port_reap(port);
+    }
+
+    if (!(port->completed & 1))
+    {
+        // The drive never answered
+        ahci_port_recover(port);
+    }
+
+    if (port->failed & 1)
+    {
+        res = -EIO;
+    }
+
+    port->completed = 0;
+    port->failed = 0;
+
+out:
+    spin_unlock_irqrestore(&port->lock, flags);
+    return res;
+}
+
+static int ahci_port_init(struct ahci_hba* hba, int index)
+{
+    int res = 0;
+    uint16_t* identify = NULL;
+    struct ahci_port* port = kzalloc(sizeof(struct ahci_port));
+    if (!port)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    port->hba = hba;
+    port->index = index;
+    port->registers = hba->abar + AHCI_PORT_BASE + index * AHCI_PORT_SIZE;
+    spinlock_init(&port->lock, "ahci");
+    waitqueue_init(&port->waiters);
+
+    uint32_t status = ahci_port_read(port, AHCI_PORT_SSTS);
+    if ((status & AHCI_SSTS_DET_MASK) != AHCI_SSTS_DET_PRESENT || ahci_port_read(port, AHCI_PORT_SIG) != AHCI_SIG_ATA)
+    {
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    res = ahci_port_stop(port);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = ahci_port_alloc(port);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    ahci_port_write(port, AHCI_PORT_SERR, 0xFFFFFFFF);
+    ahci_port_write(port, AHCI_PORT_IS, 0xFFFFFFFF);
+    ahci_port_write(port, AHCI_PORT_IE, AHCI_PORT_IS_DHRS | AHCI_PORT_IS_SDBS | AHCI_PORT_IS_ERRORS);
+    ahci_port_start(port);
+
+    identify = kzalloc(PEACHOS_SECTOR_SIZE);
+    if (!identify)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = ahci_port_identify(port, identify);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    port->total_sectors = *(uint64_t*) &identify[ATA_IDENTIFY_LBA48_SECTORS];
+    if (!port->total_sectors)
+    {
+        port->total_sectors = *(uint32_t*) &identify[ATA_IDENTIFY_LBA28_SECTORS];
+    }
+
+    // Without NCQ the HBA still takes every slot, it runs them one after the other
+    port->queue_depth = hba->command_slots;
+    if (hba->supports_ncq && (identify[ATA_IDENTIFY_SATA_CAPABILITIES] & ATA_IDENTIFY_SATA_NCQ))
+    {
+        int depth = (identify[ATA_IDENTIFY_QUEUE_DEPTH] & ATA_IDENTIFY_QUEUE_DEPTH_MASK) + 1;
+        port->ncq = true;
+        if (depth < port->queue_depth)
+        {
+            port->queue_depth = depth;
+        }
+    }
+    port->slot_mask = port->queue_depth >= 32 ? 0xFFFFFFFF : (1U << port->queue_depth) - 1;
+    hba->ports[index] = port;
+
+    print("AHCI port ");
+    print(itoa(index));
+    print(": ");
+    print(itoa(port->total_sectors / 2048));
+    print("MB, ");
+    print(port->ncq ? "NCQ" : "no NCQ");
+    print(" depth ");
+    print(itoa(port->queue_depth));
+    print("\n");
+
+    res = disk_create_device(PEACHOS_DISK_TYPE_AHCI, PEACHOS_SECTOR_SIZE, port, &port->disk);
+
+out:
+    if (identify)
+    {
+        kfree(identify);
+    }
+
+    if (res < 0 && port)
+    {
+        if (port->command_list)
+        {
+            ahci_port_write(port, AHCI_PORT_IE, 0);
+            ahci_port_stop(port);
+        }
+        ahci_port_free(port);
+        hba->ports[index] = NULL;
+        kfree(port);
+    }
+    return res;
+}
+
+static int ahci_hba_init(struct pci_device* pci)
+{
+    int res = 0;
+    if (pci->bar_is_io[AHCI_ABAR] || !pci->bars[AHCI_ABAR])
+    {
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    struct ahci_hba* hba = kzalloc(sizeof(struct ahci_hba));
+    if (!hba)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    hba->pci = pci;
+    hba->abar = pci_map_bar(pci, AHCI_ABAR, 0, AHCI_PORT_BASE + AHCI_MAX_PORTS * AHCI_PORT_SIZE);
+    pci_enable(pci, PCI_COMMAND_MEMORY_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    // AHCI mode first, the other registers mean nothing until then
+    ahci_hba_write(hba, AHCI_HBA_GHC, ahci_hba_read(hba, AHCI_HBA_GHC) | AHCI_GHC_AE);
+    uint32_t cap = ahci_hba_read(hba, AHCI_HBA_CAP);
+    hba->command_slots = ((cap >> AHCI_CAP_NCS_SHIFT) & AHCI_CAP_NCS_MASK) + 1;
+    hba->supports_64bit = cap & AHCI_CAP_S64A;
+    hba->supports_ncq = cap & AHCI_CAP_SNCQ;
+
+    int vector = IRQ_msi_vector_alloc();
+    if (vector > 0)
+    {
+        if (pci_enable_msi(pci, IRQ_msi_destination(), vector) == 0)
+        {
+            hba->vector = vector;
+            idt_register_interrupt_callback(vector, ahci_interrupt_handler);
+        }
+    }
+
+    uint32_t implemented = ahci_hba_read(hba, AHCI_HBA_PI);
+    for (int i = 0; i < AHCI_MAX_PORTS; i++)
+    {
+        if (implemented & (1U << i))
+        {
+            ahci_port_init(hba, i);
+        }
+    }
+
+    hba->next = ahci_hbas;
+    ahci_hbas = hba;
+
+    // Drop whatever the ports raised while being set up, then let them interrupt
+    ahci_hba_write(hba, AHCI_HBA_IS, 0xFFFFFFFF);
+    if (hba->vector)
+    {
+        ahci_hba_write(hba, AHCI_HBA_GHC, ahci_hba_read(hba, AHCI_HBA_GHC) | AHCI_GHC_IE);
+    }
+    else
+    {
+        print("AHCI has no MSI, completions are polled\n");
+    }
+
+out:
+    return res;
+}
+
+int ahci_init()
+{
+    int res = -ENOTFOUND;
+    struct pci_device* pci = NULL;
+    for (int i = 0; (pci = pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_STORAGE_SATA, i)); i++)
+    {
+        if (pci->prog_if != AHCI_PROG_IF)
+        {
+            continue;
+        }
+
+        if (ahci_hba_init(pci) == 0)
+        {
+            res = 0;
+        }
+    }
+
+    return res;
+}
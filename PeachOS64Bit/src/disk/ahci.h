@@ -0,0 +1,295 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_AHCI_H
+#define KERNEL_AHCI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+
+// Programming interface of a SATA controller speaking AHCI 1.0
+#define AHCI_PROG_IF 0x01
+
+// The HBA registers are memory mapped through BAR5, known as ABAR
+#define AHCI_ABAR 5
+
+// Generic host control registers
+#define AHCI_HBA_CAP 0x00
+#define AHCI_HBA_GHC 0x04
+#define AHCI_HBA_IS 0x08
+#define AHCI_HBA_PI 0x0C
+
+#define AHCI_CAP_NCS_SHIFT 8        // Command slots minus one
+#define AHCI_CAP_NCS_MASK 0x1F
+#define AHCI_CAP_SNCQ (1 << 30)
+#define AHCI_CAP_S64A (1U << 31)
+
+#define AHCI_GHC_IE 0x00000002
+#define AHCI_GHC_AE 0x80000000
+
+// Port registers, one block of them per port after the generic ones
+#define AHCI_PORT_BASE 0x100
+#define AHCI_PORT_SIZE 0x80
+#define AHCI_PORT_CLB 0x00
+#define AHCI_PORT_CLBU 0x04
+#define AHCI_PORT_FB 0x08
+#define AHCI_PORT_FBU 0x0C
+#define AHCI_PORT_IS 0x10
+#define AHCI_PORT_IE 0x14
+#define AHCI_PORT_CMD 0x18
+#define AHCI_PORT_TFD 0x20
+#define AHCI_PORT_SIG 0x24
+#define AHCI_PORT_SSTS 0x28
+#define AHCI_PORT_SERR 0x30
+#define AHCI_PORT_SACT 0x34
+#define AHCI_PORT_CI 0x38
+
+#define AHCI_PORT_CMD_ST 0x0001
+#define AHCI_PORT_CMD_FRE 0x0010
+#define AHCI_PORT_CMD_FR 0x4000
+#define AHCI_PORT_CMD_CR 0x8000
+
+// Interrupt status, a register FIS ends a plain command, set device bits ends queued ones
+#define AHCI_PORT_IS_DHRS 0x00000001
+#define AHCI_PORT_IS_SDBS 0x00000008
+#define AHCI_PORT_IS_IFS 0x08000000
+#define AHCI_PORT_IS_HBDS 0x10000000
+#define AHCI_PORT_IS_HBFS 0x20000000
+#define AHCI_PORT_IS_TFES 0x40000000
+#define AHCI_PORT_IS_ERRORS (AHCI_PORT_IS_IFS | AHCI_PORT_IS_HBDS | AHCI_PORT_IS_HBFS | AHCI_PORT_IS_TFES)
+
+#define AHCI_PORT_TFD_ERR 0x01
+#define AHCI_PORT_TFD_DRQ 0x08
+#define AHCI_PORT_TFD_BSY 0x80
+
+// A device is there and the phy is talking to it
+#define AHCI_SSTS_DET_MASK 0x0F
+#define AHCI_SSTS_DET_PRESENT 0x03
+
+// Signature of a plain ATA disk, ATAPI and port multipliers are left alone
+#define AHCI_SIG_ATA 0x00000101
+
+#define AHCI_FIS_TYPE_REG_H2D 0x27
+#define AHCI_FIS_H2D_COMMAND 0x80
+
+#define ATA_COMMAND_IDENTIFY 0xEC
+#define ATA_COMMAND_READ_DMA_EXT 0x25
+#define ATA_COMMAND_READ_FPDMA_QUEUED 0x60
+#define ATA_COMMAND_WRITE_DMA_EXT 0x35
+#define ATA_COMMAND_WRITE_FPDMA_QUEUED 0x61
+#define ATA_COMMAND_FLUSH_CACHE_EXT 0xEA
+#define ATA_DEVICE_LBA 0x40
+
+// Words of the IDENTIFY DEVICE data
+#define ATA_IDENTIFY_QUEUE_DEPTH 75
+#define ATA_IDENTIFY_SATA_CAPABILITIES 76
+#define ATA_IDENTIFY_LBA28_SECTORS 60
+#define ATA_IDENTIFY_LBA48_SECTORS 100
+#define ATA_IDENTIFY_QUEUE_DEPTH_MASK 0x1F
+#define ATA_IDENTIFY_SATA_NCQ (1 << 8)
+
+#define AHCI_MAX_PORTS 32
+#define AHCI_MAX_SLOTS 32
+
+// A command table with 24 descriptors is 512 bytes, eight of them fit a page
+#define AHCI_MAX_PRDS 24
+#define AHCI_COMMAND_TABLE_SIZE 512
+
+// Sectors moved by one command, 64KB touches at most 17 pages
+#define AHCI_MAX_SECTORS 128
+
+// Command header flags, the FIS length is in dwords
+#define AHCI_COMMAND_HEADER_FIS_LENGTH_MASK 0x1F
+#define AHCI_COMMAND_HEADER_WRITE 0x40
+
+// How long the command engine of a port may take to stop or the drive to answer IDENTIFY
+#define AHCI_TIMEOUT_MS 500
+
+struct ahci_command_header
+{
+    uint16_t flags;
+    uint16_t prdt_length;
+    volatile uint32_t prd_byte_count;
+    uint32_t table_address_low;
+    uint32_t table_address_high;
+    uint32_t reserved[4];
+} __attribute__((packed));
+
+struct ahci_prd
+{
+    uint32_t address_low;
+    uint32_t address_high;
+    uint32_t reserved;
+    uint32_t byte_count;
+} __attribute__((packed));
+
+struct ahci_command_table
+{
+    uint8_t command_fis[64];
+    uint8_t atapi_command[16];
+    uint8_t reserved[48];
+    struct ahci_prd prdt[AHCI_MAX_PRDS];
+} __attribute__((packed));
+
+/**
+ * Register FIS sent from the host to the device, carries an ATA command
+ */
+struct ahci_fis_h2d
+{
+    uint8_t type;
+    uint8_t flags;
+    uint8_t command;
+    uint8_t feature_low;
+    uint8_t lba0;
+    uint8_t lba1;
+    uint8_t lba2;
+    uint8_t device;
+    uint8_t lba3;
+    uint8_t lba4;
+    uint8_t lba5;
+    uint8_t feature_high;
+    uint8_t count_low;
+    uint8_t count_high;
+    uint8_t icc;
+    uint8_t control;
+    uint32_t reserved;
+} __attribute__((packed));
+
+struct ahci_hba;
+struct disk;
+struct pci_device;
+struct blk_command;
+
+/**
+ * A port with an ATA disk on it. Every command slot is its own outstanding
+ * command, with NCQ the slot number doubles as the tag the drive sees.
+ */
+struct ahci_port
+{
+    struct ahci_hba* hba;
+    int index;
+
+    // Address of the registers of this port
+    uintptr_t registers;
+
+    struct ahci_command_header* command_list;
+    struct ahci_command_table* tables[AHCI_MAX_SLOTS];
+
+    bool ncq;
+    int queue_depth;
+    uint64_t total_sectors;
+
+    // The slots readers may use, one bit per slot
+    uint32_t slot_mask;
+
+    // Slots a reader owns, issued or not yet collected
+    uint32_t busy;
+
+    // Slots the HBA is working on
+    uint32_t issued;
+
+    // Slots the HBA finished, waiting for their reader to collect them
+    uint32_t completed;
+    uint32_t failed;
+
+    // The request queue command each slot carries a part of, NULL for a reader of our own
+    struct blk_command* commands[AHCI_MAX_SLOTS];
+
+    // Request queue commands waiting for a free slot, or with parts still to issue
+    struct blk_command* pending;
+    struct blk_command* pending_tail;
+
+    // Flushes claiming the slots, pending commands wait for them
+    int flushing;
+
+    // Guards the slot masks between readers and the interrupt handler
+    struct spinlock lock;
+
+    // Readers waiting for a completion or a free slot
+    struct waitqueue waiters;
+
+    struct disk* disk;
+};
+
+struct ahci_hba
+{
+    struct pci_device* pci;
+    uintptr_t abar;
+    int command_slots;
+    bool supports_64bit;
+    bool supports_ncq;
+
+    // The message signalled vector, zero when completions are polled
+    int vector;
+
+    struct ahci_port* ports[AHCI_MAX_PORTS];
+    struct ahci_hba* next;
+};
+
+/**
+ * Finds every AHCI controller on the PCI buses and creates a disk for each
+ * ATA drive on them
+ * \return Returns -ENOTFOUND when there is no controller
+ */
+int ahci_init();
+
+/**
+ * Reads sectors of the disk on the port. The read is split over as many
+ * command slots as are free and all of them are issued before waiting,
+ * other readers get the rest of the slots at the same time.
+ */
+int ahci_read(struct ahci_port* port, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors of the disk on the port, split over the free slots like a read
+ */
+int ahci_write(struct ahci_port* port, uint64_t lba, int total, void* buf);
+
+/**
+ * Issues a command of the request queue and returns, the interrupt handler
+ * completes it. It is split over as many slots as it needs and waits on
+ * the port for the ones that are not free yet.
+ * \return Returns -EUNIMP when the completions of the HBA are polled
+ */
+int ahci_submit(struct ahci_port* port, struct blk_command* command);
+
+/**
+ * Completes the request queue commands the HBA has finished
+ */
+void ahci_poll(struct ahci_port* port);
+
+/**
+ * Makes the drive put its write cache on the media. FLUSH CACHE is not a
+ * queued command, so it waits for every slot of the port to be free and
+ * holds all of them while it runs.
+ */
+int ahci_flush(struct ahci_port* port);
+
+#endif
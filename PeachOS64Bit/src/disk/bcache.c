@@ -0,0 +1,785 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "bcache.h"
+#include "disk.h"
+#include "kernel.h"
+#include "status.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "task/task.h"
+#include "task/waitqueue.h"
+#include "task/workqueue.h"
+#include "lib/spinlock/spinlock.h"
+#include "timer/ktime.h"
+
+static struct bcache_buffer* bcache_buffers = NULL;
+static struct bcache_buffer* bcache_hash[BCACHE_HASH_BUCKETS];
+
+// Index of the next buffer the CLOCK hand looks at
+static int bcache_hand = 0;
+
+static struct bcache_stats bcache_stats;
+
+// Guards the hash, the buffer heads and the statistics, never held across device reads
+static struct spinlock bcache_lock;
+
+// Tasks waiting for a block someone else is reading, or for writeback to finish
+static struct waitqueue bcache_waiters;
+
+// Writes dirty blocks back on its own queue, the worker does the device writes itself
+static struct workqueue* bcache_writeback_queue = NULL;
+static struct delayed_work bcache_writeback_dwork;
+
+int bcache_init()
+{
+    int res = 0;
+    spinlock_init(&bcache_lock, "bcache");
+    waitqueue_init(&bcache_waiters);
+    bcache_buffers = kzalloc(sizeof(struct bcache_buffer) * PEACHOS_BCACHE_BUFFERS);
+    if (!bcache_buffers)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    for (int i = 0; i < PEACHOS_BCACHE_BUFFERS; i++)
+    {
+        bcache_buffers[i].data = kzalloc(PEACHOS_BCACHE_BLOCK_SIZE);
+        if (!bcache_buffers[i].data)
+        {
+            res = -ENOMEM;
+            goto out;
+        }
+    }
+
+out:
+    if (res < 0)
+    {
+        // Without buffers every read goes straight to the device
+        bcache_buffers = NULL;
+    }
+    return res;
+}
+
+static int bcache_bucket(struct disk* device, uint64_t block)
+{
+    return (block ^ ((uintptr_t) device >> 4)) & (BCACHE_HASH_BUCKETS - 1);
+}
+
+/**
+ * The lock must be held
+ */
+static struct bcache_buffer* bcache_lookup(struct disk* device, uint64_t block)
+{
+    for (struct bcache_buffer* buffer = bcache_hash[bcache_bucket(device, block)]; buffer; buffer = buffer->hash_next)
+    {
+        if (buffer->device == device && buffer->block == block)
+        {
+            return buffer;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * The lock must be held
+ */
+static void bcache_unhash(struct bcache_buffer* buffer)
+{
+    struct bcache_buffer** link = &bcache_hash[bcache_bucket(buffer->device, buffer->block)];
+    while (*link)
+    {
+        if (*link == buffer)
+        {
+            *link = buffer->hash_next;
+            break;
+        }
+        link = &(*link)->hash_next;
+    }
+
+    buffer->hash_next = NULL;
+    buffer->device = NULL;
+    buffer->valid = false;
+}
+
+/**
+ * Runs the CLOCK hand until it finds an unreferenced buffer, recently used
+ * buffers get a second chance. The lock must be held.
+ * \return Returns NULL when every buffer is in use
+ */
+static struct bcache_buffer* bcache_evict()
+{
+    // Two sweeps clear every second chance bit, a third would find nothing new
+    for (int i = 0; i < PEACHOS_BCACHE_BUFFERS * 2; i++)
+    {
+        struct bcache_buffer* buffer = &bcache_buffers[bcache_hand];
+        bcache_hand = (bcache_hand + 1) % PEACHOS_BCACHE_BUFFERS;
+        // Dirty data has nowhere else to go until it is written back
+        if (buffer->refcount > 0 || buffer->loading || buffer->dirty || buffer->writing)
+        {
+            continue;
+        }
+
+        if (buffer->referenced)
+        {
+            buffer->referenced = false;
+            continue;
+        }
+
+        if (buffer->device)
+        {
+            bcache_unhash(buffer);
+            bcache_stats.evictions++;
+        }
+        return buffer;
+    }
+
+    return NULL;
+}
+
+static int bcache_sectors_per_block(struct disk* device)
+{
+    return PEACHOS_BCACHE_BLOCK_SIZE / device->sector_size;
+}
+
+/**
+ * Takes a reference on the block if it is cached, waiting while another
+ * task reads it in
+ * \return Returns NULL when the block is not cached
+ */
+static struct bcache_buffer* bcache_acquire(struct disk* device, uint64_t block, bool count_hit)
+{
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    struct bcache_buffer* buffer = bcache_lookup(device, block);
+    while (buffer && buffer->loading)
+    {
+        // The read may have failed and the block gone by the time we wake
+        waitqueue_add(&bcache_waiters, task_current());
+        spin_unlock_irqrestore(&bcache_lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&bcache_lock);
+        buffer = bcache_lookup(device, block);
+    }
+
+    if (buffer)
+    {
+        buffer->refcount++;
+        buffer->referenced = true;
+        if (count_hit)
+        {
+            bcache_stats.hits++;
+        }
+    }
+    spin_unlock_irqrestore(&bcache_lock, flags);
+    return buffer;
+}
+
+/**
+ * The request of a buffer finished, it is valid or dropped from the cache
+ */
+static void bcache_request_done(struct blk_request* request)
+{
+    struct bcache_buffer* buffer = request->private;
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    buffer->loading = false;
+    if (request->result < 0)
+    {
+        bcache_unhash(buffer);
+    }
+    else
+    {
+        buffer->valid = true;
+    }
+    waitqueue_wake_all(&bcache_waiters);
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
+
+/**
+ * Submits reads of the missing blocks from the first one onwards, stopping
+ * at the first block already cached. They are submitted under one plug so
+ * the request queue merges them into a single command.
+ * \param counter The statistic the submitted blocks are added to
+ * \param first_out When given, waits for the first block and receives it referenced.
+ *                  Stays NULL when the first block was cached already.
+ * \return Returns the number of blocks submitted or a negative error code
+ */
+static int bcache_fill_run(struct disk* device, uint64_t block, int count, uint64_t* counter, struct bcache_buffer** first_out)
+{
+    int res = 0;
+    struct bcache_buffer* buffers[BCACHE_MAX_RUN_BLOCKS];
+    int total = 0;
+    if (first_out)
+    {
+        *first_out = NULL;
+    }
+
+    if (count > BCACHE_MAX_RUN_BLOCKS)
+    {
+        count = BCACHE_MAX_RUN_BLOCKS;
+    }
+
+    // Hashed as loading before the read so others wait for it rather than reading it twice
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    while (total < count && !bcache_lookup(device, block + total))
+    {
+        struct bcache_buffer* buffer = bcache_evict();
+        if (!buffer)
+        {
+            break;
+        }
+
+        buffer->device = device;
+        buffer->block = block + total;
+        buffer->refcount = 0;
+        buffer->referenced = true;
+        buffer->loading = true;
+        buffer->hash_next = bcache_hash[bcache_bucket(device, buffer->block)];
+        bcache_hash[bcache_bucket(device, buffer->block)] = buffer;
+        buffers[total++] = buffer;
+    }
+    bool cached = total == 0 && bcache_lookup(device, block);
+    if (total > 0)
+    {
+        *counter += total;
+
+        // Our reference keeps the first block from being evicted before we look at it
+        if (first_out)
+        {
+            buffers[0]->refcount = 1;
+        }
+    }
+    spin_unlock_irqrestore(&bcache_lock, flags);
+
+    if (total == 0)
+    {
+        // Either someone else has the first block or every buffer is in use
+        return cached ? 0 : -ENOMEM;
+    }
+
+    int sectors = bcache_sectors_per_block(device);
+    blk_plug(device);
+    for (int i = 0; i < total; i++)
+    {
+        struct blk_request* request = &buffers[i]->request;
+        blk_request_init(request, device, BLK_REQUEST_READ, buffers[i]->block * sectors, sectors, buffers[i]->data);
+        request->callback = bcache_request_done;
+        request->private = buffers[i];
+        blk_submit(request);
+    }
+    blk_unplug(device);
+
+    if (first_out)
+    {
+        res = blk_request_wait(&buffers[0]->request);
+        if (res < 0)
+        {
+            bcache_put(buffers[0]);
+            return res;
+        }
+
+        *first_out = buffers[0];
+    }
+
+    return total;
+}
+
+struct bcache_buffer* bcache_get(struct disk* device, uint64_t block)
+{
+    if (!bcache_buffers)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    struct bcache_buffer* buffer = bcache_acquire(device, block, true);
+    while (!buffer)
+    {
+        int res = bcache_fill_run(device, block, 1, &bcache_stats.misses, &buffer);
+        if (res < 0)
+        {
+            return ERROR(res);
+        }
+
+        if (!buffer)
+        {
+            // Someone else had it, it may be evicted again before we get to it if the cache is very busy
+            buffer = bcache_acquire(device, block, false);
+        }
+    }
+
+    return buffer;
+}
+
+void bcache_put(struct bcache_buffer* buffer)
+{
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    if (buffer->refcount <= 0)
+    {
+        panic("bcache_put(): The buffer has no references\n");
+    }
+
+    buffer->refcount--;
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
+
+int bcache_read(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    int res = 0;
+    int sectors_per_block = bcache_sectors_per_block(device);
+    uint64_t last_block = (lba + total - 1) / sectors_per_block;
+    while (total > 0)
+    {
+        uint64_t block = lba / sectors_per_block;
+        int first = lba % sectors_per_block;
+        int count = sectors_per_block - first;
+        if (count > total)
+        {
+            count = total;
+        }
+
+        struct bcache_buffer* buffer = NULL;
+        if (bcache_buffers)
+        {
+            buffer = bcache_acquire(device, block, true);
+            if (!buffer && bcache_fill_run(device, block, last_block - block + 1, &bcache_stats.misses, &buffer) == 0)
+            {
+                buffer = bcache_acquire(device, block, false);
+            }
+        }
+
+        if (!buffer)
+        {
+            // No buffer to be had, or the whole block is not readable such as at the end of the disk
+            res = blk_read(device, lba, count, buf);
+            if (res < 0)
+            {
+                goto out;
+            }
+        }
+        else
+        {
+            memcpy(buf, buffer->data + first * device->sector_size, count * device->sector_size);
+            bcache_put(buffer);
+        }
+
+        buf += count * device->sector_size;
+        lba += count;
+        total -= count;
+    }
+
+out:
+    return res;
+}
+
+/**
+ * Hashes a buffer for a block that is about to be written whole, nothing is
+ * read. It stays loading until bcache_mark_dirty() so readers wait for the data.
+ * \return Returns NULL when the block turned out to be cached, -ENOMEM when
+ *         every buffer is in use or dirty
+ */
+static struct bcache_buffer* bcache_claim(struct disk* device, uint64_t block)
+{
+    struct bcache_buffer* buffer = NULL;
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    if (bcache_lookup(device, block))
+    {
+        goto out;
+    }
+
+    buffer = bcache_evict();
+    if (!buffer)
+    {
+        buffer = ERROR(-ENOMEM);
+        goto out;
+    }
+
+    buffer->device = device;
+    buffer->block = block;
+    buffer->refcount = 1;
+    buffer->referenced = true;
+    buffer->loading = true;
+    buffer->hash_next = bcache_hash[bcache_bucket(device, block)];
+    bcache_hash[bcache_bucket(device, block)] = buffer;
+    bcache_stats.misses++;
+
+out:
+    spin_unlock_irqrestore(&bcache_lock, flags);
+    return buffer;
+}
+
+/**
+ * The buffer holds newer data than the device, a claimed buffer becomes valid
+ */
+static void bcache_mark_dirty(struct bcache_buffer* buffer)
+{
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    if (!buffer->dirty)
+    {
+        buffer->dirty = true;
+        bcache_stats.dirty++;
+    }
+    bcache_stats.writes++;
+
+    if (buffer->loading)
+    {
+        buffer->loading = false;
+        buffer->valid = true;
+        waitqueue_wake_all(&bcache_waiters);
+    }
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
+
+/**
+ * A writeback finished. A failed block stays in the cache as it is but is no
+ * longer dirty, retrying a bad sector forever would hold the buffer for good.
+ */
+static void bcache_writeback_done(struct blk_request* request)
+{
+    struct bcache_buffer* buffer = request->private;
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    buffer->writing = false;
+    if (request->result < 0)
+    {
+        bcache_stats.write_errors++;
+    }
+    waitqueue_wake_all(&bcache_waiters);
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
+
+/**
+ * Submits writes of the dirty blocks of the device, of every device when
+ * NULL. The blocks of one device go out under a single plug so the request
+ * queue sorts them and merges neighbours into large commands. Blocks
+ * already being written are left for the next round.
+ * \return Returns the number of blocks submitted
+ */
+static int bcache_writeback_start(struct disk* device)
+{
+    int started = 0;
+
+    // Writers dirtying blocks as fast as we write them cannot keep us here for good
+    while (started < PEACHOS_BCACHE_BUFFERS)
+    {
+        struct bcache_buffer* batch[BCACHE_WRITEBACK_BATCH];
+        struct disk* target = device;
+        int total = 0;
+        uint64_t flags = spin_lock_irqsave(&bcache_lock);
+        for (int i = 0; i < PEACHOS_BCACHE_BUFFERS && total < BCACHE_WRITEBACK_BATCH; i++)
+        {
+            struct bcache_buffer* buffer = &bcache_buffers[i];
+            if (!buffer->dirty || buffer->writing || (target && buffer->device != target))
+            {
+                continue;
+            }
+
+            target = buffer->device;
+            buffer->dirty = false;
+            buffer->writing = true;
+            bcache_stats.dirty--;
+            bcache_stats.writeback++;
+            batch[total++] = buffer;
+        }
+        spin_unlock_irqrestore(&bcache_lock, flags);
+
+        if (total == 0)
+        {
+            break;
+        }
+
+        int sectors = bcache_sectors_per_block(target);
+        blk_plug(target);
+        for (int i = 0; i < total; i++)
+        {
+            struct blk_request* request = &batch[i]->request;
+            blk_request_init(request, target, BLK_REQUEST_WRITE, batch[i]->block * sectors, sectors, batch[i]->data);
+            request->callback = bcache_writeback_done;
+            request->private = batch[i];
+            blk_submit(request);
+        }
+        blk_unplug(target);
+        started += total;
+    }
+
+    return started;
+}
+
+/**
+ * Looks for buffers of the device, of any device when NULL, that are dirty
+ * or being written. The lock must be held.
+ */
+static bool bcache_has_dirty(struct disk* device, bool writing)
+{
+    for (int i = 0; i < PEACHOS_BCACHE_BUFFERS; i++)
+    {
+        struct bcache_buffer* buffer = &bcache_buffers[i];
+        if ((writing ? buffer->writing : buffer->dirty) && (!device || buffer->device == device))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Waits until no block of the device is being written back
+ */
+static void bcache_writeback_wait(struct disk* device)
+{
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    while (bcache_has_dirty(device, true))
+    {
+        if (!task_can_sleep())
+        {
+            // Boot code dispatched its own writes, whatever is left finishes without us
+            spin_unlock_irqrestore(&bcache_lock, flags);
+            __builtin_ia32_pause();
+            flags = spin_lock_irqsave(&bcache_lock);
+            continue;
+        }
+
+        waitqueue_add(&bcache_waiters, task_current());
+        spin_unlock_irqrestore(&bcache_lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&bcache_lock);
+    }
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
+
+/**
+ * Queues the periodic writeback, straight away when too much of the cache is dirty
+ */
+static void bcache_writeback_kick()
+{
+    if (!bcache_writeback_queue)
+    {
+        return;
+    }
+
+    uint64_t ticks = ktime_ns_to_ticks(PEACHOS_BCACHE_WRITEBACK_MS * 1000000ULL);
+    if (bcache_stats.dirty > PEACHOS_BCACHE_DIRTY_LIMIT)
+    {
+        ticks = 0;
+    }
+
+    // Already waiting on its timer or queued, the blocks go out with that run
+    queue_delayed_work(bcache_writeback_queue, &bcache_writeback_dwork, ticks);
+}
+
+static void bcache_writeback_work(struct work* work)
+{
+    bcache_writeback_start(NULL);
+
+    // Blocks written again while we were at it wait for the next period
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    bool dirty = bcache_has_dirty(NULL, false);
+    spin_unlock_irqrestore(&bcache_lock, flags);
+    if (dirty)
+    {
+        bcache_writeback_kick();
+    }
+}
+
+void bcache_writeback_init()
+{
+    if (!bcache_buffers)
+    {
+        return;
+    }
+
+    struct workqueue* queue = workqueue_create("writeback");
+    if (ISERR(queue))
+    {
+        print("No writeback task, dirty blocks wait for a sync\n");
+        return;
+    }
+
+    delayed_work_init(&bcache_writeback_dwork, bcache_writeback_work);
+    bcache_writeback_queue = queue;
+    if (bcache_stats.dirty)
+    {
+        // Written during boot
+        bcache_writeback_kick();
+    }
+}
+
+/**
+ * Returns a referenced buffer for the block ready to be written into. A
+ * block written whole is not read first. When every buffer is dirty the
+ * caller writes the cache back itself and tries again.
+ * \return Returns NULL when no buffer can be had or the block cannot be read
+ */
+static struct bcache_buffer* bcache_get_for_write(struct disk* device, uint64_t block, bool whole)
+{
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        struct bcache_buffer* buffer = NULL;
+        if (whole)
+        {
+            buffer = bcache_acquire(device, block, true);
+            if (!buffer)
+            {
+                buffer = bcache_claim(device, block);
+            }
+
+            if (!buffer)
+            {
+                // Someone else brought it in between
+                buffer = bcache_acquire(device, block, false);
+            }
+        }
+        else
+        {
+            buffer = bcache_get(device, block);
+        }
+
+        if (buffer && !ISERR(buffer))
+        {
+            return buffer;
+        }
+
+        if (ISERR(buffer) && ERROR_I(buffer) != -ENOMEM)
+        {
+            // The rest of the block could not be read
+            return NULL;
+        }
+
+        bcache_writeback_start(NULL);
+        bcache_writeback_wait(NULL);
+    }
+
+    return NULL;
+}
+
+int bcache_write(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    int res = 0;
+    int sectors_per_block = bcache_sectors_per_block(device);
+    while (total > 0)
+    {
+        uint64_t block = lba / sectors_per_block;
+        int first = lba % sectors_per_block;
+        int count = sectors_per_block - first;
+        if (count > total)
+        {
+            count = total;
+        }
+
+        struct bcache_buffer* buffer = NULL;
+        if (bcache_buffers)
+        {
+            buffer = bcache_get_for_write(device, block, count == sectors_per_block);
+        }
+
+        if (!buffer)
+        {
+            // No buffer to be had, or the block is not readable such as at the end of the disk
+            res = blk_write(device, lba, count, buf);
+            if (res < 0)
+            {
+                goto out;
+            }
+        }
+        else
+        {
+            memcpy(buffer->data + first * device->sector_size, buf, count * device->sector_size);
+            bcache_mark_dirty(buffer);
+            bcache_put(buffer);
+        }
+
+        buf += count * device->sector_size;
+        lba += count;
+        total -= count;
+    }
+
+out:
+    bcache_writeback_kick();
+    return res;
+}
+
+int bcache_sync(struct disk* device)
+{
+    if (!bcache_buffers)
+    {
+        return 0;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    uint64_t errors = bcache_stats.write_errors;
+    bool dirty = bcache_has_dirty(device, false);
+    spin_unlock_irqrestore(&bcache_lock, flags);
+
+    // Blocks written again while their writeback was in flight need another round
+    while (dirty)
+    {
+        bcache_writeback_start(device);
+        bcache_writeback_wait(device);
+
+        flags = spin_lock_irqsave(&bcache_lock);
+        dirty = bcache_has_dirty(device, false);
+        spin_unlock_irqrestore(&bcache_lock, flags);
+    }
+
+    // Writeback that was already in flight counts too
+    bcache_writeback_wait(device);
+    flags = spin_lock_irqsave(&bcache_lock);
+    bool failed = bcache_stats.write_errors != errors;
+    spin_unlock_irqrestore(&bcache_lock, flags);
+    return failed ? -EIO : 0;
+}
+
+void bcache_prefetch(struct disk* device, uint64_t lba, int total)
+{
+    if (!bcache_buffers || total <= 0)
+    {
+        return;
+    }
+
+    int sectors_per_block = bcache_sectors_per_block(device);
+    uint64_t block = lba / sectors_per_block;
+    uint64_t last_block = (lba + total - 1) / sectors_per_block;
+    while (block <= last_block)
+    {
+        int res = bcache_fill_run(device, block, last_block - block + 1, &bcache_stats.readahead, NULL);
+        if (res < 0)
+        {
+            // Out of buffers or past the end of the disk, the reader will find out for itself
+            break;
+        }
+
+        // Zero when the block was cached already
+        block += res ? res : 1;
+    }
+}
+
+void bcache_get_stats(struct bcache_stats* stats_out)
+{
+    uint64_t flags = spin_lock_irqsave(&bcache_lock);
+    memcpy(stats_out, &bcache_stats, sizeof(struct bcache_stats));
+    spin_unlock_irqrestore(&bcache_lock, flags);
+}
@@ -0,0 +1,152 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_BCACHE_H
+#define KERNEL_BCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "config.h"
+#include "blkqueue.h"
+
+// Buckets of the (device, block) hash, must be a power of two
+#define BCACHE_HASH_BUCKETS 64
+
+// Most blocks filled together, their requests merge into one device command
+#define BCACHE_MAX_RUN_BLOCKS 16
+
+// Dirty blocks of a device submitted under one plug, the request queue sorts and merges them
+#define BCACHE_WRITEBACK_BATCH 64
+
+struct disk;
+
+/**
+ * A buffer head, one cached block of a device. A buffer with references
+ * is never evicted, the CLOCK hand only takes unreferenced clean ones.
+ */
+struct bcache_buffer
+{
+    // The physical disk and the block number on it, in PEACHOS_BCACHE_BLOCK_SIZE units
+    struct disk* device;
+    uint64_t block;
+
+    int refcount;
+
+    // True once the data has been read from the device
+    bool valid;
+
+    // True while the block is being read, other users of it wait
+    bool loading;
+
+    // Second chance bit for the CLOCK hand, set on every use
+    bool referenced;
+
+    // True while the data is newer than the device, set again when written during writeback
+    bool dirty;
+
+    // True while the block is being written back
+    bool writing;
+
+    struct bcache_buffer* hash_next;
+    void* data;
+
+    // Reads the block in or writes it back, only in use while loading or writing
+    struct blk_request request;
+};
+
+struct bcache_stats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+
+    // Blocks read ahead of being asked for
+    uint64_t readahead;
+
+    // Blocks written into the cache, and written back from it to the devices
+    uint64_t writes;
+    uint64_t writeback;
+    uint64_t write_errors;
+
+    // Buffers dirty right now
+    int dirty;
+};
+
+/**
+ * Allocates every buffer of the cache
+ */
+int bcache_init();
+
+/**
+ * Returns a referenced buffer holding the block, reading it on a miss
+ * \return Returns the buffer or an error pointer, -ENOMEM when every buffer is in use
+ */
+struct bcache_buffer* bcache_get(struct disk* device, uint64_t block);
+
+/**
+ * Drops a reference taken by bcache_get()
+ */
+void bcache_put(struct bcache_buffer* buffer);
+
+/**
+ * Copies sectors of the device through the cache. Consecutive missing
+ * blocks are submitted together and merge into a single device command.
+ * Falls back to reading the device directly when no buffer can be had.
+ */
+int bcache_read(struct disk* device, uint64_t lba, int total, void* buf);
+
+/**
+ * Copies sectors into the cache and marks their blocks dirty, blocks only
+ * partly written are read in first. Returns without touching the device
+ * unless the cache is full of dirty blocks, then the writer writes some back
+ * itself. Falls back to writing the device directly when no buffer can be had.
+ */
+int bcache_write(struct disk* device, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes back every dirty block of the device and waits for them
+ * \return Returns -EIO when one of the writes failed
+ */
+int bcache_sync(struct disk* device);
+
+/**
+ * Starts the periodic writeback of dirty blocks, needs the workqueues. Until
+ * then dirty blocks only reach the device through bcache_sync().
+ */
+void bcache_writeback_init();
+
+/**
+ * Submits reads of the blocks covering the sectors and returns once they
+ * are queued, blocks already cached are skipped. Readers of a block still
+ * on its way wait for it. Boot code reads them before returning.
+ */
+void bcache_prefetch(struct disk* device, uint64_t lba, int total);
+
+void bcache_get_stats(struct bcache_stats* stats_out);
+
+#endif
@@ -0,0 +1,565 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "blkqueue.h"
+#include "disk.h"
+#include "kernel.h"
+#include "status.h"
+#include "cpu/cpu.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "task/task.h"
+#include "timer/ktime.h"
+
+// Runs the deferred commands of every queue, NULL until blk_workqueue_init()
+static struct workqueue* blk_workqueue = NULL;
+
+static void blk_queue_work(struct work* work);
+
+int blk_queue_init(struct disk* device, int max_depth)
+{
+    struct blk_queue* queue = kzalloc(sizeof(struct blk_queue));
+    if (!queue)
+    {
+        return -ENOMEM;
+    }
+
+    if (max_depth < 1)
+    {
+        max_depth = 1;
+    }
+
+    if (max_depth > BLK_QUEUE_MAX_DEPTH)
+    {
+        max_depth = BLK_QUEUE_MAX_DEPTH;
+    }
+
+    queue->device = device;
+    queue->max_depth = max_depth;
+    queue->free_slots = max_depth >= 32 ? 0xFFFFFFFF : (1U << max_depth) - 1;
+    for (int slot = 0; slot < max_depth; slot++)
+    {
+        queue->commands[slot].queue = queue;
+        queue->commands[slot].slot = slot;
+
+        // A slot without one only merges requests whose buffers follow on
+        queue->bounce[slot] = kzalloc(BLK_QUEUE_MAX_SECTORS * device->sector_size);
+    }
+
+    spinlock_init(&queue->lock, "blk queue");
+    waitqueue_init(&queue->waiters);
+    work_init(&queue->work, blk_queue_work);
+    device->queue = queue;
+    return 0;
+}
+
+void blk_workqueue_init()
+{
+    struct workqueue* workqueue = workqueue_create("blkio");
+    if (ISERR(workqueue))
+    {
+        panic("Failed to create the block I/O workqueue\n");
+    }
+
+    blk_workqueue = workqueue;
+}
+
+void blk_request_init(struct blk_request* request, struct disk* device, int op, uint64_t lba, int total, void* buf)
+{
+    memset(request, 0, sizeof(struct blk_request));
+    request->device = device;
+    request->op = op;
+    request->lba = lba;
+    request->total = total;
+    request->buf = buf;
+}
+
+/**
+ * Links the request in after every request at or below its LBA, the lock must be held
+ */
+static void blk_queue_insert(struct blk_queue* queue, struct blk_request* request)
+{
+    struct blk_request** link = &queue->head;
+    while (*link && (*link)->lba <= request->lba)
+    {
+        link = &(*link)->next;
+    }
+
+    request->next = *link;
+    *link = request;
+    queue->stats.queued++;
+}
+
+/**
+ * Takes the next command off the queue, the first request at or above the
+ * sweep position along with the adjacent ones after it. The lock must be held.
+ * \param bounce False when the slot has no bounce buffer, only requests whose buffers follow on merge
+ * \return Returns the requests linked through next, sectors_out receives their total
+ */
+static struct blk_request* blk_queue_pick(struct blk_queue* queue, bool bounce, int* sectors_out)
+{
+    struct blk_request** link = &queue->head;
+    while (*link && (*link)->lba < queue->position)
+    {
+        link = &(*link)->next;
+    }
+
+    if (!*link)
+    {
+        // Nothing above, the sweep starts again from the bottom
+        link = &queue->head;
+    }
+
+    struct blk_request* first = *link;
+    struct blk_request* last = first;
+    int sectors = first->total;
+    int requests = 1;
+    while (last->next && last->next->op == first->op && last->next->lba == last->lba + last->total &&
+           sectors + last->next->total <= BLK_QUEUE_MAX_SECTORS &&
+           (bounce || last->next->buf == last->buf + last->total * queue->device->sector_size))
+    {
+        last = last->next;
+        sectors += last->total;
+        requests++;
+    }
+
+    *link = last->next;
+    last->next = NULL;
+    queue->stats.queued -= requests;
+    queue->stats.merges += requests - 1;
+    *sectors_out = sectors;
+    return first;
+}
+
+static int blk_device_transfer(struct disk* device, int op, uint64_t lba, int total, void* buf)
+{
+    if (op == BLK_REQUEST_WRITE)
+    {
+        return disk_write_device(device, lba, total, buf);
+    }
+
+    return disk_read_device(device, lba, total, buf);
+}
+
+/**
+ * Points the command at the buffer it moves the data of its requests
+ * through, gathering the writes into the bounce buffer when theirs do not follow on
+ */
+static void blk_command_prepare(struct blk_command* command)
+{
+    struct blk_queue* queue = command->queue;
+    struct disk* device = queue->device;
+    command->buf = command->batch->buf;
+    for (struct blk_request* request = command->batch; request->next; request = request->next)
+    {
+        if (request->next->buf != request->buf + request->total * device->sector_size)
+        {
+            command->buf = queue->bounce[command->slot];
+            break;
+        }
+    }
+
+    if (command->buf == command->batch->buf || command->op != BLK_REQUEST_WRITE)
+    {
+        return;
+    }
+
+    void* data = command->buf;
+    for (struct blk_request* request = command->batch; request; request = request->next)
+    {
+        size_t size = request->total * device->sector_size;
+        memcpy(data, request->buf, size);
+        data += size;
+    }
+}
+
+/**
+ * Records the result of the command in each of its requests, scattering a
+ * bounced read back into their buffers
+ */
+static void blk_command_finish(struct blk_command* command)
+{
+    struct disk* device = command->queue->device;
+    bool bounced = command->buf != command->batch->buf;
+    void* data = command->buf;
+    for (struct blk_request* request = command->batch; request; request = request->next)
+    {
+        size_t size = request->total * device->sector_size;
+        if (bounced && command->result >= 0 && command->op == BLK_REQUEST_READ)
+        {
+            memcpy(request->buf, data, size);
+        }
+        request->result = command->result;
+        data += size;
+    }
+}
+
+static void blk_queue_complete(struct blk_queue* queue, struct blk_request* batch)
+{
+    uint64_t now = ktime_get_ns();
+    uint64_t end_tsc = cpu_read_tsc();
+    for (struct blk_request* request = batch; request; request = request->next)
+    {
+        disk_stats_complete(request, end_tsc);
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    for (struct blk_request* request = batch; request; request = request->next)
+    {
+        uint64_t latency = now - request->submitted_ns;
+        queue->stats.latency_total_ns += latency;
+        if (latency > queue->stats.latency_max_ns)
+        {
+            queue->stats.latency_max_ns = latency;
+        }
+
+        if (request->result < 0)
+        {
+            queue->stats.errors++;
+        }
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    struct blk_request* next = NULL;
+    for (struct blk_request* request = batch; request; request = next)
+    {
+        // The owner may reuse the request the moment it is done
+        next = request->next;
+        if (request->callback)
+        {
+            request->callback(request);
+        }
+        request->done = true;
+    }
+
+    flags = spin_lock_irqsave(&queue->lock);
+    waitqueue_wake_all(&queue->waiters);
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+/**
+ * Hands waiting requests to the driver while the device has room. Nothing
+ * here waits for the device, a queued request is dispatched by whoever
+ * completes the command ahead of it. Commands the driver cannot take go to
+ * the block I/O worker.
+ */
+static void blk_queue_run(struct blk_queue* queue)
+{
+    bool deferred = false;
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    while (queue->head && !queue->plugged && queue->depth < queue->max_depth)
+    {
+        int sectors = 0;
+        int slot = __builtin_ctz(queue->free_slots);
+        struct blk_command* command = &queue->commands[slot];
+        struct blk_request* batch = blk_queue_pick(queue, queue->bounce[slot] != NULL, &sectors);
+        queue->free_slots &= ~(1U << slot);
+        queue->depth++;
+        queue->position = batch->lba + sectors;
+        queue->stats.dispatches++;
+        queue->stats.sectors += sectors;
+        queue->stats.depth = queue->depth;
+        if (queue->depth > queue->stats.max_depth_seen)
+        {
+            queue->stats.max_depth_seen = queue->depth;
+        }
+        spin_unlock_irqrestore(&queue->lock, flags);
+
+        command->op = batch->op;
+        command->lba = batch->lba;
+        command->total = sectors;
+        command->batch = batch;
+        command->result = 0;
+        command->issued = 0;
+        command->outstanding = 0;
+        command->next = NULL;
+        blk_command_prepare(command);
+
+        uint64_t dispatched_tsc = cpu_read_tsc();
+        for (struct blk_request* request = batch; request; request = request->next)
+        {
+            request->dispatched_tsc = dispatched_tsc;
+        }
+
+        disk_stats_dispatch(queue->device);
+        int res = disk_submit_device(queue->device, command);
+        if (res == -EUNIMP)
+        {
+            flags = spin_lock_irqsave(&queue->lock);
+            if (queue->deferred_tail)
+            {
+                queue->deferred_tail->next = command;
+            }
+            else
+            {
+                queue->deferred = command;
+            }
+            queue->deferred_tail = command;
+            spin_unlock_irqrestore(&queue->lock, flags);
+            deferred = true;
+        }
+        else if (res < 0)
+        {
+            command->result = res;
+            blk_command_complete(command);
+        }
+
+        flags = spin_lock_irqsave(&queue->lock);
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    if (deferred && blk_workqueue)
+    {
+        queue_work(blk_workqueue, &queue->work);
+    }
+}
+
+void blk_command_complete(struct blk_command* commands)
+{
+    struct blk_command* next = NULL;
+    for (struct blk_command* command = commands; command; command = next)
+    {
+        struct blk_queue* queue = command->queue;
+        struct blk_request* batch = command->batch;
+        next = command->next;
+        disk_stats_done(queue->device);
+        blk_command_finish(command);
+
+        // The slot may be dispatched again from here on, the requests are ours to complete
+        uint64_t flags = spin_lock_irqsave(&queue->lock);
+        queue->free_slots |= 1U << command->slot;
+        queue->depth--;
+        queue->stats.depth = queue->depth;
+        spin_unlock_irqrestore(&queue->lock, flags);
+
+        blk_queue_complete(queue, batch);
+        blk_queue_run(queue);
+    }
+}
+
+/**
+ * Runs the deferred commands of the queue one after the other, each for as
+ * long as the device takes
+ */
+static void blk_queue_run_deferred(struct blk_queue* queue)
+{
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    while (queue->deferred)
+    {
+        struct blk_command* command = queue->deferred;
+        queue->deferred = command->next;
+        if (!queue->deferred)
+        {
+            queue->deferred_tail = NULL;
+        }
+        command->next = NULL;
+        spin_unlock_irqrestore(&queue->lock, flags);
+
+        command->result = blk_device_transfer(queue->device, command->op, command->lba, command->total, command->buf);
+        blk_command_complete(command);
+
+        flags = spin_lock_irqsave(&queue->lock);
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+static void blk_queue_work(struct work* work)
+{
+    // The work is the first member
+    blk_queue_run_deferred((struct blk_queue*) work);
+}
+
+/**
+ * Dispatches and finishes everything on the queue without sleeping, for
+ * boot code where nothing would complete the commands or wake us. Requests
+ * held back by a plug are left to blk_unplug().
+ */
+static void blk_queue_drain(struct blk_queue* queue)
+{
+    blk_queue_run(queue);
+    blk_queue_run_deferred(queue);
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    while ((queue->head && !queue->plugged) || queue->depth)
+    {
+        spin_unlock_irqrestore(&queue->lock, flags);
+        __builtin_ia32_pause();
+
+        // Commands the poll completes dispatch what waits behind them
+        disk_poll_device(queue->device);
+        blk_queue_run_deferred(queue);
+        flags = spin_lock_irqsave(&queue->lock);
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+void blk_submit(struct blk_request* request)
+{
+    struct blk_queue* queue = request->device->queue;
+    request->done = false;
+    request->result = 0;
+    request->next = NULL;
+    request->submitted_ns = ktime_get_ns();
+    request->submitted_tsc = cpu_read_tsc();
+    if (!queue)
+    {
+        // A disk without a queue is read or written there and then
+        request->dispatched_tsc = request->submitted_tsc;
+        disk_stats_dispatch(request->device);
+        request->result = blk_device_transfer(request->device, request->op, request->lba, request->total, request->buf);
+        disk_stats_done(request->device);
+        disk_stats_complete(request, cpu_read_tsc());
+        if (request->callback)
+        {
+            request->callback(request);
+        }
+        request->done = true;
+        return;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    blk_queue_insert(queue, request);
+    queue->stats.requests++;
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    if (!task_can_sleep())
+    {
+        blk_queue_drain(queue);
+        return;
+    }
+
+    blk_queue_run(queue);
+}
+
+void blk_plug(struct disk* device)
+{
+    struct blk_queue* queue = device->queue;
+    if (!queue)
+    {
+        return;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    queue->plugged++;
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+void blk_unplug(struct disk* device)
+{
+    struct blk_queue* queue = device->queue;
+    if (!queue)
+    {
+        return;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    queue->plugged--;
+    spin_unlock_irqrestore(&queue->lock, flags);
+    if (!task_can_sleep())
+    {
+        blk_queue_drain(queue);
+        return;
+    }
+
+    blk_queue_run(queue);
+}
+
+bool blk_request_poll(struct blk_request* request)
+{
+    if (!request->done && request->device->queue)
+    {
+        // The interrupt may not have come in yet
+        disk_poll_device(request->device);
+    }
+
+    return request->done;
+}
+
+int blk_request_wait(struct blk_request* request)
+{
+    struct blk_queue* queue = request->device->queue;
+    if (!queue)
+    {
+        return request->result;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    while (!request->done)
+    {
+        if (!task_can_sleep())
+        {
+            // Nothing would wake us, see the queue through ourselves
+            spin_unlock_irqrestore(&queue->lock, flags);
+            blk_queue_drain(queue);
+            flags = spin_lock_irqsave(&queue->lock);
+            continue;
+        }
+
+        waitqueue_add(&queue->waiters, task_current());
+        spin_unlock_irqrestore(&queue->lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&queue->lock);
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+    return request->result;
+}
+
+int blk_read(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    struct blk_request request;
+    blk_request_init(&request, device, BLK_REQUEST_READ, lba, total, buf);
+    blk_submit(&request);
+    return blk_request_wait(&request);
+}
+
+int blk_write(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    struct blk_request request;
+    blk_request_init(&request, device, BLK_REQUEST_WRITE, lba, total, buf);
+    blk_submit(&request);
+    return blk_request_wait(&request);
+}
+
+int blk_flush(struct disk* device)
+{
+    // The drivers keep the flush apart from the commands they have in flight themselves
+    return disk_flush_device(device);
+}
+
+void blk_queue_get_stats(struct disk* device, struct blk_queue_stats* stats_out)
+{
+    struct blk_queue* queue = device->queue;
+    if (!queue)
+    {
+        memset(stats_out, 0, sizeof(struct blk_queue_stats));
+        return;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    memcpy(stats_out, &queue->stats, sizeof(struct blk_queue_stats));
+    spin_unlock_irqrestore(&queue->lock, flags);
+}
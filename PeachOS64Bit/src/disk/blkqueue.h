@@ -0,0 +1,249 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_BLKQUEUE_H
+#define KERNEL_BLKQUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+#include "task/workqueue.h"
+
+// Adjacent requests are merged into one device command up to this many sectors
+#define BLK_QUEUE_MAX_SECTORS 128
+
+// Commands a queue has in flight at once, one bit each in the slot mask
+#define BLK_QUEUE_MAX_DEPTH 32
+
+#define BLK_REQUEST_READ 0
+#define BLK_REQUEST_WRITE 1
+
+struct disk;
+struct blk_request;
+struct blk_queue;
+
+typedef void (*BLK_REQUEST_CALLBACK)(struct blk_request* request);
+
+/**
+ * A request for sectors of a real disk. The memory belongs to the caller
+ * and must stay put until the request is done.
+ */
+struct blk_request
+{
+    struct disk* device;
+    int op;
+    uint64_t lba;
+    int total;
+    void* buf;
+
+    // Runs once the request completed and before done is set, with no lock held, may be NULL
+    BLK_REQUEST_CALLBACK callback;
+    void* private;
+
+    int result;
+    volatile bool done;
+
+    uint64_t submitted_ns;
+
+    // Time stamp counter on submission and when the command carrying it went to the device
+    uint64_t submitted_tsc;
+    uint64_t dispatched_tsc;
+
+    // The next request in the queue, then in the command it was dispatched with
+    struct blk_request* next;
+};
+
+struct blk_queue_stats
+{
+    // Requests submitted, and device commands they went out as
+    uint64_t requests;
+    uint64_t dispatches;
+
+    // Requests that rode along in the command of another
+    uint64_t merges;
+
+    uint64_t sectors;
+    uint64_t errors;
+
+    // Requests waiting and commands in flight right now, and the most ever in flight
+    int queued;
+    int depth;
+    int max_depth_seen;
+
+    // Time from submission to completion, summed over every request
+    uint64_t latency_total_ns;
+    uint64_t latency_max_ns;
+};
+
+/**
+ * A device command made of one or more adjacent requests, one per slot of
+ * the queue. The driver gets it through disk_submit_device() and hands it
+ * back with blk_command_complete() once the device finished it.
+ */
+struct blk_command
+{
+    struct blk_queue* queue;
+    int slot;
+    int op;
+    uint64_t lba;
+    int total;
+
+    // The buffer of the requests, or the bounce buffer of the slot when theirs do not follow on
+    void* buf;
+
+    // The requests it carries, linked through next
+    struct blk_request* batch;
+
+    // Negative once any part of it failed
+    int result;
+
+    // For the driver, the sectors handed to the device so far and the device commands still out
+    int issued;
+    int outstanding;
+
+    // For the driver while the command waits for room, then links finished commands together
+    struct blk_command* next;
+};
+
+/**
+ * The request queue of a real disk. Requests wait sorted by LBA and the
+ * elevator sweeps upwards through them from the last dispatch, wrapping
+ * around at the top. Submitting only queues, commands go to the driver
+ * while the device has room and the driver completes them from its
+ * interrupt handler, which dispatches what waits next. Drivers that can
+ * only run a command while their caller waits for it get theirs run by
+ * the block I/O worker instead.
+ */
+struct blk_queue
+{
+    // Runs the deferred commands on the block I/O worker, the first member so the work leads back here
+    struct work work;
+
+    struct disk* device;
+
+    // Guards everything below, never held across a device command
+    struct spinlock lock;
+
+    // Requests waiting to be dispatched, sorted by LBA
+    struct blk_request* head;
+
+    // Commands in flight and how many the device may have
+    int depth;
+    int max_depth;
+
+    // Non zero while a submitter holds requests back so they can merge
+    int plugged;
+
+    // The sector after the last command, where the sweep carries on from
+    uint64_t position;
+
+    // The free command slots, each has its own bounce buffer for merged requests.
+    // The buffers are allocated up front as commands are dispatched from interrupt handlers.
+    uint32_t free_slots;
+    struct blk_command commands[BLK_QUEUE_MAX_DEPTH];
+    void* bounce[BLK_QUEUE_MAX_DEPTH];
+
+    // Commands the driver could not take, waiting for the worker in order
+    struct blk_command* deferred;
+    struct blk_command* deferred_tail;
+
+    // Tasks in blk_request_wait()
+    struct waitqueue waiters;
+
+    struct blk_queue_stats stats;
+};
+
+/**
+ * Gives the real disk a request queue that has up to max_depth commands in flight
+ */
+int blk_queue_init(struct disk* device, int max_depth);
+
+void blk_request_init(struct blk_request* request, struct disk* device, int op, uint64_t lba, int total, void* buf);
+
+/**
+ * Creates the workqueue that runs the commands of drivers which cannot
+ * complete them on their own, such as the legacy ATA one
+ */
+void blk_workqueue_init();
+
+/**
+ * Queues the request and dispatches what the device has room for, unless
+ * plugged. Returns without waiting for the device, the callback of the
+ * request runs once it finished. Boot code has nothing to finish its
+ * commands for it, so it sees them through before returning.
+ */
+void blk_submit(struct blk_request* request);
+
+/**
+ * Holds back dispatching on the disk so the requests submitted next can be
+ * merged, blk_unplug() dispatches them without waiting for them. Must not
+ * sleep in between.
+ */
+void blk_plug(struct disk* device);
+void blk_unplug(struct disk* device);
+
+/**
+ * Completes the commands linked through next, for drivers once the device
+ * finished them. Dispatches what waits on their queues, so the driver lock
+ * must not be held.
+ */
+void blk_command_complete(struct blk_command* commands);
+
+/**
+ * Collects what the device finished without waiting for its interrupt
+ * \return Returns true once the request is done
+ */
+bool blk_request_poll(struct blk_request* request);
+
+/**
+ * Waits for the request to be done
+ * \return Returns the result of the request
+ */
+int blk_request_wait(struct blk_request* request);
+
+/**
+ * Reads sectors of a real disk through its request queue and waits for them
+ */
+int blk_read(struct disk* device, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors of a real disk through its request queue and waits for the
+ * device to take them, they may still sit in its write cache
+ */
+int blk_write(struct disk* device, uint64_t lba, int total, void* buf);
+
+/**
+ * Makes every write that completed before the call durable by emptying the
+ * write cache of the device. Writes still queued are not waited for.
+ */
+int blk_flush(struct disk* device);
+
+void blk_queue_get_stats(struct disk* device, struct blk_queue_stats* stats_out);
+
+#endif
@@ -26,6 +26,12 @@
  */
 
 #include "disk.h"
+#include "bcache.h"
+#include "blkqueue.h"
+#include "idedma.h"
+#include "ahci.h"
+#include "virtioblk.h"
+#include "nvme.h"
 #include "io/io.h"
 #include "config.h"
 #include "status.h"
@@ -33,9 +39,18 @@
 #include "memory/heap/kheap.h"
 #include "string/string.h"
 #include "lib/vector/vector.h"
+#include "lib/spinlock/spinlock.h"
+#include "lib/mutex/mutex.h"
+#include "kernel.h"
 
 struct vector* disk_vector = NULL;
 
+// Guards disk_vector
+static struct spinlock disk_vector_lock;
+
+// Only one command can be in flight on the ATA channel, a DMA reader sleeps holding it
+static struct mutex ata_lock;
+
 // A pointer to the primary hard disk
 // allowing IO directly to the disk from LBA zero onwards
 struct disk* disk = NULL;
@@ -44,59 +59,168 @@ struct disk* disk = NULL;
 // where kernel files are found.
 struct disk* primary_fs_disk = NULL;
 
-int disk_read_sector(int lba, int total, void* buf)
+/**
+ * Programmed I/O, the processor moves every word. The channel must be owned.
+ */
+static int disk_read_sector(uint64_t lba, int total, void* buf)
 {
-    // Wait for the disk not to be busy
-    while(insb(0x1F7) & 0x80)
+    int res = 0;
+    unsigned short* ptr = (unsigned short*) buf;
+    while (total > 0)
     {
-        // spin
-    }
+        int count = total > ide_max_sectors() ? ide_max_sectors() : total;
+
+        // Wait for the disk not to be busy
+        while(insb(0x1F7) & 0x80)
+        {
+            // spin
+        }
+
+        // Drive, sector count and LBA, twice over for sectors past LBA28
+        int ext = ide_set_task_file(lba, count);
+        if (ext < 0)
+        {
+            res = ext;
+            goto out;
+        }
+
+        outb(0x1F7, ext ? IDE_COMMAND_READ_SECTORS_EXT : IDE_COMMAND_READ_SECTORS);
 
-    // Select drive: bits 7..4=0xE, bits 3..0 = high nibble of lba
-    outb(0x1F6, 0xE0 | ((lba >> 24) & 0x0F));
-    // Sector count
-    outb(0x1F2, (unsigned char) total);
-    // LBA low, mid, high
-    outb(0x1F3, (unsigned char)(lba & 0xff));
-    outb(0x1F4, (unsigned char)((lba >> 8) & 0xff));
-    outb(0x1F5, (unsigned char)((lba >> 16) & 0xff));
+        for (int b = 0; b < count; b++)
+        {
+            // Wait for the disk not to be busy
+            while(insb(0x1F7) & 0x80)
+            {
+                // spin
+            }
+
+            // Check error bit
+            char status = insb(0x1F7);
+            if (status & 0x01)
+            {
+                res = -EIO;
+                goto out;
+            }
+
+            // Wait for the buffer to be ready
+            while(!(insb(0x1F7) & 0x08))
+            {
+                // spin
+            }
 
-    // Read SECTORS command (0x20)
-    outb(0x1F7, 0x20);
+            // Copy from hard disk to memory
+            for (int word = 0; word < 256; word++)
+            {
+                *ptr++ = insw(0x1F0);
+            }
+        }
+
+        lba += count;
+        total -= count;
+    }
 
+out:
+    return res;
+}
+
+/**
+ * Programmed I/O, the processor hands over every word. The channel must be owned.
+ */
+static int disk_write_sector(uint64_t lba, int total, void* buf)
+{
+    int res = 0;
     unsigned short* ptr = (unsigned short*) buf;
-    for (int b = 0; b < total; b++)
+    while (total > 0)
     {
+        int count = total > ide_max_sectors() ? ide_max_sectors() : total;
+
         // Wait for the disk not to be busy
         while(insb(0x1F7) & 0x80)
         {
             // spin
         }
 
-        // Check error bit
-        char status = insb(0x1F7);
-        if (status & 0x01)
+        int ext = ide_set_task_file(lba, count);
+        if (ext < 0)
         {
-            return -EIO;
+            res = ext;
+            goto out;
         }
 
-        // Wait for the buffer to be ready
-        while(!(insb(0x1F7) & 0x08))
+        outb(0x1F7, ext ? IDE_COMMAND_WRITE_SECTORS_EXT : IDE_COMMAND_WRITE_SECTORS);
+
+        for (int b = 0; b < count; b++)
+        {
+            while(insb(0x1F7) & 0x80)
+            {
+                // spin
+            }
+
+            char status = insb(0x1F7);
+            if (status & 0x01)
+            {
+                res = -EIO;
+                goto out;
+            }
+
+            // Wait for the drive to ask for the sector
+            while(!(insb(0x1F7) & 0x08))
+            {
+                // spin
+            }
+
+            for (int word = 0; word < 256; word++)
+            {
+                outw(0x1F0, *ptr++);
+            }
+        }
+
+        // The last sector is only written once the drive is no longer busy with it
+        while(insb(0x1F7) & 0x80)
         {
             // spin
         }
 
-        // Copy from hard disk to memory
-        for (int word = 0; word < 256; word++)
+        if (insb(0x1F7) & 0x01)
         {
-            *ptr++ = insw(0x1F0);
+            res = -EIO;
+            goto out;
         }
 
+        lba += count;
+        total -= count;
+    }
+
+out:
+    return res;
+}
+
+/**
+ * FLUSH CACHE (0xE7), the drive puts its write cache on the media. The channel must be owned.
+ */
+static int disk_flush_cache()
+{
+    while(insb(0x1F7) & 0x80)
+    {
+        // spin
+    }
+
+    outb(0x1F6, 0xE0);
+    outb(0x1F7, 0xE7);
+
+    // Emptying a large cache takes a while
+    while(insb(0x1F7) & 0x80)
+    {
+        // spin
     }
-    return 0;
+
+    return (insb(0x1F7) & 0x01) ? -EIO : 0;
 }
 
-int disk_create_new(int type, int starting_lba, int ending_lba, size_t sector_size, struct disk** disk_out)
+/**
+ * \param device The real disk the sectors live on, NULL when the new disk is one itself
+ */
+static int disk_create(int type, uint64_t starting_lba, uint64_t ending_lba, size_t sector_size, struct disk* device, void* driver_private, struct disk** disk_out)
 {
     int res = 0;
     struct disk* disk = kzalloc(sizeof(struct disk));
@@ -106,10 +230,22 @@ int disk_create_new(int type, int starting_lba, int ending_lba, size_t sector_si
         goto out;
     }
     disk->type = type;
-    disk->id = vector_count(disk_vector);
     disk->sector_size = sector_size;
     disk->starting_lba = starting_lba;
     disk->ending_lba = ending_lba;
+    disk->driver_private = driver_private;
+
+    disk->device = device ? device : disk;
+    disk_stats_init(&disk->stats);
+    if (!device)
+    {
+        // The ATA channel takes one command at a time, the others queue in hardware
+        int depth = type == PEACHOS_DISK_TYPE_REAL ? 1 : BLK_QUEUE_MAX_DEPTH;
+        if (blk_queue_init(disk, depth) < 0)
+        {
+            print("No memory for a request queue, the disk is read directly\n");
+        }
+    }
 
     // Not all disks have filesystems its not an error not to have one
     disk->filesystem = fs_resolve(disk);
@@ -120,9 +256,9 @@ int disk_create_new(int type, int starting_lba, int ending_lba, size_t sector_si
         strncpy(primary_drive_fs_name, PEACHOS_KERNEL_FILESYSTEM_NAME, strlen(PEACHOS_KERNEL_FILESYSTEM_NAME));
         // Is the disk the primary disk, lets check
         disk->filesystem->volume_name(disk->fs_private, fs_name, sizeof(fs_name));
-        if (strncmp(fs_name, primary_drive_fs_name, sizeof(fs_name)) == 0)
+        if (!primary_fs_disk && strncmp(fs_name, primary_drive_fs_name, sizeof(fs_name)) == 0)
         {
-            // Set the primary filesystem disk
+            // Set the primary filesystem disk, a copy of it on a later disk does not take over
             primary_fs_disk = disk;
         }
     }
@@ -131,13 +267,52 @@ int disk_create_new(int type, int starting_lba, int ending_lba, size_t sector_si
     {
         *disk_out = disk;
     }
+
+    uint64_t flags = spin_lock_irqsave(&disk_vector_lock);
+    disk->id = vector_count(disk_vector);
     vector_push(disk_vector, &disk);
+    spin_unlock_irqrestore(&disk_vector_lock, flags);
 out:
     return res;
 }
+int disk_create_new(int type, uint64_t starting_lba, uint64_t ending_lba, size_t sector_size, struct disk** disk_out)
+{
+    // Partitions created this way live on the primary disk
+    struct disk* device = type == PEACHOS_DISK_TYPE_PARTITION ? disk_primary() : NULL;
+    return disk_create(type, starting_lba, ending_lba, sector_size, device, NULL, disk_out);
+}
+
+int disk_create_partition(struct disk* parent, uint64_t starting_lba, uint64_t ending_lba, struct disk** disk_out)
+{
+    return disk_create(PEACHOS_DISK_TYPE_PARTITION, starting_lba, ending_lba, parent->sector_size, parent->device, NULL, disk_out);
+}
+
+int disk_create_device(int type, size_t sector_size, void* driver_private, struct disk** disk_out)
+{
+    return disk_create(type, 0, 0, sector_size, NULL, driver_private, disk_out);
+}
+
 void disk_search_and_init()
 {
     int res = 0;
+    spinlock_init(&disk_vector_lock, "disks");
+    mutex_init(&ata_lock, "ata");
+    disk_trace_init();
+    if (ide_identify() < 0)
+    {
+        print("No ATA drive answered identify, only LBA28 is used\n");
+    }
+
+    if (ide_dma_init() < 0)
+    {
+        print("No IDE bus master, disk reads use PIO\n");
+    }
+
+    if (bcache_init() < 0)
+    {
+        print("No memory for the block cache, disk reads are uncached\n");
+    }
+
     disk_vector = vector_new(sizeof(struct disk*), 4, 0);
     if (!disk_vector)
     {
@@ -150,10 +325,20 @@ void disk_search_and_init()
     {
         goto out;
     }
+
+    // SATA, virtio and NVMe disks come after the legacy ATA disk
+    ahci_init();
+    virtio_blk_init();
+    nvme_init();
 out:
     return;
 }
 
+void disk_smp_init()
+{
+    nvme_smp_init();
+}
+
 struct disk* disk_primary()
 {
     return disk;
@@ -168,31 +353,205 @@ struct disk* disk_primary_fs_disk()
 
 struct disk* disk_get(int index)
 {
+    struct disk* disk = NULL;
+    uint64_t flags = spin_lock_irqsave(&disk_vector_lock);
     size_t total_disks = vector_count(disk_vector);
     if (index >= (int) total_disks)
     {
         // out of bounds no such disk is loaded
-        return NULL;
+        goto out;
     }
 
-    struct disk* disk = NULL;
     vector_at(disk_vector, index, &disk, sizeof(disk));
+out:
+    spin_unlock_irqrestore(&disk_vector_lock, flags);
     return disk;
 }
 
-int disk_read_block(struct disk* idisk, unsigned int lba, int total, void* buf)
+/**
+ * \return Returns false when the sectors run past the end of a partition
+ */
+static bool disk_in_bounds(struct disk* idisk, uint64_t lba, int total)
 {
-    size_t absolute_lba = idisk->starting_lba + lba;
-    size_t absolute_ending_lba = absolute_lba + total;
-    if (absolute_ending_lba > idisk->ending_lba)
+    // Is this the primary disk
+    if (idisk->starting_lba == 0 || idisk->ending_lba == 0)
     {
-        // Is this the primary disk
-        if (idisk->starting_lba != 0 && idisk->ending_lba != 0)
+        return true;
+    }
+
+    // Out of bounds, you cannot read over to other virtual disks. Compared
+    // as a size so a huge LBA cannot wrap around past the end.
+    uint64_t sectors = idisk->ending_lba - idisk->starting_lba;
+    return lba < sectors && (uint64_t) total <= sectors - lba;
+}
+
+int disk_read_block(struct disk* idisk, uint64_t lba, int total, void* buf)
+{
+    if (!disk_in_bounds(idisk, lba, total))
+    {
+        return -EIO;
+    }
+
+    disk_stats_requested(idisk, BLK_REQUEST_READ, total);
+    return bcache_read(idisk->device, idisk->starting_lba + lba, total, buf);
+}
+
+int disk_read_direct(struct disk* idisk, uint64_t lba, int total, void* buf)
+{
+    if (total <= 0 || !disk_in_bounds(idisk, lba, total))
+    {
+        return -EIO;
+    }
+
+    disk_stats_requested(idisk, BLK_REQUEST_READ, total);
+    return blk_read(idisk->device, idisk->starting_lba + lba, total, buf);
+}
+
+int disk_write_block(struct disk* idisk, uint64_t lba, int total, void* buf)
+{
+    if (total <= 0 || !disk_in_bounds(idisk, lba, total))
+    {
+        return -EIO;
+    }
+
+    disk_stats_requested(idisk, BLK_REQUEST_WRITE, total);
+    return bcache_write(idisk->device, idisk->starting_lba + lba, total, buf);
+}
+
+int disk_sync(struct disk* idisk)
+{
+    int res = bcache_sync(idisk->device);
+    int flush_res = blk_flush(idisk->device);
+    return res < 0 ? res : flush_res;
+}
+
+void disk_readahead(struct disk* idisk, uint64_t lba, int total)
+{
+    uint64_t absolute_lba = idisk->starting_lba + lba;
+    if (idisk->ending_lba != 0 && absolute_lba + total > idisk->ending_lba)
+    {
+        if (absolute_lba >= idisk->ending_lba)
         {
-            // Out of bounds, you cannot read over to other virtual disks
-            return -EIO;
+            return;
         }
+
+        total = idisk->ending_lba - absolute_lba;
+    }
+
+    bcache_prefetch(idisk->device, absolute_lba, total);
+}
+
+int disk_read_device(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    if (device->type == PEACHOS_DISK_TYPE_AHCI)
+    {
+        return ahci_read(device->driver_private, lba, total, buf);
     }
 
-    return disk_read_sector(absolute_lba, total, buf);
-}
\ No newline at end of file
+    if (device->type == PEACHOS_DISK_TYPE_VIRTIO)
+    {
+        return virtio_blk_read(device->driver_private, lba, total, buf);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_NVME)
+    {
+        return nvme_read(device->driver_private, lba, total, buf);
+    }
+
+    // Otherwise it is the primary ATA disk
+    mutex_lock(&ata_lock);
+    int res = ide_dma_read(lba, total, buf);
+    if (res == -EUNIMP)
+    {
+        res = disk_read_sector(lba, total, buf);
+    }
+    mutex_unlock(&ata_lock);
+    return res;
+}
+
+int disk_write_device(struct disk* device, uint64_t lba, int total, void* buf)
+{
+    if (device->type == PEACHOS_DISK_TYPE_AHCI)
+    {
+        return ahci_write(device->driver_private, lba, total, buf);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_VIRTIO)
+    {
+        return virtio_blk_write(device->driver_private, lba, total, buf);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_NVME)
+    {
+        return nvme_write(device->driver_private, lba, total, buf);
+    }
+
+    mutex_lock(&ata_lock);
+    int res = ide_dma_write(lba, total, buf);
+    if (res == -EUNIMP)
+    {
+        res = disk_write_sector(lba, total, buf);
+    }
+    mutex_unlock(&ata_lock);
+    return res;
+}
+
+int disk_submit_device(struct disk* device, struct blk_command* command)
+{
+    if (device->type == PEACHOS_DISK_TYPE_AHCI)
+    {
+        return ahci_submit(device->driver_private, command);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_VIRTIO)
+    {
+        return virtio_blk_submit(device->driver_private, command);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_NVME)
+    {
+        return nvme_submit(device->driver_private, command);
+    }
+
+    // The ATA channel is waited on under its mutex
+    return -EUNIMP;
+}
+
+void disk_poll_device(struct disk* device)
+{
+    if (device->type == PEACHOS_DISK_TYPE_AHCI)
+    {
+        ahci_poll(device->driver_private);
+    }
+    else if (device->type == PEACHOS_DISK_TYPE_VIRTIO)
+    {
+        virtio_blk_poll(device->driver_private);
+    }
+    else if (device->type == PEACHOS_DISK_TYPE_NVME)
+    {
+        nvme_poll(device->driver_private);
+    }
+}
+
+int disk_flush_device(struct disk* device)
+{
+    if (device->type == PEACHOS_DISK_TYPE_AHCI)
+    {
+        return ahci_flush(device->driver_private);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_VIRTIO)
+    {
+        return virtio_blk_flush(device->driver_private);
+    }
+
+    if (device->type == PEACHOS_DISK_TYPE_NVME)
+    {
+        return nvme_flush(device->driver_private);
+    }
+
+    mutex_lock(&ata_lock);
+    int res = disk_flush_cache();
+    mutex_unlock(&ata_lock);
+    return res;
+}
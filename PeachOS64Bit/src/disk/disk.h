@@ -29,6 +29,7 @@
 #define DISK_H
 
 #include "fs/file.h"
+#include "disk/diskstat.h"
 
 typedef unsigned int PEACHOS_DISK_TYPE;
 
@@ -39,8 +40,20 @@ typedef unsigned int PEACHOS_DISK_TYPE;
 // Specifies this disk represents a partion/virtual-disk
 #define PEACHOS_DISK_TYPE_PARTITION 1 
 
+// A SATA disk on a port of an AHCI controller
+#define PEACHOS_DISK_TYPE_AHCI 2
+
+// A virtio block device, as given to a virtual machine
+#define PEACHOS_DISK_TYPE_VIRTIO 3
+
+// A namespace of an NVMe controller
+#define PEACHOS_DISK_TYPE_NVME 4
+
 #define PEACHOS_KERNEL_FILESYSTEM_NAME "PEACH      "
 
+struct blk_queue;
+struct blk_command;
+
 struct disk
 {
     PEACHOS_DISK_TYPE type;
@@ -53,17 +66,101 @@ struct disk
 
     // Set both to zero for the primary disk
     // all bounds checking is ignored if set to zero.
-    size_t starting_lba;
-    size_t ending_lba;
+    // The ending LBA is the first sector past the partition.
+    uint64_t starting_lba;
+    uint64_t ending_lba;
 
     // The private data of our filesystem
     void* fs_private;
+
+    // The real disk the sectors live on, itself for a real disk. Cached blocks
+    // are keyed by it so partitions share them with the whole disk.
+    struct disk* device;
+
+    // State of the driver of a real disk, such as its AHCI port
+    void* driver_private;
+
+    // Requests waiting for a real disk, NULL for partitions and when there was no memory
+    struct blk_queue* queue;
+
+    // What was asked of the disk and, for a real disk, what its device did
+    struct disk_stats stats;
 };
 
-int disk_create_new(int type, int starting_lba, int ending_lba, size_t sector_size, struct disk** disk_out);
+int disk_create_new(int type, uint64_t starting_lba, uint64_t ending_lba, size_t sector_size, struct disk** disk_out);
+/**
+ * Creates a whole disk behind a driver other than the legacy ATA one, such as
+ * a SATA disk, and looks for a filesystem on it
+ */
+int disk_create_device(int type, size_t sector_size, void* driver_private, struct disk** disk_out);
+
+/**
+ * Creates a partition of the given disk, the LBAs are relative to the start of the real disk
+ */
+int disk_create_partition(struct disk* parent, uint64_t starting_lba, uint64_t ending_lba, struct disk** disk_out);
 void disk_search_and_init();
+
+/**
+ * Lets the drivers spread themselves over the processors, once smp_init() has started them
+ */
+void disk_smp_init();
 struct disk* disk_get(int index);
-int disk_read_block(struct disk* idisk, unsigned int lba, int total, void* buf);
+/**
+ * Reads sectors relative to the start of the disk through the block cache
+ */
+int disk_read_block(struct disk* idisk, uint64_t lba, int total, void* buf);
+
+/**
+ * Reads sectors relative to the start of the disk through the request queue
+ * of the device, the block cache is neither consulted nor filled
+ */
+int disk_read_direct(struct disk* idisk, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors relative to the start of the disk into the block cache. It
+ * returns once the data is cached, the blocks reach the device with the next
+ * writeback or disk_sync(). Reads that bypass the cache do not see them until then.
+ */
+int disk_write_block(struct disk* idisk, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes back every dirty cached block of the real disk the disk lives on and
+ * empties the write cache of the device
+ * \return Returns -EIO when a block could not be written
+ */
+int disk_sync(struct disk* idisk);
+
+/**
+ * Starts bringing the sectors into the block cache ahead of them being read,
+ * sectors past the end of a partition are ignored
+ */
+void disk_readahead(struct disk* idisk, uint64_t lba, int total);
+
+/**
+ * Reads sectors of a real disk straight from the hardware, only the request queue should need this
+ */
+int disk_read_device(struct disk* device, uint64_t lba, int total, void* buf);
+int disk_write_device(struct disk* device, uint64_t lba, int total, void* buf);
+
+/**
+ * Hands a command of the request queue to the driver of a real disk. It
+ * returns once the command is issued, the driver completes it with
+ * blk_command_complete() from its interrupt handler or disk_poll_device().
+ * \return Returns -EUNIMP when the driver only completes commands its caller
+ *         waits for, the request queue then runs it with disk_read_device()
+ *         or disk_write_device() from its worker
+ */
+int disk_submit_device(struct disk* device, struct blk_command* command);
+
+/**
+ * Completes the submitted commands the device has finished without waiting for its interrupt
+ */
+void disk_poll_device(struct disk* device);
+
+/**
+ * Empties the write cache of a real disk, only the request queue should need this
+ */
+int disk_flush_device(struct disk* device);
 struct disk* disk_primary_fs_disk();
 struct disk* disk_primary();
 
@@ -0,0 +1,221 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "diskstat.h"
+#include "disk.h"
+#include "blkqueue.h"
+#include "config.h"
+#include "status.h"
+#include "cpu/cpu.h"
+#include "memory/memory.h"
+#include "timer/ktime.h"
+
+// The last requests of every disk, written over oldest first
+static struct disk_trace_entry disk_trace[PEACHOS_DISK_TRACE_ENTRIES];
+static uint64_t disk_trace_next_sequence = 1;
+static bool disk_trace_on = false;
+
+// Guards the trace ring
+static struct spinlock disk_trace_lock;
+
+static int disk_stats_bucket(uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (us >= 2 && bucket < DISK_STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void disk_trace_init()
+{
+    spinlock_init(&disk_trace_lock, "disk trace");
+}
+
+void disk_stats_init(struct disk_stats* stats)
+{
+    memset(stats, 0, sizeof(struct disk_stats));
+    spinlock_init(&stats->lock, "disk stats");
+}
+
+void disk_stats_requested(struct disk* disk, int op, int total)
+{
+    uint64_t flags = spin_lock_irqsave(&disk->stats.lock);
+    if (op == BLK_REQUEST_WRITE)
+    {
+        disk->stats.writes_requested++;
+        disk->stats.write_sectors_requested += total;
+    }
+    else
+    {
+        disk->stats.reads_requested++;
+        disk->stats.read_sectors_requested += total;
+    }
+    spin_unlock_irqrestore(&disk->stats.lock, flags);
+}
+
+void disk_stats_dispatch(struct disk* device)
+{
+    uint64_t flags = spin_lock_irqsave(&device->stats.lock);
+    if (device->stats.in_flight++ == 0)
+    {
+        device->stats.busy_since_tsc = cpu_read_tsc();
+    }
+    spin_unlock_irqrestore(&device->stats.lock, flags);
+}
+
+void disk_stats_done(struct disk* device)
+{
+    uint64_t flags = spin_lock_irqsave(&device->stats.lock);
+    if (--device->stats.in_flight == 0)
+    {
+        device->stats.busy_ns += ktime_cycles_to_ns(cpu_read_tsc() - device->stats.busy_since_tsc);
+    }
+    spin_unlock_irqrestore(&device->stats.lock, flags);
+}
+
+static void disk_trace_record(struct blk_request* request, uint64_t end_tsc)
+{
+    uint64_t flags = spin_lock_irqsave(&disk_trace_lock);
+    uint64_t sequence = disk_trace_next_sequence++;
+    struct disk_trace_entry* entry = &disk_trace[sequence % PEACHOS_DISK_TRACE_ENTRIES];
+    entry->sequence = sequence;
+    entry->disk_id = request->device->id;
+    entry->op = request->op;
+    entry->result = request->result;
+    entry->total = request->total;
+    entry->lba = request->lba;
+    entry->start_tsc = request->submitted_tsc;
+    entry->dispatch_tsc = request->dispatched_tsc;
+    entry->end_tsc = end_tsc;
+    spin_unlock_irqrestore(&disk_trace_lock, flags);
+}
+
+void disk_stats_complete(struct blk_request* request, uint64_t end_tsc)
+{
+    struct disk_stats* stats = &request->device->stats;
+    uint64_t queue_ns = ktime_cycles_to_ns(request->dispatched_tsc - request->submitted_tsc);
+    uint64_t service_ns = ktime_cycles_to_ns(end_tsc - request->dispatched_tsc);
+    uint64_t flags = spin_lock_irqsave(&stats->lock);
+    if (request->op == BLK_REQUEST_WRITE)
+    {
+        stats->writes++;
+        stats->write_sectors += request->total;
+    }
+    else
+    {
+        stats->reads++;
+        stats->read_sectors += request->total;
+    }
+
+    if (request->result < 0)
+    {
+        stats->errors++;
+    }
+
+    stats->queue_ns += queue_ns;
+    stats->service_ns += service_ns;
+    stats->latency_histogram[disk_stats_bucket(queue_ns + service_ns)]++;
+    spin_unlock_irqrestore(&stats->lock, flags);
+
+    if (disk_trace_on)
+    {
+        disk_trace_record(request, end_tsc);
+    }
+}
+
+int disk_stats_get(struct disk* disk, struct disk_stats_info* info_out)
+{
+    struct disk_stats* stats = &disk->stats;
+    memset(info_out, 0, sizeof(struct disk_stats_info));
+    info_out->id = disk->id;
+    info_out->device_id = disk->device->id;
+    info_out->type = disk->type;
+
+    uint64_t flags = spin_lock_irqsave(&stats->lock);
+    info_out->in_flight = stats->in_flight;
+    info_out->reads_requested = stats->reads_requested;
+    info_out->read_sectors_requested = stats->read_sectors_requested;
+    info_out->writes_requested = stats->writes_requested;
+    info_out->write_sectors_requested = stats->write_sectors_requested;
+    info_out->reads = stats->reads;
+    info_out->read_sectors = stats->read_sectors;
+    info_out->writes = stats->writes;
+    info_out->write_sectors = stats->write_sectors;
+    info_out->errors = stats->errors;
+    info_out->queue_ns = stats->queue_ns;
+    info_out->service_ns = stats->service_ns;
+    info_out->busy_ns = stats->busy_ns;
+    if (stats->in_flight)
+    {
+        // Count the time of the commands in flight so a busy disk does not look idle
+        info_out->busy_ns += ktime_cycles_to_ns(cpu_read_tsc() - stats->busy_since_tsc);
+    }
+    memcpy(info_out->latency_histogram, stats->latency_histogram, sizeof(info_out->latency_histogram));
+    spin_unlock_irqrestore(&stats->lock, flags);
+    return 0;
+}
+
+void disk_trace_enable(int enable)
+{
+    if (enable < 0)
+    {
+        return;
+    }
+
+    disk_trace_on = enable != 0;
+}
+
+bool disk_trace_enabled()
+{
+    return disk_trace_on;
+}
+
+int disk_trace_read(uint64_t since, struct disk_trace_entry* entries_out, int max)
+{
+    int total = 0;
+    uint64_t flags = spin_lock_irqsave(&disk_trace_lock);
+
+    // Anything older than a full ring has been written over
+    uint64_t oldest = disk_trace_next_sequence > PEACHOS_DISK_TRACE_ENTRIES ? disk_trace_next_sequence - PEACHOS_DISK_TRACE_ENTRIES : 1;
+    if (since < oldest)
+    {
+        since = oldest;
+    }
+
+    for (uint64_t sequence = since; sequence < disk_trace_next_sequence && total < max; sequence++)
+    {
+        memcpy(&entries_out[total], &disk_trace[sequence % PEACHOS_DISK_TRACE_ENTRIES], sizeof(struct disk_trace_entry));
+        total++;
+    }
+    spin_unlock_irqrestore(&disk_trace_lock, flags);
+    return total;
+}
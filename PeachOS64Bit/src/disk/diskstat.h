@@ -0,0 +1,167 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_DISKSTAT_H
+#define KERNEL_DISKSTAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib/spinlock/spinlock.h"
+
+// Latencies are bucketed by powers of two microseconds, the last bucket takes everything longer
+#define DISK_STATS_HISTOGRAM_BUCKETS 24
+
+struct disk;
+struct blk_request;
+
+/**
+ * The I/O counters of a disk. Every disk counts what its users asked of it,
+ * only real disks see device commands, the requests of a partition are
+ * counted on the disk it lives on. Asked for against sent to the device
+ * shows how much the block cache saved.
+ */
+struct disk_stats
+{
+    // Guards everything below, taken from completion paths with no other lock held
+    struct spinlock lock;
+
+    // Asked of the disk through the block cache or past it
+    uint64_t reads_requested;
+    uint64_t read_sectors_requested;
+    uint64_t writes_requested;
+    uint64_t write_sectors_requested;
+
+    // Requests that reached the device, a merged command counts each of its requests
+    uint64_t reads;
+    uint64_t read_sectors;
+    uint64_t writes;
+    uint64_t write_sectors;
+    uint64_t errors;
+
+    // Submission to dispatch and dispatch to completion, summed over every request
+    uint64_t queue_ns;
+    uint64_t service_ns;
+
+    // Time with at least one command in flight
+    uint64_t busy_ns;
+    uint64_t busy_since_tsc;
+    int in_flight;
+
+    // Submission to completion
+    uint64_t latency_histogram[DISK_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Copy of the statistics of a disk as handed to user land, keep in sync
+ * with the standard library.
+ */
+struct disk_stats_info
+{
+    int id;
+
+    // Id of the real disk the sectors live on, the disk itself unless it is a partition
+    int device_id;
+    int type;
+    int in_flight;
+
+    uint64_t reads_requested;
+    uint64_t read_sectors_requested;
+    uint64_t writes_requested;
+    uint64_t write_sectors_requested;
+
+    uint64_t reads;
+    uint64_t read_sectors;
+    uint64_t writes;
+    uint64_t write_sectors;
+    uint64_t errors;
+
+    uint64_t queue_ns;
+    uint64_t service_ns;
+    uint64_t busy_ns;
+    uint64_t latency_histogram[DISK_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * One request in the trace ring, keep in sync with the standard library
+ */
+struct disk_trace_entry
+{
+    // Counts up from one across every disk, user land asks for the entries after the last it saw
+    uint64_t sequence;
+    int disk_id;
+    int op;
+    int result;
+    int total;
+    uint64_t lba;
+
+    // Time stamp counter at submission, dispatch and completion
+    uint64_t start_tsc;
+    uint64_t dispatch_tsc;
+    uint64_t end_tsc;
+};
+
+/**
+ * Sets up the trace ring, tracing starts off
+ */
+void disk_trace_init();
+
+void disk_stats_init(struct disk_stats* stats);
+
+/**
+ * Counts a request a user of the disk made, before the block cache sees it
+ */
+void disk_stats_requested(struct disk* disk, int op, int total);
+
+/**
+ * The device starts or finishes a command, busy time runs while any is in flight
+ */
+void disk_stats_dispatch(struct disk* device);
+void disk_stats_done(struct disk* device);
+
+/**
+ * Counts a request the device completed and traces it when tracing is on,
+ * its time stamps must be filled in
+ */
+void disk_stats_complete(struct blk_request* request, uint64_t end_tsc);
+
+int disk_stats_get(struct disk* disk, struct disk_stats_info* info_out);
+
+/**
+ * Turns the trace ring on or off, it keeps the last PEACHOS_DISK_TRACE_ENTRIES requests
+ * \param enable One to trace, zero to stop, negative leaves it as it is
+ */
+void disk_trace_enable(int enable);
+bool disk_trace_enabled();
+
+/**
+ * Copies the traced requests from the given sequence number on, oldest
+ * first. Requests that were overwritten since are skipped.
+ * \return Returns the number of entries copied
+ */
+int disk_trace_read(uint64_t since, struct disk_trace_entry* entries_out, int max);
+
+#endif
@@ -32,18 +32,16 @@
 #include "disk/streamer.h"
 #include "kernel.h"
 
-struct disk* gpt_primary_disk = NULL;
-
 size_t gpt_partition_table_header_real_size(struct gpt_partition_table_header* header)
 {
     return sizeof(*header) + (header->hdr_size - offsetof(struct gpt_partition_table_header, reserved2));
 }
 
-int gpt_partition_table_header_read(struct gpt_partition_table_header* header_out)
+int gpt_partition_table_header_read(struct disk* disk, struct gpt_partition_table_header* header_out)
 {
     int res = 0;
-    char sector[gpt_primary_disk->sector_size];
-    res = disk_read_block(gpt_primary_disk, GPT_PARTITION_TABLE_HEADER_LBA, 1, sector);
+    char sector[disk->sector_size];
+    res = disk_read_block(disk, GPT_PARTITION_TABLE_HEADER_LBA, 1, sector);
     if (res < 0)
     {
         goto out;
@@ -54,21 +52,21 @@ out:
     return res;
 }
 
-int gpt_mount_partitions(struct gpt_partition_table_header* partition_header)
+int gpt_mount_partitions(struct disk* disk, struct gpt_partition_table_header* partition_header)
 {
     int res = 0;
     size_t total_entries = partition_header->total_array_entries;
     uint64_t starting_lba = partition_header->guid_array_lba_start;
-    uint64_t starting_byte = starting_lba * gpt_primary_disk->sector_size;
+    uint64_t starting_byte = starting_lba * disk->sector_size;
     size_t entry_size = partition_header->array_entry_size;
-    struct disk_stream* streamer = diskstreamer_new(gpt_primary_disk->id);
+    struct disk_stream* streamer = diskstreamer_new_from_disk(disk);
     if (!streamer)
     {
         res = -EINVARG;
         goto out;
     }
 
-    res = diskstreamer_seek(streamer, (int) starting_byte);
+    res = diskstreamer_seek(streamer, starting_byte);
     if (res < 0)
     {
         goto out;
@@ -94,8 +92,9 @@ int gpt_mount_partitions(struct gpt_partition_table_header* partition_header)
             continue;
         }
  
-        // We have the entry, lets create a virtual disk
-        res = disk_create_new(PEACHOS_DISK_TYPE_PARTITION, entry->starting_lba, entry->ending_lba, gpt_primary_disk->sector_size, NULL);
+        // We have the entry, lets create a virtual disk. GPT gives the last
+        // sector of the partition, the disk wants the one past it.
+        res = disk_create_partition(disk, entry->starting_lba, entry->ending_lba + 1, NULL);
         if (res < 0)
         {
             goto out;
@@ -106,22 +105,21 @@ int gpt_mount_partitions(struct gpt_partition_table_header* partition_header)
 
     }
 out:
+    if (streamer)
+    {
+        diskstreamer_close(streamer);
+    }
     return res;
 }
 
-int gpt_init()
+/**
+ * Mounts the partitions of one whole disk
+ */
+static int gpt_mount_disk(struct disk* disk)
 {
     int res = 0;
     struct gpt_partition_table_header partition_header = {0};
-    gpt_primary_disk = disk_get(0);
-
-    if (!gpt_primary_disk)
-    {
-        res = -EINVARG;
-        goto out;
-    }
-
-    res = gpt_partition_table_header_read(&partition_header);
+    res = gpt_partition_table_header_read(disk, &partition_header);
     if (res < 0)
     {
         goto out;
@@ -137,7 +135,7 @@ int gpt_init()
 
     // This is a GPT disk mount all partitions as seperate
     // virtual disks
-    res = gpt_mount_partitions(&partition_header);
+    res = gpt_mount_partitions(disk, &partition_header);
     if (res < 0)
     {
         goto out;
@@ -146,4 +144,28 @@ int gpt_init()
 
 out:    
     return res;
-}
\ No newline at end of file
+}
+
+int gpt_init()
+{
+    int res = -EINVARG;
+    struct disk* disk = NULL;
+
+    // Partitions are added as they are found, they are skipped being no whole disks
+    for (int i = 0; (disk = disk_get(i)); i++)
+    {
+        if (disk->type == PEACHOS_DISK_TYPE_PARTITION)
+        {
+            continue;
+        }
+
+        int disk_res = gpt_mount_disk(disk);
+        if (res < 0)
+        {
+            // One GPT disk is enough to succeed
+            res = disk_res;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,456 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "idedma.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "pci/pci.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "task/task.h"
+#include "task/waitqueue.h"
+#include "timer/timer.h"
+#include "timer/ktimer.h"
+#include "timer/ktime.h"
+#include "lib/spinlock/spinlock.h"
+
+static uint16_t ide_bm_base = 0;
+static bool ide_dma_enabled = false;
+
+// Set once the drive said it takes LBA48 commands
+static bool ide_lba48 = false;
+
+// The descriptor table, one page so it never crosses a 64KB boundary
+static struct ide_prd* ide_prdt = NULL;
+static uint32_t ide_prdt_physical = 0;
+
+// Set by the interrupt handler once the transfer has ended
+static bool ide_dma_done = false;
+static uint8_t ide_dma_bm_status = 0;
+static uint8_t ide_dma_ata_status = 0;
+
+// Set instead when the transfer never ended, the timer knows its transfer by the sequence number
+static bool ide_dma_timed_out = false;
+static uint64_t ide_dma_sequence = 0;
+static struct ktimer ide_dma_timer;
+
+// Guards the completion state above between the reader and the interrupt
+static struct spinlock ide_lock;
+static struct waitqueue ide_waiters;
+
+/**
+ * Ends the transfer, reading the drive status also drops its interrupt line
+ */
+static void ide_dma_complete()
+{
+    ide_dma_bm_status = insb(ide_bm_base + IDE_BM_STATUS);
+    outb(ide_bm_base + IDE_BM_COMMAND, 0);
+    ide_dma_ata_status = insb(IDE_PRIMARY_STATUS_PORT);
+
+    // Write one to clear the interrupt and error bits
+    outb(ide_bm_base + IDE_BM_STATUS, IDE_BM_STATUS_INTERRUPT | IDE_BM_STATUS_ERROR);
+    ide_dma_done = true;
+}
+
+static void ide_dma_timeout(struct ktimer* timer)
+{
+    uint64_t flags = spin_lock_irqsave(&ide_lock);
+    if ((uint64_t)(uintptr_t) timer->data == ide_dma_sequence && !ide_dma_done)
+    {
+        outb(ide_bm_base + IDE_BM_COMMAND, 0);
+        ide_dma_timed_out = true;
+        ide_dma_done = true;
+        waitqueue_wake_all(&ide_waiters);
+    }
+    spin_unlock_irqrestore(&ide_lock, flags);
+}
+
+/**
+ * Software reset of the channel, it leaves the drive ready for PIO after the engine hung
+ */
+static void ide_reset()
+{
+    outb(IDE_PRIMARY_CONTROL_PORT, IDE_CONTROL_SRST);
+    timer_pit_delay_us(5);
+    outb(IDE_PRIMARY_CONTROL_PORT, 0);
+    for (int ms = 0; ms < IDE_DMA_TIMEOUT_MS && (insb(IDE_PRIMARY_STATUS_PORT) & IDE_STATUS_BUSY); ms++)
+    {
+        timer_pit_delay_us(1000);
+    }
+}
+
+static void ide_interrupt_handler(struct interrupt_frame* frame)
+{
+    spin_lock(&ide_lock);
+    if (ide_dma_enabled && !ide_dma_done && (insb(ide_bm_base + IDE_BM_STATUS) & IDE_BM_STATUS_INTERRUPT))
+    {
+        ide_dma_complete();
+        waitqueue_wake_all(&ide_waiters);
+    }
+    else
+    {
+        // A PIO transfer or a stray interrupt, acknowledge the drive
+        insb(IDE_PRIMARY_STATUS_PORT);
+    }
+    spin_unlock(&ide_lock);
+}
+
+int ide_dma_init()
+{
+    int res = 0;
+    spinlock_init(&ide_lock, "ide");
+    waitqueue_init(&ide_waiters);
+    ktimer_init(&ide_dma_timer, ide_dma_timeout, NULL);
+
+    struct pci_device* device = NULL;
+    for (int i = 0; (device = pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_STORAGE_IDE, i)); i++)
+    {
+        // The task file ports are fixed, only a compatibility mode primary channel will do
+        if ((device->prog_if & IDE_PROG_IF_BUS_MASTER) &&
+            !(device->prog_if & IDE_PROG_IF_PRIMARY_NATIVE) &&
+            device->bar_is_io[IDE_BM_BAR] && device->bars[IDE_BM_BAR])
+        {
+            break;
+        }
+    }
+
+    if (!device)
+    {
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    ide_prdt = kzalloc(PAGING_PAGE_SIZE);
+    if (!ide_prdt)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    uint64_t physical = (uint64_t) paging_get_physical_address(kernel_desc(), ide_prdt);
+    if (!physical || physical > 0xFFFFFFFF)
+    {
+        // The engine only takes 32 bit addresses
+        res = -ENOMEM;
+        goto out;
+    }
+
+    ide_prdt_physical = physical;
+    ide_bm_base = device->bars[IDE_BM_BAR];
+    pci_enable(device, PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    idt_register_interrupt_callback(IDE_INTERRUPT, ide_interrupt_handler);
+    outb(IDE_PRIMARY_CONTROL_PORT, 0);
+    IRQ_enable(IRQ_PRIMARY_ATA_HDD);
+    ide_dma_enabled = true;
+    print("IDE bus master DMA enabled\n");
+
+out:
+    return res;
+}
+
+/**
+ * Waits for the drive to drop BSY and, unless ready is zero, raise one of the ready bits
+ * \return Returns the status or -ENOTFOUND when the drive did not get there in time
+ */
+static int ide_identify_wait(uint8_t ready)
+{
+    for (int ms = 0; ms < IDE_IDENTIFY_TIMEOUT_MS; ms++)
+    {
+        uint8_t status = insb(IDE_PRIMARY_STATUS_PORT);
+        if (!(status & IDE_STATUS_BUSY) && (!ready || (status & ready)))
+        {
+            return status;
+        }
+
+        timer_pit_delay_us(1000);
+    }
+
+    return -ENOTFOUND;
+}
+
+int ide_identify()
+{
+    // A floating bus reads all ones, BSY included, so look before waiting on it
+    uint8_t status = insb(IDE_PRIMARY_STATUS_PORT);
+    if (status == 0 || status == 0xFF || ide_identify_wait(0) < 0)
+    {
+        // Nothing on the channel
+        return -ENOTFOUND;
+    }
+
+    outb(IDE_PRIMARY_DRIVE_PORT, IDE_DRIVE_MASTER_LBA);
+    outb(IDE_PRIMARY_COMMAND_PORT, IDE_COMMAND_IDENTIFY);
+    status = insb(IDE_PRIMARY_STATUS_PORT);
+    if (status == 0 || status == 0xFF)
+    {
+        return -ENOTFOUND;
+    }
+
+    // A packet device aborts the command
+    int res = ide_identify_wait(IDE_STATUS_DRQ | IDE_STATUS_ERROR);
+    if (res < 0 || (res & IDE_STATUS_ERROR))
+    {
+        return -ENOTFOUND;
+    }
+
+    uint16_t identify[256];
+    for (int word = 0; word < 256; word++)
+    {
+        identify[word] = insw(IDE_PRIMARY_DATA_PORT);
+    }
+
+    ide_lba48 = (identify[IDE_IDENTIFY_COMMAND_SETS] & IDE_IDENTIFY_LBA48) != 0;
+    return 0;
+}
+
+int ide_max_sectors()
+{
+    return ide_lba48 ? IDE_LBA48_MAX_SECTORS : IDE_LBA28_MAX_SECTORS;
+}
+
+/**
+ * \return Returns false when the sectors lie past what LBA28 reaches and the drive has nothing else
+ */
+static bool ide_in_reach(uint64_t lba, int total)
+{
+    return ide_lba48 || lba + total <= IDE_LBA28_LIMIT;
+}
+
+int ide_set_task_file(uint64_t lba, int total)
+{
+    if (lba + total <= IDE_LBA28_LIMIT && total <= IDE_LBA28_MAX_SECTORS)
+    {
+        outb(IDE_PRIMARY_DRIVE_PORT, IDE_DRIVE_MASTER_LBA | ((lba >> 24) & 0x0F));
+        outb(IDE_PRIMARY_SECTOR_COUNT_PORT, (uint8_t) total);
+        outb(IDE_PRIMARY_LBA_LOW_PORT, (uint8_t) lba);
+        outb(IDE_PRIMARY_LBA_MID_PORT, (uint8_t) (lba >> 8));
+        outb(IDE_PRIMARY_LBA_HIGH_PORT, (uint8_t) (lba >> 16));
+        return 0;
+    }
+
+    if (!ide_lba48)
+    {
+        return -EIO;
+    }
+
+    // Each register holds two bytes, the high one is written first
+    outb(IDE_PRIMARY_DRIVE_PORT, IDE_DRIVE_MASTER_LBA48);
+    outb(IDE_PRIMARY_SECTOR_COUNT_PORT, (uint8_t) (total >> 8));
+    outb(IDE_PRIMARY_LBA_LOW_PORT, (uint8_t) (lba >> 24));
+    outb(IDE_PRIMARY_LBA_MID_PORT, (uint8_t) (lba >> 32));
+    outb(IDE_PRIMARY_LBA_HIGH_PORT, (uint8_t) (lba >> 40));
+    outb(IDE_PRIMARY_SECTOR_COUNT_PORT, (uint8_t) total);
+    outb(IDE_PRIMARY_LBA_LOW_PORT, (uint8_t) lba);
+    outb(IDE_PRIMARY_LBA_MID_PORT, (uint8_t) (lba >> 8));
+    outb(IDE_PRIMARY_LBA_HIGH_PORT, (uint8_t) (lba >> 16));
+    return 1;
+}
+
+/**
+ * Describes the buffer one page at a time, pages need not be physically contiguous
+ * \return Returns -EUNIMP when some of it is out of reach of the engine
+ */
+static int ide_dma_build_prdt(void* buf, size_t size)
+{
+    int total = 0;
+    while (size > 0)
+    {
+        uint64_t physical = (uint64_t) paging_get_physical_address(kernel_desc(), buf);
+        size_t chunk = PAGING_PAGE_SIZE - ((uint64_t) buf % PAGING_PAGE_SIZE);
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        // Addresses must be even and below 4GB
+        if (!physical || (physical & 1) || physical + chunk > 0x100000000ULL || total >= IDE_MAX_PRDS)
+        {
+            return -EUNIMP;
+        }
+
+        ide_prdt[total].address = physical;
+        ide_prdt[total].byte_count = chunk;
+        ide_prdt[total].flags = 0;
+        total++;
+        buf += chunk;
+        size -= chunk;
+    }
+
+    ide_prdt[total - 1].flags = IDE_PRD_END_OF_TABLE;
+    return 0;
+}
+
+/**
+ * \param write True when the engine reads the buffer and the drive writes it out
+ * \param engine_fault_out Set when the engine rather than the drive failed, or the transfer hung
+ * \return Returns -EIO when the drive reported an error, such as a bad sector
+ */
+static int ide_dma_transfer(uint64_t lba, int total, void* buf, bool write, bool* engine_fault_out)
+{
+    int res = ide_dma_build_prdt(buf, total * PEACHOS_SECTOR_SIZE);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    while (insb(IDE_PRIMARY_STATUS_PORT) & IDE_STATUS_BUSY)
+    {
+        // spin
+    }
+
+    uint64_t flags = spin_lock_irqsave(&ide_lock);
+    ide_dma_done = false;
+    ide_dma_timed_out = false;
+    ide_dma_sequence++;
+    outb(ide_bm_base + IDE_BM_COMMAND, 0);
+    outdw(ide_bm_base + IDE_BM_PRDT, ide_prdt_physical);
+    outb(ide_bm_base + IDE_BM_STATUS, IDE_BM_STATUS_INTERRUPT | IDE_BM_STATUS_ERROR);
+    uint8_t direction = write ? 0 : IDE_BM_COMMAND_READ;
+    outb(ide_bm_base + IDE_BM_COMMAND, direction);
+
+    int ext = ide_set_task_file(lba, total);
+    if (ext < 0)
+    {
+        spin_unlock_irqrestore(&ide_lock, flags);
+        return ext;
+    }
+
+    uint8_t command = write ? IDE_COMMAND_WRITE_DMA : IDE_COMMAND_READ_DMA;
+    if (ext)
+    {
+        command = write ? IDE_COMMAND_WRITE_DMA_EXT : IDE_COMMAND_READ_DMA_EXT;
+    }
+    outb(IDE_PRIMARY_COMMAND_PORT, command);
+    outb(ide_bm_base + IDE_BM_COMMAND, direction | IDE_BM_COMMAND_START);
+
+    if (task_can_sleep())
+    {
+        // Other tasks run while the engine moves the data
+        ide_dma_timer.data = (void*)(uintptr_t) ide_dma_sequence;
+        ktimer_add(&ide_dma_timer, timer_ticks() + ktime_ns_to_ticks(IDE_DMA_TIMEOUT_MS * 1000000ULL));
+        while (!ide_dma_done)
+        {
+            waitqueue_add(&ide_waiters, task_current());
+            spin_unlock_irqrestore(&ide_lock, flags);
+            task_next();
+            flags = spin_lock_irqsave(&ide_lock);
+        }
+        ktimer_del(&ide_dma_timer);
+    }
+    else
+    {
+        // Boot code has nothing to switch to, watch the engine instead
+        int waited_us = 0;
+        while (!(insb(ide_bm_base + IDE_BM_STATUS) & IDE_BM_STATUS_INTERRUPT) && waited_us < IDE_DMA_TIMEOUT_MS * 1000)
+        {
+            timer_pit_delay_us(10);
+            waited_us += 10;
+        }
+
+        if (insb(ide_bm_base + IDE_BM_STATUS) & IDE_BM_STATUS_INTERRUPT)
+        {
+            ide_dma_complete();
+        }
+        else
+        {
+            outb(ide_bm_base + IDE_BM_COMMAND, 0);
+            ide_dma_timed_out = true;
+        }
+    }
+
+    if (ide_dma_timed_out || (ide_dma_bm_status & IDE_BM_STATUS_ERROR))
+    {
+        *engine_fault_out = true;
+        res = -EIO;
+    }
+    else if (ide_dma_ata_status & IDE_STATUS_ERROR)
+    {
+        // The drive failed the command, the engine is fine
+        res = -EIO;
+    }
+    spin_unlock_irqrestore(&ide_lock, flags);
+    return res;
+}
+
+static int ide_dma_rw(uint64_t lba, int total, void* buf, bool write)
+{
+    int res = 0;
+    if (!ide_dma_enabled)
+    {
+        return -EUNIMP;
+    }
+
+    if (!ide_in_reach(lba, total))
+    {
+        // Not a fault of the engine, PIO could not do better
+        return -EIO;
+    }
+
+    while (total > 0)
+    {
+        int max = ide_max_sectors() < IDE_DMA_MAX_SECTORS ? ide_max_sectors() : IDE_DMA_MAX_SECTORS;
+        int count = total > max ? max : total;
+        bool engine_fault = false;
+        res = ide_dma_transfer(lba, count, buf, write, &engine_fault);
+        if (engine_fault)
+        {
+            // Give up on the engine rather than fail every transfer from now on,
+            // an error the drive reports is passed on with DMA left enabled
+            print("IDE DMA engine failed, falling back to PIO\n");
+            ide_dma_enabled = false;
+            ide_reset();
+            res = -EUNIMP;
+        }
+
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        lba += count;
+        total -= count;
+        buf += count * PEACHOS_SECTOR_SIZE;
+    }
+
+out:
+    return res;
+}
+
+int ide_dma_read(uint64_t lba, int total, void* buf)
+{
+    return ide_dma_rw(lba, total, buf, false);
+}
+
+int ide_dma_write(uint64_t lba, int total, void* buf)
+{
+    return ide_dma_rw(lba, total, buf, true);
+}
@@ -0,0 +1,165 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_IDEDMA_H
+#define KERNEL_IDEDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Primary channel task file, the legacy compatibility ports
+#define IDE_PRIMARY_DATA_PORT 0x1F0
+#define IDE_PRIMARY_SECTOR_COUNT_PORT 0x1F2
+#define IDE_PRIMARY_LBA_LOW_PORT 0x1F3
+#define IDE_PRIMARY_LBA_MID_PORT 0x1F4
+#define IDE_PRIMARY_LBA_HIGH_PORT 0x1F5
+#define IDE_PRIMARY_DRIVE_PORT 0x1F6
+#define IDE_PRIMARY_COMMAND_PORT 0x1F7
+#define IDE_PRIMARY_STATUS_PORT 0x1F7
+#define IDE_PRIMARY_CONTROL_PORT 0x3F6
+
+#define IDE_STATUS_ERROR 0x01
+#define IDE_STATUS_DRQ 0x08
+#define IDE_STATUS_BUSY 0x80
+
+// Master drive, LBA addressing, bits 3 to 0 carry LBA bits 27 to 24
+#define IDE_DRIVE_MASTER_LBA 0xE0
+
+// Master drive for LBA48 commands, the address and count are written twice instead
+#define IDE_DRIVE_MASTER_LBA48 0x40
+
+// LBA28 commands reach the first 128GB and take an eight bit count, zero meaning 256
+#define IDE_LBA28_LIMIT (1ULL << 28)
+#define IDE_LBA28_MAX_SECTORS 256
+
+// LBA48 commands take a sixteen bit count, zero meaning 65536
+#define IDE_LBA48_MAX_SECTORS 65536
+
+// Word 83 of the identify data, bit 10 set when the drive takes LBA48 commands
+#define IDE_IDENTIFY_COMMAND_SETS 83
+#define IDE_IDENTIFY_LBA48 (1 << 10)
+
+// Device control, clearing nIEN lets the drive raise IRQ14
+#define IDE_CONTROL_NIEN 0x02
+#define IDE_CONTROL_SRST 0x04
+
+// A DMA command that has not finished by then is taken as a hung engine
+#define IDE_DMA_TIMEOUT_MS 1000
+
+// How long the drive may stay busy or take to answer IDENTIFY before the channel is taken as empty
+#define IDE_IDENTIFY_TIMEOUT_MS 500
+
+#define IDE_COMMAND_IDENTIFY 0xEC
+#define IDE_COMMAND_READ_SECTORS 0x20
+#define IDE_COMMAND_READ_SECTORS_EXT 0x24
+#define IDE_COMMAND_WRITE_SECTORS 0x30
+#define IDE_COMMAND_WRITE_SECTORS_EXT 0x34
+#define IDE_COMMAND_READ_DMA 0xC8
+#define IDE_COMMAND_READ_DMA_EXT 0x25
+#define IDE_COMMAND_WRITE_DMA 0xCA
+#define IDE_COMMAND_WRITE_DMA_EXT 0x35
+
+// Bus master registers of the primary channel, at the I/O base in BAR4
+#define IDE_BM_COMMAND 0x00
+#define IDE_BM_STATUS 0x02
+#define IDE_BM_PRDT 0x04
+#define IDE_BM_BAR 4
+
+#define IDE_BM_COMMAND_START 0x01
+#define IDE_BM_COMMAND_READ 0x08    // The engine writes to memory
+
+#define IDE_BM_STATUS_ACTIVE 0x01
+#define IDE_BM_STATUS_ERROR 0x02
+#define IDE_BM_STATUS_INTERRUPT 0x04
+
+// Programming interface bits, bit zero set means the primary channel is in native mode
+#define IDE_PROG_IF_PRIMARY_NATIVE 0x01
+#define IDE_PROG_IF_BUS_MASTER 0x80
+
+// A physical region descriptor covers at most 64KB and may not cross a 64KB boundary
+#define IDE_PRD_END_OF_TABLE 0x8000
+
+// The table fills its page, eight bytes a descriptor
+#define IDE_MAX_PRDS 512
+
+// Each descriptor covers at least a page of the buffer, an unaligned buffer takes one more
+#define IDE_DMA_MAX_SECTORS ((IDE_MAX_PRDS - 1) * (4096 / 512))
+
+#define IDE_INTERRUPT 0x2E
+
+/**
+ * Physical region descriptor, one physically contiguous piece of the buffer
+ */
+struct ide_prd
+{
+    uint32_t address;
+    uint16_t byte_count;
+    uint16_t flags;
+} __attribute__((packed));
+
+/**
+ * Asks the primary master what it supports, until then only LBA28 commands are used
+ * \return Returns -ENOTFOUND when no ATA drive answers
+ */
+int ide_identify();
+
+/**
+ * Sectors one command of the primary master can move, the drive must have been identified
+ */
+int ide_max_sectors();
+
+/**
+ * Loads the address and sector count of a command for the primary master.
+ * Commands within reach of LBA28 keep the form every drive knows, the rest
+ * use LBA48. The drive must not be busy.
+ * \param total Sectors, at most ide_max_sectors()
+ * \return Returns 1 when the EXT form of the command must be issued, -EIO
+ * when the drive cannot reach the sectors
+ */
+int ide_set_task_file(uint64_t lba, int total);
+
+/**
+ * Looks for a PCI IDE controller with a bus master engine driving the legacy
+ * primary channel, such as the PIIX of QEMU, and takes IRQ14
+ * \return Returns -ENOTFOUND when there is none, reads then stay on PIO
+ */
+int ide_dma_init();
+
+/**
+ * Reads sectors of the primary master with bus master DMA. A task sleeps
+ * until the IRQ14 completion, boot code polls the engine instead. The
+ * caller must own the channel.
+ * \return Returns -EUNIMP when DMA is not possible for this buffer, the caller should use PIO
+ */
+int ide_dma_read(uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors of the primary master with bus master DMA, the same rules as ide_dma_read() apply
+ */
+int ide_dma_write(uint64_t lba, int total, void* buf);
+
+#endif
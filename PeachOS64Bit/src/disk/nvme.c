@@ -0,0 +1,989 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "nvme.h"
+#include "disk.h"
+#include "blkqueue.h"
+#include "kernel.h"
+#include "status.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "pci/pci.h"
+#include "apic/lapic.h"
+#include "smp/smp.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "string/string.h"
+#include "task/task.h"
+#include "timer/timer.h"
+
+static struct nvme_controller* nvme_controllers = NULL;
+
+static uint32_t nvme_read32(struct nvme_controller* controller, uint32_t reg)
+{
+    return *(volatile uint32_t*)(controller->registers + reg);
+}
+
+static void nvme_write32(struct nvme_controller* controller, uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t*)(controller->registers + reg) = value;
+}
+
+// 64 bit registers are accessed a half at a time, low half first
+static uint64_t nvme_read64(struct nvme_controller* controller, uint32_t reg)
+{
+    uint64_t low = nvme_read32(controller, reg);
+    return low | ((uint64_t) nvme_read32(controller, reg + 4) << 32);
+}
+
+static void nvme_write64(struct nvme_controller* controller, uint32_t reg, uint64_t value)
+{
+    nvme_write32(controller, reg, value);
+    nvme_write32(controller, reg + 4, value >> 32);
+}
+
+static uint64_t nvme_physical(void* address)
+{
+    return (uint64_t) paging_get_physical_address(kernel_desc(), address);
+}
+
+static int nvme_queue_alloc(struct nvme_controller* controller, struct nvme_queue* queue, int id, uint16_t size, int slots)
+{
+    queue->controller = controller;
+    queue->id = id;
+    queue->size = size;
+    queue->phase = NVME_COMPLETION_PHASE;
+    queue->slot_mask = slots >= 32 ? 0xFFFFFFFF : (1U << slots) - 1;
+    spinlock_init(&queue->lock, "nvme");
+    waitqueue_init(&queue->waiters);
+
+    // Submission queue y is doorbell 2y, its completion queue 2y + 1
+    queue->sq_doorbell = (volatile uint32_t*)(controller->registers + NVME_DOORBELL_BASE + (2 * id) * controller->doorbell_stride);
+    queue->cq_doorbell = (volatile uint32_t*)(controller->registers + NVME_DOORBELL_BASE + (2 * id + 1) * controller->doorbell_stride);
+
+    queue->sq = kzalloc(PAGING_PAGE_SIZE);
+    queue->cq = kzalloc(PAGING_PAGE_SIZE);
+    if (!queue->sq || !queue->cq)
+    {
+        return -ENOMEM;
+    }
+
+    int lists_per_page = PAGING_PAGE_SIZE / NVME_PRP_LIST_SIZE;
+    for (int slot = 0; slot < slots; slot += lists_per_page)
+    {
+        void* lists = kzalloc(PAGING_PAGE_SIZE);
+        if (!lists)
+        {
+            return -ENOMEM;
+        }
+
+        for (int i = 0; i < lists_per_page && slot + i < slots; i++)
+        {
+            queue->prp_lists[slot + i] = lists + i * NVME_PRP_LIST_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Frees the memory nvme_queue_alloc() gave the queue, the controller must no longer know about it
+ */
+static void nvme_queue_free(struct nvme_queue* queue)
+{
+    int lists_per_page = PAGING_PAGE_SIZE / NVME_PRP_LIST_SIZE;
+    for (int slot = 0; slot < NVME_MAX_SLOTS; slot += lists_per_page)
+    {
+        if (queue->prp_lists[slot])
+        {
+            kfree(queue->prp_lists[slot]);
+        }
+    }
+
+    if (queue->sq)
+    {
+        kfree(queue->sq);
+    }
+
+    if (queue->cq)
+    {
+        kfree((void*) queue->cq);
+    }
+}
+
+/**
+ * Places the command on the submission queue, the controller is not told yet.
+ * The queue lock must be held.
+ */
+static void nvme_queue_push(struct nvme_queue* queue, struct nvme_command* command)
+{
+    memcpy(&queue->sq[queue->sq_tail], command, sizeof(struct nvme_command));
+    queue->sq_tail = (queue->sq_tail + 1) % queue->size;
+}
+
+/**
+ * Tells the controller about every command pushed since the doorbell was last rung
+ */
+static void nvme_queue_ring(struct nvme_queue* queue)
+{
+    if (queue->sq_rung == queue->sq_tail)
+    {
+        return;
+    }
+
+    // The entries must be in memory before the controller goes looking
+    __sync_synchronize();
+    *queue->sq_doorbell = queue->sq_tail;
+    queue->sq_rung = queue->sq_tail;
+}
+
+/**
+ * Moves the slots the controller has finished with over to completed, the queue lock must be held
+ */
+static void nvme_queue_reap(struct nvme_queue* queue)
+{
+    bool reaped = false;
+    while ((queue->cq[queue->cq_head].status & NVME_COMPLETION_PHASE) == queue->phase)
+    {
+        volatile struct nvme_completion* completion = &queue->cq[queue->cq_head];
+        uint16_t slot = completion->command_id;
+        if (slot < NVME_MAX_SLOTS)
+        {
+            // Anything but a zero status code and type is an error
+            if (completion->status >> 1)
+            {
+                queue->failed |= 1U << slot;
+            }
+            queue->results[slot] = completion->result;
+            queue->completed |= 1U << slot;
+        }
+
+        queue->cq_head++;
+        if (queue->cq_head == queue->size)
+        {
+            queue->cq_head = 0;
+            queue->phase ^= NVME_COMPLETION_PHASE;
+        }
+        reaped = true;
+    }
+
+    if (reaped)
+    {
+        *queue->cq_doorbell = queue->cq_head;
+    }
+}
+
+/**
+ * Runs an admin command and polls for it, admin commands are rare enough
+ * \param result_out Receives the command specific result, may be NULL
+ */
+static int nvme_admin(struct nvme_controller* controller, struct nvme_command* command, uint32_t* result_out)
+{
+    int res = 0;
+    struct nvme_queue* queue = &controller->admin;
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    if (controller->broken)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    command->command_id = 0;
+    nvme_queue_push(queue, command);
+    nvme_queue_ring(queue);
+    for (int us = 0; !(queue->completed & 1); us += NVME_POLL_US)
+    {
+        if (us >= NVME_ADMIN_TIMEOUT_MS * 1000)
+        {
+            // The command id could come back at any time, nothing more is sent
+            controller->broken = true;
+            res = -EIO;
+            goto out;
+        }
+
+        timer_pit_delay_us(NVME_POLL_US);
+        nvme_queue_reap(queue);
+    }
+
+    if (queue->failed & 1)
+    {
+        res = -EIO;
+    }
+
+    if (result_out)
+    {
+        *result_out = queue->results[0];
+    }
+
+    queue->completed = 0;
+    queue->failed = 0;
+
+out:
+    spin_unlock_irqrestore(&queue->lock, flags);
+    return res;
+}
+
+static int nvme_identify(struct nvme_controller* controller, uint8_t cns, uint32_t namespace_id, void* buf)
+{
+    struct nvme_command command = {0};
+    command.opcode = NVME_ADMIN_IDENTIFY;
+    command.namespace_id = namespace_id;
+    command.prp1 = nvme_physical(buf);
+    command.cdw10 = cns;
+    return nvme_admin(controller, &command, NULL);
+}
+
+static void nvme_interrupt_handler(struct interrupt_frame* frame);
+
+/**
+ * Creates I/O queue pair id
+ * \param destination APIC id of the processor its completions interrupt
+ * \return Returns NULL when the controller would not take it
+ */
+static struct nvme_queue* nvme_io_queue_create(struct nvme_controller* controller, int id, uint8_t destination)
+{
+    bool cq_created = false;
+    struct nvme_command command = {0};
+    if (controller->broken)
+    {
+        return NULL;
+    }
+
+    struct nvme_queue* queue = kzalloc(sizeof(struct nvme_queue));
+    if (!queue)
+    {
+        return NULL;
+    }
+
+    int slots = controller->io_queue_size - 1;
+    if (slots > NVME_MAX_SLOTS)
+    {
+        slots = NVME_MAX_SLOTS;
+    }
+
+    if (nvme_queue_alloc(controller, queue, id, controller->io_queue_size, slots) < 0)
+    {
+        goto fail;
+    }
+
+    // MSI-X entry zero belongs to the admin queue, which is polled
+    int vector = IRQ_msi_vector_alloc();
+    if (vector > 0 && pci_enable_msix(controller->pci, id, destination, vector) == 0)
+    {
+        queue->vector = vector;
+    }
+    else if (vector > 0)
+    {
+        IRQ_msi_vector_free(vector);
+    }
+
+    command.opcode = NVME_ADMIN_CREATE_IO_CQ;
+    command.prp1 = nvme_physical((void*) queue->cq);
+    command.cdw10 = ((uint32_t)(queue->size - 1) << 16) | id;
+    command.cdw11 = NVME_QUEUE_PHYSICALLY_CONTIGUOUS;
+    if (queue->vector)
+    {
+        command.cdw11 |= NVME_QUEUE_INTERRUPTS_ENABLED | ((uint32_t) id << 16);
+    }
+
+    if (nvme_admin(controller, &command, NULL) < 0)
+    {
+        goto fail;
+    }
+    cq_created = true;
+
+    memset(&command, 0, sizeof(command));
+    command.opcode = NVME_ADMIN_CREATE_IO_SQ;
+    command.prp1 = nvme_physical(queue->sq);
+    command.cdw10 = ((uint32_t)(queue->size - 1) << 16) | id;
+    command.cdw11 = ((uint32_t) id << 16) | NVME_QUEUE_PHYSICALLY_CONTIGUOUS;
+    if (nvme_admin(controller, &command, NULL) < 0)
+    {
+        goto fail;
+    }
+
+    if (queue->vector)
+    {
+        idt_register_interrupt_callback(queue->vector, nvme_interrupt_handler);
+    }
+    return queue;
+
+fail:
+    if (queue->vector)
+    {
+        // Nothing handles the vector, the entry must not raise it
+        pci_disable_msix(controller->pci, id);
+        IRQ_msi_vector_free(queue->vector);
+    }
+
+    if (cq_created)
+    {
+        memset(&command, 0, sizeof(command));
+        command.opcode = NVME_ADMIN_DELETE_IO_CQ;
+        command.cdw10 = id;
+        if (nvme_admin(controller, &command, NULL) < 0)
+        {
+            // The controller may still post completions into it, the memory is left to it
+            return NULL;
+        }
+    }
+    else if (controller->broken)
+    {
+        // The create timed out, whether the controller took the queue is not known
+        return NULL;
+    }
+
+    nvme_queue_free(queue);
+    kfree(queue);
+    return NULL;
+}
+
+/**
+ * Returns the queue pair of the calling processor
+ */
+static struct nvme_queue* nvme_io_queue(struct nvme_controller* controller)
+{
+    struct nvme_queue* queue = controller->io_queues[smp_cpu_current()->id % controller->total_io_queues];
+    return queue ? queue : controller->io_queues[0];
+}
+
+/**
+ * Fills in an I/O command for the slot, the pages after the first go on its
+ * PRP list. A flush carries no LBA range and no data.
+ */
+static int nvme_prepare(struct nvme_queue* queue, int slot, struct nvme_namespace* ns, uint8_t opcode, uint64_t lba, int total, void* buf, struct nvme_command* command)
+{
+    memset(command, 0, sizeof(struct nvme_command));
+    command->opcode = opcode;
+    command->command_id = slot;
+    command->namespace_id = ns->id;
+    if (opcode == NVME_IO_FLUSH)
+    {
+        return 0;
+    }
+
+    command->cdw10 = lba;
+    command->cdw11 = lba >> 32;
+    command->cdw12 = total - 1;
+
+    uint64_t* list = queue->prp_lists[slot];
+    size_t size = total * PEACHOS_SECTOR_SIZE;
+    int pages = 0;
+    while (size > 0)
+    {
+        uint64_t physical = nvme_physical(buf);
+        size_t chunk = PAGING_PAGE_SIZE - ((uintptr_t) buf % PAGING_PAGE_SIZE);
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        // Addresses must be dword aligned
+        if (!physical || (physical & 3) || pages > NVME_PRP_LIST_ENTRIES)
+        {
+            return -EIO;
+        }
+
+        if (pages == 0)
+        {
+            command->prp1 = physical;
+        }
+        else
+        {
+            list[pages - 1] = physical;
+        }
+        pages++;
+        buf += chunk;
+        size -= chunk;
+    }
+
+    // Two pages fit the command itself, more need the list
+    if (pages == 2)
+    {
+        command->prp2 = list[0];
+    }
+    else if (pages > 2)
+    {
+        command->prp2 = nvme_physical(list);
+    }
+
+    return 0;
+}
+
+/**
+ * Submits the parts of the pending request queue commands into the free
+ * slots and rings the doorbell once for them, the queue lock must be held
+ * \param done Receives the commands with nothing left to submit or wait for
+ */
+static void nvme_queue_issue_pending(struct nvme_queue* queue, struct blk_command** done)
+{
+    while (queue->pending)
+    {
+        struct blk_command* command = queue->pending;
+        struct nvme_namespace* ns = command->queue->device->driver_private;
+        uint32_t free = queue->slot_mask & ~queue->busy;
+        if (command->result < 0)
+        {
+            // Part of it failed, the rest is not worth submitting
+            command->issued = command->total;
+        }
+        else if (free)
+        {
+            struct nvme_command nvme_command;
+            int slot = __builtin_ctz(free);
+            int count = command->total - command->issued;
+            if (count > ns->controller->max_sectors)
+            {
+                count = ns->controller->max_sectors;
+            }
+
+            uint8_t opcode = command->op == BLK_REQUEST_WRITE ? NVME_IO_WRITE : NVME_IO_READ;
+            void* buf = command->buf + command->issued * PEACHOS_SECTOR_SIZE;
+            if (nvme_prepare(queue, slot, ns, opcode, command->lba + command->issued, count, buf, &nvme_command) < 0)
+            {
+                command->result = -EIO;
+                continue;
+            }
+
+            queue->busy |= 1U << slot;
+            queue->commands[slot] = command;
+            command->outstanding++;
+            command->issued += count;
+            nvme_queue_push(queue, &nvme_command);
+        }
+
+        if (command->issued < command->total)
+        {
+            if (!free)
+            {
+                // The rest goes out as slots come back
+                break;
+            }
+            continue;
+        }
+
+        queue->pending = command->next;
+        if (!queue->pending)
+        {
+            queue->pending_tail = NULL;
+        }
+
+        command->next = NULL;
+        if (!command->outstanding)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+
+    nvme_queue_ring(queue);
+}
+
+/**
+ * Frees the finished slots that carried request queue commands and submits
+ * what is pending into them, the queue lock must be held
+ * \param done Receives the commands that are finished, to be completed once the lock is dropped
+ */
+static void nvme_queue_collect(struct nvme_queue* queue, struct blk_command** done)
+{
+    uint32_t finished = queue->completed;
+    uint32_t freed = 0;
+    while (finished)
+    {
+        int slot = __builtin_ctz(finished);
+        uint32_t bit = 1U << slot;
+        finished &= ~bit;
+        struct blk_command* command = queue->commands[slot];
+        if (!command)
+        {
+            // A reader of our own collects it
+            continue;
+        }
+
+        if (queue->failed & bit)
+        {
+            command->result = -EIO;
+        }
+
+        queue->commands[slot] = NULL;
+        queue->completed &= ~bit;
+        queue->failed &= ~bit;
+        queue->busy &= ~bit;
+        freed |= bit;
+        command->outstanding--;
+        if (!command->outstanding && command->issued == command->total)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+
+    if (freed)
+    {
+        // Readers of our own may be waiting for a free slot
+        nvme_queue_issue_pending(queue, done);
+        waitqueue_wake_all(&queue->waiters);
+    }
+}
+
+static void nvme_interrupt_handler(struct interrupt_frame* frame)
+{
+    struct blk_command* done = NULL;
+    for (struct nvme_controller* controller = nvme_controllers; controller; controller = controller->next)
+    {
+        for (int i = 0; i < controller->total_io_queues; i++)
+        {
+            // Processors sharing a queue point at the one of the first of them
+            struct nvme_queue* queue = controller->io_queues[i];
+            if (!queue || queue->id != i + 1 || !queue->vector)
+            {
+                continue;
+            }
+
+            spin_lock(&queue->lock);
+            nvme_queue_reap(queue);
+            nvme_queue_collect(queue, &done);
+            if (queue->completed)
+            {
+                waitqueue_wake_all(&queue->waiters);
+            }
+            spin_unlock(&queue->lock);
+        }
+    }
+
+    // Completing them dispatches more, which takes the queue locks
+    blk_command_complete(done);
+}
+
+/**
+ * Waits for the controller to finish something. The queue lock is held on
+ * entry and on return, a task sleeps without it until the interrupt wakes it.
+ */
+static void nvme_queue_wait(struct nvme_queue* queue, uint64_t* flags)
+{
+    if (queue->vector && lapic_present() && task_can_sleep())
+    {
+        waitqueue_add(&queue->waiters, task_current());
+        spin_unlock_irqrestore(&queue->lock, *flags);
+        task_next();
+        *flags = spin_lock_irqsave(&queue->lock);
+        return;
+    }
+
+    // Boot code, or nothing would wake us, watch the completion queue instead
+    __builtin_ia32_pause();
+    nvme_queue_reap(queue);
+}
+
+/**
+ * Splits the transfer over the free slots, a flush goes out as a single command
+ */
+static int nvme_transfer(struct nvme_namespace* ns, uint8_t opcode, uint64_t lba, int total, void* buf)
+{
+    int res = 0;
+    uint32_t mine = 0;
+    bool submit = true;
+    struct blk_command* done = NULL;
+    struct nvme_queue* queue = nvme_io_queue(ns->controller);
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    while (submit || mine)
+    {
+        uint32_t finished = mine & queue->completed;
+        if (finished)
+        {
+            if (finished & queue->failed)
+            {
+                // Stop submitting, what is in flight still has to come back
+                res = -EIO;
+                submit = false;
+            }
+
+            queue->completed &= ~finished;
+            queue->failed &= ~finished;
+            queue->busy &= ~finished;
+            mine &= ~finished;
+
+            // Request queue commands and readers waiting for a free slot can have these
+            nvme_queue_issue_pending(queue, &done);
+            waitqueue_wake_all(&queue->waiters);
+            continue;
+        }
+
+        uint32_t free = queue->slot_mask & ~queue->busy;
+        if (submit && free)
+        {
+            struct nvme_command command;
+            int slot = __builtin_ctz(free);
+            int count = total > ns->controller->max_sectors ? ns->controller->max_sectors : total;
+            if (nvme_prepare(queue, slot, ns, opcode, lba, count, buf, &command) < 0)
+            {
+                res = -EIO;
+                submit = false;
+                continue;
+            }
+
+            queue->busy |= 1U << slot;
+            mine |= 1U << slot;
+            nvme_queue_push(queue, &command);
+            lba += count;
+            total -= count;
+            buf += count * PEACHOS_SECTOR_SIZE;
+            submit = total > 0;
+            continue;
+        }
+
+        // Everything that fits is queued, one doorbell write covers the lot
+        nvme_queue_ring(queue);
+        nvme_queue_wait(queue, &flags);
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+    blk_command_complete(done);
+    return res;
+}
+
+int nvme_read(struct nvme_namespace* ns, uint64_t lba, int total, void* buf)
+{
+    return nvme_transfer(ns, NVME_IO_READ, lba, total, buf);
+}
+
+int nvme_write(struct nvme_namespace* ns, uint64_t lba, int total, void* buf)
+{
+    return nvme_transfer(ns, NVME_IO_WRITE, lba, total, buf);
+}
+
+int nvme_submit(struct nvme_namespace* ns, struct blk_command* command)
+{
+    struct blk_command* done = NULL;
+    struct nvme_queue* queue = nvme_io_queue(ns->controller);
+    if (!queue->vector || !lapic_present())
+    {
+        // Nothing would tell us it finished
+        return -EUNIMP;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&queue->lock);
+    command->next = NULL;
+    if (queue->pending_tail)
+    {
+        queue->pending_tail->next = command;
+    }
+    else
+    {
+        queue->pending = command;
+    }
+    queue->pending_tail = command;
+    nvme_queue_issue_pending(queue, &done);
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    // Only when it could not be submitted at all
+    blk_command_complete(done);
+    return 0;
+}
+
+void nvme_poll(struct nvme_namespace* ns)
+{
+    struct blk_command* done = NULL;
+    struct nvme_controller* controller = ns->controller;
+    for (int i = 0; i < controller->total_io_queues; i++)
+    {
+        // Processors sharing a queue point at the one of the first of them
+        struct nvme_queue* queue = controller->io_queues[i];
+        if (!queue || queue->id != i + 1)
+        {
+            continue;
+        }
+
+        uint64_t flags = spin_lock_irqsave(&queue->lock);
+        nvme_queue_reap(queue);
+        nvme_queue_collect(queue, &done);
+        spin_unlock_irqrestore(&queue->lock, flags);
+    }
+
+    blk_command_complete(done);
+}
+
+int nvme_flush(struct nvme_namespace* ns)
+{
+    return nvme_transfer(ns, NVME_IO_FLUSH, 0, 0, NULL);
+}
+
+static bool nvme_wait_ready(struct nvme_controller* controller, bool ready, int timeout_ms)
+{
+    for (int ms = 0; ms < timeout_ms; ms++)
+    {
+        uint32_t status = nvme_read32(controller, NVME_REG_CSTS);
+        if (status & NVME_CSTS_FATAL)
+        {
+            return false;
+        }
+
+        if (!!(status & NVME_CSTS_READY) == ready)
+        {
+            return true;
+        }
+        timer_pit_delay_us(1000);
+    }
+
+    return false;
+}
+
+static int nvme_namespace_init(struct nvme_controller* controller, uint32_t id, uint8_t* identify)
+{
+    int res = 0;
+    struct nvme_namespace* ns = NULL;
+    res = nvme_identify(controller, NVME_IDENTIFY_NAMESPACE, id, identify);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    uint64_t total_sectors = *(uint64_t*) &identify[NVME_IDENTIFY_NAMESPACE_NSZE];
+    if (!total_sectors)
+    {
+        // Not an active namespace
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    uint8_t format = identify[NVME_IDENTIFY_NAMESPACE_FLBAS] & NVME_IDENTIFY_FLBAS_FORMAT_MASK;
+    uint32_t lbaf = *(uint32_t*) &identify[NVME_IDENTIFY_NAMESPACE_LBAF + format * sizeof(uint32_t)];
+    if ((1U << ((lbaf >> NVME_LBAF_LBADS_SHIFT) & 0xFF)) != PEACHOS_SECTOR_SIZE)
+    {
+        print("NVMe namespace ");
+        print(itoa(id));
+        print(" is not formatted with 512 byte blocks, skipped\n");
+        res = -EUNIMP;
+        goto out;
+    }
+
+    ns = kzalloc(sizeof(struct nvme_namespace));
+    if (!ns)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    ns->controller = controller;
+    ns->id = id;
+    ns->total_sectors = total_sectors;
+    controller->namespaces[id - 1] = ns;
+
+    print("NVMe namespace ");
+    print(itoa(id));
+    print(": ");
+    print(itoa(ns->total_sectors / 2048));
+    print("MB\n");
+
+    res = disk_create_device(PEACHOS_DISK_TYPE_NVME, PEACHOS_SECTOR_SIZE, ns, &ns->disk);
+
+out:
+    return res;
+}
+
+static int nvme_controller_init(struct pci_device* pci)
+{
+    int res = 0;
+    uint8_t* identify = NULL;
+    if (pci->bar_is_io[NVME_BAR] || !pci->bars[NVME_BAR])
+    {
+        res = -ENOTFOUND;
+        goto out;
+    }
+
+    struct nvme_controller* controller = kzalloc(sizeof(struct nvme_controller));
+    if (!controller)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    controller->pci = pci;
+    pci_enable(pci, PCI_COMMAND_MEMORY_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    // The doorbell stride is only known once the registers can be read
+    controller->registers = pci_map_bar(pci, NVME_BAR, 0, NVME_DOORBELL_BASE);
+    uint64_t cap = nvme_read64(controller, NVME_REG_CAP);
+    controller->doorbell_stride = 4 << ((cap >> NVME_CAP_DSTRD_SHIFT) & NVME_CAP_DSTRD_MASK);
+    pci_map_bar(pci, NVME_BAR, 0, NVME_DOORBELL_BASE + 2 * (PEACHOS_MAX_CPUS + 1) * controller->doorbell_stride);
+
+    if ((cap >> NVME_CAP_MPSMIN_SHIFT) & NVME_CAP_MPSMIN_MASK)
+    {
+        // The smallest page the controller takes is bigger than ours
+        res = -EUNIMP;
+        goto out;
+    }
+
+    controller->io_queue_size = (cap & NVME_CAP_MQES_MASK) + 1;
+    if (controller->io_queue_size > NVME_IO_QUEUE_SIZE)
+    {
+        controller->io_queue_size = NVME_IO_QUEUE_SIZE;
+    }
+
+    int timeout_ms = ((cap >> NVME_CAP_TO_SHIFT) & NVME_CAP_TO_MASK) * NVME_CAP_TO_UNIT_MS;
+    nvme_write32(controller, NVME_REG_CC, 0);
+    if (!nvme_wait_ready(controller, false, timeout_ms))
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    res = nvme_queue_alloc(controller, &controller->admin, 0, NVME_ADMIN_QUEUE_SIZE, 1);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    nvme_write32(controller, NVME_REG_AQA, ((NVME_ADMIN_QUEUE_SIZE - 1) << 16) | (NVME_ADMIN_QUEUE_SIZE - 1));
+    nvme_write64(controller, NVME_REG_ASQ, nvme_physical(controller->admin.sq));
+    nvme_write64(controller, NVME_REG_ACQ, nvme_physical((void*) controller->admin.cq));
+    nvme_write32(controller, NVME_REG_CC, NVME_CC_ENABLE | NVME_CC_IOSQES | NVME_CC_IOCQES);
+    if (!nvme_wait_ready(controller, true, timeout_ms))
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    identify = kzalloc(PAGING_PAGE_SIZE);
+    if (!identify)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = nvme_identify(controller, NVME_IDENTIFY_CONTROLLER, 0, identify);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // The transfer limit is a power of two of the smallest page, zero means none
+    controller->max_sectors = NVME_MAX_SECTORS;
+    uint8_t mdts = identify[NVME_IDENTIFY_CONTROLLER_MDTS];
+    if (mdts && ((PAGING_PAGE_SIZE / PEACHOS_SECTOR_SIZE) << mdts) < controller->max_sectors)
+    {
+        controller->max_sectors = (PAGING_PAGE_SIZE / PEACHOS_SECTOR_SIZE) << mdts;
+    }
+
+    uint32_t total_namespaces = *(uint32_t*) &identify[NVME_IDENTIFY_CONTROLLER_NN];
+    if (total_namespaces > NVME_MAX_NAMESPACES)
+    {
+        total_namespaces = NVME_MAX_NAMESPACES;
+    }
+
+    // Ask for a queue pair per processor we could ever have, the answer counts from zero
+    struct nvme_command command = {0};
+    uint32_t granted = 0;
+    command.opcode = NVME_ADMIN_SET_FEATURES;
+    command.cdw10 = NVME_FEATURE_NUMBER_OF_QUEUES;
+    command.cdw11 = ((PEACHOS_MAX_CPUS - 1) << 16) | (PEACHOS_MAX_CPUS - 1);
+    res = nvme_admin(controller, &command, &granted);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    uint32_t submission_queues = (granted & 0xFFFF) + 1;
+    uint32_t completion_queues = (granted >> 16) + 1;
+    controller->total_io_queues = submission_queues < completion_queues ? submission_queues : completion_queues;
+    if (controller->total_io_queues > PEACHOS_MAX_CPUS)
+    {
+        controller->total_io_queues = PEACHOS_MAX_CPUS;
+    }
+
+    // The queue pair of the bootstrap processor, every other processor falls back on it
+    controller->io_queues[0] = nvme_io_queue_create(controller, 1, IRQ_msi_destination());
+    if (!controller->io_queues[0])
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    controller->next = nvme_controllers;
+    nvme_controllers = controller;
+
+    print("NVMe: up to ");
+    print(itoa(controller->total_io_queues));
+    print(" queue pairs of ");
+    print(itoa(controller->io_queue_size));
+    print(controller->io_queues[0]->vector ? ", MSI-X\n" : ", polled\n");
+
+    for (uint32_t id = 1; id <= total_namespaces; id++)
+    {
+        nvme_namespace_init(controller, id, identify);
+    }
+
+out:
+    if (identify)
+    {
+        kfree(identify);
+    }
+    return res;
+}
+
+int nvme_init()
+{
+    int res = -ENOTFOUND;
+    struct pci_device* pci = NULL;
+    for (int i = 0; (pci = pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_STORAGE_NVM, i)); i++)
+    {
+        if (pci->prog_if != NVME_PROG_IF)
+        {
+            continue;
+        }
+
+        if (nvme_controller_init(pci) == 0)
+        {
+            res = 0;
+        }
+    }
+
+    return res;
+}
+
+void nvme_smp_init()
+{
+    for (struct nvme_controller* controller = nvme_controllers; controller; controller = controller->next)
+    {
+        int total = smp_total_cpus() < controller->total_io_queues ? smp_total_cpus() : controller->total_io_queues;
+        for (int index = 1; index < total; index++)
+        {
+            struct cpu* cpu = smp_cpu(index);
+            if (!cpu || !cpu->started)
+            {
+                continue;
+            }
+
+            controller->io_queues[index] = nvme_io_queue_create(controller, index + 1, cpu->apic_id);
+            if (!controller->io_queues[index])
+            {
+                // Share the first one rather than run without
+                controller->io_queues[index] = controller->io_queues[0];
+            }
+        }
+    }
+}
@@ -0,0 +1,288 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_NVME_H
+#define KERNEL_NVME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "config.h"
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+
+// Programming interface of a non volatile memory controller speaking NVM Express
+#define NVME_PROG_IF 0x02
+
+// The controller registers are memory mapped through BAR0, the doorbells follow them
+#define NVME_BAR 0
+#define NVME_REG_CAP 0x00
+#define NVME_REG_CC 0x14
+#define NVME_REG_CSTS 0x1C
+#define NVME_REG_AQA 0x24
+#define NVME_REG_ASQ 0x28
+#define NVME_REG_ACQ 0x30
+#define NVME_DOORBELL_BASE 0x1000
+
+#define NVME_CAP_MQES_MASK 0xFFFF
+#define NVME_CAP_TO_SHIFT 24
+#define NVME_CAP_TO_MASK 0xFF
+#define NVME_CAP_DSTRD_SHIFT 32
+#define NVME_CAP_DSTRD_MASK 0x0F
+#define NVME_CAP_MPSMIN_SHIFT 48
+#define NVME_CAP_MPSMIN_MASK 0x0F
+
+// Enabled, NVM command set, 4KB pages, 64 byte submission and 16 byte completion entries
+#define NVME_CC_ENABLE 0x00000001
+#define NVME_CC_IOSQES (6 << 16)
+#define NVME_CC_IOCQES (4 << 20)
+
+#define NVME_CSTS_READY 0x01
+#define NVME_CSTS_FATAL 0x02
+
+// The controller timeout in CAP counts in 500ms steps
+#define NVME_CAP_TO_UNIT_MS 500
+
+#define NVME_ADMIN_DELETE_IO_CQ 0x04
+#define NVME_ADMIN_CREATE_IO_SQ 0x01
+#define NVME_ADMIN_CREATE_IO_CQ 0x05
+#define NVME_ADMIN_IDENTIFY 0x06
+#define NVME_ADMIN_SET_FEATURES 0x09
+
+#define NVME_IO_FLUSH 0x00
+#define NVME_IO_WRITE 0x01
+#define NVME_IO_READ 0x02
+
+#define NVME_IDENTIFY_NAMESPACE 0x00
+#define NVME_IDENTIFY_CONTROLLER 0x01
+#define NVME_FEATURE_NUMBER_OF_QUEUES 0x07
+
+// Physically contiguous queue, interrupts enabled on the completion queue
+#define NVME_QUEUE_PHYSICALLY_CONTIGUOUS 0x01
+#define NVME_QUEUE_INTERRUPTS_ENABLED 0x02
+
+// Byte offsets into the identify data
+#define NVME_IDENTIFY_CONTROLLER_MDTS 77
+#define NVME_IDENTIFY_CONTROLLER_NN 516
+#define NVME_IDENTIFY_NAMESPACE_NSZE 0
+#define NVME_IDENTIFY_NAMESPACE_FLBAS 26
+#define NVME_IDENTIFY_NAMESPACE_LBAF 128
+#define NVME_IDENTIFY_FLBAS_FORMAT_MASK 0x0F
+#define NVME_LBAF_LBADS_SHIFT 16
+
+// The phase bit of a completion flips every time the queue wraps
+#define NVME_COMPLETION_PHASE 0x0001
+
+#define NVME_ADMIN_QUEUE_SIZE 16
+
+// Each queue is one page, 64 submission entries of 64 bytes
+#define NVME_IO_QUEUE_SIZE 64
+
+// Commands in flight per queue, the command id is the slot. Fewer than the
+// entries so a submission queue can never fill up.
+#define NVME_MAX_SLOTS 32
+
+// Sectors moved by one command, 64KB touches at most 17 pages
+#define NVME_MAX_SECTORS 128
+
+// PRP list of a command, every page after the first one
+#define NVME_PRP_LIST_ENTRIES 16
+#define NVME_PRP_LIST_SIZE (NVME_PRP_LIST_ENTRIES * sizeof(uint64_t))
+
+#define NVME_MAX_NAMESPACES 16
+
+// How long an admin command may take, and how often it is looked at meanwhile
+#define NVME_ADMIN_TIMEOUT_MS 1000
+#define NVME_POLL_US 100
+
+struct nvme_command
+{
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t command_id;
+    uint32_t namespace_id;
+    uint64_t reserved;
+    uint64_t metadata;
+    uint64_t prp1;
+    uint64_t prp2;
+    uint32_t cdw10;
+    uint32_t cdw11;
+    uint32_t cdw12;
+    uint32_t cdw13;
+    uint32_t cdw14;
+    uint32_t cdw15;
+} __attribute__((packed));
+
+struct nvme_completion
+{
+    uint32_t result;
+    uint32_t reserved;
+    uint16_t sq_head;
+    uint16_t sq_id;
+    uint16_t command_id;
+    uint16_t status;
+} __attribute__((packed));
+
+struct nvme_controller;
+struct disk;
+struct pci_device;
+struct blk_command;
+
+/**
+ * A submission and completion queue pair. Each processor gets its own so
+ * readers on different processors never share a lock or a doorbell.
+ */
+struct nvme_queue
+{
+    struct nvme_controller* controller;
+    int id;
+    uint16_t size;
+
+    struct nvme_command* sq;
+    volatile struct nvme_completion* cq;
+    volatile uint32_t* sq_doorbell;
+    volatile uint32_t* cq_doorbell;
+
+    uint16_t sq_tail;
+
+    // sq_tail when the doorbell was last rung
+    uint16_t sq_rung;
+
+    uint16_t cq_head;
+    uint16_t phase;
+
+    // The MSI-X vector, zero when completions are polled
+    int vector;
+
+    uint64_t* prp_lists[NVME_MAX_SLOTS];
+    uint32_t results[NVME_MAX_SLOTS];
+
+    // The slots readers may use, one bit per slot
+    uint32_t slot_mask;
+
+    // Slots a reader owns, submitted or not yet collected
+    uint32_t busy;
+
+    // Slots the controller finished, waiting for their reader to collect them
+    uint32_t completed;
+    uint32_t failed;
+
+    // The request queue command each slot carries a part of, NULL for a reader of our own
+    struct blk_command* commands[NVME_MAX_SLOTS];
+
+    // Request queue commands waiting for a free slot, or with parts still to submit
+    struct blk_command* pending;
+    struct blk_command* pending_tail;
+
+    // Guards the queue and the masks between readers and the interrupt handler
+    struct spinlock lock;
+
+    // Readers waiting for a completion or a free slot
+    struct waitqueue waiters;
+};
+
+/**
+ * A namespace of a controller, each one is a disk
+ */
+struct nvme_namespace
+{
+    struct nvme_controller* controller;
+    uint32_t id;
+    uint64_t total_sectors;
+    struct disk* disk;
+};
+
+struct nvme_controller
+{
+    struct pci_device* pci;
+    uintptr_t registers;
+    uint32_t doorbell_stride;
+    uint16_t io_queue_size;
+    int max_sectors;
+
+    // Set when an admin command timed out, the controller is left alone from then on
+    bool broken;
+
+    struct nvme_queue admin;
+
+    // One queue pair per processor, made once the processors are up. Processors
+    // beyond what the controller granted share them, entries that could not be
+    // made point at the first. Never changes afterwards so it is read unlocked.
+    int total_io_queues;
+    struct nvme_queue* io_queues[PEACHOS_MAX_CPUS];
+
+    struct nvme_namespace* namespaces[NVME_MAX_NAMESPACES];
+    struct nvme_controller* next;
+};
+
+/**
+ * Finds every NVMe controller on the PCI buses and creates a disk for each
+ * of their namespaces
+ * \return Returns -ENOTFOUND when there is no controller
+ */
+int nvme_init();
+
+/**
+ * Gives every processor smp_init() brought up its own queue pair, completions
+ * interrupt the processor that submits on it. Until then every processor uses
+ * the queue pair of the bootstrap processor.
+ */
+void nvme_smp_init();
+
+/**
+ * Reads sectors of the namespace through the queue pair of the calling
+ * processor. The read is split over as many slots as are free, the
+ * doorbell is rung once for all of them.
+ */
+int nvme_read(struct nvme_namespace* ns, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors of the namespace, split over the free slots like a read
+ */
+int nvme_write(struct nvme_namespace* ns, uint64_t lba, int total, void* buf);
+
+/**
+ * Submits a command of the request queue on the queue pair of the calling
+ * processor and returns, the interrupt handler completes it. It is split
+ * over as many slots as it needs and waits on the queue pair for the ones
+ * that are not free yet.
+ * \return Returns -EUNIMP when the completions of the queue pair are polled
+ */
+int nvme_submit(struct nvme_namespace* ns, struct blk_command* command);
+
+/**
+ * Completes the request queue commands the controller has finished on any of its queue pairs
+ */
+void nvme_poll(struct nvme_namespace* ns);
+
+/**
+ * Makes the controller put the completed writes of the namespace on non
+ * volatile media, completes at once when it has no volatile write cache
+ */
+int nvme_flush(struct nvme_namespace* ns);
+
+#endif
@@ -39,60 +39,132 @@ struct disk_stream* diskstreamer_new(int disk_id)
         return 0;
     }
 
-    struct disk_stream* streamer = kzalloc(sizeof(struct disk_stream));
-    streamer->pos = 0;
-    streamer->disk = disk;
-    return streamer;
+    return diskstreamer_new_from_disk(disk);
 }
 
 struct disk_stream* diskstreamer_new_from_disk(struct disk* disk)
 {
     struct disk_stream* streamer = kzalloc(sizeof(struct disk_stream));
+    if (!streamer)
+    {
+        return 0;
+    }
+
     streamer->pos = 0;
     streamer->disk = disk;
+
+    // Nothing read yet, the first read starts the window off small
+    streamer->next_pos = 0;
+    streamer->readahead_sectors = 0;
+    streamer->readahead_end = 0;
     return streamer;
 }
 
-int diskstreamer_seek(struct disk_stream* stream, int pos)
+int diskstreamer_seek(struct disk_stream* stream, uint64_t pos)
 {
     stream->pos = pos;
     return 0;
 }
 
-int diskstreamer_read(struct disk_stream* stream, void* out, int total)
+/**
+ * Grows the readahead window while the stream is read sequentially and
+ * drops it on a seek elsewhere. Once the reader gets within half a window
+ * of what was read ahead the next window is fetched.
+ */
+static void diskstreamer_readahead(struct disk_stream* stream, int total)
 {
-    int sector = stream->pos / PEACHOS_SECTOR_SIZE;
-    int offset = stream->pos % PEACHOS_SECTOR_SIZE;
-    int total_to_read = total;
-    bool overflow = (offset+total_to_read) >= PEACHOS_SECTOR_SIZE;
-    char buf[PEACHOS_SECTOR_SIZE];
-    if (overflow)
+    bool sequential = stream->pos == stream->next_pos;
+    if (!sequential)
     {
-        total_to_read -= (offset+total_to_read) - PEACHOS_SECTOR_SIZE;
+        stream->readahead_sectors = 0;
+        stream->readahead_end = 0;
+        return;
     }
 
-    int res = disk_read_block(stream->disk, sector, 1, buf);
-    if (res < 0)
+    if (stream->readahead_sectors == 0)
     {
-        goto out;
+        stream->readahead_sectors = DISKSTREAMER_READAHEAD_MIN_SECTORS;
     }
 
-    for(int i = 0; i < total_to_read; i++)
+    uint64_t end_sector = (stream->pos + total + PEACHOS_SECTOR_SIZE - 1) / PEACHOS_SECTOR_SIZE;
+    if (end_sector + stream->readahead_sectors / 2 < stream->readahead_end)
     {
-        *(char*)out++ = buf[offset+i];
+        // Still well inside the last window
+        return;
     }
 
-    stream->pos += total_to_read;
-    if (overflow)
+    uint64_t start = end_sector > stream->readahead_end ? end_sector : stream->readahead_end;
+    disk_readahead(stream->disk, start, end_sector + stream->readahead_sectors - start);
+    stream->readahead_end = end_sector + stream->readahead_sectors;
+
+    if (stream->readahead_sectors < DISKSTREAMER_READAHEAD_MAX_SECTORS)
     {
-        res = diskstreamer_read(stream, out, total-total_to_read);
+        stream->readahead_sectors *= 2;
     }
-    
+}
+
+int diskstreamer_read(struct disk_stream* stream, void* out, int total)
+{
+    int res = 0;
+    char bounce[PEACHOS_SECTOR_SIZE];
+    diskstreamer_readahead(stream, total);
+
+    // Unaligned head, bounced through a single sector
+    int offset = stream->pos % PEACHOS_SECTOR_SIZE;
+    if (offset && total > 0)
+    {
+        int chunk = PEACHOS_SECTOR_SIZE - offset;
+        if (chunk > total)
+        {
+            chunk = total;
+        }
+
+        res = disk_read_block(stream->disk, stream->pos / PEACHOS_SECTOR_SIZE, 1, bounce);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        memcpy(out, bounce + offset, chunk);
+        out += chunk;
+        total -= chunk;
+        stream->pos += chunk;
+    }
+
+    // The aligned middle goes straight to the destination in as few reads as possible
+    int sectors = total / PEACHOS_SECTOR_SIZE;
+    if (sectors)
+    {
+        res = disk_read_block(stream->disk, stream->pos / PEACHOS_SECTOR_SIZE, sectors, out);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        out += sectors * PEACHOS_SECTOR_SIZE;
+        total -= sectors * PEACHOS_SECTOR_SIZE;
+        stream->pos += sectors * PEACHOS_SECTOR_SIZE;
+    }
+
+    // Unaligned tail
+    if (total > 0)
+    {
+        res = disk_read_block(stream->disk, stream->pos / PEACHOS_SECTOR_SIZE, 1, bounce);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        memcpy(out, bounce, total);
+        stream->pos += total;
+    }
+
 out:
+    stream->next_pos = stream->pos;
     return res;
 }
 
 void diskstreamer_close(struct disk_stream* stream)
 {
     kfree(stream);
-}
\ No newline at end of file
+}
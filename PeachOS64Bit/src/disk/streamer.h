@@ -28,16 +28,31 @@
 #ifndef DISKSTREAMER_H
 #define DISKSTREAMER_H
 
+#include <stdint.h>
 #include "disk.h"
 
+// Sectors read ahead once a stream is read sequentially, doubling up to the maximum
+#define DISKSTREAMER_READAHEAD_MIN_SECTORS 16
+#define DISKSTREAMER_READAHEAD_MAX_SECTORS 256
+
 struct disk_stream
 {
-    int pos;
+    // Byte offset from the start of the disk
+    uint64_t pos;
     struct disk* disk;
+
+    // Where the last read ended, a read starting here is sequential
+    uint64_t next_pos;
+
+    // Size of the next readahead window, zero until the stream reads sequentially
+    unsigned int readahead_sectors;
+
+    // First sector past what has been read ahead
+    uint64_t readahead_end;
 };
 
 struct disk_stream* diskstreamer_new(int disk_id);
-int diskstreamer_seek(struct disk_stream* stream, int pos);
+int diskstreamer_seek(struct disk_stream* stream, uint64_t pos);
 int diskstreamer_read(struct disk_stream* stream, void* out, int total);
 void diskstreamer_close(struct disk_stream* stream);
 struct disk_stream* diskstreamer_new_from_disk(struct disk* disk);
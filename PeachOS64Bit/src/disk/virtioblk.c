@@ -0,0 +1,600 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "virtioblk.h"
+#include "disk.h"
+#include "blkqueue.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "pci/pci.h"
+#include "apic/lapic.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "string/string.h"
+#include "task/task.h"
+
+static struct virtio_blk* virtio_blks = NULL;
+
+static uint64_t virtio_blk_physical(void* address)
+{
+    return (uint64_t) paging_get_physical_address(kernel_desc(), address);
+}
+
+/**
+ * The descriptor in the ring that starts the chain of the request
+ */
+static uint16_t virtio_blk_head(struct virtio_blk* blk, int request)
+{
+    return request * blk->descriptors_per_request;
+}
+
+static int virtio_blk_alloc(struct virtio_blk* blk)
+{
+    int per_page = PAGING_PAGE_SIZE / VIRTIO_BLK_REQUEST_SIZE;
+    for (int request = 0; request < blk->total_requests; request += per_page)
+    {
+        void* page = kzalloc(PAGING_PAGE_SIZE);
+        if (!page)
+        {
+            return -ENOMEM;
+        }
+
+        for (int i = 0; i < per_page && request + i < blk->total_requests; i++)
+        {
+            blk->requests[request + i] = page + i * VIRTIO_BLK_REQUEST_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Builds the descriptor chain of the request, nothing is published yet. A
+ * flush has no data descriptors.
+ */
+static int virtio_blk_prepare(struct virtio_blk* blk, int request, uint32_t type, uint64_t lba, int total, void* buf)
+{
+    struct virtio_blk_request* req = blk->requests[request];
+    uint16_t head = virtio_blk_head(blk, request);
+
+    // Indirect chains link within their own table, direct ones within the ring
+    struct virtq_desc* chain = blk->indirect ? req->table : &blk->queue.desc[head];
+    uint16_t base = blk->indirect ? 0 : head;
+    int descriptors = 0;
+
+    req->header.type = type;
+    req->header.reserved = 0;
+    req->header.sector = lba;
+    req->status = 0xFF;
+
+    chain[descriptors].address = virtio_blk_physical(&req->header);
+    chain[descriptors].length = sizeof(struct virtio_blk_request_header);
+    chain[descriptors].flags = VIRTQ_DESC_F_NEXT;
+    chain[descriptors].next = base + descriptors + 1;
+    descriptors++;
+
+    // The device writes the data of a read into memory and only reads that of a write
+    uint16_t data_flags = type == VIRTIO_BLK_T_IN ? VIRTQ_DESC_F_WRITE | VIRTQ_DESC_F_NEXT : VIRTQ_DESC_F_NEXT;
+    size_t size = total * PEACHOS_SECTOR_SIZE;
+    while (size > 0)
+    {
+        uint64_t physical = virtio_blk_physical(buf);
+        size_t chunk = PAGING_PAGE_SIZE - ((uintptr_t) buf % PAGING_PAGE_SIZE);
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        if (!physical || descriptors > VIRTIO_BLK_MAX_SEGMENTS)
+        {
+            return -EIO;
+        }
+
+        chain[descriptors].address = physical;
+        chain[descriptors].length = chunk;
+        chain[descriptors].flags = data_flags;
+        chain[descriptors].next = base + descriptors + 1;
+        descriptors++;
+        buf += chunk;
+        size -= chunk;
+    }
+
+    chain[descriptors].address = virtio_blk_physical((void*) &req->status);
+    chain[descriptors].length = 1;
+    chain[descriptors].flags = VIRTQ_DESC_F_WRITE;
+    chain[descriptors].next = 0;
+    descriptors++;
+
+    if (blk->indirect)
+    {
+        struct virtq_desc* desc = &blk->queue.desc[head];
+        desc->address = virtio_blk_physical(req->table);
+        desc->length = descriptors * sizeof(struct virtq_desc);
+        desc->flags = VIRTQ_DESC_F_INDIRECT;
+        desc->next = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Moves the requests the device has finished with over to completed, the lock must be held
+ */
+static void virtio_blk_reap(struct virtio_blk* blk)
+{
+    uint16_t head = 0;
+    uint32_t length = 0;
+    while (virtqueue_pop_used(&blk->queue, &head, &length))
+    {
+        int request = head / blk->descriptors_per_request;
+        if (request >= blk->total_requests)
+        {
+            continue;
+        }
+
+        uint64_t bit = 1ULL << request;
+        if (blk->requests[request]->status != VIRTIO_BLK_S_OK)
+        {
+            blk->failed |= bit;
+        }
+        blk->completed |= bit;
+    }
+}
+
+/**
+ * Publishes the parts of the pending request queue commands into the free
+ * requests and tells the device once for them, the lock must be held
+ * \param done Receives the commands with nothing left to publish or wait for
+ */
+static void virtio_blk_issue_pending(struct virtio_blk* blk, struct blk_command** done)
+{
+    while (blk->pending)
+    {
+        struct blk_command* command = blk->pending;
+        uint64_t free = blk->request_mask & ~blk->busy;
+        if (command->result < 0)
+        {
+            // Part of it failed, the rest is not worth publishing
+            command->issued = command->total;
+        }
+        else if (free)
+        {
+            int request = __builtin_ctzll(free);
+            int count = command->total - command->issued;
+            if (count > VIRTIO_BLK_MAX_SECTORS)
+            {
+                count = VIRTIO_BLK_MAX_SECTORS;
+            }
+
+            uint32_t type = command->op == BLK_REQUEST_WRITE ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+            void* buf = command->buf + command->issued * PEACHOS_SECTOR_SIZE;
+            if (virtio_blk_prepare(blk, request, type, command->lba + command->issued, count, buf) < 0)
+            {
+                command->result = -EIO;
+                continue;
+            }
+
+            blk->busy |= 1ULL << request;
+            blk->carrying |= 1ULL << request;
+            blk->commands[request] = command;
+            command->outstanding++;
+            command->issued += count;
+            virtqueue_publish(&blk->queue, virtio_blk_head(blk, request));
+        }
+
+        if (command->issued < command->total)
+        {
+            if (!free)
+            {
+                // The rest goes out as requests come back
+                break;
+            }
+            continue;
+        }
+
+        blk->pending = command->next;
+        if (!blk->pending)
+        {
+            blk->pending_tail = NULL;
+        }
+
+        command->next = NULL;
+        if (!command->outstanding)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+
+    virtqueue_kick(&blk->queue);
+}
+
+/**
+ * Frees the finished requests that carried request queue commands and
+ * publishes what is pending into them, the lock must be held
+ * \param done Receives the commands that are finished, to be completed once the lock is dropped
+ */
+static void virtio_blk_collect(struct virtio_blk* blk, struct blk_command** done)
+{
+    uint64_t finished = blk->completed & blk->carrying;
+    if (!finished)
+    {
+        return;
+    }
+
+    while (finished)
+    {
+        int request = __builtin_ctzll(finished);
+        uint64_t bit = 1ULL << request;
+        finished &= ~bit;
+        struct blk_command* command = blk->commands[request];
+        if (blk->failed & bit)
+        {
+            command->result = -EIO;
+        }
+
+        blk->commands[request] = NULL;
+        blk->carrying &= ~bit;
+        blk->completed &= ~bit;
+        blk->failed &= ~bit;
+        blk->busy &= ~bit;
+        command->outstanding--;
+        if (!command->outstanding && command->issued == command->total)
+        {
+            command->next = *done;
+            *done = command;
+        }
+    }
+
+    // Readers of our own may be waiting for a free request
+    virtio_blk_issue_pending(blk, done);
+    waitqueue_wake_all(&blk->waiters);
+}
+
+/**
+ * Asks for an interrupt while requests carry request queue commands,
+ * collecting what the device finished before it was asked. The lock must be held.
+ */
+static void virtio_blk_arm(struct virtio_blk* blk, struct blk_command** done)
+{
+    while (blk->vector && blk->carrying && !virtqueue_enable_interrupts(&blk->queue))
+    {
+        virtqueue_disable_interrupts(&blk->queue);
+        virtio_blk_reap(blk);
+        virtio_blk_collect(blk, done);
+    }
+}
+
+static void virtio_blk_interrupt_handler(struct interrupt_frame* frame)
+{
+    struct blk_command* done = NULL;
+    for (struct virtio_blk* blk = virtio_blks; blk; blk = blk->next)
+    {
+        if (!blk->vector)
+        {
+            continue;
+        }
+
+        spin_lock(&blk->lock);
+
+        // One interrupt per sleep, the next reader to sleep asks for another
+        virtqueue_disable_interrupts(&blk->queue);
+        virtio_blk_reap(blk);
+        virtio_blk_collect(blk, &done);
+        if (blk->completed)
+        {
+            waitqueue_wake_all(&blk->waiters);
+        }
+
+        // Unless request queue commands are still out
+        virtio_blk_arm(blk, &done);
+        spin_unlock(&blk->lock);
+    }
+
+    // Completing them dispatches more, which takes the device locks
+    blk_command_complete(done);
+}
+
+/**
+ * Waits for the device to finish something. The lock is held on entry and
+ * on return, a task sleeps without it until the interrupt wakes it.
+ */
+static void virtio_blk_wait(struct virtio_blk* blk, uint64_t* flags)
+{
+    if (blk->vector && lapic_present() && task_can_sleep())
+    {
+        // A completion that came in while interrupts were off would never wake us
+        if (virtqueue_enable_interrupts(&blk->queue))
+        {
+            waitqueue_add(&blk->waiters, task_current());
+            spin_unlock_irqrestore(&blk->lock, *flags);
+            task_next();
+            *flags = spin_lock_irqsave(&blk->lock);
+            return;
+        }
+
+        virtqueue_disable_interrupts(&blk->queue);
+        virtio_blk_reap(blk);
+        return;
+    }
+
+    // Boot code, or nothing would wake us, watch the used ring instead
+    __builtin_ia32_pause();
+    virtio_blk_reap(blk);
+}
+
+/**
+ * Splits the transfer over the free requests, a flush goes out as a single request with no data
+ */
+static int virtio_blk_transfer(struct virtio_blk* blk, uint32_t type, uint64_t lba, int total, void* buf)
+{
+    int res = 0;
+    uint64_t mine = 0;
+    bool publish = true;
+    struct blk_command* done = NULL;
+    uint64_t flags = spin_lock_irqsave(&blk->lock);
+    while (publish || mine)
+    {
+        // Waiting may have reaped request queue commands in place of the interrupt
+        virtio_blk_collect(blk, &done);
+        uint64_t finished = mine & blk->completed;
+        if (finished)
+        {
+            if (finished & blk->failed)
+            {
+                // Stop publishing, what is in flight still has to come back
+                res = -EIO;
+                publish = false;
+            }
+
+            blk->completed &= ~finished;
+            blk->failed &= ~finished;
+            blk->busy &= ~finished;
+            mine &= ~finished;
+
+            // Request queue commands and readers waiting for a free request can have these
+            virtio_blk_issue_pending(blk, &done);
+            waitqueue_wake_all(&blk->waiters);
+            continue;
+        }
+
+        uint64_t free = blk->request_mask & ~blk->busy;
+        if (publish && free)
+        {
+            int request = __builtin_ctzll(free);
+            int count = total > VIRTIO_BLK_MAX_SECTORS ? VIRTIO_BLK_MAX_SECTORS : total;
+            if (virtio_blk_prepare(blk, request, type, lba, count, buf) < 0)
+            {
+                res = -EIO;
+                publish = false;
+                continue;
+            }
+
+            blk->busy |= 1ULL << request;
+            mine |= 1ULL << request;
+            virtqueue_publish(&blk->queue, virtio_blk_head(blk, request));
+            lba += count;
+            total -= count;
+            buf += count * PEACHOS_SECTOR_SIZE;
+            publish = total > 0;
+            continue;
+        }
+
+        // Everything that fits is published, one notification covers the lot
+        virtqueue_kick(&blk->queue);
+        virtio_blk_wait(blk, &flags);
+    }
+    virtio_blk_arm(blk, &done);
+    spin_unlock_irqrestore(&blk->lock, flags);
+    blk_command_complete(done);
+    return res;
+}
+
+int virtio_blk_read(struct virtio_blk* blk, uint64_t lba, int total, void* buf)
+{
+    return virtio_blk_transfer(blk, VIRTIO_BLK_T_IN, lba, total, buf);
+}
+
+int virtio_blk_write(struct virtio_blk* blk, uint64_t lba, int total, void* buf)
+{
+    return virtio_blk_transfer(blk, VIRTIO_BLK_T_OUT, lba, total, buf);
+}
+
+int virtio_blk_submit(struct virtio_blk* blk, struct blk_command* command)
+{
+    struct blk_command* done = NULL;
+    if (!blk->vector || !lapic_present())
+    {
+        // Nothing would tell us it finished
+        return -EUNIMP;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&blk->lock);
+    command->next = NULL;
+    if (blk->pending_tail)
+    {
+        blk->pending_tail->next = command;
+    }
+    else
+    {
+        blk->pending = command;
+    }
+    blk->pending_tail = command;
+    virtio_blk_issue_pending(blk, &done);
+    virtio_blk_arm(blk, &done);
+    spin_unlock_irqrestore(&blk->lock, flags);
+
+    // Only when it could not be published at all or came back straight away
+    blk_command_complete(done);
+    return 0;
+}
+
+void virtio_blk_poll(struct virtio_blk* blk)
+{
+    struct blk_command* done = NULL;
+    uint64_t flags = spin_lock_irqsave(&blk->lock);
+    virtio_blk_reap(blk);
+    virtio_blk_collect(blk, &done);
+    virtio_blk_arm(blk, &done);
+    spin_unlock_irqrestore(&blk->lock, flags);
+    blk_command_complete(done);
+}
+
+int virtio_blk_flush(struct virtio_blk* blk)
+{
+    if (!(blk->device.features & VIRTIO_BLK_F_FLUSH))
+    {
+        // Writes are on stable storage once they complete
+        return 0;
+    }
+
+    return virtio_blk_transfer(blk, VIRTIO_BLK_T_FLUSH, 0, 0, NULL);
+}
+
+static int virtio_blk_device_init(struct pci_device* pci)
+{
+    int res = 0;
+    struct virtio_blk* blk = kzalloc(sizeof(struct virtio_blk));
+    if (!blk)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    spinlock_init(&blk->lock, "virtio-blk");
+    waitqueue_init(&blk->waiters);
+    res = virtio_device_init(&blk->device, pci);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = virtio_negotiate(&blk->device, VIRTIO_F_INDIRECT_DESC | VIRTIO_F_EVENT_IDX | VIRTIO_BLK_F_FLUSH);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // MSI-X must be on before the device takes an entry for the queue
+    uint16_t msix_entry = VIRTIO_MSI_NO_VECTOR;
+    int vector = IRQ_msi_vector_alloc();
+    if (vector > 0 && pci_enable_msix(pci, 0, IRQ_msi_destination(), vector) == 0)
+    {
+        msix_entry = 0;
+    }
+
+    res = virtqueue_init(&blk->device, &blk->queue, 0, VIRTIO_BLK_QUEUE_SIZE, msix_entry);
+    if (res < 0)
+    {
+        virtio_device_failed(&blk->device);
+        goto out;
+    }
+
+    if (msix_entry != VIRTIO_MSI_NO_VECTOR && blk->queue.msix_entry == msix_entry)
+    {
+        blk->vector = vector;
+        idt_register_interrupt_callback(vector, virtio_blk_interrupt_handler);
+    }
+
+    // Without indirect descriptors the ring is carved up between the requests
+    blk->indirect = blk->device.features & VIRTIO_F_INDIRECT_DESC;
+    blk->descriptors_per_request = blk->indirect ? 1 : VIRTIO_BLK_REQUEST_DESCRIPTORS;
+    blk->total_requests = blk->queue.size / blk->descriptors_per_request;
+    if (blk->total_requests > VIRTIO_BLK_MAX_REQUESTS)
+    {
+        blk->total_requests = VIRTIO_BLK_MAX_REQUESTS;
+    }
+
+    if (blk->total_requests == 0)
+    {
+        virtio_device_failed(&blk->device);
+        res = -EIO;
+        goto out;
+    }
+
+    blk->request_mask = blk->total_requests >= 64 ? ~0ULL : (1ULL << blk->total_requests) - 1;
+    res = virtio_blk_alloc(blk);
+    if (res < 0)
+    {
+        virtio_device_failed(&blk->device);
+        goto out;
+    }
+
+    if (blk->device.device_cfg)
+    {
+        volatile uint32_t* capacity = (volatile uint32_t*)(blk->device.device_cfg + VIRTIO_BLK_CONFIG_CAPACITY);
+        blk->total_sectors = capacity[0] | ((uint64_t) capacity[1] << 32);
+    }
+
+    // Polled until a reader sleeps and asks for an interrupt
+    virtqueue_disable_interrupts(&blk->queue);
+    virtio_device_ready(&blk->device);
+    blk->next = virtio_blks;
+    virtio_blks = blk;
+
+    print("virtio-blk: ");
+    print(itoa(blk->total_sectors / 2048));
+    print("MB, ");
+    print(blk->indirect ? "indirect" : "direct");
+    print(blk->queue.event_idx ? ", event idx" : "");
+    print(blk->vector ? ", MSI-X" : ", polled");
+    print(" requests ");
+    print(itoa(blk->total_requests));
+    print("\n");
+
+    res = disk_create_device(PEACHOS_DISK_TYPE_VIRTIO, PEACHOS_SECTOR_SIZE, blk, &blk->disk);
+
+out:
+    if (res < 0 && blk && blk != virtio_blks)
+    {
+        kfree(blk);
+    }
+    return res;
+}
+
+int virtio_blk_init()
+{
+    int res = -ENOTFOUND;
+    uint16_t ids[] = { VIRTIO_BLK_PCI_DEVICE_TRANSITIONAL, VIRTIO_PCI_DEVICE_MODERN_BASE + VIRTIO_DEVICE_TYPE_BLOCK };
+    for (int id = 0; id < sizeof(ids) / sizeof(ids[0]); id++)
+    {
+        struct pci_device* pci = NULL;
+        for (int i = 0; (pci = pci_find_device(VIRTIO_PCI_VENDOR, ids[id], i)); i++)
+        {
+            if (virtio_blk_device_init(pci) == 0)
+            {
+                res = 0;
+            }
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,174 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_VIRTIOBLK_H
+#define KERNEL_VIRTIOBLK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "virtio/virtio.h"
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+
+// The transitional block device, modern only ones use VIRTIO_PCI_DEVICE_MODERN_BASE + VIRTIO_DEVICE_TYPE_BLOCK
+#define VIRTIO_BLK_PCI_DEVICE_TRANSITIONAL 0x1001
+
+// Offset of the capacity in 512 byte sectors within the device configuration
+#define VIRTIO_BLK_CONFIG_CAPACITY 0
+
+// The device has a write cache that VIRTIO_BLK_T_FLUSH empties
+#define VIRTIO_BLK_F_FLUSH (1ULL << 9)
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+#define VIRTIO_BLK_T_FLUSH 4
+#define VIRTIO_BLK_S_OK 0
+
+// Entries asked for in the request queue
+#define VIRTIO_BLK_QUEUE_SIZE 128
+
+// Sectors moved by one request, 64KB touches at most 17 pages
+#define VIRTIO_BLK_MAX_SECTORS 128
+#define VIRTIO_BLK_MAX_SEGMENTS 17
+
+// Descriptors of one request, the header, the data pages and the status byte
+#define VIRTIO_BLK_REQUEST_DESCRIPTORS (VIRTIO_BLK_MAX_SEGMENTS + 2)
+
+// Requests in flight at once, one bit each in the masks
+#define VIRTIO_BLK_MAX_REQUESTS 64
+
+// Every request is given 512 bytes so eight of them share a page
+#define VIRTIO_BLK_REQUEST_SIZE 512
+
+struct virtio_blk_request_header
+{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __attribute__((packed));
+
+/**
+ * The memory of one request, the device reads the header and writes the status
+ */
+struct virtio_blk_request
+{
+    struct virtio_blk_request_header header;
+    volatile uint8_t status;
+
+    // The descriptors of the request when they are handed over indirectly
+    struct virtq_desc table[VIRTIO_BLK_REQUEST_DESCRIPTORS] __attribute__((aligned(16)));
+};
+
+struct disk;
+struct blk_command;
+
+/**
+ * A virtio block device. Every request owns a fixed descriptor range, with
+ * indirect descriptors that is the single head entry, otherwise the whole chain.
+ */
+struct virtio_blk
+{
+    struct virtio_device device;
+    struct virtqueue queue;
+    uint64_t total_sectors;
+    bool indirect;
+
+    // The MSI-X vector, zero when completions are polled
+    int vector;
+
+    int total_requests;
+    int descriptors_per_request;
+    struct virtio_blk_request* requests[VIRTIO_BLK_MAX_REQUESTS];
+
+    // The requests readers may use, one bit per request
+    uint64_t request_mask;
+
+    // Requests a reader owns, published or not yet collected
+    uint64_t busy;
+
+    // Requests the device finished, waiting for their reader to collect them
+    uint64_t completed;
+    uint64_t failed;
+
+    // The request queue command each request carries a part of, NULL for a reader of our own
+    struct blk_command* commands[VIRTIO_BLK_MAX_REQUESTS];
+
+    // Requests carrying one, the interrupt stays asked for while there are any
+    uint64_t carrying;
+
+    // Request queue commands waiting for a free request, or with parts still to publish
+    struct blk_command* pending;
+    struct blk_command* pending_tail;
+
+    // Guards the queue and the masks between readers and the interrupt handler
+    struct spinlock lock;
+
+    // Readers waiting for a completion or a free request
+    struct waitqueue waiters;
+
+    struct disk* disk;
+    struct virtio_blk* next;
+};
+
+/**
+ * Finds every virtio block device on the PCI buses and creates a disk for each
+ * \return Returns -ENOTFOUND when there is none
+ */
+int virtio_blk_init();
+
+/**
+ * Reads sectors of the device. The read is split over as many requests as
+ * are free, all of them are published and the device is told once.
+ */
+int virtio_blk_read(struct virtio_blk* blk, uint64_t lba, int total, void* buf);
+
+/**
+ * Writes sectors of the device, split over the free requests like a read
+ */
+int virtio_blk_write(struct virtio_blk* blk, uint64_t lba, int total, void* buf);
+
+/**
+ * Publishes a command of the request queue and returns, the interrupt
+ * handler completes it. It is split over as many requests as it needs and
+ * waits on the device for the ones that are not free yet.
+ * \return Returns -EUNIMP when the completions of the device are polled
+ */
+int virtio_blk_submit(struct virtio_blk* blk, struct blk_command* command);
+
+/**
+ * Completes the request queue commands the device has finished
+ */
+void virtio_blk_poll(struct virtio_blk* blk);
+
+/**
+ * Makes the device put the writes it has completed on stable storage, does
+ * nothing when the device has no write cache to flush
+ */
+int virtio_blk_flush(struct virtio_blk* blk);
+
+#endif
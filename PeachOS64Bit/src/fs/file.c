@@ -34,9 +34,17 @@
 #include "fat/fat16.h"
 #include "status.h"
 #include "kernel.h"
+#include "lib/spinlock/spinlock.h"
+#include "lib/mutex/mutex.h"
 struct filesystem* filesystems[PEACHOS_MAX_FILESYSTEMS];
 struct file_descriptor* file_descriptors[PEACHOS_MAX_FILE_DESCRIPTORS];
 
+// Guards the file_descriptors table
+static struct spinlock file_descriptors_lock;
+
+// The file system drivers keep shared state such as the disk streamer, one call at a time
+static struct mutex vfs_mutex;
+
 static struct filesystem** fs_get_free_filesystem()
 {
     int i = 0;
@@ -77,24 +85,36 @@ void fs_load()
 
 void fs_init()
 {
+    spinlock_init(&file_descriptors_lock, "file_descriptors");
+    mutex_init(&vfs_mutex, "vfs");
     memset(file_descriptors, 0, sizeof(file_descriptors));
     fs_load();
 }
 
 static void file_free_descriptor(struct file_descriptor* desc)
 {
+    uint64_t flags = spin_lock_irqsave(&file_descriptors_lock);
     file_descriptors[desc->index-1] = 0x00;
+    spin_unlock_irqrestore(&file_descriptors_lock, flags);
     kfree(desc);
 }
 
 static int file_new_descriptor(struct file_descriptor** desc_out)
 {
     int res = -ENOMEM;
+
+    // Allocate before taking the lock, the heap has a lock of its own
+    struct file_descriptor* desc = kzalloc(sizeof(struct file_descriptor));
+    if (!desc)
+    {
+        return -ENOMEM;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&file_descriptors_lock);
     for (int i = 0; i < PEACHOS_MAX_FILE_DESCRIPTORS; i++)
     {
         if (file_descriptors[i] == 0)
         {
-            struct file_descriptor* desc = kzalloc(sizeof(struct file_descriptor));
             // Descriptors start at 1
             desc->index = i + 1;
             file_descriptors[i] = desc;
@@ -103,6 +123,12 @@ static int file_new_descriptor(struct file_descriptor** desc_out)
             break;
         }
     }
+    spin_unlock_irqrestore(&file_descriptors_lock, flags);
+
+    if (res < 0)
+    {
+        kfree(desc);
+    }
 
     return res;
 }
@@ -116,7 +142,10 @@ static struct file_descriptor* file_get_descriptor(int fd)
 
     // Descriptors start at 1
     int index = fd - 1;
-    return file_descriptors[index];
+    uint64_t flags = spin_lock_irqsave(&file_descriptors_lock);
+    struct file_descriptor* desc = file_descriptors[index];
+    spin_unlock_irqrestore(&file_descriptors_lock, flags);
+    return desc;
 }
 
 struct filesystem* fs_resolve(struct disk* disk)
@@ -159,6 +188,7 @@ int fopen(const char* filename, const char* mode_str)
     FILE_MODE mode = FILE_MODE_INVALID;
     void* descriptor_private_data = NULL;
     struct file_descriptor* desc = 0;
+    mutex_lock(&vfs_mutex);
     struct path_root* root_path = pathparser_parse(filename, NULL);
     if (!root_path)
     {
@@ -240,12 +270,14 @@ out:
         res = 0;
     }
 
+    mutex_unlock(&vfs_mutex);
     return res;
 }
 
 int fstat(int fd, struct file_stat* stat)
 {
     int res = 0;
+    mutex_lock(&vfs_mutex);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -255,12 +287,14 @@ int fstat(int fd, struct file_stat* stat)
 
     res = desc->filesystem->stat(desc->disk, desc->private, stat);
 out:
+    mutex_unlock(&vfs_mutex);
     return res;
 }
 
 int fclose(int fd)
 {
     int res = 0;
+    mutex_lock(&vfs_mutex);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -274,12 +308,14 @@ int fclose(int fd)
         file_free_descriptor(desc);
     }
 out:
+    mutex_unlock(&vfs_mutex);
     return res;
 }
 
 int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 {
     int res = 0;
+    mutex_lock(&vfs_mutex);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -289,11 +325,13 @@ int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 
     res = desc->filesystem->seek(desc->private, offset, whence);
 out:
+    mutex_unlock(&vfs_mutex);
     return res;
 }
 int fread(void* ptr, uint32_t size, uint32_t nmemb, int fd)
 {
     int res = 0;
+    mutex_lock(&vfs_mutex);
     if (size == 0 || nmemb == 0 || fd < 1)
     {
         res = -EINVARG;
@@ -309,5 +347,6 @@ int fread(void* ptr, uint32_t size, uint32_t nmemb, int fd)
 
     res = desc->filesystem->read(desc->disk, desc->private, size, nmemb, (char*) ptr);
 out:
+    mutex_unlock(&vfs_mutex);
     return res;
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include "graphics/graphics.h"
 #include "memory/heap/kheap.h"
 #include "lib/vector/vector.h"
+#include "lib/spinlock/spinlock.h"
 #include "memory/memory.h"
 #include "string/string.h"
 #include "kernel.h"
@@ -36,6 +37,9 @@
 #include <stdbool.h>
 
 struct vector* loaded_fonts = NULL;
+
+// Guards loaded_fonts, fonts are loaded from disk without holding it
+static struct spinlock loaded_fonts_lock;
 struct font* system_font = NULL;
 
 int font_draw_from_index(struct graphics_info* graphics_info, struct font* font, int screen_x, int screen_y, int index_character, struct framebuffer_pixel font_color);
@@ -125,7 +129,7 @@ struct font* font_load_from_image(const char* filename, size_t pixel_width, size
     return font_create(character_data, total_characters, pixel_width, pixel_height, FONT_IMAGE_DRAW_SUBTRACT_FROM_INDEX);
 }
 
-struct font* font_get_loaded_font(const char* filename)
+static struct font* font_get_loaded_font_locked(const char* filename)
 {
     struct font* font = NULL;
     size_t total_fonts = vector_count(loaded_fonts);
@@ -144,6 +148,15 @@ struct font* font_get_loaded_font(const char* filename)
 
     return NULL;
 }
+
+struct font* font_get_loaded_font(const char* filename)
+{
+    uint64_t flags = spin_lock_irqsave(&loaded_fonts_lock);
+    struct font* font = font_get_loaded_font_locked(filename);
+    spin_unlock_irqrestore(&loaded_fonts_lock, flags);
+    return font;
+}
+
 struct font* font_load(const char* filename)
 {
     struct font* loaded_font = font_get_loaded_font(filename);
@@ -156,8 +169,20 @@ struct font* font_load(const char* filename)
     if (loaded_font)
     {
         strncpy(loaded_font->filename, filename, sizeof(loaded_font->filename));
-        // push it to the loaded fonts vector
-        vector_push(loaded_fonts, &loaded_font);
+
+        // Someone may have loaded the same font while we were reading it, keep theirs
+        uint64_t flags = spin_lock_irqsave(&loaded_fonts_lock);
+        struct font* existing_font = font_get_loaded_font_locked(filename);
+        if (existing_font)
+        {
+            loaded_font = existing_font;
+        }
+        else
+        {
+            // push it to the loaded fonts vector
+            vector_push(loaded_fonts, &loaded_font);
+        }
+        spin_unlock_irqrestore(&loaded_fonts_lock, flags);
     }
 
     return loaded_font;
@@ -257,6 +282,7 @@ int font_draw_text(struct graphics_info* graphics_info, struct font* font, int s
 int font_system_init()
 {
     int res = 0;
+    spinlock_init(&loaded_fonts_lock, "fonts");
     loaded_fonts = vector_new(sizeof(struct font*), 4, 0);
     if (!loaded_fonts)
     {
@@ -39,14 +39,21 @@ global disable_interrupts
 global isr80h_wrapper
 global interrupt_pointer_table
 
-temp_rsp_storage: dq 0x00
 %macro pushad_macro 0
-    mov qword [temp_rsp_storage], rsp
+    push r15
+    push r14
+    push r13
+    push r12
+    push r11
+    push r10
+    push r9
+    push r8
     push rax
     push rcx
     push rdx
     push rbx
-    push qword [temp_rsp_storage]
+    lea rax, [rsp+8*12]     ; RSP on entry, above the twelve registers pushed so far
+    push rax
     push rbp
     push rsi
     push rdi
@@ -56,14 +63,34 @@ temp_rsp_storage: dq 0x00
     pop rdi
     pop rsi
     pop rbp
-    pop qword[temp_rsp_storage]
+    add rsp, 8              ; Skip the saved RSP, popping the registers restores it
     pop rbx
     pop rdx
     pop rcx
     pop rax
-    mov rsp, [temp_rsp_storage]
+    pop r8
+    pop r9
+    pop r10
+    pop r11
+    pop r12
+    pop r13
+    pop r14
+    pop r15
+%endmacro
+
+; Kernel code finds its processor through GS, swap in the kernel GS base
+; when we arrive from user land and swap it back out on the way back.
+; Must be used while the error code and the interrupt frame are on the top of the stack.
+%macro swapgs_if_user_macro 0
+    test qword [rsp+16], 3  ; Requested privilege level of the interrupted CS
+    jz %%kernel
+    swapgs
+%%kernel:
 %endmacro
 
+; Exceptions that come with an error code pushed by the processor
+%define has_error_code(n) ((n) == 8 || ((n) >= 10 && (n) <= 14) || (n) == 17 || (n) == 21 || (n) == 29 || (n) == 30)
+
 enable_interrupts:
     sti
     ret
@@ -95,6 +122,11 @@ no_interrupt:
         ; uint64_t flags
         ; uint64_t sp;
         ; uint64_t ss;
+        ; Every frame carries an error code so the saved CS is always in the same place
+        %if !has_error_code(%1)
+        push qword 0
+        %endif
+        swapgs_if_user_macro
         ; Pushes the general purpose registers to the stack
         pushad_macro
         ; interrupt frame end
@@ -102,6 +134,9 @@ no_interrupt:
         mov rsi, rsp
         call interrupt_handler
         popad_macro
+        swapgs_if_user_macro
+        ; Drop the error code
+        add rsp, 8
         iretq
 %endmacro
 
@@ -119,6 +154,10 @@ isr80h_wrapper:
     ; uint64_t flags
     ; uint64_t sp;
     ; uint64_t ss;
+    ; Lay the frame out like the other interrupts, with an empty error code
+    push qword 0
+    ; System commands only come from user land
+    swapgs
     ; Pushes the general purpose registers to the stack
     pushad_macro
     
@@ -127,19 +166,19 @@ isr80h_wrapper:
     ; Second argument is the interrupt stack pointer
     mov rsi, rsp
 
-    ; rax holds our first argument
-    mov rdi, rax
+    ; The saved rax holds our first argument
+    mov rdi, [rsp+56]
     call isr80h_handler
-    mov qword[tmp_res], rax
+
+    ; Store the result in the saved rax so it is restored with the other registers
+    mov qword [rsp+56], rax
     ; Restore general purpose registers for user land
     popad_macro
-    mov rax, [tmp_res]
+    swapgs
+    add rsp, 8
     iretq
 
 section .data
-; Inside here is stored the return result from isr80h_handler
-tmp_res: dq 0
-
 
 %macro interrupt_array_entry 1
     dq int%1
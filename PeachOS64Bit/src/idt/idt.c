@@ -34,6 +34,12 @@
 #include "memory/heap/kheap.h"
 #include "io/io.h"
 #include "status.h"
+#include "smp/smp.h"
+#include "apic/lapic.h"
+#include "idt/irq.h"
+#include "idt/irqstat.h"
+#include "idt/softirq.h"
+#include "cpu/cpu.h"
 struct idt_desc idt_descriptors[PEACHOS_TOTAL_INTERRUPTS];
 struct idtr_desc idtr_descriptor;
 
@@ -50,20 +56,43 @@ extern void isr80h_wrapper();
 
 void no_interrupt_handler()
 {
-    outb(0x20, 0x20);
+    IRQ_end_of_interrupt(IRQ_VECTOR_BASE);
 }
 
 void interrupt_handler(int interrupt, struct interrupt_frame* frame)
 {
+    bool state_saved = false;
+    uint64_t entered = cpu_read_tsc();
+    uint64_t handler_cycles = 0;
+    smp_lock_kernel();
     kernel_page();
     if (interrupt_callbacks[interrupt] != 0)
     {
         task_current_save_state(frame);
+        state_saved = true;
+        uint64_t handler_start = cpu_read_tsc();
         interrupt_callbacks[interrupt](frame);
+        handler_cycles = cpu_read_tsc() - handler_start;
+    }
+
+    IRQ_end_of_interrupt(interrupt);
+    irq_stats_record(interrupt, handler_cycles, cpu_read_tsc() - entered);
+
+    // The controller can deliver again, now do the work the top half deferred
+    softirq_run();
+
+    // Our task may have been killed by another processor while we waited for the lock
+    task_exit_if_dead();
+
+    // The callback may have woken a task or ended the timeslice. The interrupt
+    // frame stays on the kernel stack of this task until we switch back.
+    if (state_saved)
+    {
+        task_reschedule_if_requested();
     }
 
     task_page();
-    outb(0x20, 0x20);
+    smp_unlock_kernel();
 }
 
 void idt_zero()
@@ -82,7 +111,8 @@ void idt_set(int interrupt_no, void* address)
    desc->ist = 0;
 
    desc->type_attr = 0xEE;
-   if (interrupt_no <= 0x31)
+   // Device vectors, message signalled ones included, cannot be raised from user land
+   if (interrupt_no <= IRQ_MSI_VECTOR_END || interrupt_no >= LAPIC_VECTOR_BASE)
    {
       desc->type_attr = 0x8E;
    }
@@ -98,14 +128,6 @@ void idt_handle_exception()
     // task_next();
 }
 
-void idt_clock()
-{
-    outb(0x20, 0x20);
-    print("test\n");
-    // Switch to the next task
-    task_next();
-}
-
 void idt_init()
 {
     memset(idt_descriptors, 0, sizeof(idt_descriptors));
@@ -127,12 +149,16 @@ void idt_init()
     }
     
 
-    idt_register_interrupt_callback(0x20, idt_clock);
-
     // Load the interrupt descriptor table
     idt_load(&idtr_descriptor);
 }
 
+void idt_cpu_init()
+{
+    // Every processor shares the one table
+    idt_load(&idtr_descriptor);
+}
+
 int idt_register_interrupt_callback(int interrupt, INTERRUPT_CALLBACK_FUNCTION interrupt_callback)
 {
     if (interrupt < 0 || interrupt >= PEACHOS_TOTAL_INTERRUPTS)
@@ -182,9 +208,15 @@ void* isr80h_handle_command(int command, struct interrupt_frame* frame)
 void* isr80h_handler(int command, struct interrupt_frame* frame)
 {
     void* res = 0;
+    smp_lock_kernel();
     kernel_page();
+    task_exit_if_dead();
     task_current_save_state(frame);
     res = isr80h_handle_command(command, frame);
+
+    // The command may have woken something more important
+    task_reschedule_if_requested();
     task_page();
+    smp_unlock_kernel();
     return res;
 }
\ No newline at end of file
@@ -95,6 +95,17 @@ struct interrupt_frame
     uint64_t rdx;
     uint64_t rcx;
     uint64_t rax;
+    uint64_t r8;
+    uint64_t r9;
+    uint64_t r10;
+    uint64_t r11;
+    uint64_t r12;
+    uint64_t r13;
+    uint64_t r14;
+    uint64_t r15;
+
+    // Pushed by the processor for some exceptions, zero for everything else
+    uint64_t error_code;
     uint64_t ip;
     uint64_t cs;
     uint64_t flags;
@@ -103,6 +114,11 @@ struct interrupt_frame
 } __attribute__((packed));
 
 void idt_init();
+
+/**
+ * Loads the interrupt descriptor table on an application processor
+ */
+void idt_cpu_init();
 void enable_interrupts();
 void disable_interrupts();
 void isr80h_register_command(int command_id, ISR80H_COMMAND command);
@@ -27,8 +27,23 @@
 
 #include "idt/irq.h"
 #include "io/io.h"
+#include "status.h"
+#include "apic/lapic.h"
+#include "apic/ioapic.h"
+#include "cpu/cpu.h"
 
-void IRQ_enable(IRQ irq)
+// The IRQs drivers asked for, kept so they can be moved from the PIC to the I/O APIC
+static uint16_t irq_enabled_mask = 0;
+
+// The processor each IRQ is delivered to while the I/O APIC is in use
+static uint8_t irq_destinations[IRQ_TOTAL_LEGACY];
+
+static bool irq_apic_mode = false;
+
+// The vectors IRQ_msi_vector_alloc() has given out and not had back
+static bool irq_msi_vectors_used[IRQ_MSI_VECTOR_END - IRQ_MSI_VECTOR_BASE + 1];
+
+static void IRQ_pic_enable(IRQ irq)
 {
     int port = IRQ_MASTER_PORT;
     // The IRQ_line relative to the PIC
@@ -51,7 +66,7 @@ void IRQ_enable(IRQ irq)
     outb(port, pic_value);
 }
 
-void IRQ_disable(IRQ irq)
+static void IRQ_pic_disable(IRQ irq)
 {
     int port = IRQ_MASTER_PORT;
     // The IRQ_line relative to the PIC
@@ -72,4 +87,157 @@ void IRQ_disable(IRQ irq)
     // Write the updated mask back to the PIC
     // disabling that IRQ functionality
     outb(port, pic_value);
-}
\ No newline at end of file
+}
+
+void IRQ_enable(IRQ irq)
+{
+    if (irq < 0 || irq >= IRQ_TOTAL_LEGACY)
+    {
+        return;
+    }
+
+    irq_enabled_mask |= (1 << irq);
+    if (irq_apic_mode)
+    {
+        ioapic_route_isa(irq, IRQ_VECTOR_BASE + irq, irq_destinations[irq]);
+        return;
+    }
+
+    IRQ_pic_enable(irq);
+}
+
+void IRQ_disable(IRQ irq)
+{
+    if (irq < 0 || irq >= IRQ_TOTAL_LEGACY)
+    {
+        return;
+    }
+
+    irq_enabled_mask &= ~(1 << irq);
+    if (irq_apic_mode)
+    {
+        ioapic_mask_isa(irq);
+        return;
+    }
+
+    IRQ_pic_disable(irq);
+}
+
+int IRQ_apic_init(struct acpi_madt_info* info)
+{
+    int res = ioapic_init(info);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    // The PIC stays remapped so a spurious interrupt from it cannot look like an exception
+    outb(IRQ_MASTER_PORT, IRQ_PIC_MASK_ALL);
+    outb(IRQ_SLAVE_PORT, IRQ_PIC_MASK_ALL);
+
+    uint8_t apic_id = lapic_id();
+    for (int irq = 0; irq < IRQ_TOTAL_LEGACY; irq++)
+    {
+        irq_destinations[irq] = apic_id;
+    }
+
+    irq_apic_mode = true;
+    for (int irq = 0; irq < IRQ_TOTAL_LEGACY; irq++)
+    {
+        if (irq_enabled_mask & (1 << irq))
+        {
+            IRQ_enable(irq);
+        }
+    }
+
+out:
+    return res;
+}
+
+bool IRQ_apic_enabled()
+{
+    return irq_apic_mode;
+}
+
+int IRQ_set_affinity(IRQ irq, uint8_t apic_id)
+{
+    if (irq < 0 || irq >= IRQ_TOTAL_LEGACY)
+    {
+        return -EINVARG;
+    }
+
+    if (!irq_apic_mode)
+    {
+        return -EUNIMP;
+    }
+
+    irq_destinations[irq] = apic_id;
+    if (irq_enabled_mask & (1 << irq))
+    {
+        IRQ_enable(irq);
+    }
+
+    return 0;
+}
+
+int IRQ_msi_vector_alloc()
+{
+    for (int vector = IRQ_MSI_VECTOR_BASE; vector <= IRQ_MSI_VECTOR_END; vector++)
+    {
+        if (!irq_msi_vectors_used[vector - IRQ_MSI_VECTOR_BASE])
+        {
+            irq_msi_vectors_used[vector - IRQ_MSI_VECTOR_BASE] = true;
+            return vector;
+        }
+    }
+
+    return -ENOMEM;
+}
+
+void IRQ_msi_vector_free(int vector)
+{
+    if (vector < IRQ_MSI_VECTOR_BASE || vector > IRQ_MSI_VECTOR_END)
+    {
+        return;
+    }
+
+    irq_msi_vectors_used[vector - IRQ_MSI_VECTOR_BASE] = false;
+}
+
+uint8_t IRQ_msi_destination()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+    // The initial APIC id is in the top byte
+    return ebx >> 24;
+}
+
+void IRQ_end_of_interrupt(int interrupt)
+{
+    if (interrupt < IRQ_VECTOR_BASE || interrupt == LAPIC_SPURIOUS_VECTOR)
+    {
+        // Exceptions are not acknowledged, nor are spurious interrupts
+        return;
+    }
+
+    if (irq_apic_mode || interrupt >= LAPIC_VECTOR_BASE ||
+        (interrupt >= IRQ_MSI_VECTOR_BASE && interrupt <= IRQ_MSI_VECTOR_END))
+    {
+        // Every interrupt arrives through the local APIC now, messages always do
+        lapic_eoi();
+        return;
+    }
+
+    if (interrupt >= IRQ_VECTOR_BASE + IRQ_TOTAL_LEGACY)
+    {
+        // Not from the PIC, a software interrupt
+        return;
+    }
+
+    if (interrupt >= IRQ_VECTOR_BASE + PIC_SLAVE_STARTING_IRQ)
+    {
+        outb(IRQ_SLAVE_COMMAND_PORT, IRQ_PIC_EOI);
+    }
+    outb(IRQ_MASTER_COMMAND_PORT, IRQ_PIC_EOI);
+}
@@ -51,8 +51,60 @@ enum
 #define PIC_SLAVE_ENDING_IRQ 15
 #define IRQ_MASTER_PORT 0x21
 #define IRQ_SLAVE_PORT 0xA1
+#define IRQ_MASTER_COMMAND_PORT 0x20
+#define IRQ_SLAVE_COMMAND_PORT 0xA0
+#define IRQ_PIC_EOI 0x20
+#define IRQ_PIC_MASK_ALL 0xFF
+
+// kernel.asm remaps the PIC so IRQ0 arrives on this vector, the I/O APIC keeps the same layout
+#define IRQ_VECTOR_BASE 0x20
+#define IRQ_TOTAL_LEGACY 16
+
+// Vectors handed to message signalled interrupts, they arrive straight at a local APIC
+#define IRQ_MSI_VECTOR_BASE 0x30
+#define IRQ_MSI_VECTOR_END 0x7F
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct acpi_madt_info;
 
 typedef int IRQ;
 void IRQ_disable(IRQ irq);
 void IRQ_enable(IRQ irq);
+
+/**
+ * Masks the whole 8259 PIC and moves every enabled IRQ over to the I/O APIC,
+ * delivered to the calling processor. Nothing changes when there is no I/O APIC.
+ */
+int IRQ_apic_init(struct acpi_madt_info* info);
+bool IRQ_apic_enabled();
+
+/**
+ * Delivers the IRQ to the processor with the given APIC id from now on.
+ * Only possible once the I/O APIC is in use, the PIC always interrupts the bootstrap processor.
+ */
+int IRQ_set_affinity(IRQ irq, uint8_t apic_id);
+
+/**
+ * Hands out an unused vector for a message signalled interrupt
+ * \return Returns the vector or -ENOMEM when all of them are taken
+ */
+int IRQ_msi_vector_alloc();
+
+/**
+ * Gives back a vector of IRQ_msi_vector_alloc() once nothing signals it
+ */
+void IRQ_msi_vector_free(int vector);
+
+/**
+ * The APIC id of the processor messages are sent to, the bootstrap processor.
+ * CPUID gives it as drivers start before the local APIC is mapped.
+ */
+uint8_t IRQ_msi_destination();
+
+/**
+ * Acknowledges the interrupt at whichever controller raised it
+ */
+void IRQ_end_of_interrupt(int interrupt);
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "irqstat.h"
+#include "status.h"
+#include "memory/memory.h"
+
+static struct irq_stats irq_stats[IRQ_STATS_VECTORS];
+
+static int irq_stats_bucket(uint64_t cycles)
+{
+    int bucket = 0;
+    while (cycles >= 4 && bucket < IRQ_STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        cycles >>= 2;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void irq_stats_record(int vector, uint64_t handler_cycles, uint64_t latency_cycles)
+{
+    if (vector < 0 || vector >= IRQ_STATS_VECTORS)
+    {
+        return;
+    }
+
+    struct irq_stats* stats = &irq_stats[vector];
+    stats->count++;
+    stats->handler_cycles += handler_cycles;
+    if (handler_cycles > stats->max_handler_cycles)
+    {
+        stats->max_handler_cycles = handler_cycles;
+    }
+
+    if (latency_cycles > stats->max_latency_cycles)
+    {
+        stats->max_latency_cycles = latency_cycles;
+    }
+
+    stats->latency_histogram[irq_stats_bucket(latency_cycles)]++;
+}
+
+int irq_stats_get(int vector, struct irq_stats_info* info_out)
+{
+    if (vector < 0 || vector >= IRQ_STATS_VECTORS)
+    {
+        return -EINVARG;
+    }
+
+    struct irq_stats* stats = &irq_stats[vector];
+    memset(info_out, 0x00, sizeof(struct irq_stats_info));
+    info_out->count = stats->count;
+    info_out->handler_cycles = stats->handler_cycles;
+    info_out->max_handler_cycles = stats->max_handler_cycles;
+    info_out->max_latency_cycles = stats->max_latency_cycles;
+    memcpy(info_out->latency_histogram, stats->latency_histogram, sizeof(info_out->latency_histogram));
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_IRQSTAT_H
+#define KERNEL_IRQSTAT_H
+
+#include <stdint.h>
+
+// Statistics are kept for every vector the processor can deliver
+#define IRQ_STATS_VECTORS 256
+
+// Latencies are bucketed by powers of four cycles like the lock statistics, the last bucket takes everything longer
+#define IRQ_STATS_HISTOGRAM_BUCKETS 16
+
+/**
+ * Counters of one interrupt vector. Updated by interrupt_handler() with the
+ * kernel lock held so no atomics are needed.
+ */
+struct irq_stats
+{
+    uint64_t count;
+
+    // Cycles spent in the registered callback
+    uint64_t handler_cycles;
+    uint64_t max_handler_cycles;
+
+    // Cycles from entering interrupt_handler() until the controller was acknowledged,
+    // this includes waiting for the kernel lock
+    uint64_t max_latency_cycles;
+    uint64_t latency_histogram[IRQ_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Copy of the statistics of a vector as handed to user land, keep in sync
+ * with the standard library.
+ */
+struct irq_stats_info
+{
+    uint64_t count;
+    uint64_t handler_cycles;
+    uint64_t max_handler_cycles;
+    uint64_t max_latency_cycles;
+    uint64_t latency_histogram[IRQ_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Records one interrupt on the vector
+ * \param handler_cycles Cycles the callback ran for, zero when there was none
+ * \param latency_cycles Cycles from entry to end of interrupt
+ */
+void irq_stats_record(int vector, uint64_t handler_cycles, uint64_t latency_cycles);
+
+/**
+ * Copies the statistics of the vector
+ * \return Returns zero on success or -EINVARG when the vector is out of range
+ */
+int irq_stats_get(int vector, struct irq_stats_info* info_out);
+
+#endif
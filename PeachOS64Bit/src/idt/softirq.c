@@ -0,0 +1,152 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "softirq.h"
+#include "kernel.h"
+#include "smp/smp.h"
+#include "task/task.h"
+#include "task/waitqueue.h"
+#include "lib/spinlock/spinlock.h"
+
+static SOFTIRQ_FUNCTION softirq_handlers[SOFTIRQ_TOTAL];
+
+// The task that drains whatever interrupt exit left behind
+static struct task* softirq_task = NULL;
+static struct waitqueue softirq_waiters;
+static struct spinlock softirq_lock;
+
+void softirq_register(int type, SOFTIRQ_FUNCTION func)
+{
+    if (type < 0 || type >= SOFTIRQ_TOTAL)
+    {
+        panic("softirq_register(): Invalid softirq type\n");
+    }
+
+    softirq_handlers[type] = func;
+}
+
+bool softirq_raise(int type, uint64_t data)
+{
+    struct softirq_ring* ring = &smp_cpu_current()->softirq;
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail - head >= SOFTIRQ_RING_SIZE)
+    {
+        ring->dropped++;
+        return false;
+    }
+
+    struct softirq_record* record = &ring->records[tail % SOFTIRQ_RING_SIZE];
+    record->type = type;
+    record->data = data;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Runs up to budget records of the ring
+ * \return Returns true when records are still left
+ */
+static bool softirq_drain(struct softirq_ring* ring, int budget)
+{
+    uint32_t head = ring->head;
+    while (budget-- > 0)
+    {
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+        {
+            return false;
+        }
+
+        // Copied out so the slot can be reused as soon as head moves on
+        struct softirq_record record = ring->records[head % SOFTIRQ_RING_SIZE];
+        head++;
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+        if (softirq_handlers[record.type])
+        {
+            softirq_handlers[record.type](record.data);
+        }
+    }
+
+    return head != __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+static void softirq_wake_task()
+{
+    uint64_t flags = spin_lock_irqsave(&softirq_lock);
+    waitqueue_wake_one(&softirq_waiters);
+    spin_unlock_irqrestore(&softirq_lock, flags);
+}
+
+void softirq_run()
+{
+    if (softirq_drain(&smp_cpu_current()->softirq, SOFTIRQ_BUDGET) && softirq_task)
+    {
+        softirq_wake_task();
+    }
+}
+
+/**
+ * Drains the rings of every processor a budget at a time, consumers are
+ * serialised by the kernel lock so it may take any ring
+ */
+static void softirq_task_main(void* arg)
+{
+    while (1)
+    {
+        bool pending = false;
+        for (int i = 0; i < smp_total_cpus(); i++)
+        {
+            pending |= softirq_drain(&smp_cpu(i)->softirq, SOFTIRQ_BUDGET);
+        }
+
+        if (pending)
+        {
+            task_yield();
+            continue;
+        }
+
+        // Raised work is picked up on interrupt exit, we are only woken for what it leaves
+        uint64_t flags = spin_lock_irqsave(&softirq_lock);
+        waitqueue_add(&softirq_waiters, task_current());
+        spin_unlock_irqrestore(&softirq_lock, flags);
+        task_next();
+    }
+}
+
+void softirq_init()
+{
+    spinlock_init(&softirq_lock, NULL);
+    waitqueue_init(&softirq_waiters);
+    struct task* task = task_new_kernel(softirq_task_main, NULL);
+    if (ISERR(task))
+    {
+        panic("softirq_init(): Failed to create the softirq task\n");
+    }
+
+    softirq_task = task;
+}
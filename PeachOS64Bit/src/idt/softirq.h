@@ -0,0 +1,93 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_SOFTIRQ_H
+#define KERNEL_SOFTIRQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Records each processor can hold before top halves start dropping them, must be a power of two
+#define SOFTIRQ_RING_SIZE 256
+
+// Records run on the way out of one interrupt, the rest is left to the softirq task
+#define SOFTIRQ_BUDGET 32
+
+/**
+ * The kinds of deferred interrupt work, each has one bottom half function
+ */
+enum
+{
+    SOFTIRQ_KEYBOARD,
+    SOFTIRQ_TOTAL
+};
+
+typedef void (*SOFTIRQ_FUNCTION)(uint64_t data);
+
+struct softirq_record
+{
+    int type;
+    uint64_t data;
+};
+
+/**
+ * Per processor ring of raised softirqs. Only the top halves of the owning
+ * processor produce and a single consumer drains it, so the indexes are
+ * published with acquire/release ordering and no lock is taken.
+ */
+struct softirq_ring
+{
+    struct softirq_record records[SOFTIRQ_RING_SIZE];
+
+    // Free running, the slot is the index modulo the size
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+    // Records lost because the ring was full
+    uint64_t dropped;
+};
+
+/**
+ * Starts the softirq task that takes over when interrupt exit runs out of budget
+ */
+void softirq_init();
+
+void softirq_register(int type, SOFTIRQ_FUNCTION func);
+
+/**
+ * Called by a top half, queues the record on the ring of this processor
+ * \return Returns false when the ring is full and the record was dropped
+ */
+bool softirq_raise(int type, uint64_t data);
+
+/**
+ * Runs the pending bottom halves of this processor up to SOFTIRQ_BUDGET,
+ * called on interrupt exit once the controller has been acknowledged.
+ */
+void softirq_run();
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "disk.h"
+#include "task/task.h"
+#include "task/process.h"
+
+void* isr80h_command31_disk_read(struct interrupt_frame* frame)
+{
+    int index = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    uint64_t lba = (uint64_t)(uintptr_t) task_get_stack_item(task_current(), 1);
+    int total = (int)(intptr_t) task_get_stack_item(task_current(), 2);
+    void* buf = task_get_stack_item(task_current(), 3);
+    return (void*)(intptr_t) process_disk_read(task_current()->process, index, lba, total, buf);
+}
+
+void* isr80h_command32_disk_write(struct interrupt_frame* frame)
+{
+    int index = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    uint64_t lba = (uint64_t)(uintptr_t) task_get_stack_item(task_current(), 1);
+    int total = (int)(intptr_t) task_get_stack_item(task_current(), 2);
+    void* buf = task_get_stack_item(task_current(), 3);
+    return (void*)(intptr_t) process_disk_write(task_current()->process, index, lba, total, buf);
+}
+
+void* isr80h_command33_disk_sync(struct interrupt_frame* frame)
+{
+    int index = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    return (void*)(intptr_t) process_disk_sync(task_current()->process, index);
+}
+
+void* isr80h_command34_disk_stats(struct interrupt_frame* frame)
+{
+    int index = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    void* info = task_get_stack_item(task_current(), 1);
+    return (void*)(intptr_t) process_disk_stats(task_current()->process, index, info);
+}
+
+void* isr80h_command35_disk_trace(struct interrupt_frame* frame)
+{
+    int enable = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    uint64_t since = (uint64_t)(uintptr_t) task_get_stack_item(task_current(), 1);
+    void* entries = task_get_stack_item(task_current(), 2);
+    int max = (int)(intptr_t) task_get_stack_item(task_current(), 3);
+    return (void*)(intptr_t) process_disk_trace(task_current()->process, enable, since, entries, max);
+}
@@ -46,6 +46,19 @@ void* isr80h_command2_getkey(struct interrupt_frame* frame)
     return (void*)((uintptr_t)c);
 }
 
+void* isr80h_command16_getkey_block(struct interrupt_frame* frame)
+{
+    char c = keyboard_pop();
+    while (c == 0)
+    {
+        // Sleep instead of letting user land spin on getkey
+        keyboard_wait();
+        c = keyboard_pop();
+    }
+
+    return (void*)((uintptr_t)c);
+}
+
 void* isr80h_command3_putchar(struct interrupt_frame* frame)
 {
     char c = (char)(uintptr_t) task_get_stack_item(task_current(), 0);
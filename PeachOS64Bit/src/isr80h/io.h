@@ -32,4 +32,5 @@ struct interrupt_frame;
 void* isr80h_command1_print(struct interrupt_frame* frame);
 void* isr80h_command2_getkey(struct interrupt_frame* frame);
 void* isr80h_command3_putchar(struct interrupt_frame* frame);
+void* isr80h_command16_getkey_block(struct interrupt_frame* frame);
 #endif
\ No newline at end of file
@@ -32,6 +32,9 @@
 #include "heap.h"
 #include "process.h"
 #include "file.h"
+#include "thread.h"
+#include "time.h"
+#include "disk.h"
 void isr80h_register_commands()
 {
     isr80h_register_command(SYSTEM_COMMAND0_SUM, isr80h_command0_sum);
@@ -50,4 +53,24 @@ void isr80h_register_commands()
     isr80h_register_command(SYSTEM_COMMAND13_FSEEK, isr80h_command13_fseek);
     isr80h_register_command(SYSTEM_COMMAND14_FSTAT, isr80h_command14_fstat);
     isr80h_register_command(SYSTEM_COMMAND15_REALLOC, isr80h_command15_realloc);
+    isr80h_register_command(SYSTEM_COMMAND16_GETKEY_BLOCK, isr80h_command16_getkey_block);
+    isr80h_register_command(SYSTEM_COMMAND17_WAKE_LATENCY, isr80h_command17_wake_latency);
+    isr80h_register_command(SYSTEM_COMMAND18_SET_NICE, isr80h_command18_set_nice);
+    isr80h_register_command(SYSTEM_COMMAND19_PROCESS_SPAWN, isr80h_command19_process_spawn);
+    isr80h_register_command(SYSTEM_COMMAND20_LOCK_STATS, isr80h_command20_lock_stats);
+    isr80h_register_command(SYSTEM_COMMAND21_THREAD_CREATE, isr80h_command21_thread_create);
+    isr80h_register_command(SYSTEM_COMMAND22_THREAD_EXIT, isr80h_command22_thread_exit);
+    isr80h_register_command(SYSTEM_COMMAND23_THREAD_JOIN, isr80h_command23_thread_join);
+    isr80h_register_command(SYSTEM_COMMAND24_THREAD_SELF, isr80h_command24_thread_self);
+    isr80h_register_command(SYSTEM_COMMAND25_FUTEX_WAIT, isr80h_command25_futex_wait);
+    isr80h_register_command(SYSTEM_COMMAND26_FUTEX_WAKE, isr80h_command26_futex_wake);
+    isr80h_register_command(SYSTEM_COMMAND27_PROCESS_WAIT, isr80h_command27_process_wait);
+    isr80h_register_command(SYSTEM_COMMAND28_CLOCK_GETTIME, isr80h_command28_clock_gettime);
+    isr80h_register_command(SYSTEM_COMMAND29_NANOSLEEP, isr80h_command29_nanosleep);
+    isr80h_register_command(SYSTEM_COMMAND30_IRQ_STATS, isr80h_command30_irq_stats);
+    isr80h_register_command(SYSTEM_COMMAND31_DISK_READ, isr80h_command31_disk_read);
+    isr80h_register_command(SYSTEM_COMMAND32_DISK_WRITE, isr80h_command32_disk_write);
+    isr80h_register_command(SYSTEM_COMMAND33_DISK_SYNC, isr80h_command33_disk_sync);
+    isr80h_register_command(SYSTEM_COMMAND34_DISK_STATS, isr80h_command34_disk_stats);
+    isr80h_register_command(SYSTEM_COMMAND35_DISK_TRACE, isr80h_command35_disk_trace);
 }
\ No newline at end of file
@@ -45,7 +45,27 @@ enum SystemCommands
     SYSTEM_COMMAND12_FREAD,
     SYSTEM_COMMAND13_FSEEK,
     SYSTEM_COMMAND14_FSTAT,
-    SYSTEM_COMMAND15_REALLOC
+    SYSTEM_COMMAND15_REALLOC,
+    SYSTEM_COMMAND16_GETKEY_BLOCK,
+    SYSTEM_COMMAND17_WAKE_LATENCY,
+    SYSTEM_COMMAND18_SET_NICE,
+    SYSTEM_COMMAND19_PROCESS_SPAWN,
+    SYSTEM_COMMAND20_LOCK_STATS,
+    SYSTEM_COMMAND21_THREAD_CREATE,
+    SYSTEM_COMMAND22_THREAD_EXIT,
+    SYSTEM_COMMAND23_THREAD_JOIN,
+    SYSTEM_COMMAND24_THREAD_SELF,
+    SYSTEM_COMMAND25_FUTEX_WAIT,
+    SYSTEM_COMMAND26_FUTEX_WAKE,
+    SYSTEM_COMMAND27_PROCESS_WAIT,
+    SYSTEM_COMMAND28_CLOCK_GETTIME,
+    SYSTEM_COMMAND29_NANOSLEEP,
+    SYSTEM_COMMAND30_IRQ_STATS,
+    SYSTEM_COMMAND31_DISK_READ,
+    SYSTEM_COMMAND32_DISK_WRITE,
+    SYSTEM_COMMAND33_DISK_SYNC,
+    SYSTEM_COMMAND34_DISK_STATS,
+    SYSTEM_COMMAND35_DISK_TRACE
 };
 
 void isr80h_register_commands();
@@ -28,10 +28,42 @@
 #include "misc.h"
 #include "idt/idt.h"
 #include "task/task.h"
+#include "lib/lockstat/lockstat.h"
+#include "idt/irqstat.h"
+#include "status.h"
 
 void* isr80h_command0_sum(struct interrupt_frame* frame)
 {
     intptr_t v2 = (intptr_t) task_get_stack_item(task_current(), 1);
     intptr_t v1 = (intptr_t) task_get_stack_item(task_current(), 0);
     return (void*)(v1 + v2);
-}
\ No newline at end of file
+}
+void* isr80h_command17_wake_latency(struct interrupt_frame* frame)
+{
+    // Cycles between the last wake up of the caller and it being scheduled
+    return (void*) task_current()->wake_latency;
+}
+
+void* isr80h_command20_lock_stats(struct interrupt_frame* frame)
+{
+    int index = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    struct lock_stats_info* info = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 1));
+    if (!info)
+    {
+        return (void*)(intptr_t) -EINVARG;
+    }
+
+    return (void*)(intptr_t) lock_stats_get(index, info);
+}
+
+void* isr80h_command30_irq_stats(struct interrupt_frame* frame)
+{
+    int vector = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    struct irq_stats_info* info = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 1));
+    if (!info)
+    {
+        return (void*)(intptr_t) -EINVARG;
+    }
+
+    return (void*)(intptr_t) irq_stats_get(vector, info);
+}
@@ -30,4 +30,7 @@
 
 struct interrupt_frame;
 void* isr80h_command0_sum(struct interrupt_frame* frame);
+void* isr80h_command17_wake_latency(struct interrupt_frame* frame);
+void* isr80h_command20_lock_stats(struct interrupt_frame* frame);
+void* isr80h_command30_irq_stats(struct interrupt_frame* frame);
 #endif
\ No newline at end of file
@@ -55,8 +55,8 @@ void* isr80h_command6_process_load_start(struct interrupt_frame* frame)
         goto out;
     }
 
-    task_switch(process->task);
-    task_return(&process->task->registers);
+    // We carry on from here once the scheduler picks us again
+    task_run(process->task);
 
 out:
     return 0;
@@ -90,9 +90,7 @@ void* isr80h_command7_invoke_system_command(struct interrupt_frame* frame)
         return ERROR(res);
     }
 
-    task_switch(process->task);
-    task_return(&process->task->registers);
-
+    task_run(process->task);
     return 0;
 }
 
@@ -109,6 +107,54 @@ void* isr80h_command9_exit(struct interrupt_frame* frame)
 {
     struct process* process = task_current()->process;
     process_terminate(process);
+
+    // The task is dead so it is never picked again, this does not return
     task_next();
     return 0;
-}
\ No newline at end of file
+}
+
+void* isr80h_command18_set_nice(struct interrupt_frame* frame)
+{
+    int nice = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    return (void*)(intptr_t) task_set_nice(task_current(), nice);
+}
+
+void* isr80h_command19_process_spawn(struct interrupt_frame* frame)
+{
+    struct command_argument* arguments = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
+    if (!arguments || strlen(arguments[0].argument) == 0)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    struct command_argument* root_command_argument = &arguments[0];
+    const char* program_name = root_command_argument->argument;
+
+    char path[PEACHOS_MAX_PATH];
+    strcpy(path, "@:/");
+    strncpy(path+3, program_name, sizeof(path));
+
+    // Unlike command 7 the caller keeps running and keeps the keyboard,
+    // the new process is only queued on the scheduler
+    struct process* process = 0;
+    int res = process_load(path, &process);
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
+
+    res = process_inject_arguments(process, root_command_argument);
+    if (res < 0)
+    {
+        process_terminate(process);
+        return ERROR(res);
+    }
+
+    return (void*)(intptr_t) process->id;
+}
+
+void* isr80h_command27_process_wait(struct interrupt_frame* frame)
+{
+    int process_id = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    return (void*)(intptr_t) process_wait(process_id);
+}
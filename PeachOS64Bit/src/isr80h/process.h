@@ -33,5 +33,8 @@ void* isr80h_command6_process_load_start(struct interrupt_frame* frame);
 void* isr80h_command7_invoke_system_command(struct interrupt_frame* frame);
 void* isr80h_command8_get_program_arguments(struct interrupt_frame* frame);
 void* isr80h_command9_exit(struct interrupt_frame* frame);
+void* isr80h_command18_set_nice(struct interrupt_frame* frame);
+void* isr80h_command19_process_spawn(struct interrupt_frame* frame);
+void* isr80h_command27_process_wait(struct interrupt_frame* frame);
 
 #endif
\ No newline at end of file
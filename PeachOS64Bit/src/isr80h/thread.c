@@ -0,0 +1,95 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "thread.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "task/futex.h"
+#include "status.h"
+#include "kernel.h"
+
+void* isr80h_command21_thread_create(struct interrupt_frame* frame)
+{
+    // The stdlib passes its own start routine as the entry, it calls the user function
+    void* entry = task_get_stack_item(task_current(), 0);
+    void* arg1 = task_get_stack_item(task_current(), 1);
+    void* arg2 = task_get_stack_item(task_current(), 2);
+    return (void*)(intptr_t) process_thread_create(task_current()->process, entry, arg1, arg2);
+}
+
+void* isr80h_command22_thread_exit(struct interrupt_frame* frame)
+{
+    uint64_t exit_code = (uint64_t) task_get_stack_item(task_current(), 0);
+    process_thread_exit(task_current()->process, task_current(), exit_code);
+
+    // The task is dead so it is never picked again, this does not return
+    task_next();
+    return 0;
+}
+
+void* isr80h_command23_thread_join(struct interrupt_frame* frame)
+{
+    int thread_id = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    void* exit_code_user_ptr = task_get_stack_item(task_current(), 1);
+
+    uint64_t exit_code = 0;
+    int res = process_thread_join(task_current()->process, thread_id, &exit_code);
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
+
+    if (exit_code_user_ptr)
+    {
+        uint64_t* exit_code_out = task_virtual_address_to_physical(task_current(), exit_code_user_ptr);
+        if (exit_code_out)
+        {
+            *exit_code_out = exit_code;
+        }
+    }
+
+    return 0;
+}
+
+void* isr80h_command24_thread_self(struct interrupt_frame* frame)
+{
+    return (void*)(intptr_t) task_current()->thread_id;
+}
+
+void* isr80h_command25_futex_wait(struct interrupt_frame* frame)
+{
+    void* user_address = task_get_stack_item(task_current(), 0);
+    uint32_t expected = (uint32_t)(uint64_t) task_get_stack_item(task_current(), 1);
+    return (void*)(intptr_t) futex_wait(task_current(), user_address, expected);
+}
+
+void* isr80h_command26_futex_wake(struct interrupt_frame* frame)
+{
+    void* user_address = task_get_stack_item(task_current(), 0);
+    int count = (int)(intptr_t) task_get_stack_item(task_current(), 1);
+    return (void*)(intptr_t) futex_wake(task_current(), user_address, count);
+}
@@ -0,0 +1,39 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef ISR80H_THREAD_H
+#define ISR80H_THREAD_H
+
+struct interrupt_frame;
+void* isr80h_command21_thread_create(struct interrupt_frame* frame);
+void* isr80h_command22_thread_exit(struct interrupt_frame* frame);
+void* isr80h_command23_thread_join(struct interrupt_frame* frame);
+void* isr80h_command24_thread_self(struct interrupt_frame* frame);
+void* isr80h_command25_futex_wait(struct interrupt_frame* frame);
+void* isr80h_command26_futex_wake(struct interrupt_frame* frame);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "time.h"
+#include "task/task.h"
+#include "timer/ktime.h"
+#include "timer/ktimer.h"
+#include "status.h"
+#include "kernel.h"
+
+void* isr80h_command28_clock_gettime(struct interrupt_frame* frame)
+{
+    int clock = (int)(intptr_t) task_get_stack_item(task_current(), 0);
+    struct timespec* ts = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 1));
+    if (!ts)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    if (clock != KTIME_CLOCK_MONOTONIC)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    ktime_ns_to_timespec(ktime_get_ns(), ts);
+    return 0;
+}
+
+void* isr80h_command29_nanosleep(struct interrupt_frame* frame)
+{
+    struct timespec* ts = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
+    if (!ts)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    int64_t ns = ktime_timespec_to_ns(ts);
+    if (ns < 0)
+    {
+        return ERROR(ns);
+    }
+
+    // Sleeps are only as fine as the tick, they never end early
+    uint64_t ticks = ktime_ns_to_ticks(ns);
+    if (ticks)
+    {
+        ktimer_sleep(ticks);
+    }
+    return 0;
+}
@@ -30,6 +30,8 @@ global _start
 global kernel_registers
 global div_test
 global gdt
+global gdt_descriptor
+global PML4_Table
 global default_graphics_info
 extern kernel_main
 
@@ -47,7 +49,6 @@ kernel_registers:
     mov ax, LONG_MODE_DATA_SEG
     mov ds, ax
     mov es, ax
-    mov gs, ax
     mov fs, ax
     ret
 
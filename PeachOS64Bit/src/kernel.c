@@ -45,9 +45,20 @@
 #include "fs/file.h"
 #include "disk/disk.h"
 #include "disk/gpt.h"
+#include "disk/bcache.h"
+#include "disk/blkqueue.h"
 #include "fs/pparser.h"
 #include "disk/streamer.h"
 #include "task/tss.h"
+#include "task/fpu.h"
+#include "task/workqueue.h"
+#include "task/futex.h"
+#include "timer/timer.h"
+#include "timer/ktime.h"
+#include "timer/ktimer.h"
+#include "idt/softirq.h"
+#include "pci/pci.h"
+#include "smp/smp.h"
 #include "gdt/gdt.h"
 #include "graphics/graphics.h"
 #include "graphics/image/image.h"
@@ -100,10 +111,6 @@ void panic(const char *msg)
 //     {.base = (uint32_t)&tss, .limit=sizeof(tss), .type = 0xE9}      // TSS Segment
 // };
 
-struct tss tss;
-
-extern struct gdt_entry gdt[];
-
 // page descriptor
 struct paging_desc *kernel_paging_desc = 0;
 
@@ -159,6 +166,17 @@ void kernel_main()
     // Enable interrupt descriptor table
     idt_init();
 
+    // Enable the FPU/SSE with lazy per task state switching
+    fpu_init();
+
+    // Give the bootstrap processor its GDT, TSS and kernel stack, from here on
+    // the kernel finds its processor through GS. Disk reads may already take
+    // mutexes and ask whether they can sleep.
+    smp_bsp_init();
+
+    // Find the devices on the PCI buses, the disk drivers look for their controllers here
+    pci_init();
+
     // Enable fs functionality
     fs_init();
 
@@ -188,36 +206,44 @@ void kernel_main()
     {
         panic("Failed to create system terminal\n");
     }
-    // Allocate a 1 MB stack for the kernel IDT 
-    size_t stack_size = 1024*1024;
-    void* megabyte_stack_tss_end = kzalloc(stack_size);
-    void* megabyte_stack_tss_begin = (void*)(((uintptr_t) megabyte_stack_tss_end) + stack_size);
-    
-    // Block the first page
-    paging_map(kernel_desc(), megabyte_stack_tss_end, megabyte_stack_tss_end, 0);
-
-    // Setup the TSS
-    memset(&tss, 0x00, sizeof(tss));
-    tss.rsp0 = (uint64_t) megabyte_stack_tss_begin;
-    tss.iopb_offset = sizeof(tss); // No I/O permissions are used
-
-    struct tss_desc_64* tssdesc = (struct tss_desc_64*)&gdt[KERNEL_LONG_MODE_TSS_GDT_INDEX];
-    gdt_set_tss(tssdesc, &tss, sizeof(tss)-1, TSS_DESCRIPTOR_TYPE, 0x00);
-    
-    // load the tss
-    tss_load(KERNEL_LONG_MODE_TSS_SELECTOR);
-
     // Initialize the process system
     process_system_init();
 
+    // Queues for user land threads sleeping on futex words
+    futex_init();
+
     print("tss load was fine\n");
     // Register isr80h commands
     isr80h_register_commands();
     print("register isr80h\n");
 
+    // Kernel timers, delayed work and sleeping tasks hang off the wheel
+    ktimer_system_init();
+
+    // Start the system workqueue, interrupt handlers defer their slow work to it
+    workqueue_init();
+
+    // Commands of disks whose drivers only finish what their caller waits on run on their own worker
+    blk_workqueue_init();
+
+    // Dirty blocks of the block cache are written back from their own workqueue
+    bcache_writeback_init();
+
+    // Bottom halves that interrupt exit did not get to run on their own task
+    softirq_init();
+
     // Initialize the keyboard
     keyboard_init();
 
+    // Create the task that runs when nothing else can
+    task_idle_init();
+
+    // Bring up the other processors, they wait on the kernel lock until we drop to user land
+    smp_init();
+
+    // Disk drivers with queues per processor make them now the processors are known
+    disk_smp_init();
+
     // struct image* img = graphics_image_load("@:/bkground.bmp");
     // graphics_draw_image(NULL, img, 0, 0);
     // graphics_redraw_all();
@@ -230,6 +256,12 @@ void kernel_main()
         panic("Failed to load user program\n");
     }
 
+    // Calibrate the TSC before the PIT is given to the scheduler tick
+    ktime_init();
+
+    // Start the scheduler tick, the first timer interrupt arrives in user land
+    timer_init();
+
     // Drop to user land
     task_run_first_ever_task();
 
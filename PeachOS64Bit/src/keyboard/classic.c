@@ -31,7 +31,7 @@
 #include "kernel.h"
 #include "idt/idt.h"
 #include "idt/irq.h"
-#include "task/task.h"
+#include "idt/softirq.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -59,11 +59,12 @@ struct keyboard classic_keyboard = {
     .init = classic_keyboard_init
 };
 
-
 void classic_keyboard_handle_interrupt();
+static void classic_keyboard_process_scancode(uint64_t scancode);
 
 int classic_keyboard_init()
 {
+    softirq_register(SOFTIRQ_KEYBOARD, classic_keyboard_process_scancode);
     idt_register_interrupt_callback(ISR_KEYBOARD_INTERRUPT, classic_keyboard_handle_interrupt);
 
     keyboard_set_capslock(&classic_keyboard, KEYBOARD_CAPS_LOCK_OFF);
@@ -95,18 +96,12 @@ uint8_t classic_keyboard_scancode_to_char(uint8_t scancode)
 }
 
 
-void classic_keyboard_handle_interrupt()
+/**
+ * The bottom half, turns the scancode into a character for the foreground
+ * process and wakes its readers
+ */
+static void classic_keyboard_process_scancode(uint64_t scancode)
 {
-    kernel_page();
-    uint8_t scancode = 0;
-    scancode = insb(KEYBOARD_INPUT_PORT);
-    insb(KEYBOARD_INPUT_PORT);
-
-    if(scancode & CLASSIC_KEYBOARD_KEY_RELEASED)
-    {
-        return;
-    }
-
     if (scancode == CLASSIC_KEYBOARD_CAPSLOCK)
     {
         KEYBOARD_CAPS_LOCK_STATE old_state = keyboard_get_capslock(&classic_keyboard);
@@ -118,9 +113,24 @@ void classic_keyboard_handle_interrupt()
     {
         keyboard_push(c);
     }
+}
+
+/**
+ * The top half, only reads the scancode from the controller. Key presses
+ * are dropped while the softirq ring is full.
+ */
+void classic_keyboard_handle_interrupt()
+{
+    uint8_t scancode = 0;
+    scancode = insb(KEYBOARD_INPUT_PORT);
+    insb(KEYBOARD_INPUT_PORT);
 
-    task_page();
+    if(scancode & CLASSIC_KEYBOARD_KEY_RELEASED)
+    {
+        return;
+    }
 
+    softirq_raise(SOFTIRQ_KEYBOARD, scancode);
 }
 
 struct keyboard* classic_init()
@@ -30,6 +30,7 @@
 #include "kernel.h"
 #include "task/process.h"
 #include "task/task.h"
+#include "task/waitqueue.h"
 #include "classic.h"
 
 static struct keyboard* keyboard_list_head = 0;
@@ -104,6 +105,9 @@ void keyboard_push(char c)
     int real_index = keyboard_get_tail_index(process);
     process->keyboard.buffer[real_index] = c;
     process->keyboard.tail++;
+
+    // Anybody blocked in a keyboard read can run again
+    waitqueue_wake_all(&process->keyboard.waiters);
 }
 
 char keyboard_pop()
@@ -125,4 +129,14 @@ char keyboard_pop()
     process->keyboard.buffer[real_index] = 0;
     process->keyboard.head++;
     return c;
-}
\ No newline at end of file
+}
+void keyboard_wait()
+{
+    struct task* task = task_current();
+    if (!task)
+    {
+        return;
+    }
+
+    waitqueue_wait(&task->process->keyboard.waiters);
+}
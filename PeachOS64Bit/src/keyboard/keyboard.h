@@ -50,6 +50,12 @@ void keyboard_init();
 void keyboard_backspace(struct process* process);
 void keyboard_push(char c);
 char keyboard_pop();
+
+/**
+ * Blocks the current task until a key is pushed to its process.
+ * Must only be called from a system command.
+ */
+void keyboard_wait();
 int keyboard_insert(struct keyboard* keyboard);
 void keyboard_set_capslock(struct keyboard* keyboard, KEYBOARD_CAPS_LOCK_STATE state);
 KEYBOARD_CAPS_LOCK_STATE keyboard_get_capslock(struct keyboard* keyboard);
@@ -0,0 +1,110 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "lockstat.h"
+#include "status.h"
+#include "cpu/cpu.h"
+#include "memory/memory.h"
+#include "string/string.h"
+
+// Registered locks, newest first. Entries are only ever added.
+static struct lock_stats* lock_stats_head = NULL;
+
+void lock_stats_init(struct lock_stats* stats, const char* name)
+{
+    memset(stats, 0x00, sizeof(struct lock_stats));
+    stats->name = name;
+    if (!name)
+    {
+        return;
+    }
+
+    // Locks can be created on any processor, push without taking a lock of our own
+    struct lock_stats* head = __atomic_load_n(&lock_stats_head, __ATOMIC_RELAXED);
+    do
+    {
+        stats->next = head;
+    } while (!__atomic_compare_exchange_n(&lock_stats_head, &head, stats, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static int lock_stats_bucket(uint64_t cycles)
+{
+    int bucket = 0;
+    while (cycles >= 4 && bucket < LOCK_STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        cycles >>= 2;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void lock_stats_contended(struct lock_stats* stats, uint64_t wait_cycles)
+{
+    stats->contentions++;
+    stats->wait_cycles += wait_cycles;
+}
+
+void lock_stats_acquired(struct lock_stats* stats)
+{
+    stats->acquisitions++;
+    stats->acquired_at = cpu_read_tsc();
+}
+
+void lock_stats_released(struct lock_stats* stats)
+{
+    uint64_t held = cpu_read_tsc() - stats->acquired_at;
+    if (held > stats->max_hold_cycles)
+    {
+        stats->max_hold_cycles = held;
+    }
+
+    stats->hold_histogram[lock_stats_bucket(held)]++;
+}
+
+int lock_stats_get(int index, struct lock_stats_info* info_out)
+{
+    struct lock_stats* stats = __atomic_load_n(&lock_stats_head, __ATOMIC_ACQUIRE);
+    for (int i = 0; stats && i < index; i++)
+    {
+        stats = stats->next;
+    }
+
+    if (index < 0 || !stats)
+    {
+        return -EINVARG;
+    }
+
+    memset(info_out, 0x00, sizeof(struct lock_stats_info));
+    strncpy(info_out->name, stats->name, sizeof(info_out->name) - 1);
+    info_out->acquisitions = stats->acquisitions;
+    info_out->contentions = stats->contentions;
+    info_out->wait_cycles = stats->wait_cycles;
+    info_out->max_hold_cycles = stats->max_hold_cycles;
+    memcpy(info_out->hold_histogram, stats->hold_histogram, sizeof(info_out->hold_histogram));
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_LOCKSTAT_H
+#define KERNEL_LOCKSTAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hold times are bucketed by powers of four cycles, the last bucket takes everything longer
+#define LOCK_STATS_HISTOGRAM_BUCKETS 16
+
+// Longest lock name copied out to user land
+#define LOCK_STATS_NAME_MAX 32
+
+/**
+ * Contention counters and a hold time histogram kept with a lock.
+ * Only updated while the lock, or the spinlock guarding it, is held so
+ * no atomics are needed.
+ */
+struct lock_stats
+{
+    const char* name;
+    uint64_t acquisitions;
+
+    // Acquisitions that found the lock held and had to wait
+    uint64_t contentions;
+    uint64_t wait_cycles;
+
+    uint64_t max_hold_cycles;
+    uint64_t hold_histogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+
+    // Time stamp of the current acquisition
+    uint64_t acquired_at;
+
+    // Next registered lock
+    struct lock_stats* next;
+};
+
+/**
+ * Copy of the statistics of a lock as handed to user land, keep in sync
+ * with the standard library.
+ */
+struct lock_stats_info
+{
+    char name[LOCK_STATS_NAME_MAX];
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_cycles;
+    uint64_t max_hold_cycles;
+    uint64_t hold_histogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Resets the statistics, named locks are registered so they can be reported.
+ * A registered lock must never be freed.
+ */
+void lock_stats_init(struct lock_stats* stats, const char* name);
+
+/**
+ * Called when an acquisition found the lock held
+ * \param wait_cycles Cycles spent waiting for it, zero if not known
+ */
+void lock_stats_contended(struct lock_stats* stats, uint64_t wait_cycles);
+
+/**
+ * Called once the lock is held
+ */
+void lock_stats_acquired(struct lock_stats* stats);
+
+/**
+ * Called just before the lock is released
+ */
+void lock_stats_released(struct lock_stats* stats);
+
+/**
+ * Copies the statistics of the registered lock at the given index
+ * \return Returns zero on success or -EINVARG when there is no such lock
+ */
+int lock_stats_get(int index, struct lock_stats_info* info_out);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "mutex.h"
+#include "kernel.h"
+#include "task/task.h"
+#include "cpu/cpu.h"
+
+void mutex_init(struct mutex* mutex, const char* name)
+{
+    spinlock_init(&mutex->lock, NULL);
+    mutex->locked = false;
+    mutex->owner = NULL;
+    waitqueue_init(&mutex->waiters);
+#if PEACHOS_LOCK_STATS
+    lock_stats_init(&mutex->stats, name);
+#endif
+}
+
+/**
+ * Takes the mutex for the current task, the spinlock must be held
+ */
+static void mutex_take(struct mutex* mutex)
+{
+    mutex->locked = true;
+    mutex->owner = task_current();
+#if PEACHOS_LOCK_STATS
+    lock_stats_acquired(&mutex->stats);
+#endif
+}
+
+bool mutex_trylock(struct mutex* mutex)
+{
+    bool taken = false;
+    uint64_t flags = spin_lock_irqsave(&mutex->lock);
+    if (!mutex->locked)
+    {
+        mutex_take(mutex);
+        taken = true;
+    }
+    spin_unlock_irqrestore(&mutex->lock, flags);
+    return taken;
+}
+
+void mutex_lock(struct mutex* mutex)
+{
+    uint64_t flags = spin_lock_irqsave(&mutex->lock);
+    if (!mutex->locked)
+    {
+        mutex_take(mutex);
+        spin_unlock_irqrestore(&mutex->lock, flags);
+        return;
+    }
+
+    struct task* task = task_current();
+    if (!task || task_is_idle(task))
+    {
+        panic("mutex_lock(): The mutex is held and there is no task to put to sleep\n");
+    }
+
+    if (mutex->owner == task)
+    {
+        panic("mutex_lock(): The task already holds the mutex\n");
+    }
+
+#if PEACHOS_LOCK_STATS
+    uint64_t wait_start = cpu_read_tsc();
+#endif
+    // Another task may take it between our wake up and us running, so wait again if so
+    while (mutex->locked)
+    {
+        waitqueue_add(&mutex->waiters, task);
+        spin_unlock_irqrestore(&mutex->lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&mutex->lock);
+    }
+
+#if PEACHOS_LOCK_STATS
+    lock_stats_contended(&mutex->stats, cpu_read_tsc() - wait_start);
+#endif
+    mutex_take(mutex);
+    spin_unlock_irqrestore(&mutex->lock, flags);
+}
+
+void mutex_unlock(struct mutex* mutex)
+{
+    uint64_t flags = spin_lock_irqsave(&mutex->lock);
+#if PEACHOS_LOCK_STATS
+    lock_stats_released(&mutex->stats);
+#endif
+    mutex->locked = false;
+    mutex->owner = NULL;
+
+    // The woken task takes the mutex when it runs unless somebody beats it to it
+    waitqueue_wake_one(&mutex->waiters);
+    spin_unlock_irqrestore(&mutex->lock, flags);
+}
+
+bool mutex_is_locked(struct mutex* mutex)
+{
+    return mutex->locked;
+}
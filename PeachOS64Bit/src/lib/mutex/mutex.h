@@ -0,0 +1,77 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_MUTEX_H
+#define KERNEL_MUTEX_H
+
+#include <stdbool.h>
+#include "config.h"
+#include "lib/spinlock/spinlock.h"
+#include "lib/lockstat/lockstat.h"
+#include "task/waitqueue.h"
+
+struct task;
+
+/**
+ * A sleeping lock for longer critical sections such as file system calls.
+ * Tasks that find it held block on its waitqueue instead of spinning, so it
+ * must not be taken from interrupt handlers.
+ */
+struct mutex
+{
+    // Guards the fields below
+    struct spinlock lock;
+
+    bool locked;
+    struct task* owner;
+
+    // Tasks waiting for the mutex to be released
+    struct waitqueue waiters;
+
+#if PEACHOS_LOCK_STATS
+    struct lock_stats stats;
+#endif
+};
+
+/**
+ * \param name Name shown in the lock statistics, NULL keeps the mutex out of them
+ */
+void mutex_init(struct mutex* mutex, const char* name);
+
+/**
+ * Takes the mutex, sleeping until it is released when another task holds it
+ */
+void mutex_lock(struct mutex* mutex);
+
+/**
+ * \return Returns true if the mutex was taken, never sleeps
+ */
+bool mutex_trylock(struct mutex* mutex);
+void mutex_unlock(struct mutex* mutex);
+bool mutex_is_locked(struct mutex* mutex);
+
+#endif
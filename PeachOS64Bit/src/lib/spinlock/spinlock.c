@@ -0,0 +1,108 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "spinlock.h"
+#include "cpu/cpu.h"
+
+void spinlock_init(struct spinlock* lock, const char* name)
+{
+    lock->next = 0;
+    lock->owner = 0;
+#if PEACHOS_LOCK_STATS
+    lock_stats_init(&lock->stats, name);
+#endif
+}
+
+bool spin_is_locked(struct spinlock* lock)
+{
+    return lock->owner != lock->next;
+}
+
+bool spin_trylock(struct spinlock* lock)
+{
+    uint16_t ticket = lock->owner;
+    uint16_t expected = ticket;
+
+    // Only take a ticket when it would be served straight away
+    if (!__atomic_compare_exchange_n(&lock->next, &expected, (uint16_t)(ticket + 1), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return false;
+    }
+
+#if PEACHOS_LOCK_STATS
+    lock_stats_acquired(&lock->stats);
+#endif
+    return true;
+}
+
+void spin_lock(struct spinlock* lock)
+{
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) == ticket)
+    {
+#if PEACHOS_LOCK_STATS
+        lock_stats_acquired(&lock->stats);
+#endif
+        return;
+    }
+
+#if PEACHOS_LOCK_STATS
+    uint64_t wait_start = cpu_read_tsc();
+#endif
+    // Wait with plain reads so the cache line is not bounced between processors
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+    {
+        __builtin_ia32_pause();
+    }
+
+#if PEACHOS_LOCK_STATS
+    lock_stats_contended(&lock->stats, cpu_read_tsc() - wait_start);
+    lock_stats_acquired(&lock->stats);
+#endif
+}
+
+void spin_unlock(struct spinlock* lock)
+{
+#if PEACHOS_LOCK_STATS
+    lock_stats_released(&lock->stats);
+#endif
+    // Only the holder writes the owner so a plain increment is enough
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+uint64_t spin_lock_irqsave(struct spinlock* lock)
+{
+    uint64_t flags = cpu_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+void spin_unlock_irqrestore(struct spinlock* lock, uint64_t flags)
+{
+    spin_unlock(lock);
+    cpu_irq_restore(flags);
+}
@@ -0,0 +1,71 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_SPINLOCK_H
+#define KERNEL_SPINLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "lib/lockstat/lockstat.h"
+
+/**
+ * A busy waiting ticket lock for data shared between processors. Waiters are
+ * served in the order they arrived so no processor can be starved. Holders
+ * must not sleep, keep critical sections short.
+ */
+struct spinlock
+{
+    // Ticket handed to the next processor that asks for the lock
+    volatile uint16_t next;
+
+    // Ticket currently allowed to hold the lock
+    volatile uint16_t owner;
+
+#if PEACHOS_LOCK_STATS
+    struct lock_stats stats;
+#endif
+};
+
+/**
+ * \param name Name shown in the lock statistics, NULL keeps the lock out of them
+ */
+void spinlock_init(struct spinlock* lock, const char* name);
+void spin_lock(struct spinlock* lock);
+bool spin_trylock(struct spinlock* lock);
+void spin_unlock(struct spinlock* lock);
+bool spin_is_locked(struct spinlock* lock);
+
+/**
+ * Disables interrupts on this processor then takes the lock, for data
+ * that interrupt handlers also touch.
+ * \return Returns the flags register to hand back to spin_unlock_irqrestore()
+ */
+uint64_t spin_lock_irqsave(struct spinlock* lock);
+void spin_unlock_irqrestore(struct spinlock* lock, uint64_t flags);
+
+#endif
@@ -43,6 +43,7 @@ struct multiheap *multiheap_new(struct heap *starting_heap)
     multiheap->starting_heap = starting_heap;
     multiheap->first_multiheap = 0;
     multiheap->total_heaps = 0;
+    spinlock_init(&multiheap->lock, "multiheap");
 out:
     return multiheap;
 }
@@ -158,8 +159,12 @@ void multiheap_get_heap_and_paging_heap_for_address(struct multiheap* multiheap,
     *real_phys_addr = real_addr;
 }
 
+static void* multiheap_alloc_locked(struct multiheap* multiheap, size_t size);
+
 void* multiheap_realloc(struct multiheap* multiheap, void* old_ptr, size_t new_size)
 {
+    void* ptr = NULL;
+    uint64_t flags = spin_lock_irqsave(&multiheap->lock);
     struct multiheap_single_heap* paging_heap = NULL;
     struct multiheap_single_heap* phys_heap = NULL;
     struct multiheap_single_heap* heap_to_use = NULL;
@@ -175,10 +180,14 @@ void* multiheap_realloc(struct multiheap* multiheap, void* old_ptr, size_t new_s
     if (!heap_to_use)
     {
         // Heap is NULL create a new allocation
-        return multiheap_alloc(multiheap, new_size);
+        ptr = multiheap_alloc_locked(multiheap, new_size);
+        goto out;
     }
 
-    return heap_realloc(heap_to_use->heap, old_ptr, new_size);
+    ptr = heap_realloc(heap_to_use->heap, old_ptr, new_size);
+out:
+    spin_unlock_irqrestore(&multiheap->lock, flags);
+    return ptr;
 }
 
 size_t multiheap_allocation_block_count(struct multiheap* multiheap, void* ptr)
@@ -266,7 +275,7 @@ int multiheap_add(struct multiheap *multiheap, void *saddr, void *eaddr, int fla
     return multiheap_add_heap(multiheap, heap, flags);
 }
 
-void multiheap_free(struct multiheap* multiheap, void* ptr)
+static void multiheap_free_locked(struct multiheap* multiheap, void* ptr)
 {
     struct multiheap_single_heap* paging_heap = NULL;
     struct multiheap_single_heap* phys_heap = NULL;
@@ -284,8 +293,8 @@ void multiheap_free(struct multiheap* multiheap, void* ptr)
             void* virtual_address_for_block = (void*)((uintptr_t) ptr) + (i * PEACHOS_HEAP_BLOCK_SIZE);
             void* data_phys_addr = paging_get_physical_address(paging_current_descriptor(), virtual_address_for_block);
 
-            // We have the physical address now we can call multiheap_free again
-            multiheap_free(multiheap, data_phys_addr);
+            // We have the physical address now we can free it from its real heap
+            multiheap_free_locked(multiheap, data_phys_addr);
         }
 
 
@@ -296,8 +305,15 @@ void multiheap_free(struct multiheap* multiheap, void* ptr)
     {
         heap_free(phys_heap->heap, real_phys_addr);
     }
+}
 
+void multiheap_free(struct multiheap* multiheap, void* ptr)
+{
+    uint64_t flags = spin_lock_irqsave(&multiheap->lock);
+    multiheap_free_locked(multiheap, ptr);
+    spin_unlock_irqrestore(&multiheap->lock, flags);
 }
+
 void multiheap_free_heap(struct multiheap* multiheap)
 {
     struct multiheap_single_heap* current = multiheap->first_multiheap;
@@ -367,7 +383,12 @@ void* multiheap_alloc_paging(struct multiheap* multiheap, size_t size, struct mu
     return allocation_ptr;
 }
 
-void* multiheap_alloc_second_pass(struct multiheap* multiheap, size_t size)
+/**
+ * Called with the lock held, it is dropped while the pages are mapped because
+ * mapping may have to allocate page tables from this very multiheap. The blocks
+ * are already reserved in both heaps so nobody else can take them meanwhile.
+ */
+void* multiheap_alloc_second_pass(struct multiheap* multiheap, size_t size, uint64_t* flags)
 {
     void* allocation_ptr = NULL;
     struct paging_desc* paging_desc = paging_current_descriptor();
@@ -398,7 +419,9 @@ void* multiheap_alloc_second_pass(struct multiheap* multiheap, size_t size)
             panic("Something went wrong, is there not enough bytes in physical heap but there is in paging heap, this mus ta bug");
         }
 
+        spin_unlock_irqrestore(&multiheap->lock, *flags);
         paging_map(paging_desc, defragmented_virtual_memory_current_addr, block_addr, PAGING_IS_WRITEABLE | PAGING_IS_PRESENT);
+        *flags = spin_lock_irqsave(&multiheap->lock);
         defragmented_virtual_memory_current_addr += (uint64_t) PEACHOS_HEAP_BLOCK_SIZE; 
     }
 
@@ -453,7 +476,7 @@ int multiheap_ready(struct multiheap* multiheap)
 out:
     return res;
 }
-void* multiheap_alloc(struct multiheap* multiheap, size_t size)
+static void* multiheap_alloc_locked(struct multiheap* multiheap, size_t size)
 {
     void* allocation_ptr = multiheap_alloc_first_pass(multiheap, size);
     if (allocation_ptr)
@@ -465,18 +488,29 @@ void* multiheap_alloc(struct multiheap* multiheap, size_t size)
     return NULL;
 }
 
+void* multiheap_alloc(struct multiheap* multiheap, size_t size)
+{
+    uint64_t flags = spin_lock_irqsave(&multiheap->lock);
+    void* allocation_ptr = multiheap_alloc_locked(multiheap, size);
+    spin_unlock_irqrestore(&multiheap->lock, flags);
+    return allocation_ptr;
+}
+
 void* multiheap_palloc(struct multiheap* multiheap, size_t size)
 {
+    uint64_t flags = spin_lock_irqsave(&multiheap->lock);
     void* allocation_ptr = multiheap_alloc_first_pass(multiheap, size);
     if (allocation_ptr)
     {
-        return allocation_ptr;
+        goto out;
     }
 
     // Possible fragmentation, no pointer able to be found
     // in all heaps.
     // perform second pass..
 
-    allocation_ptr = multiheap_alloc_second_pass(multiheap, size);
+    allocation_ptr = multiheap_alloc_second_pass(multiheap, size, &flags);
+out:
+    spin_unlock_irqrestore(&multiheap->lock, flags);
     return allocation_ptr;
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #define KERNEL_MULTIHEAP_H
 
 #include "heap.h"
+#include "lib/spinlock/spinlock.h"
 enum
 {
     // Set if the heap was created externally and its memory should not
@@ -61,6 +62,9 @@ struct multiheap
     void* max_end_data_addr;
     int flags;
     size_t total_heaps;
+
+    // Guards the heap lists and every heap table, interrupts may allocate
+    struct spinlock lock;
 };
 
 int multiheap_ready(struct multiheap* multiheap);
@@ -0,0 +1,345 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "pci.h"
+#include "kernel.h"
+#include "status.h"
+#include "io/io.h"
+#include "string/string.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+
+static struct pci_device* pci_devices = NULL;
+static int pci_total_devices = 0;
+
+static uint32_t pci_address(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+    return PCI_CONFIG_ENABLE | ((uint32_t) bus << 16) | ((uint32_t) slot << 11) | ((uint32_t) function << 8) | (offset & 0xFC);
+}
+
+static uint32_t pci_read32(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+    outdw(PCI_CONFIG_ADDRESS_PORT, pci_address(bus, slot, function, offset));
+    return insdw(PCI_CONFIG_DATA_PORT);
+}
+
+static void pci_write32(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset, uint32_t value)
+{
+    outdw(PCI_CONFIG_ADDRESS_PORT, pci_address(bus, slot, function, offset));
+    outdw(PCI_CONFIG_DATA_PORT, value);
+}
+
+uint32_t pci_config_read32(struct pci_device* device, uint8_t offset)
+{
+    return pci_read32(device->bus, device->slot, device->function, offset);
+}
+
+uint16_t pci_config_read16(struct pci_device* device, uint8_t offset)
+{
+    return pci_config_read32(device, offset) >> ((offset & 2) * 8);
+}
+
+uint8_t pci_config_read8(struct pci_device* device, uint8_t offset)
+{
+    return pci_config_read32(device, offset) >> ((offset & 3) * 8);
+}
+
+void pci_config_write32(struct pci_device* device, uint8_t offset, uint32_t value)
+{
+    pci_write32(device->bus, device->slot, device->function, offset, value);
+}
+
+void pci_config_write16(struct pci_device* device, uint8_t offset, uint16_t value)
+{
+    // Read, modify, write the dword, the other half must keep its value
+    uint32_t dword = pci_config_read32(device, offset);
+    int shift = (offset & 2) * 8;
+    dword = (dword & ~(0xFFFF << shift)) | ((uint32_t) value << shift);
+    pci_config_write32(device, offset, dword);
+}
+
+void pci_enable(struct pci_device* device, uint16_t command_bits)
+{
+    uint16_t command = pci_config_read16(device, PCI_CONFIG_COMMAND);
+    pci_config_write16(device, PCI_CONFIG_COMMAND, command | command_bits);
+}
+
+uint8_t pci_next_capability(struct pci_device* device, uint8_t id, uint8_t offset)
+{
+    if (!(pci_config_read16(device, PCI_CONFIG_STATUS) & PCI_STATUS_CAPABILITIES))
+    {
+        return 0;
+    }
+
+    // The list lives above the header, the bound stops a looping list
+    if (offset)
+    {
+        offset = pci_config_read8(device, offset + PCI_CAPABILITY_NEXT) & ~0x03;
+    }
+    else
+    {
+        offset = pci_config_read8(device, PCI_CONFIG_CAPABILITIES) & ~0x03;
+    }
+
+    for (int i = 0; offset && i < 48; i++)
+    {
+        if (pci_config_read8(device, offset + PCI_CAPABILITY_ID) == id)
+        {
+            return offset;
+        }
+
+        offset = pci_config_read8(device, offset + PCI_CAPABILITY_NEXT) & ~0x03;
+    }
+
+    return 0;
+}
+
+uint8_t pci_find_capability(struct pci_device* device, uint8_t id)
+{
+    return pci_next_capability(device, id, 0);
+}
+
+uintptr_t pci_map_bar(struct pci_device* device, int bar, uint64_t offset, uint64_t size)
+{
+    if (bar < 0 || bar >= PCI_TOTAL_BARS || device->bar_is_io[bar] || !device->bars[bar])
+    {
+        return 0;
+    }
+
+    uintptr_t address = device->bars[bar] + offset;
+    uintptr_t start = address & ~((uintptr_t) PAGING_PAGE_SIZE - 1);
+    size_t pages = (address + size - start + PAGING_PAGE_SIZE - 1) / PAGING_PAGE_SIZE;
+
+    // Device memory, must never be cached
+    paging_map_range(kernel_desc(), (void*) start, (void*) start, pages, PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_CACHE_DISABLED);
+    return address;
+}
+
+int pci_enable_msi(struct pci_device* device, uint8_t apic_id, uint8_t vector)
+{
+    uint8_t msi = pci_find_capability(device, PCI_CAPABILITY_MSI);
+    if (!msi)
+    {
+        return -ENOTFOUND;
+    }
+
+    uint16_t control = pci_config_read16(device, msi + PCI_MSI_CONTROL);
+    pci_config_write32(device, msi + PCI_MSI_ADDRESS_LOW, PCI_MSI_ADDRESS_BASE | ((uint32_t) apic_id << PCI_MSI_ADDRESS_DESTINATION_SHIFT));
+    if (control & PCI_MSI_CONTROL_64BIT)
+    {
+        pci_config_write32(device, msi + PCI_MSI_ADDRESS_HIGH, 0);
+        pci_config_write16(device, msi + PCI_MSI_DATA_64, vector);
+    }
+    else
+    {
+        pci_config_write16(device, msi + PCI_MSI_DATA_32, vector);
+    }
+
+    // One message only, then stop the pin so the interrupt is not seen twice
+    control &= ~PCI_MSI_CONTROL_MULTIPLE_ENABLE;
+    pci_config_write16(device, msi + PCI_MSI_CONTROL, control | PCI_MSI_CONTROL_ENABLE);
+    pci_enable(device, PCI_COMMAND_INTERRUPT_DISABLE);
+    return 0;
+}
+
+/**
+ * Maps the MSI-X table of the function
+ * \return Returns the address of the entry or zero when the function has no MSI-X or no such entry
+ */
+static uintptr_t pci_msix_entry(struct pci_device* device, uint8_t msix, int entry)
+{
+    uint16_t control = pci_config_read16(device, msix + PCI_MSIX_CONTROL);
+    int total_entries = (control & PCI_MSIX_CONTROL_TABLE_SIZE_MASK) + 1;
+    if (entry < 0 || entry >= total_entries)
+    {
+        return 0;
+    }
+
+    uint32_t table = pci_config_read32(device, msix + PCI_MSIX_TABLE);
+    uintptr_t base = pci_map_bar(device, table & PCI_MSIX_TABLE_BIR_MASK, table & ~PCI_MSIX_TABLE_BIR_MASK, total_entries * PCI_MSIX_ENTRY_SIZE);
+    if (!base)
+    {
+        return 0;
+    }
+
+    return base + entry * PCI_MSIX_ENTRY_SIZE;
+}
+
+int pci_enable_msix(struct pci_device* device, int entry, uint8_t apic_id, uint8_t vector)
+{
+    uint8_t msix = pci_find_capability(device, PCI_CAPABILITY_MSIX);
+    if (!msix)
+    {
+        return -ENOTFOUND;
+    }
+
+    uintptr_t address = pci_msix_entry(device, msix, entry);
+    if (!address)
+    {
+        return -ENOTFOUND;
+    }
+
+    // Entries come out of reset masked, only ours is unmasked
+    volatile uint32_t* message = (volatile uint32_t*) address;
+    message[PCI_MSIX_ENTRY_ADDRESS_LOW / sizeof(uint32_t)] = PCI_MSI_ADDRESS_BASE | ((uint32_t) apic_id << PCI_MSI_ADDRESS_DESTINATION_SHIFT);
+    message[PCI_MSIX_ENTRY_ADDRESS_HIGH / sizeof(uint32_t)] = 0;
+    message[PCI_MSIX_ENTRY_DATA / sizeof(uint32_t)] = vector;
+    message[PCI_MSIX_ENTRY_CONTROL / sizeof(uint32_t)] &= ~PCI_MSIX_ENTRY_MASKED;
+
+    uint16_t control = pci_config_read16(device, msix + PCI_MSIX_CONTROL);
+    control &= ~PCI_MSIX_CONTROL_FUNCTION_MASK;
+    pci_config_write16(device, msix + PCI_MSIX_CONTROL, control | PCI_MSIX_CONTROL_ENABLE);
+    pci_enable(device, PCI_COMMAND_INTERRUPT_DISABLE);
+    return 0;
+}
+
+void pci_disable_msix(struct pci_device* device, int entry)
+{
+    uint8_t msix = pci_find_capability(device, PCI_CAPABILITY_MSIX);
+    if (!msix)
+    {
+        return;
+    }
+
+    uintptr_t address = pci_msix_entry(device, msix, entry);
+    if (!address)
+    {
+        return;
+    }
+
+    // The other entries may still be in use, MSI-X stays enabled for them
+    volatile uint32_t* message = (volatile uint32_t*) address;
+    message[PCI_MSIX_ENTRY_CONTROL / sizeof(uint32_t)] |= PCI_MSIX_ENTRY_MASKED;
+}
+
+struct pci_device* pci_find_device(uint16_t vendor_id, uint16_t device_id, int index)
+{
+    for (struct pci_device* device = pci_devices; device; device = device->next)
+    {
+        if (device->vendor_id == vendor_id && device->device_id == device_id && index-- == 0)
+        {
+            return device;
+        }
+    }
+
+    return NULL;
+}
+
+static void pci_read_bars(struct pci_device* device)
+{
+    for (int i = 0; i < PCI_TOTAL_BARS; i++)
+    {
+        uint32_t bar = pci_config_read32(device, PCI_CONFIG_BAR0 + i * 4);
+        if (bar & PCI_BAR_IO)
+        {
+            device->bars[i] = bar & ~0x03;
+            device->bar_is_io[i] = true;
+            continue;
+        }
+
+        device->bars[i] = bar & ~0x0F;
+        if ((bar & PCI_BAR_TYPE_MASK) == PCI_BAR_TYPE_64 && i + 1 < PCI_TOTAL_BARS)
+        {
+            // The next BAR holds the upper half
+            i++;
+            device->bars[i - 1] |= (uint64_t) pci_config_read32(device, PCI_CONFIG_BAR0 + i * 4) << 32;
+        }
+    }
+}
+
+static void pci_add_function(uint8_t bus, uint8_t slot, uint8_t function)
+{
+    struct pci_device* device = kzalloc(sizeof(struct pci_device));
+    if (!device)
+    {
+        return;
+    }
+
+    device->bus = bus;
+    device->slot = slot;
+    device->function = function;
+    device->vendor_id = pci_config_read16(device, PCI_CONFIG_VENDOR_ID);
+    device->device_id = pci_config_read16(device, PCI_CONFIG_DEVICE_ID);
+    device->class_code = pci_config_read8(device, PCI_CONFIG_CLASS);
+    device->subclass = pci_config_read8(device, PCI_CONFIG_SUBCLASS);
+    device->prog_if = pci_config_read8(device, PCI_CONFIG_PROG_IF);
+    device->interrupt_line = pci_config_read8(device, PCI_CONFIG_INTERRUPT_LINE);
+    pci_read_bars(device);
+
+    // Kept in scan order
+    struct pci_device** link = &pci_devices;
+    while (*link)
+    {
+        link = &(*link)->next;
+    }
+    *link = device;
+    pci_total_devices++;
+}
+
+void pci_init()
+{
+    // Brute force, bridges need not be followed as every bus number is tried
+    for (int bus = 0; bus < PCI_MAX_BUSES; bus++)
+    {
+        for (int slot = 0; slot < PCI_MAX_SLOTS; slot++)
+        {
+            if ((pci_read32(bus, slot, 0, PCI_CONFIG_VENDOR_ID) & 0xFFFF) == PCI_VENDOR_NONE)
+            {
+                continue;
+            }
+
+            uint8_t header_type = pci_read32(bus, slot, 0, PCI_CONFIG_HEADER_TYPE & ~3) >> 16;
+            int functions = (header_type & PCI_HEADER_TYPE_MULTI_FUNCTION) ? PCI_MAX_FUNCTIONS : 1;
+            for (int function = 0; function < functions; function++)
+            {
+                if ((pci_read32(bus, slot, function, PCI_CONFIG_VENDOR_ID) & 0xFFFF) == PCI_VENDOR_NONE)
+                {
+                    continue;
+                }
+
+                pci_add_function(bus, slot, function);
+            }
+        }
+    }
+
+    print("PCI functions: ");
+    print(itoa(pci_total_devices));
+    print("\n");
+}
+
+struct pci_device* pci_find_class(uint8_t class_code, uint8_t subclass, int index)
+{
+    for (struct pci_device* device = pci_devices; device; device = device->next)
+    {
+        if (device->class_code == class_code && device->subclass == subclass && index-- == 0)
+        {
+            return device;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,198 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_PCI_H
+#define KERNEL_PCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Configuration mechanism one, an address is written then the dword read or written through the data port
+#define PCI_CONFIG_ADDRESS_PORT 0xCF8
+#define PCI_CONFIG_DATA_PORT 0xCFC
+#define PCI_CONFIG_ENABLE 0x80000000
+
+// Configuration space offsets
+#define PCI_CONFIG_VENDOR_ID 0x00
+#define PCI_CONFIG_DEVICE_ID 0x02
+#define PCI_CONFIG_COMMAND 0x04
+#define PCI_CONFIG_STATUS 0x06
+#define PCI_CONFIG_PROG_IF 0x09
+#define PCI_CONFIG_SUBCLASS 0x0A
+#define PCI_CONFIG_CLASS 0x0B
+#define PCI_CONFIG_HEADER_TYPE 0x0E
+#define PCI_CONFIG_BAR0 0x10
+#define PCI_CONFIG_CAPABILITIES 0x34
+#define PCI_CONFIG_INTERRUPT_LINE 0x3C
+#define PCI_CONFIG_INTERRUPT_PIN 0x3D
+
+// Capability list entries, the id then the offset of the next entry
+#define PCI_CAPABILITY_ID 0x00
+#define PCI_CAPABILITY_NEXT 0x01
+#define PCI_CAPABILITY_MSI 0x05
+#define PCI_CAPABILITY_VENDOR 0x09
+#define PCI_CAPABILITY_MSIX 0x11
+
+// Message signalled interrupt capability, the data register moves up when the address is 64 bit
+#define PCI_MSI_CONTROL 0x02
+#define PCI_MSI_ADDRESS_LOW 0x04
+#define PCI_MSI_ADDRESS_HIGH 0x08
+#define PCI_MSI_DATA_32 0x08
+#define PCI_MSI_DATA_64 0x0C
+#define PCI_MSI_CONTROL_ENABLE 0x0001
+#define PCI_MSI_CONTROL_MULTIPLE_ENABLE 0x0070
+#define PCI_MSI_CONTROL_64BIT 0x0080
+
+// MSI-X capability, the table of messages lives in one of the BARs
+#define PCI_MSIX_CONTROL 0x02
+#define PCI_MSIX_TABLE 0x04
+#define PCI_MSIX_CONTROL_TABLE_SIZE_MASK 0x07FF
+#define PCI_MSIX_CONTROL_FUNCTION_MASK 0x4000
+#define PCI_MSIX_CONTROL_ENABLE 0x8000
+#define PCI_MSIX_TABLE_BIR_MASK 0x07
+#define PCI_MSIX_ENTRY_SIZE 16
+#define PCI_MSIX_ENTRY_ADDRESS_LOW 0x00
+#define PCI_MSIX_ENTRY_ADDRESS_HIGH 0x04
+#define PCI_MSIX_ENTRY_DATA 0x08
+#define PCI_MSIX_ENTRY_CONTROL 0x0C
+#define PCI_MSIX_ENTRY_MASKED 0x01
+
+// Messages are writes to the local APIC window of the destination processor, fixed delivery, edge
+#define PCI_MSI_ADDRESS_BASE 0xFEE00000
+#define PCI_MSI_ADDRESS_DESTINATION_SHIFT 12
+
+#define PCI_COMMAND_IO_SPACE 0x0001
+#define PCI_COMMAND_MEMORY_SPACE 0x0002
+#define PCI_COMMAND_BUS_MASTER 0x0004
+#define PCI_COMMAND_INTERRUPT_DISABLE 0x0400
+
+#define PCI_STATUS_CAPABILITIES 0x0010
+#define PCI_HEADER_TYPE_MULTI_FUNCTION 0x80
+#define PCI_VENDOR_NONE 0xFFFF
+
+#define PCI_BAR_IO 0x01
+#define PCI_BAR_TYPE_MASK 0x06
+#define PCI_BAR_TYPE_64 0x04
+
+#define PCI_MAX_BUSES 256
+#define PCI_MAX_SLOTS 32
+#define PCI_MAX_FUNCTIONS 8
+#define PCI_TOTAL_BARS 6
+
+// Mass storage controllers
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_STORAGE_IDE 0x01
+#define PCI_SUBCLASS_STORAGE_SATA 0x06
+#define PCI_SUBCLASS_STORAGE_NVM 0x08
+
+struct pci_device
+{
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t function;
+
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;
+
+    // The legacy interrupt line the firmware routed the device to
+    uint8_t interrupt_line;
+
+    // Decoded base addresses, I/O ports or physical memory
+    uint64_t bars[PCI_TOTAL_BARS];
+    bool bar_is_io[PCI_TOTAL_BARS];
+
+    struct pci_device* next;
+};
+
+/**
+ * Scans every bus for functions and records them
+ */
+void pci_init();
+
+/**
+ * Returns the index-th function of the given class and subclass or NULL
+ */
+struct pci_device* pci_find_class(uint8_t class_code, uint8_t subclass, int index);
+
+uint32_t pci_config_read32(struct pci_device* device, uint8_t offset);
+uint16_t pci_config_read16(struct pci_device* device, uint8_t offset);
+uint8_t pci_config_read8(struct pci_device* device, uint8_t offset);
+void pci_config_write32(struct pci_device* device, uint8_t offset, uint32_t value);
+void pci_config_write16(struct pci_device* device, uint8_t offset, uint16_t value);
+
+/**
+ * Sets bits in the command register, such as PCI_COMMAND_BUS_MASTER
+ */
+void pci_enable(struct pci_device* device, uint16_t command_bits);
+
+/**
+ * Returns the index-th function with the given vendor and device id or NULL
+ */
+struct pci_device* pci_find_device(uint16_t vendor_id, uint16_t device_id, int index);
+
+/**
+ * Walks the capability list of the function
+ * \return Returns the configuration space offset of the capability or zero when it has none
+ */
+uint8_t pci_find_capability(struct pci_device* device, uint8_t id);
+
+/**
+ * Finds the next capability with the id after the one at offset, a function
+ * may carry several vendor capabilities
+ * \return Returns the configuration space offset of the capability or zero when there are no more
+ */
+uint8_t pci_next_capability(struct pci_device* device, uint8_t id, uint8_t offset);
+
+/**
+ * Maps memory of a BAR into the kernel, uncached
+ * \return Returns the address of the memory or zero when the BAR is not memory
+ */
+uintptr_t pci_map_bar(struct pci_device* device, int bar, uint64_t offset, uint64_t size);
+
+/**
+ * Has the function raise the vector on the processor with the given APIC id
+ * with a single message, its legacy interrupt pin goes quiet.
+ * \return Returns -ENOTFOUND when the function cannot signal messages
+ */
+int pci_enable_msi(struct pci_device* device, uint8_t apic_id, uint8_t vector);
+
+/**
+ * Has MSI-X table entry raise the vector on the processor with the given
+ * APIC id, the other entries stay masked
+ * \return Returns -ENOTFOUND when the function has no MSI-X or no such entry
+ */
+int pci_enable_msix(struct pci_device* device, int entry, uint8_t apic_id, uint8_t vector);
+
+/**
+ * Masks MSI-X table entry again, the function no longer sends its message
+ */
+void pci_disable_msix(struct pci_device* device, int entry);
+
+#endif
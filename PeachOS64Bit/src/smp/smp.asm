@@ -0,0 +1,152 @@
+; PeachOS 64-Bit Kernel Project
+; Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+;
+; This file is part of the PeachOS 64-Bit Kernel.
+;
+; This program is free software; you can redistribute it and/or
+; modify it under the terms of the GNU General Public License
+; version 2 as published by the Free Software Foundation.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+; See the GNU General Public License version 2 for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program; if not, see <https://www.gnu.org/licenses/>.
+;
+; For full source code, documentation, and structured learning,
+; see the official kernel development course part one:
+; https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+;
+; Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+;
+; Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+;
+
+[BITS 64]
+section .asm
+
+global smp_cpu_current
+global smp_load_gdt
+global smp_trampoline_start
+global smp_trampoline_end
+global smp_trampoline_data
+
+; The trampoline is copied to this address before the startup IPI, keep in sync with SMP_TRAMPOLINE_ADDRESS
+SMP_TRAMPOLINE_ADDRESS equ 0x8000
+
+; Address of a trampoline label once the trampoline is copied into place
+%define TRAMPOLINE(label) (SMP_TRAMPOLINE_ADDRESS + (label - smp_trampoline_start))
+
+; Selectors of the trampoline GDT
+TRAMPOLINE_CODE32_SEG equ 0x08
+TRAMPOLINE_DATA32_SEG equ 0x10
+TRAMPOLINE_CODE64_SEG equ 0x18
+TRAMPOLINE_DATA64_SEG equ 0x20
+
+; struct cpu* smp_cpu_current()
+smp_cpu_current:
+    mov rax, [gs:0]     ; cpu->self
+    ret
+
+; void smp_load_gdt(struct gdtr_desc* gdtr)
+; Loads a GDT with the same layout as the boot GDT and reloads the segments from it
+smp_load_gdt:
+    lgdt [rdi]
+    mov ax, 0x20        ; Kernel data segment
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    ; Reload CS with a far return
+    pop rax             ; Our return address
+    push qword 0x18     ; Kernel code segment
+    push rax
+    retfq
+
+; The application processors start here in real mode, CS:IP = 0x0800:0000
+[BITS 16]
+smp_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    lgdt [TRAMPOLINE(smp_trampoline_gdt_descriptor)]
+    mov eax, cr0
+    or eax, 0x01        ; Protection enable
+    mov cr0, eax
+    jmp dword TRAMPOLINE_CODE32_SEG:TRAMPOLINE(smp_trampoline_32)
+
+[BITS 32]
+smp_trampoline_32:
+    mov ax, TRAMPOLINE_DATA32_SEG
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    mov eax, cr4
+    or eax, 1 << 5      ; PAE
+    mov cr4, eax
+
+    ; The boot page tables live below 4GB and identity map the kernel
+    mov eax, [TRAMPOLINE(smp_trampoline_data)]
+    mov cr3, eax
+
+    mov ecx, 0xC0000080 ; EFER
+    rdmsr
+    or eax, 1 << 8      ; Long mode enable
+    wrmsr
+
+    mov eax, cr0
+    or eax, 1 << 31     ; Paging, activates long mode
+    mov cr0, eax
+    jmp TRAMPOLINE_CODE64_SEG:TRAMPOLINE(smp_trampoline_64)
+
+[BITS 64]
+smp_trampoline_64:
+    mov ax, TRAMPOLINE_DATA64_SEG
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Now switch to the kernel page tables which may live anywhere
+    mov rax, [TRAMPOLINE(smp_trampoline_data) + 8]
+    mov cr3, rax
+
+    mov rsp, [TRAMPOLINE(smp_trampoline_data) + 16]
+    mov rbp, rsp
+    mov rdi, [TRAMPOLINE(smp_trampoline_data) + 24]
+    mov rax, [TRAMPOLINE(smp_trampoline_data) + 32]
+    call rax
+
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+align 8
+smp_trampoline_gdt:
+    dq 0x0000000000000000   ; Null
+    dq 0x00CF9A000000FFFF   ; 32-bit code
+    dq 0x00CF92000000FFFF   ; 32-bit data
+    dq 0x00AF9A000000FFFF   ; 64-bit code
+    dq 0x00CF92000000FFFF   ; 64-bit data
+smp_trampoline_gdt_end:
+
+smp_trampoline_gdt_descriptor:
+    dw smp_trampoline_gdt_end - smp_trampoline_gdt - 1
+    dd TRAMPOLINE(smp_trampoline_gdt)
+
+; struct smp_trampoline_data, filled in by smp_start_cpu() before each startup
+align 8
+smp_trampoline_data:
+    dq 0    ; Boot page tables, must be below 4GB
+    dq 0    ; Kernel page tables
+    dq 0    ; Stack
+    dq 0    ; struct cpu*
+    dq 0    ; Entry point, void entry(struct cpu*)
+smp_trampoline_end:
@@ -0,0 +1,372 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "smp.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "acpi/acpi.h"
+#include "apic/lapic.h"
+#include "cpu/cpu.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "lib/spinlock/spinlock.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "string/string.h"
+#include "task/task.h"
+#include "task/fpu.h"
+#include "timer/timer.h"
+
+/**
+ * Layout of the data block at the end of the trampoline, see smp.asm
+ */
+struct smp_trampoline_data
+{
+    uint64_t boot_cr3;
+    uint64_t cr3;
+    uint64_t stack;
+    uint64_t cpu;
+    uint64_t entry;
+} __attribute__((packed));
+
+// Defined in smp.asm
+extern uint8_t smp_trampoline_start[];
+extern uint8_t smp_trampoline_end[];
+extern uint8_t smp_trampoline_data[];
+
+// Defined in kernel.asm
+extern struct gdt_entry gdt[];
+extern struct gdtr_desc gdt_descriptor;
+extern uint64_t PML4_Table[];
+
+static struct cpu* cpus[PEACHOS_MAX_CPUS];
+static int total_cpus = 0;
+
+static struct spinlock kernel_lock;
+static volatile int kernel_lock_owner = -1;
+static int kernel_lock_depth = 0;
+
+struct cpu* smp_cpu(int index)
+{
+    if (index < 0 || index >= total_cpus)
+    {
+        return NULL;
+    }
+
+    return cpus[index];
+}
+
+int smp_total_cpus()
+{
+    return total_cpus;
+}
+
+bool smp_cpu_is_bsp(struct cpu* cpu)
+{
+    return cpu->id == 0;
+}
+
+void smp_lock_kernel()
+{
+    struct cpu* cpu = smp_cpu_current();
+    if (kernel_lock_owner == cpu->id)
+    {
+        kernel_lock_depth++;
+        return;
+    }
+
+    spin_lock(&kernel_lock);
+    kernel_lock_owner = cpu->id;
+    kernel_lock_depth = 1;
+}
+
+void smp_unlock_kernel()
+{
+    if (kernel_lock_owner != smp_cpu_current()->id)
+    {
+        return;
+    }
+
+    kernel_lock_depth--;
+    if (kernel_lock_depth == 0)
+    {
+        kernel_lock_owner = -1;
+        spin_unlock(&kernel_lock);
+    }
+}
+
+void smp_unlock_kernel_all()
+{
+    if (kernel_lock_owner != smp_cpu_current()->id)
+    {
+        return;
+    }
+
+    kernel_lock_depth = 0;
+    kernel_lock_owner = -1;
+    spin_unlock(&kernel_lock);
+}
+
+int smp_kernel_lock_depth()
+{
+    if (kernel_lock_owner != smp_cpu_current()->id)
+    {
+        return 0;
+    }
+
+    return kernel_lock_depth;
+}
+
+void smp_kernel_lock_set_depth(int depth)
+{
+    if (kernel_lock_owner != smp_cpu_current()->id || depth <= 0)
+    {
+        panic("smp_kernel_lock_set_depth(): The kernel lock is not held\n");
+    }
+
+    kernel_lock_depth = depth;
+}
+
+void smp_send_reschedule(struct cpu* cpu)
+{
+    if (cpu == smp_cpu_current())
+    {
+        cpu->reschedule_requested = true;
+        return;
+    }
+
+    lapic_send_ipi(cpu->apic_id, LAPIC_RESCHEDULE_VECTOR);
+}
+
+static void smp_reschedule_interrupt_handler(struct interrupt_frame* frame)
+{
+    task_request_reschedule();
+}
+
+static struct cpu* smp_cpu_new(uint8_t apic_id)
+{
+    if (total_cpus >= PEACHOS_MAX_CPUS)
+    {
+        return NULL;
+    }
+
+    struct cpu* cpu = kzalloc(sizeof(struct cpu));
+    if (!cpu)
+    {
+        return NULL;
+    }
+
+    void* stack = kzalloc(PEACHOS_KERNEL_STACK_SIZE);
+    if (!stack)
+    {
+        kfree(cpu);
+        return NULL;
+    }
+
+    // Block the lowest page so an overflow faults rather than corrupting the heap
+    paging_map(kernel_desc(), stack, stack, 0);
+
+    cpu->self = cpu;
+    cpu->id = total_cpus;
+    cpu->apic_id = apic_id;
+    cpu->kernel_stack = stack + PEACHOS_KERNEL_STACK_SIZE;
+    sched_runqueue_init(&cpu->runqueue);
+    cpus[total_cpus] = cpu;
+    total_cpus++;
+    return cpu;
+}
+
+/**
+ * Loads the descriptor tables of the processor and points GS at its structure
+ */
+static void smp_cpu_load(struct cpu* cpu)
+{
+    size_t gdt_size = gdt_descriptor.limit + 1;
+    if (gdt_size > sizeof(cpu->gdt))
+    {
+        panic("smp_cpu_load(): The kernel GDT is too large\n");
+    }
+
+    // Every processor needs its own TSS descriptor, a loaded TSS is marked busy
+    memcpy(cpu->gdt, gdt, gdt_size);
+    cpu->gdtr.limit = gdt_descriptor.limit;
+    cpu->gdtr.base = (uint64_t) cpu->gdt;
+    smp_load_gdt(&cpu->gdtr);
+
+    memset(&cpu->tss, 0x00, sizeof(cpu->tss));
+    cpu->tss.rsp0 = (uint64_t) cpu->kernel_stack;
+    cpu->tss.iopb_offset = sizeof(cpu->tss); // No I/O permissions are used
+
+    struct tss_desc_64* tssdesc = (struct tss_desc_64*)&cpu->gdt[KERNEL_LONG_MODE_TSS_GDT_INDEX];
+    gdt_set_tss(tssdesc, &cpu->tss, sizeof(cpu->tss)-1, TSS_DESCRIPTOR_TYPE, 0x00);
+    tss_load(KERNEL_LONG_MODE_TSS_SELECTOR);
+
+    // Kernel code runs with GS pointing at the processor, user land gets zero through swapgs
+    cpu_write_msr(CPU_MSR_GS_BASE, (uint64_t) cpu);
+    cpu_write_msr(CPU_MSR_KERNEL_GS_BASE, 0);
+}
+
+void smp_bsp_init()
+{
+    spinlock_init(&kernel_lock, "kernel");
+    struct cpu* cpu = smp_cpu_new(0);
+    if (!cpu)
+    {
+        panic("Failed to allocate the bootstrap processor\n");
+    }
+
+    smp_cpu_load(cpu);
+    cpu->started = true;
+    cpu->online = true;
+}
+
+/**
+ * First C code of an application processor, entered from the trampoline
+ * on its own kernel stack. Never returns.
+ */
+static void smp_ap_main(struct cpu* cpu)
+{
+    paging_switch(kernel_desc());
+    smp_cpu_load(cpu);
+    idt_cpu_init();
+    fpu_cpu_init();
+    lapic_cpu_init();
+    cpu->started = true;
+
+    // The bootstrap processor holds the lock until it drops to user land
+    smp_lock_kernel();
+    task_idle_init();
+    cpu->tick_stopped = true;
+    cpu->online = true;
+
+    // Pick up whatever was placed here while we were starting
+    task_run_first_ever_task();
+}
+
+static int smp_start_cpu(uint8_t apic_id)
+{
+    int res = 0;
+    struct cpu* cpu = smp_cpu_new(apic_id);
+    if (!cpu)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    struct smp_trampoline_data* data = (struct smp_trampoline_data*)(SMP_TRAMPOLINE_ADDRESS + (smp_trampoline_data - smp_trampoline_start));
+    data->boot_cr3 = (uint64_t) PML4_Table;
+    data->cr3 = (uint64_t) &kernel_desc()->pml->entries[0];
+    data->stack = (uint64_t) cpu->kernel_stack;
+    data->cpu = (uint64_t) cpu;
+    data->entry = (uint64_t) smp_ap_main;
+
+    // INIT, then up to two startup IPIs as the MP specification asks for
+    lapic_send_init(apic_id);
+    timer_pit_delay_us(10000);
+    for (int attempt = 0; attempt < 2 && !cpu->started; attempt++)
+    {
+        lapic_send_startup(apic_id, SMP_TRAMPOLINE_ADDRESS / PAGING_PAGE_SIZE);
+        timer_pit_delay_us(200);
+    }
+
+    for (int ms = 0; ms < SMP_AP_STARTUP_TIMEOUT_MS && !cpu->started; ms++)
+    {
+        timer_pit_delay_us(1000);
+    }
+
+    if (!cpu->started)
+    {
+        // Never came up, it was the last one allocated so forget it
+        total_cpus--;
+        cpus[total_cpus] = NULL;
+        res = -EIO;
+        goto out;
+    }
+
+out:
+    return res;
+}
+
+int smp_init()
+{
+    int res = 0;
+
+    // Kernel code is not reentrant, the first processor to leave the kernel unlocks
+    smp_lock_kernel();
+    idt_register_interrupt_callback(LAPIC_RESCHEDULE_VECTOR, smp_reschedule_interrupt_handler);
+
+    struct acpi_madt_info madt;
+    res = acpi_init();
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    res = acpi_madt_parse(&madt);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    lapic_init(madt.local_apic_address);
+    smp_cpu_current()->apic_id = lapic_id();
+    lapic_timer_calibrate();
+
+    // Device interrupts move from the 8259 to the I/O APIC, still delivered to us
+    if (IRQ_apic_init(&madt) < 0)
+    {
+        print("No I/O APIC, device interrupts stay on the PIC\n");
+    }
+
+    memcpy((void*) SMP_TRAMPOLINE_ADDRESS, smp_trampoline_start, smp_trampoline_end - smp_trampoline_start);
+    for (int i = 0; i < madt.total_cpus; i++)
+    {
+        uint8_t apic_id = madt.cpu_apic_ids[i];
+        if (apic_id == smp_cpu_current()->apic_id)
+        {
+            continue;
+        }
+
+        if (smp_start_cpu(apic_id) < 0)
+        {
+            print("A processor failed to start\n");
+        }
+    }
+
+out:
+    if (res < 0)
+    {
+        print("No ACPI MADT, running on the bootstrap processor only\n");
+    }
+
+    print("Processors started: ");
+    print(itoa(total_cpus));
+    print("\n");
+    return res;
+}
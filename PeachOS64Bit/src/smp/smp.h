@@ -0,0 +1,158 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_SMP_H
+#define KERNEL_SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "gdt/gdt.h"
+#include "task/tss.h"
+#include "task/sched.h"
+#include "idt/softirq.h"
+
+// The application processors start executing in real mode at this page
+#define SMP_TRAMPOLINE_ADDRESS 0x8000
+
+// Room for the GDT of the kernel, each processor needs its own copy for its TSS
+#define SMP_GDT_MAX_ENTRIES 16
+
+// How long to wait for an application processor to report in after the startup IPIs
+#define SMP_AP_STARTUP_TIMEOUT_MS 100
+
+struct task;
+
+struct gdtr_desc
+{
+    uint16_t limit;
+    uint64_t base;
+} __attribute__((packed));
+
+/**
+ * Everything that is private to a single processor. The GS base of each
+ * processor points at its own structure while in the kernel.
+ */
+struct cpu
+{
+    // Must stay first, smp_cpu_current() reads it through gs:0
+    struct cpu* self;
+
+    // Index into the processor table, the bootstrap processor is zero
+    int id;
+
+    uint8_t apic_id;
+
+    // Set by the processor once it runs C code
+    volatile bool started;
+
+    // Set once the processor has its idle task and can be given work
+    volatile bool online;
+
+    // The task this processor is running
+    struct task* current_task;
+
+    // The task we just switched away from, its kernel stack may only be freed once we are off it
+    struct task* previous_task;
+
+    // Runs when nothing on this processor is runnable
+    struct task* idle_task;
+
+    // Set once the processor left its boot stack for its first task
+    bool tasks_started;
+
+    // Set when the current task should give up the processor at the end of the interrupt
+    bool reschedule_requested;
+
+    // The tasks that run on this processor
+    struct runqueue runqueue;
+
+    // The task whose state is loaded in the FPU/SSE registers of this processor
+    struct task* fpu_owner;
+
+    // True while the scheduler tick of this processor is stopped for idle
+    bool tick_stopped;
+
+    // Bottom halves raised by interrupts taken on this processor
+    struct softirq_ring softirq;
+
+    // Top of the stack the processor boots on
+    void* kernel_stack;
+
+    struct tss tss;
+    struct gdt_entry gdt[SMP_GDT_MAX_ENTRIES];
+    struct gdtr_desc gdtr;
+};
+
+/**
+ * Sets up the processor structure, GDT, TSS and GS base of the bootstrap processor
+ */
+void smp_bsp_init();
+
+/**
+ * Finds the other processors through the ACPI MADT and starts them.
+ * Takes the big kernel lock, it is released when the bootstrap processor
+ * drops to user land for the first time.
+ */
+int smp_init();
+
+/**
+ * Returns the processor the caller is running on
+ */
+struct cpu* smp_cpu_current();
+struct cpu* smp_cpu(int index);
+int smp_total_cpus();
+bool smp_cpu_is_bsp(struct cpu* cpu);
+
+/**
+ * Asks the processor to run its scheduler, sends an IPI when it is not the caller
+ */
+void smp_send_reschedule(struct cpu* cpu);
+
+/**
+ * The big kernel lock, only one processor runs kernel code at a time.
+ * It is recursive so nested kernel entries on the same processor are safe.
+ */
+void smp_lock_kernel();
+void smp_unlock_kernel();
+
+/**
+ * Drops the big kernel lock completely, called on the way back to a task
+ */
+void smp_unlock_kernel_all();
+
+/**
+ * How many times the calling processor has taken the big kernel lock.
+ * A task switch hands the lock to the next task, each task puts back
+ * its own depth when it runs again.
+ */
+int smp_kernel_lock_depth();
+void smp_kernel_lock_set_depth(int depth);
+
+void smp_load_gdt(struct gdtr_desc* gdtr);
+
+#endif
@@ -40,5 +40,6 @@
 #define EINFORMAT 9
 #define EOUTOFRANGE 10
 #define ENOTFOUND 11
+#define EAGAIN 12
 
 #endif
\ No newline at end of file
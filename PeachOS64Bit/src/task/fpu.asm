@@ -0,0 +1,74 @@
+; PeachOS 64-Bit Kernel Project
+; Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+;
+; This file is part of the PeachOS 64-Bit Kernel.
+;
+; This program is free software; you can redistribute it and/or
+; modify it under the terms of the GNU General Public License
+; version 2 as published by the Free Software Foundation.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+; See the GNU General Public License version 2 for more details.
+;
+; You should have received a copy of the GNU General Public License
+; along with this program; if not, see <https://www.gnu.org/licenses/>.
+;
+; For full source code, documentation, and structured learning,
+; see the official kernel development course part one:
+; https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+;
+; Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+;
+; Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+;
+
+[BITS 64]
+section .asm
+
+global fpu_clts
+global fpu_fxsave
+global fpu_fxrstor
+global fpu_xsave
+global fpu_xrstor
+global fpu_reset
+
+; void fpu_clts()
+fpu_clts:
+    clts        ; Clear CR0.TS so FPU/SSE instructions no longer trap
+    ret
+
+; void fpu_fxsave(void* area)
+fpu_fxsave:
+    fxsave64 [rdi]
+    ret
+
+; void fpu_fxrstor(void* area)
+fpu_fxrstor:
+    fxrstor64 [rdi]
+    ret
+
+; void fpu_xsave(void* area, uint64_t mask)
+fpu_xsave:
+    mov rax, rsi    ; Requested feature bitmap low 32 bits
+    mov rdx, rsi
+    shr rdx, 32     ; Requested feature bitmap high 32 bits
+    xsave64 [rdi]
+    ret
+
+; void fpu_xrstor(void* area, uint64_t mask)
+fpu_xrstor:
+    mov rax, rsi
+    mov rdx, rsi
+    shr rdx, 32
+    xrstor64 [rdi]
+    ret
+
+; void fpu_reset()
+fpu_reset:
+    fninit
+    push qword 0x1F80   ; Default MXCSR, all SIMD exceptions masked
+    ldmxcsr [rsp]
+    add rsp, 8
+    ret
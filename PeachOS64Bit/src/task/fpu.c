@@ -0,0 +1,259 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "fpu.h"
+#include "task.h"
+#include "kernel.h"
+#include "cpu/cpu.h"
+#include "idt/idt.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "smp/smp.h"
+
+// True when the CPU supports XSAVE and we have enabled it
+static bool fpu_xsave_enabled = false;
+
+// The state components we ask XSAVE/XRSTOR to manage (XCR0)
+static uint64_t fpu_xsave_mask = 0;
+
+// Size of a single save area, either the FXSAVE area or the XSAVE size reported by CPUID
+static size_t fpu_area_size = FPU_FXSAVE_AREA_SIZE;
+
+// A clean FPU state that new tasks start with
+static void* fpu_initial_state = NULL;
+
+static void fpu_save(void* area)
+{
+    if (fpu_xsave_enabled)
+    {
+        fpu_xsave(area, fpu_xsave_mask);
+        return;
+    }
+
+    fpu_fxsave(area);
+}
+
+static void fpu_restore(void* area)
+{
+    if (fpu_xsave_enabled)
+    {
+        fpu_xrstor(area, fpu_xsave_mask);
+        return;
+    }
+
+    fpu_fxrstor(area);
+}
+
+static void fpu_set_task_switched(bool set)
+{
+    uint64_t cr0 = cpu_read_cr0();
+    bool is_set = cr0 & CPU_CR0_TASK_SWITCHED;
+    if (is_set == set)
+    {
+        // Writing CR0 is not free, avoid it when nothing changes
+        return;
+    }
+
+    if (set)
+    {
+        cpu_write_cr0(cr0 | CPU_CR0_TASK_SWITCHED);
+        return;
+    }
+
+    fpu_clts();
+}
+
+size_t fpu_state_size()
+{
+    return fpu_area_size;
+}
+
+/**
+ * Allocates a save area, the kernel heap hands out 4096 byte aligned blocks
+ * which satisfies the 16 byte FXSAVE and 64 byte XSAVE alignment rules.
+ */
+static void* fpu_state_new()
+{
+    void* area = kzalloc(fpu_area_size);
+    if (!area)
+    {
+        return NULL;
+    }
+
+    memcpy(area, fpu_initial_state, fpu_area_size);
+    return area;
+}
+
+/**
+ * True when the FPU registers of the processor still hold the latest state of the task
+ */
+static bool fpu_registers_hold(struct cpu* cpu, struct task* task)
+{
+    return cpu->fpu_owner == task && task->fpu_cpu == cpu->id;
+}
+
+static void fpu_handle_device_not_available(struct interrupt_frame* frame)
+{
+    struct cpu* cpu = smp_cpu_current();
+    struct task* task = task_current();
+
+    // Allow FPU instructions again, we are about to give the registers to this task
+    fpu_clts();
+    if (fpu_registers_hold(cpu, task))
+    {
+        return;
+    }
+
+    if (!task->fpu_state)
+    {
+        task->fpu_state = fpu_state_new();
+        if (!task->fpu_state)
+        {
+            panic("Failed to allocate FPU state for task\n");
+        }
+    }
+
+    // The owner may have run on another processor since, then our registers are stale
+    if (cpu->fpu_owner && fpu_registers_hold(cpu, cpu->fpu_owner))
+    {
+        fpu_save(cpu->fpu_owner->fpu_state);
+    }
+
+    fpu_restore(task->fpu_state);
+    cpu->fpu_owner = task;
+    task->fpu_cpu = cpu->id;
+}
+
+void fpu_task_switch(struct task* prev, struct task* next)
+{
+    struct cpu* cpu = smp_cpu_current();
+    if (prev && prev != next && smp_total_cpus() > 1 &&
+        fpu_registers_hold(cpu, prev) && !(cpu_read_cr0() & CPU_CR0_TASK_SWITCHED))
+    {
+        // The task used the FPU this timeslice and may be picked up by
+        // another processor next, its save area must be current
+        fpu_save(prev->fpu_state);
+    }
+
+    if (!next->process)
+    {
+        // Kernel tasks never touch the FPU, leave CR0.TS alone for them
+        return;
+    }
+
+    fpu_set_task_switched(!fpu_registers_hold(cpu, next));
+}
+
+void fpu_task_free(struct task* task)
+{
+    for (int i = 0; i < smp_total_cpus(); i++)
+    {
+        struct cpu* cpu = smp_cpu(i);
+        if (cpu->fpu_owner == task)
+        {
+            // The registers belong to nobody now, nothing needs saving
+            cpu->fpu_owner = NULL;
+        }
+    }
+
+    if (task->fpu_state)
+    {
+        kfree(task->fpu_state);
+        task->fpu_state = NULL;
+    }
+}
+
+static void fpu_enable_xsave()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t feature_ecx = ecx;
+    if (!(feature_ecx & CPUID_FEATURE_ECX_XSAVE))
+    {
+        return;
+    }
+
+    cpu_write_cr4(cpu_read_cr4() | CPU_CR4_OSXSAVE);
+
+    // Leaf 0x0D sub leaf zero reports the state components the CPU supports
+    uint32_t supported_low, supported_high;
+    cpu_cpuid(0x0D, 0, &supported_low, &ebx, &ecx, &supported_high);
+
+    uint64_t mask = CPU_XCR0_X87 | CPU_XCR0_SSE;
+    if ((feature_ecx & CPUID_FEATURE_ECX_AVX) && (supported_low & CPU_XCR0_AVX))
+    {
+        mask |= CPU_XCR0_AVX;
+    }
+
+    cpu_xsetbv(0, mask);
+
+    // EBX now reports the save area size for the components enabled in XCR0
+    cpu_cpuid(0x0D, 0, &eax, &ebx, &ecx, &edx);
+    fpu_xsave_mask = mask;
+    fpu_area_size = ebx;
+    fpu_xsave_enabled = true;
+}
+
+void fpu_cpu_init()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEATURE_EDX_FXSR) || !(edx & CPUID_FEATURE_EDX_SSE))
+    {
+        panic("CPU does not support FXSR/SSE\n");
+    }
+
+    // Hardware FPU, native error reporting, WAIT honours CR0.TS
+    uint64_t cr0 = cpu_read_cr0();
+    cr0 &= ~(CPU_CR0_EMULATION | CPU_CR0_TASK_SWITCHED);
+    cr0 |= CPU_CR0_MONITOR_COPROCESSOR | CPU_CR0_NUMERIC_ERROR;
+    cpu_write_cr0(cr0);
+
+    cpu_write_cr4(cpu_read_cr4() | CPU_CR4_OSFXSR | CPU_CR4_OSXMMEXCPT);
+    fpu_enable_xsave();
+
+    // Nobody owns the registers of this processor yet so the first use must trap
+    fpu_set_task_switched(true);
+}
+
+void fpu_init()
+{
+    fpu_cpu_init();
+
+    // Capture a clean state that every new task will start from
+    fpu_initial_state = kzalloc(fpu_area_size);
+    if (!fpu_initial_state)
+    {
+        panic("Failed to allocate the initial FPU state\n");
+    }
+    fpu_clts();
+    fpu_reset();
+    fpu_save(fpu_initial_state);
+    fpu_set_task_switched(true);
+
+    idt_register_interrupt_callback(FPU_DEVICE_NOT_AVAILABLE_INTERRUPT, fpu_handle_device_not_available);
+}
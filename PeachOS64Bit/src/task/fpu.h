@@ -0,0 +1,81 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_FPU_H
+#define KERNEL_FPU_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FPU_DEVICE_NOT_AVAILABLE_INTERRUPT 0x07
+
+// Size of the legacy FXSAVE area, used when XSAVE is not supported
+#define FPU_FXSAVE_AREA_SIZE 512
+
+struct task;
+struct interrupt_frame;
+
+/**
+ * Enables the FPU/SSE (and AVX through XSAVE when the CPU supports it)
+ * and installs the device not available handler used for lazy switching.
+ */
+void fpu_init();
+
+/**
+ * Enables the FPU/SSE on an application processor, fpu_init() must have
+ * run on the bootstrap processor first
+ */
+void fpu_cpu_init();
+
+/**
+ * Called on every task switch, sets CR0.TS unless the task we are switching
+ * to already owns the FPU registers of this processor. The first SIMD
+ * instruction of the task will then trap and load its state. With more than
+ * one processor the outgoing task's state is saved if it was used, it may
+ * run elsewhere next.
+ */
+void fpu_task_switch(struct task* prev, struct task* next);
+
+/**
+ * Releases the FPU state of a task that is being freed
+ */
+void fpu_task_free(struct task* task);
+
+/**
+ * Returns the size in bytes of a single task FPU save area
+ */
+size_t fpu_state_size();
+
+void fpu_clts();
+void fpu_fxsave(void* area);
+void fpu_fxrstor(void* area);
+void fpu_xsave(void* area, uint64_t mask);
+void fpu_xrstor(void* area, uint64_t mask);
+void fpu_reset();
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "futex.h"
+#include "task.h"
+#include "kernel.h"
+#include "status.h"
+
+static struct futex_bucket futex_buckets[FUTEX_HASH_BUCKETS];
+
+void futex_init()
+{
+    // Too many to list in the lock statistics one by one
+    for (int i = 0; i < FUTEX_HASH_BUCKETS; i++)
+    {
+        spinlock_init(&futex_buckets[i].lock, NULL);
+        waitqueue_init(&futex_buckets[i].waiters);
+    }
+}
+
+static struct futex_bucket* futex_bucket_get(uint64_t key)
+{
+    // Words are 4 byte aligned, the low bits carry nothing
+    return &futex_buckets[(key >> 2) & (FUTEX_HASH_BUCKETS - 1)];
+}
+
+/**
+ * Resolves the user address to the physical address that identifies the
+ * futex, threads sharing the page tables resolve to the same word
+ * \return Returns zero when the address is not a usable futex word
+ */
+static uint64_t futex_key(struct task* task, void* user_address)
+{
+    if (!user_address || ((uint64_t) user_address & (sizeof(uint32_t) - 1)))
+    {
+        return 0;
+    }
+
+    return (uint64_t) task_virtual_address_to_physical(task, user_address);
+}
+
+int futex_wait(struct task* task, void* user_address, uint32_t expected)
+{
+    int res = 0;
+    uint64_t key = futex_key(task, user_address);
+    if (!key)
+    {
+        return -EINVARG;
+    }
+
+    struct futex_bucket* bucket = futex_bucket_get(key);
+    uint64_t flags = spin_lock_irqsave(&bucket->lock);
+    if (*(volatile uint32_t*) key != expected)
+    {
+        // Somebody changed it since user land looked, let the caller try again
+        res = -EAGAIN;
+        spin_unlock_irqrestore(&bucket->lock, flags);
+        goto out;
+    }
+
+    task->futex_key = key;
+    waitqueue_add(&bucket->waiters, task);
+    spin_unlock_irqrestore(&bucket->lock, flags);
+    task_next();
+    task->futex_key = 0;
+
+out:
+    return res;
+}
+
+int futex_wake(struct task* task, void* user_address, int count)
+{
+    uint64_t key = futex_key(task, user_address);
+    if (!key)
+    {
+        return -EINVARG;
+    }
+
+    int woken = 0;
+    struct futex_bucket* bucket = futex_bucket_get(key);
+    uint64_t flags = spin_lock_irqsave(&bucket->lock);
+    struct task* waiter = bucket->waiters.head;
+    while (waiter && woken < count)
+    {
+        struct task* next = waiter->wait_next;
+        if (waiter->futex_key == key)
+        {
+            waitqueue_remove(&bucket->waiters, waiter);
+            task_wake(waiter);
+            woken++;
+        }
+
+        waiter = next;
+    }
+    spin_unlock_irqrestore(&bucket->lock, flags);
+    return woken;
+}
@@ -0,0 +1,66 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_FUTEX_H
+#define KERNEL_FUTEX_H
+
+#include <stdint.h>
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+
+// Waiters are spread over this many queues by the address of their word, must be a power of two
+#define FUTEX_HASH_BUCKETS 64
+
+struct task;
+
+/**
+ * One queue of tasks sleeping on futex words that hash to it, each
+ * task records the word it waits for in task->futex_key
+ */
+struct futex_bucket
+{
+    struct spinlock lock;
+    struct waitqueue waiters;
+};
+
+void futex_init();
+
+/**
+ * Sleeps the task until a futex_wake() on the same word, but only if the
+ * 32 bit word at the user address still holds the expected value. Checking
+ * and sleeping happen under the bucket lock so a wake in between is not lost.
+ * \return Returns zero once woken, -EAGAIN when the value differed or another negative error code
+ */
+int futex_wait(struct task* task, void* user_address, uint32_t expected);
+
+/**
+ * Wakes up to count tasks waiting on the word at the user address
+ * \return Returns the number of tasks woken or a negative error code
+ */
+int futex_wake(struct task* task, void* user_address, int count);
+
+#endif
@@ -32,17 +32,38 @@
 #include "memory/memory.h"
 #include "string/string.h"
 #include "fs/file.h"
+#include "disk/disk.h"
 #include "lib/vector/vector.h"
+#include "lib/spinlock/spinlock.h"
 #include "memory/heap/kheap.h"
 #include "memory/paging/paging.h"
 #include "loader/formats/elfloader.h"
+#include "apic/lapic.h"
 #include "kernel.h"
 #include <stdbool.h>
 
 // The current process that is running
 struct process *current_process = 0;
 
-struct vector *process_vector = NULL;
+// Every process that has been given an id, for walking them all
+static struct process *process_list_head = NULL;
+
+// Processes by id, chained through process->hash_next
+static struct process *process_hash[PROCESS_ID_HASH_BUCKETS];
+
+// Bit N is set while process id N is taken, grown when every id is in use
+static uint64_t *process_id_bitmap = NULL;
+static int process_id_bitmap_words = 0;
+
+// Where the search for a free id starts, ids are handed out in a rolling
+// order so a freed id is not reused straight away
+static int process_id_next = 0;
+
+// Tasks in process_wait(), woken whenever a process goes away
+static struct waitqueue process_exit_waiters;
+
+// Guards the process list, hash, id bitmap and exit waiters
+static struct spinlock process_table_lock;
 
 int process_get_allocation_by_start_addr(struct process *process, void *addr, struct process_allocation *allocation_out);
 
@@ -56,7 +77,8 @@ void *process_virtual_address_to_physical(struct process *process, void *virt_ad
 
 void process_system_init()
 {
-    process_vector = vector_new(sizeof(struct process *), 10, 0);
+    spinlock_init(&process_table_lock, "processes");
+    waitqueue_init(&process_exit_waiters);
 }
 
 static void process_init(struct process *process)
@@ -64,6 +86,8 @@ static void process_init(struct process *process)
     memset(process, 0, sizeof(struct process));
     process->allocations = vector_new(sizeof(struct process_allocation), 10, 0);
     process->file_handles = vector_new(sizeof(struct process_file_handle *), 4, 0);
+    waitqueue_init(&process->keyboard.waiters);
+    waitqueue_init(&process->thread_waiters);
 }
 
 struct process *process_current()
@@ -71,17 +95,176 @@ struct process *process_current()
     return current_process;
 }
 
+static struct process **process_hash_bucket(int process_id)
+{
+    return &process_hash[process_id & (PROCESS_ID_HASH_BUCKETS - 1)];
+}
+
+/**
+ * Finds the process with the id, the table lock must be held
+ */
+static struct process *process_get_locked(int process_id)
+{
+    struct process *process = *process_hash_bucket(process_id);
+    while (process && process->id != process_id)
+    {
+        process = process->hash_next;
+    }
+
+    return process;
+}
+
 struct process *process_get(int process_id)
 {
-    int res = 0;
-    struct process *process_out = NULL;
-    res = vector_at(process_vector, process_id, &process_out, sizeof(process_out));
-    if (res < 0)
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    struct process *process = process_get_locked(process_id);
+    spin_unlock_irqrestore(&process_table_lock, flags);
+    return process;
+}
+
+/**
+ * Takes the first free id at or after the rolling cursor, the table lock must be held
+ * \return Returns the id or -EISTKN when every id in the bitmap is taken
+ */
+static int process_id_take_locked()
+{
+    int total_ids = process_id_bitmap_words * 64;
+    if (total_ids == 0)
+    {
+        return -EISTKN;
+    }
+
+    int start = process_id_next % total_ids;
+    // One more word than there are so the bits below the cursor in its own word get a look too
+    for (int i = 0; i <= process_id_bitmap_words; i++)
+    {
+        int word = (start / 64 + i) % process_id_bitmap_words;
+        uint64_t free_bits = ~process_id_bitmap[word];
+        if (i == 0)
+        {
+            free_bits &= ~0ULL << (start % 64);
+        }
+
+        if (free_bits)
+        {
+            int id = word * 64 + __builtin_ctzll(free_bits);
+            process_id_bitmap[word] |= 1ULL << (id % 64);
+            process_id_next = id + 1;
+            return id;
+        }
+    }
+
+    return -EISTKN;
+}
+
+/**
+ * Allocates a process id, doubling the bitmap when every id is taken
+ * \return Returns the id or a negative error code
+ */
+static int process_id_alloc()
+{
+    while (1)
+    {
+        uint64_t flags = spin_lock_irqsave(&process_table_lock);
+        int id = process_id_take_locked();
+        int words = process_id_bitmap_words;
+        spin_unlock_irqrestore(&process_table_lock, flags);
+        if (id >= 0)
+        {
+            return id;
+        }
+
+        int new_words = words ? words * 2 : PROCESS_ID_BITMAP_INITIAL_WORDS;
+        if (new_words * 64 > PEACHOS_PROCESS_ID_MAX)
+        {
+            new_words = PEACHOS_PROCESS_ID_MAX / 64;
+        }
+
+        if (new_words <= words)
+        {
+            return -EISTKN;
+        }
+
+        // The heap may map pages, so allocate without holding the lock
+        uint64_t *bitmap = kzalloc(new_words * sizeof(uint64_t));
+        if (!bitmap)
+        {
+            return -ENOMEM;
+        }
+
+        flags = spin_lock_irqsave(&process_table_lock);
+        if (process_id_bitmap_words == words)
+        {
+            if (process_id_bitmap)
+            {
+                memcpy(bitmap, process_id_bitmap, words * sizeof(uint64_t));
+                kfree(process_id_bitmap);
+            }
+            process_id_bitmap = bitmap;
+            process_id_bitmap_words = new_words;
+            bitmap = NULL;
+        }
+        spin_unlock_irqrestore(&process_table_lock, flags);
+
+        if (bitmap)
+        {
+            // Another processor grew it first
+            kfree(bitmap);
+        }
+    }
+}
+
+static void process_id_free_locked(int process_id)
+{
+    process_id_bitmap[process_id / 64] &= ~(1ULL << (process_id % 64));
+}
+
+static void process_id_free(int process_id)
+{
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    process_id_free_locked(process_id);
+    spin_unlock_irqrestore(&process_table_lock, flags);
+}
+
+/**
+ * Makes the process visible to process_get() and the process list
+ */
+static void process_link(struct process *process)
+{
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    struct process **bucket = process_hash_bucket(process->id);
+    process->hash_next = *bucket;
+    *bucket = process;
+
+    process->list_prev = NULL;
+    process->list_next = process_list_head;
+    if (process_list_head)
+    {
+        process_list_head->list_prev = process;
+    }
+    process_list_head = process;
+    process->linked = true;
+    spin_unlock_irqrestore(&process_table_lock, flags);
+}
+
+int process_wait(int process_id)
+{
+    struct task *task = task_current();
+    if (task->process && task->process->id == process_id)
     {
-        return ERROR(EINVARG);
+        return -EINVARG;
     }
 
-    return process_out;
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    while (process_get_locked(process_id))
+    {
+        waitqueue_add(&process_exit_waiters, task);
+        spin_unlock_irqrestore(&process_table_lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&process_table_lock);
+    }
+    spin_unlock_irqrestore(&process_table_lock, flags);
+    return 0;
 }
 
 int process_switch(struct process *process)
@@ -185,7 +368,7 @@ void* process_realloc(struct process* process, void* old_virt_ptr, size_t new_si
     old_phys_ptr = old_virt_ptr;
     if (old_phys_ptr)
     {
-        old_phys_ptr = task_virtual_address_to_physical(process->task, old_virt_ptr);
+        old_phys_ptr = process_virtual_address_to_physical(process, old_virt_ptr);
         if (!old_phys_ptr)
         {
             res = -ENOMEM;
@@ -364,29 +547,53 @@ int process_free_program_data(struct process *process)
 
 void process_switch_to_any()
 {
-    size_t total_process_slots = vector_count(process_vector);
-    for(size_t i = 0; i < total_process_slots; i++)
-    {
-        struct process* process = NULL;
-        int res = vector_at(process_vector, i, &process, sizeof(&process));
-        if (res < 0)
-        {
-            break;
-        }
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    struct process* found_process = process_list_head;
+    spin_unlock_irqrestore(&process_table_lock, flags);
 
-        if (process)
-        {
-            process_switch(process);
-            return;
-        }
+    if (found_process)
+    {
+        process_switch(found_process);
+        return;
     }
     panic("No processes to switch too\n");
 }
 
 static void process_unlink(struct process *process)
 {
-    struct process* null_process = NULL;
-    vector_overwrite(process_vector, process->id, &null_process, sizeof(&null_process));
+    uint64_t flags = spin_lock_irqsave(&process_table_lock);
+    if (!process->linked)
+    {
+        spin_unlock_irqrestore(&process_table_lock, flags);
+        return;
+    }
+
+    struct process **link = process_hash_bucket(process->id);
+    while (*link != process)
+    {
+        link = &(*link)->hash_next;
+    }
+    *link = process->hash_next;
+
+    if (process->list_prev)
+    {
+        process->list_prev->list_next = process->list_next;
+    }
+    else
+    {
+        process_list_head = process->list_next;
+    }
+
+    if (process->list_next)
+    {
+        process->list_next->list_prev = process->list_prev;
+    }
+
+    process->linked = false;
+    process_id_free_locked(process->id);
+    waitqueue_wake_all(&process_exit_waiters);
+    spin_unlock_irqrestore(&process_table_lock, flags);
+
     if (current_process == process)
     {
         process_switch_to_any();
@@ -410,12 +617,17 @@ int process_free_process(struct process *process)
         kfree(process->stack);
         process->stack = NULL;
     }
-    // Free the task
-    if (process->task)
+    // Free the tasks, threads running on other processors die at their next interrupt
+    for (int i = 0; i < PEACHOS_MAX_PROCESS_THREADS; i++)
     {
-        task_free(process->task);
-        process->task = NULL;
+        struct process_thread* thread = &process->threads[i];
+        if (thread->task)
+        {
+            task_free(thread->task);
+            thread->task = NULL;
+        }
     }
+    process->task = NULL;
 
     kfree(process);
 
@@ -438,6 +650,121 @@ out:
     return res;
 }
 
+static int process_thread_get_free_slot(struct process *process)
+{
+    for (int i = 0; i < PEACHOS_MAX_PROCESS_THREADS; i++)
+    {
+        if (!process->threads[i].used)
+        {
+            return i;
+        }
+    }
+
+    return -EISTKN;
+}
+
+int process_thread_create(struct process *process, void *entry, void *arg1, void *arg2)
+{
+    int res = 0;
+    void *stack = NULL;
+    int thread_id = process_thread_get_free_slot(process);
+    if (thread_id < 0)
+    {
+        res = thread_id;
+        goto out;
+    }
+
+    // Heap memory of the process is mapped at its physical address
+    stack = process_malloc(process, PEACHOS_USER_THREAD_STACK_SIZE);
+    if (!stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // The entry point starts as if it had been called, the return address is never used
+    uint64_t stack_top = (uint64_t) stack + PEACHOS_USER_THREAD_STACK_SIZE - sizeof(uint64_t);
+    struct task *task = task_new_thread(process, (uint64_t) entry, stack_top, (uint64_t) arg1, (uint64_t) arg2);
+    if (ISERR(task))
+    {
+        res = ERROR_I(task);
+        goto out;
+    }
+
+    task->thread_id = thread_id;
+    struct process_thread *thread = &process->threads[thread_id];
+    memset(thread, 0, sizeof(struct process_thread));
+    thread->used = true;
+    thread->task = task;
+    thread->stack = stack;
+    process->total_threads++;
+    res = thread_id;
+
+out:
+    if (res < 0 && stack)
+    {
+        process_free(process, stack);
+    }
+    return res;
+}
+
+int process_thread_exit(struct process *process, struct task *task, uint64_t exit_code)
+{
+    if (process->total_threads <= 1)
+    {
+        // The last thread takes the whole process with it
+        return process_terminate(process);
+    }
+
+    struct process_thread *thread = &process->threads[task->thread_id];
+    thread->exited = true;
+    thread->exit_code = exit_code;
+    thread->task = NULL;
+    if (process->task == task)
+    {
+        process->task = NULL;
+    }
+
+    if (thread->stack)
+    {
+        process_free(process, thread->stack);
+        thread->stack = NULL;
+    }
+
+    process->total_threads--;
+    waitqueue_wake_all(&process->thread_waiters);
+    return task_free(task);
+}
+
+int process_thread_join(struct process *process, int thread_id, uint64_t *exit_code_out)
+{
+    if (thread_id < 0 || thread_id >= PEACHOS_MAX_PROCESS_THREADS)
+    {
+        return -EINVARG;
+    }
+
+    struct process_thread *thread = &process->threads[thread_id];
+    struct task *task = task_current();
+    if (!thread->used || thread->task == task)
+    {
+        return -EINVARG;
+    }
+
+    while (!thread->exited)
+    {
+        waitqueue_add(&process->thread_waiters, task);
+        task_next();
+    }
+
+    if (exit_code_out)
+    {
+        *exit_code_out = thread->exit_code;
+    }
+
+    memset(thread, 0, sizeof(struct process_thread));
+    return 0;
+}
+
 void process_get_arguments(struct process *process, int *argc, char ***argv)
 {
     *argc = process->arguments.argc;
@@ -633,6 +960,7 @@ int process_map_memory(struct process *process)
     // Map all the e820 memory regions
     // so the whole address space is mapped
     paging_map_e820_memory_regions(process->paging_desc);
+    lapic_map(process->paging_desc);
 
     switch (process->filetype)
     {
@@ -659,79 +987,14 @@ out:
     return res;
 }
 
-int process_get_free_slot()
-{
-    int res = 0;
-    bool found = false;
-    size_t total_process_slots = vector_count(process_vector);
-    for(size_t i = 0; i < total_process_slots; i++)
-    {
-        struct process* process_out = NULL;
-        res = vector_at(process_vector, i, &process_out, sizeof(process_out));
-        if (res < 0)
-        {
-            break;
-        }
-
-        if (!process_out)
-        {
-            found = true;
-            res = i;
-            break;
-        }
-    }
-
-    if (res < 0)
-    {
-        goto out;
-    }
-
-    if (!found)
-    {
-        struct process* null_process = NULL;
-        int process_index = vector_push(process_vector, &null_process);
-
-        // vector_push returned the index of the new null process pointer
-        res = process_index;
-    }
-out:
-    return res;
-}
-
 int process_load(const char *filename, struct process **process)
 {
     int res = 0;
-    int process_slot = process_get_free_slot();
-    if (process_slot < 0)
-    {
-        res = -EISTKN;
-        goto out;
-    }
-
-    res = process_load_for_slot(filename, process, process_slot);
-out:
-    return res;
-}
-
-int process_load_switch(const char *filename, struct process **process)
-{
-    int res = process_load(filename, process);
-    if (res == 0)
-    {
-        process_switch(*process);
-    }
-
-    return res;
-}
-
-int process_load_for_slot(const char *filename, struct process **process, int process_slot)
-{
-    int res = 0;
-    struct process *_process;
-
-    if (process_get(process_slot) != 0)
+    struct process *_process = NULL;
+    int process_id = process_id_alloc();
+    if (process_id < 0)
     {
-        res = -EISTKN;
+        res = process_id;
         goto out;
     }
 
@@ -757,7 +1020,7 @@ int process_load_for_slot(const char *filename, struct process **process, int pr
     }
 
     strncpy(_process->filename, filename, sizeof(_process->filename));
-    _process->id = process_slot;
+    _process->id = process_id;
 
     _process->paging_desc = paging_desc_new(PAGING_MAP_LEVEL_4);
     if (!_process->paging_desc)
@@ -783,11 +1046,12 @@ int process_load_for_slot(const char *filename, struct process **process, int pr
         goto out;
     }
 
-    *process = _process;
+    _process->threads[0].used = true;
+    _process->threads[0].task = _process->task;
+    _process->total_threads = 1;
 
-    // Overwrite the free process pointer thats in the vector
-    // with our allocated one. SO we take ownership of the slot.
-    vector_overwrite(process_vector, process_slot, &_process, sizeof(&_process));
+    process_link(_process);
+    *process = _process;
 
 out:
     if (ISERR(res))
@@ -799,11 +1063,25 @@ out:
             *process = NULL;
         }
 
-        // Free the process data
+        if (process_id >= 0)
+        {
+            process_id_free(process_id);
+        }
     }
     return res;
 }
 
+int process_load_switch(const char *filename, struct process **process)
+{
+    int res = process_load(filename, process);
+    if (res == 0)
+    {
+        process_switch(*process);
+    }
+
+    return res;
+}
+
 bool process_is_stack_memory(struct process *process, void *addr)
 {
     return (uintptr_t)addr >= PEACHOS_PROGRAM_VIRTUAL_STACK_ADDRESS_END &&
@@ -941,7 +1219,7 @@ int process_fread(struct process *process, void *virt_ptr, uint64_t size, uint64
         goto out;
     }
 
-    void *phys_ptr = task_virtual_address_to_physical(process->task, virt_ptr);
+    void *phys_ptr = process_virtual_address_to_physical(process, virt_ptr);
     if (!phys_ptr)
     {
         goto out;
@@ -953,6 +1231,131 @@ int process_fread(struct process *process, void *virt_ptr, uint64_t size, uint64
         goto out;
     }
 
+out:
+    return res;
+}
+int process_disk_read(struct process *process, int disk_index, uint64_t lba, int total, void *virt_ptr)
+{
+    int res = 0;
+    struct disk *disk = disk_get(disk_index);
+    if (!disk || total <= 0)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = process_validate_memory_or_terminate(process, virt_ptr, (size_t) total * disk->sector_size);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    void *phys_ptr = process_virtual_address_to_physical(process, virt_ptr);
+    if (!phys_ptr)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = disk_read_direct(disk, lba, total, phys_ptr);
+
+out:
+    return res;
+}
+
+int process_disk_write(struct process *process, int disk_index, uint64_t lba, int total, void *virt_ptr)
+{
+    int res = 0;
+    struct disk *disk = disk_get(disk_index);
+    if (!disk || total <= 0)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = process_validate_memory_or_terminate(process, virt_ptr, (size_t) total * disk->sector_size);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    void *phys_ptr = process_virtual_address_to_physical(process, virt_ptr);
+    if (!phys_ptr)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = disk_write_block(disk, lba, total, phys_ptr);
+
+out:
+    return res;
+}
+
+int process_disk_sync(struct process *process, int disk_index)
+{
+    struct disk *disk = disk_get(disk_index);
+    if (!disk)
+    {
+        return -EINVARG;
+    }
+
+    return disk_sync(disk);
+}
+
+int process_disk_stats(struct process *process, int disk_index, void *virt_ptr)
+{
+    int res = 0;
+    struct disk *disk = disk_get(disk_index);
+    if (!disk)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = process_validate_memory_or_terminate(process, virt_ptr, sizeof(struct disk_stats_info));
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct disk_stats_info *info = process_virtual_address_to_physical(process, virt_ptr);
+    if (!info)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = disk_stats_get(disk, info);
+
+out:
+    return res;
+}
+
+int process_disk_trace(struct process *process, int enable, uint64_t since, void *virt_ptr, int max)
+{
+    int res = 0;
+    disk_trace_enable(enable);
+    if (!virt_ptr || max <= 0)
+    {
+        goto out;
+    }
+
+    res = process_validate_memory_or_terminate(process, virt_ptr, (size_t) max * sizeof(struct disk_trace_entry));
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct disk_trace_entry *entries = process_virtual_address_to_physical(process, virt_ptr);
+    if (!entries)
+    {
+        res = -EINVARG;
+        goto out;
+    }
+
+    res = disk_trace_read(since, entries, max);
+
 out:
     return res;
 }
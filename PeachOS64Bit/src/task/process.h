@@ -31,9 +31,16 @@
 #include <stdbool.h>
 
 #include "task.h"
+#include "waitqueue.h"
 #include "fs/file.h"
 #include "config.h"
 
+// process_get() looks ids up in this many buckets, must be a power of two
+#define PROCESS_ID_HASH_BUCKETS 256
+
+// The id bitmap starts with room for 64 * this many processes and doubles when full
+#define PROCESS_ID_BITMAP_INITIAL_WORDS 1
+
 #define PROCESS_FILETYPE_ELF 0
 #define PROCESS_FILETYPE_BINARY 1
 
@@ -89,16 +96,50 @@ struct process_file_handle
     char mode[2];
 };
 
+struct process_thread
+{
+    // True while the slot belongs to a thread that is running or not yet joined
+    bool used;
+
+    // NULL once the thread has exited
+    struct task* task;
+
+    // The user stack allocation, NULL for the main thread which has the process stack
+    void* stack;
+
+    bool exited;
+    uint64_t exit_code;
+};
+
 struct process
 {
     // The process id
-    uint16_t id;
+    int id;
+
+    // The next process in the same id hash bucket
+    struct process* hash_next;
+
+    // Neighbours in the list of all processes
+    struct process* list_next;
+    struct process* list_prev;
+
+    // True while the process can be found by its id
+    bool linked;
 
     char filename[PEACHOS_MAX_PATH];
 
-    // The main process task
+    // The main process task, NULL once the main thread has exited
     struct task* task;
 
+    // Every thread of the process, slot zero is the main thread
+    struct process_thread threads[PEACHOS_MAX_PROCESS_THREADS];
+
+    // Threads that have not exited yet, the process ends with the last one
+    int total_threads;
+
+    // Tasks waiting in process_thread_join()
+    struct waitqueue thread_waiters;
+
      /**
      * The page directory of the process virtual memory.
      */
@@ -134,6 +175,9 @@ struct process
         char buffer[PEACHOS_KEYBOARD_BUFFER_SIZE];
         int tail;
         int head;
+
+        // Tasks of this process sleeping until a key is pushed
+        struct waitqueue waiters;
     } keyboard;
 
 
@@ -145,9 +189,18 @@ void process_system_init();
 int process_switch(struct process* process);
 int process_load_switch(const char* filename, struct process** process);
 int process_load(const char* filename, struct process** process);
-int process_load_for_slot(const char* filename, struct process** process, int process_slot);
 struct process* process_current();
+
+/**
+ * \return Returns the process with the id or NULL when there is none
+ */
 struct process* process_get(int process_id);
+
+/**
+ * Sleeps until no process has the id, returns straight away when it already exited
+ * \return Returns zero or a negative error code
+ */
+int process_wait(int process_id);
 void* process_malloc(struct process* process, size_t size);
 void* process_realloc(struct process* process, void* old_virt_ptr, size_t new_size);
 void process_free(struct process* process, void* ptr);
@@ -156,6 +209,25 @@ void process_get_arguments(struct process* process, int* argc, char*** argv);
 int process_inject_arguments(struct process* process, struct command_argument* root_argument);
 int process_terminate(struct process* process);
 
+/**
+ * Starts another thread in the process at entry(arg1, arg2) on a new user stack
+ * \return Returns the thread id or a negative error code
+ */
+int process_thread_create(struct process* process, void* entry, void* arg1, void* arg2);
+
+/**
+ * Ends the thread, the exit code is kept for process_thread_join(). The last
+ * thread to exit terminates the process. The caller must switch away when
+ * the task is the current one.
+ */
+int process_thread_exit(struct process* process, struct task* task, uint64_t exit_code);
+
+/**
+ * Sleeps until the thread has exited and releases its slot
+ * \return Returns zero on success or a negative error code
+ */
+int process_thread_join(struct process* process, int thread_id, uint64_t* exit_code_out);
+
 struct process_file_handle* process_file_handle_get(struct process* process, int fd);
 int process_fopen(struct process* process, const char* path, const char* mode);
 int process_fclose(struct process* process, int fd);
@@ -163,4 +235,29 @@ int process_fread(struct process* process, void* virt_ptr, uint64_t size, uint64
 int process_fseek(struct process* process, int fd, int offset, FILE_SEEK_MODE whence);
 int process_fstat(struct process* process, int fd, struct file_stat* virt_filestat_addr);
 
+/**
+ * Reads raw sectors of a disk into memory of the process, past the block cache
+ */
+int process_disk_read(struct process* process, int disk_index, uint64_t lba, int total, void* virt_ptr);
+
+/**
+ * Writes raw sectors of a disk from memory of the process into the block
+ * cache, they reach the disk with writeback or process_disk_sync()
+ */
+int process_disk_write(struct process* process, int disk_index, uint64_t lba, int total, void* virt_ptr);
+int process_disk_sync(struct process* process, int disk_index);
+
+/**
+ * Copies the I/O statistics of a disk into a struct disk_stats_info of the process
+ */
+int process_disk_stats(struct process* process, int disk_index, void* virt_ptr);
+
+/**
+ * Turns disk tracing on or off and copies up to max traced requests from the
+ * sequence number since on into memory of the process
+ * \param enable One to trace, zero to stop, negative leaves it as it is
+ * \return Returns the number of entries copied
+ */
+int process_disk_trace(struct process* process, int enable, uint64_t since, void* virt_ptr, int max);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,360 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "sched.h"
+#include "task.h"
+#include "status.h"
+#include "smp/smp.h"
+#include "memory/memory.h"
+
+static int sched_timeslice(int nice)
+{
+    int timeslice = SCHED_BASE_TIMESLICE * (SCHED_NICE_MAX + 1 - nice) / (SCHED_NICE_MAX + 1);
+    if (timeslice < 1)
+    {
+        timeslice = 1;
+    }
+
+    return timeslice;
+}
+
+/**
+ * The effective priority, the nice level adjusted by the interactivity bonus.
+ * Tasks that sleep a lot (waiting on the keyboard) float up, CPU hogs sink.
+ */
+static int sched_priority(struct task* task)
+{
+    int priority = (task->nice - SCHED_NICE_MIN) - task->bonus;
+    if (priority < 0)
+    {
+        priority = 0;
+    }
+
+    if (priority >= SCHED_PRIORITY_LEVELS)
+    {
+        priority = SCHED_PRIORITY_LEVELS - 1;
+    }
+
+    return priority;
+}
+
+void sched_runqueue_init(struct runqueue* runqueue)
+{
+    memset(runqueue, 0x00, sizeof(struct runqueue));
+    spinlock_init(&runqueue->lock, "runqueue");
+}
+
+void sched_task_init(struct task* task)
+{
+    task->nice = SCHED_NICE_DEFAULT;
+    task->bonus = 0;
+    task->priority = sched_priority(task);
+    task->timeslice = sched_timeslice(task->nice);
+}
+
+/**
+ * Queues the task, the lock of its run queue must be held
+ */
+static void sched_enqueue_locked(struct task* task)
+{
+    if (task->queued)
+    {
+        return;
+    }
+
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    int priority = sched_priority(task);
+    task->priority = priority;
+    task->next = NULL;
+    task->prev = runqueue->tail[priority];
+    if (runqueue->tail[priority])
+    {
+        runqueue->tail[priority]->next = task;
+    }
+    else
+    {
+        runqueue->head[priority] = task;
+    }
+
+    runqueue->tail[priority] = task;
+    runqueue->bitmap |= (1ULL << priority);
+    runqueue->total++;
+    task->queued = true;
+}
+
+void sched_enqueue(struct task* task)
+{
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    uint64_t flags = spin_lock_irqsave(&runqueue->lock);
+    sched_enqueue_locked(task);
+    spin_unlock_irqrestore(&runqueue->lock, flags);
+}
+
+/**
+ * Takes the task off its run queue, the lock of the queue must be held
+ */
+static void sched_dequeue_locked(struct task* task)
+{
+    if (!task->queued)
+    {
+        return;
+    }
+
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    int priority = task->priority;
+    if (task->prev)
+    {
+        task->prev->next = task->next;
+    }
+    else
+    {
+        runqueue->head[priority] = task->next;
+    }
+
+    if (task->next)
+    {
+        task->next->prev = task->prev;
+    }
+    else
+    {
+        runqueue->tail[priority] = task->prev;
+    }
+
+    if (!runqueue->head[priority])
+    {
+        runqueue->bitmap &= ~(1ULL << priority);
+    }
+
+    runqueue->total--;
+    task->next = NULL;
+    task->prev = NULL;
+    task->queued = false;
+}
+
+void sched_dequeue(struct task* task)
+{
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    uint64_t flags = spin_lock_irqsave(&runqueue->lock);
+    sched_dequeue_locked(task);
+    spin_unlock_irqrestore(&runqueue->lock, flags);
+}
+
+static bool sched_cpu_is_idle(struct cpu* cpu)
+{
+    return cpu->online && cpu->runqueue.total == 0;
+}
+
+/**
+ * Returns an online processor with nothing to run, NULL if all are busy
+ */
+static struct cpu* sched_find_idle_cpu()
+{
+    for (int i = 0; i < smp_total_cpus(); i++)
+    {
+        struct cpu* cpu = smp_cpu(i);
+        if (sched_cpu_is_idle(cpu))
+        {
+            return cpu;
+        }
+    }
+
+    return NULL;
+}
+
+struct cpu* sched_place(struct task* task)
+{
+    struct cpu* best = smp_cpu_current();
+    for (int i = 0; i < smp_total_cpus(); i++)
+    {
+        struct cpu* cpu = smp_cpu(i);
+        if (cpu->online && cpu->runqueue.total < best->runqueue.total)
+        {
+            best = cpu;
+        }
+    }
+
+    task->cpu = best;
+    sched_enqueue(task);
+    return best;
+}
+
+/**
+ * Moves a queued task that is not running from the busiest processor onto
+ * this one, the most important candidates are taken first.
+ */
+static struct task* sched_steal(struct cpu* cpu)
+{
+    struct cpu* busiest = NULL;
+    for (int i = 0; i < smp_total_cpus(); i++)
+    {
+        struct cpu* other = smp_cpu(i);
+        if (other == cpu || !other->online)
+        {
+            continue;
+        }
+
+        // One of them is running, there must be at least one waiting
+        if (other->runqueue.total > 1 && (!busiest || other->runqueue.total > busiest->runqueue.total))
+        {
+            busiest = other;
+        }
+    }
+
+    if (!busiest)
+    {
+        return NULL;
+    }
+
+    // Only one run queue lock is held at a time so two processors stealing
+    // from each other cannot deadlock
+    struct task* stolen = NULL;
+    uint64_t flags = spin_lock_irqsave(&busiest->runqueue.lock);
+    uint64_t bitmap = busiest->runqueue.bitmap;
+    while (bitmap && !stolen)
+    {
+        int priority = __builtin_ctzll(bitmap);
+        bitmap &= bitmap - 1;
+        for (struct task* task = busiest->runqueue.head[priority]; task; task = task->next)
+        {
+            if (task->on_cpu)
+            {
+                continue;
+            }
+
+            sched_dequeue_locked(task);
+            stolen = task;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&busiest->runqueue.lock, flags);
+
+    if (stolen)
+    {
+        stolen->cpu = cpu;
+        sched_enqueue(stolen);
+    }
+
+    return stolen;
+}
+
+struct task* sched_pick_next(struct cpu* cpu)
+{
+    struct task* task = NULL;
+    struct runqueue* runqueue = &cpu->runqueue;
+    uint64_t flags = spin_lock_irqsave(&runqueue->lock);
+    if (runqueue->bitmap)
+    {
+        // The lowest set bit is the most important level with a runnable task
+        int priority = __builtin_ctzll(runqueue->bitmap);
+        task = runqueue->head[priority];
+    }
+    spin_unlock_irqrestore(&runqueue->lock, flags);
+
+    if (!task)
+    {
+        task = sched_steal(cpu);
+    }
+
+    return task;
+}
+
+bool sched_tick(struct task* task)
+{
+    task->timeslice--;
+    if (task->timeslice > 0)
+    {
+        return false;
+    }
+
+    // Used the whole timeslice, looks like a CPU hog
+    if (task->bonus > -SCHED_MAX_BONUS)
+    {
+        task->bonus--;
+    }
+
+    // Go to the back of the (possibly lower) level so others get a turn
+    task->timeslice = sched_timeslice(task->nice);
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    uint64_t flags = spin_lock_irqsave(&runqueue->lock);
+    sched_dequeue_locked(task);
+    sched_enqueue_locked(task);
+    spin_unlock_irqrestore(&runqueue->lock, flags);
+    return true;
+}
+
+struct cpu* sched_wake(struct task* task)
+{
+    if (task->bonus < SCHED_MAX_BONUS)
+    {
+        task->bonus++;
+    }
+
+    // Its cache is still warm on the last processor, move only to use an idle one
+    struct cpu* cpu = task->cpu;
+    if (!sched_cpu_is_idle(cpu))
+    {
+        struct cpu* idle = sched_find_idle_cpu();
+        if (idle)
+        {
+            cpu = idle;
+        }
+    }
+
+    task->cpu = cpu;
+    sched_enqueue(task);
+
+    struct task* running = cpu->current_task;
+    if (!running || task_is_idle(running) || task->priority < running->priority)
+    {
+        return cpu;
+    }
+
+    return NULL;
+}
+
+int sched_set_nice(struct task* task, int nice)
+{
+    if (nice < SCHED_NICE_MIN || nice > SCHED_NICE_MAX)
+    {
+        return -EINVARG;
+    }
+
+    struct runqueue* runqueue = &task->cpu->runqueue;
+    uint64_t flags = spin_lock_irqsave(&runqueue->lock);
+    bool queued = task->queued;
+    sched_dequeue_locked(task);
+    task->nice = nice;
+    task->timeslice = sched_timeslice(nice);
+    task->priority = sched_priority(task);
+    if (queued)
+    {
+        sched_enqueue_locked(task);
+    }
+    spin_unlock_irqrestore(&runqueue->lock, flags);
+
+    return 0;
+}
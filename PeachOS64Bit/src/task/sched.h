@@ -0,0 +1,122 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_SCHED_H
+#define KERNEL_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib/spinlock/spinlock.h"
+
+// Nice levels map one to one onto priority levels, level zero is the most important
+#define SCHED_NICE_MIN -20
+#define SCHED_NICE_MAX 19
+#define SCHED_NICE_DEFAULT 0
+#define SCHED_PRIORITY_LEVELS (SCHED_NICE_MAX - SCHED_NICE_MIN + 1)
+
+// How many levels a task can move up for sleeping or down for hogging the CPU
+#define SCHED_MAX_BONUS 5
+
+// Timeslice in ticks of a nice 0 task, nicer tasks get shorter slices
+#define SCHED_BASE_TIMESLICE 10
+
+struct task;
+struct cpu;
+
+/**
+ * One FIFO of runnable tasks per priority level, bit N of the bitmap is set
+ * while level N is not empty so picking the next task is a single bit scan.
+ * Tasks are linked through task->next and task->prev. Every processor has
+ * its own run queue.
+ */
+struct runqueue
+{
+    // Other processors take from the queue when stealing work
+    struct spinlock lock;
+
+    uint64_t bitmap;
+    struct task* head[SCHED_PRIORITY_LEVELS];
+    struct task* tail[SCHED_PRIORITY_LEVELS];
+
+    // Tasks on the queue, including the one running
+    int total;
+};
+
+void sched_runqueue_init(struct runqueue* runqueue);
+
+/**
+ * Gives a new task the default nice level and a full timeslice
+ */
+void sched_task_init(struct task* task);
+
+/**
+ * Appends the task to the tail of the run queue for its priority,
+ * on the processor in task->cpu
+ */
+void sched_enqueue(struct task* task);
+
+/**
+ * Queues a new task on an idle processor if there is one,
+ * otherwise on the processor with the fewest runnable tasks
+ * \return Returns the processor the task was queued on
+ */
+struct cpu* sched_place(struct task* task);
+
+/**
+ * Removes the task from the run queue, does nothing if it is not queued
+ */
+void sched_dequeue(struct task* task);
+
+/**
+ * Returns the first task of the highest priority non empty level of the
+ * processor. When its queue is empty a waiting task is pulled over from the
+ * busiest processor. Returns NULL when nothing is runnable.
+ */
+struct task* sched_pick_next(struct cpu* cpu);
+
+/**
+ * Charges a tick to the running task.
+ * \return Returns true when the timeslice ran out and another task should run
+ */
+bool sched_tick(struct task* task);
+
+/**
+ * Called when a blocked task becomes runnable, rewards it for sleeping
+ * and queues it. It stays on the processor it last ran on unless that one
+ * is busy and another is idle.
+ * \return Returns the processor that should reschedule, NULL if the task
+ * does not preempt anything
+ */
+struct cpu* sched_wake(struct task* task);
+
+/**
+ * Changes the nice level of a task, moving it to its new run queue
+ * \return Returns zero on success or -EINVARG if the nice level is out of range
+ */
+int sched_set_nice(struct task* task, int nice);
+
+#endif
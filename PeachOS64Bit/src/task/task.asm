@@ -30,6 +30,10 @@ section .asm
 global restore_general_purpose_registers
 global task_return
 global user_registers
+global task_idle_loop
+global task_context_switch
+
+extern smp_unlock_kernel_all
 
 ; void task_return(struct registers* regs);
 task_return:
@@ -39,8 +43,19 @@ task_return:
     or rax, 0x200       ; Set IF Bit
     push rax
 
-    push qword 0x2B     ; User data segment
+    push qword [rdi+64] ; CS, user code segment or the kernel code segment for kernel tasks
     push qword [rdi+56] ; RIP
+
+    ; We are leaving the kernel, let the other processors in
+    push rdi
+    call smp_unlock_kernel_all
+    pop rdi
+
+    ; User land runs with its own GS base, kernel tasks keep the processor
+    test qword [rsp+8], 3
+    jz .kernel_task
+    swapgs
+.kernel_task:
     call restore_general_purpose_registers
 
     ; Leave the kernel and jump to user land.
@@ -48,6 +63,14 @@ task_return:
     
 ; void restore_general_purpose_registers(struct registers* regs);
 restore_general_purpose_registers:
+    mov r8, [rdi+96]
+    mov r9, [rdi+104]
+    mov r10, [rdi+112]
+    mov r11, [rdi+120]
+    mov r12, [rdi+128]
+    mov r13, [rdi+136]
+    mov r14, [rdi+144]
+    mov r15, [rdi+152]
     mov rsi, [rdi+8]
     mov rbp, [rdi+16]
     mov rbx, [rdi+24]
@@ -59,11 +82,39 @@ restore_general_purpose_registers:
     mov rdi, [rdi]
     ret
 
+; void task_context_switch(uint64_t* prev_rsp, uint64_t next_rsp)
+; Every other register is caller saved so only these need to survive the switch,
+; keep the order in sync with task_kernel_stack_new()
+task_context_switch:
+    push rbp
+    push rbx
+    push r12
+    push r13
+    push r14
+    push r15
+    mov [rdi], rsp
+
+    ; Now on the kernel stack of the next task
+    mov rsp, rsi
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbx
+    pop rbp
+    ret
+
+; void task_idle_loop()
+; Entry point of the idle task, runs in ring zero with interrupts enabled
+task_idle_loop:
+    sti
+    hlt
+    jmp task_idle_loop
+
 ; void user_registers()
 user_registers:
     mov ax, 0x2B ; User data segment | privilaged bit
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     ret
\ No newline at end of file
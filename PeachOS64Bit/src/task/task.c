@@ -35,19 +35,34 @@
 #include "memory/paging/paging.h"
 #include "loader/formats/elfloader.h"
 #include "idt/idt.h"
-
-// The current task that is running
-struct task *current_task = 0;
-
-// Task linked list
-struct task *task_tail = 0;
-struct task *task_head = 0;
+#include "fpu.h"
+#include "waitqueue.h"
+#include "sched.h"
+#include "cpu/cpu.h"
+#include "timer/timer.h"
+#include "timer/ktimer.h"
+#include "smp/smp.h"
 
 int task_init(struct task *task, struct process *process);
+static void task_entry();
+static int task_kernel_stack_new(struct task* task);
 
 struct task *task_current()
 {
-    return current_task;
+    return smp_cpu_current()->current_task;
+}
+
+/**
+ * Puts a new task on the run queue of the processor that should run it
+ * and gets that processor going when it is idle
+ */
+static void task_place(struct task* task)
+{
+    struct cpu* cpu = sched_place(task);
+    if (cpu->current_task && task_is_idle(cpu->current_task))
+    {
+        smp_send_reschedule(cpu);
+    }
 }
 
 struct task *task_new(struct process *process)
@@ -66,18 +81,22 @@ struct task *task_new(struct process *process)
         goto out;
     }
 
-
-    if (task_head == 0)
+    res = task_kernel_stack_new(task);
+    if (res < 0)
     {
-        task_head = task;
-        task_tail = task;
-        current_task = task;
         goto out;
     }
 
-    task_tail->next = task;
-    task->prev = task_tail;
-    task_tail = task;
+    struct cpu* cpu = sched_place(task);
+    if (!cpu->current_task)
+    {
+        cpu->current_task = task;
+    }
+    else if (task_is_idle(cpu->current_task))
+    {
+        // Nothing else to do over there, get it started
+        smp_send_reschedule(cpu);
+    }
 
 out:
     if (ISERR(res))
@@ -89,80 +108,427 @@ out:
     return task;
 }
 
-struct task *task_get_next()
+struct task* task_new_kernel(TASK_KERNEL_ENTRY entry, void* arg)
 {
-    if (!current_task->next)
+    int res = 0;
+    struct task* task = kzalloc(sizeof(struct task));
+    if (!task)
     {
-        return task_head;
+        res = -ENOMEM;
+        goto out;
     }
 
-    return current_task->next;
+    task->kernel_entry = entry;
+    task->kernel_entry_arg = arg;
+    task->state = TASK_STATE_RUNNABLE;
+    sched_task_init(task);
+
+    res = task_kernel_stack_new(task);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    task_place(task);
+
+out:
+    if (ISERR(res))
+    {
+        // Never placed on a run queue and only the stack can fail
+        kfree(task);
+        return ERROR(res);
+    }
+
+    return task;
 }
 
-static void task_list_remove(struct task *task)
+struct task* task_new_thread(struct process* process, uint64_t entry, uint64_t stack, uint64_t arg1, uint64_t arg2)
 {
-    if (task->prev)
+    int res = 0;
+    struct task* task = kzalloc(sizeof(struct task));
+    if (!task)
     {
-        task->prev->next = task->next;
+        res = -ENOMEM;
+        goto out;
     }
 
-    if (task == task_head)
+    res = task_init(task, process);
+    if (res < 0)
     {
-        task_head = task->next;
+        goto out;
     }
 
-    if (task == task_tail)
+    task->registers.ip = entry;
+    task->registers.rsp = stack;
+    task->registers.rdi = arg1;
+    task->registers.rsi = arg2;
+
+    res = task_kernel_stack_new(task);
+    if (res < 0)
     {
-        task_tail = task->prev;
+        goto out;
     }
 
-    if (task == current_task)
+    task_place(task);
+
+out:
+    if (ISERR(res))
     {
-        current_task = task_get_next();
+        if (task)
+        {
+            kfree(task);
+        }
+        return ERROR(res);
     }
+
+    return task;
 }
 
-int task_free(struct task *task)
+/**
+ * Returns the most important runnable task, NULL if every task is blocked
+ */
+struct task *task_get_next()
+{
+    return sched_pick_next(smp_cpu_current());
+}
+
+/**
+ * Allocates the kernel stack of the task and lays it out as if the task had
+ * called task_context_switch(), the first switch to it returns into task_entry()
+ */
+static int task_kernel_stack_new(struct task* task)
+{
+    void* stack = kzalloc(PEACHOS_TASK_KERNEL_STACK_SIZE);
+    if (!stack)
+    {
+        return -ENOMEM;
+    }
+
+    // Block the lowest page so an overflow faults rather than corrupting the heap
+    paging_map(kernel_desc(), stack, stack, 0);
+    task->kernel_stack = stack;
+
+    uint64_t* sp = (uint64_t*)(stack + PEACHOS_TASK_KERNEL_STACK_SIZE);
+    // Return address of task_entry(), never used but keeps the stack aligned as after a call
+    *--sp = 0;
+    *--sp = (uint64_t) task_entry;
+
+    // RBP, RBX, R12, R13, R14, R15
+    for (int i = 0; i < 6; i++)
+    {
+        *--sp = 0;
+    }
+
+    task->kernel_rsp = (uint64_t) sp;
+    return 0;
+}
+
+static void task_kernel_stack_free(struct task* task)
 {
-    task_list_remove(task);
+    if (!task->kernel_stack)
+    {
+        return;
+    }
+
+    // Give the guard page back to the heap
+    paging_map(kernel_desc(), task->kernel_stack, task->kernel_stack, PAGING_IS_WRITEABLE | PAGING_IS_PRESENT);
+    kfree(task->kernel_stack);
+    task->kernel_stack = NULL;
+}
 
-    // Finally free the task data
+static void task_release(struct task* task)
+{
+    task_kernel_stack_free(task);
     kfree(task);
+}
+
+int task_free(struct task *task)
+{
+    if (task->waitqueue)
+    {
+        waitqueue_remove(task->waitqueue, task);
+    }
+
+    if (task->sleep_timer)
+    {
+        ktimer_del(task->sleep_timer);
+        task->sleep_timer = NULL;
+    }
+
+    sched_dequeue(task);
+    fpu_task_free(task);
+
+    if (task == task_current())
+    {
+        // We are still running on its kernel stack, whoever runs next frees it
+        task->state = TASK_STATE_DEAD;
+        return 0;
+    }
+
+    if (task->on_cpu)
+    {
+        // Another thread of the same process running elsewhere, it cannot be in
+        // the kernel as we hold the lock. Its next interrupt switches it away.
+        task->state = TASK_STATE_DEAD;
+        smp_send_reschedule(task->cpu);
+        return 0;
+    }
+
+    task_release(task);
     return 0;
 }
 
-void task_next()
+void task_exit_if_dead()
+{
+    struct task* task = task_current();
+    if (task && task->state == TASK_STATE_DEAD)
+    {
+        task_next();
+    }
+}
+
+/**
+ * Runs on the next task right after every switch, finishing what could
+ * not be done on the stack of the previous one
+ */
+static void task_finish_switch()
+{
+    struct cpu* cpu = smp_cpu_current();
+    struct task* prev = cpu->previous_task;
+    cpu->previous_task = NULL;
+    if (!prev)
+    {
+        return;
+    }
+
+    // Other processors may pick it up now that we are off its stack
+    prev->on_cpu = false;
+    if (prev->state == TASK_STATE_DEAD)
+    {
+        task_release(prev);
+    }
+}
+
+/**
+ * Where every task starts, the first switch to a new task returns here on
+ * its fresh kernel stack. Drops to the entry point in task->registers, or
+ * calls the entry point of a kernel task.
+ */
+static void task_entry()
+{
+    task_finish_switch();
+    struct task* task = task_current();
+    if (task->kernel_entry)
+    {
+        task->kernel_entry(task->kernel_entry_arg);
+
+        // Returning ends a kernel task, whoever runs next frees its stack
+        task_free(task);
+        task_next();
+        panic("task_entry(): A dead kernel task was scheduled\n");
+    }
+
+    task_page();
+    task_return(&task->registers);
+}
+
+/**
+ * Switches the processor over to the next task, returns when the current
+ * task is switched back to. Always switches on the kernel page tables so
+ * the kernel code we come back to finds them loaded.
+ */
+static void task_switch_to(struct task* next)
+{
+    struct task* prev = task_current();
+    if (next == prev)
+    {
+        return;
+    }
+
+    kernel_page();
+
+    // The kernel lock stays with the processor, the next task takes over its depth
+    int lock_depth = smp_kernel_lock_depth();
+    task_switch(next);
+    task_context_switch(&prev->kernel_rsp, next->kernel_rsp);
+
+    // We are running again, possibly on another processor
+    smp_kernel_lock_set_depth(lock_depth);
+    task_finish_switch();
+}
+
+/**
+ * Picks what the processor runs next and prepares the processor for it
+ */
+static struct task* task_pick_next(struct cpu* cpu)
 {
     struct task* next_task = task_get_next();
     if (!next_task)
     {
-        panic("No more tasks!\n");
+        // Every task is blocked or there are none, halt until an interrupt
+        next_task = cpu->idle_task;
+    }
+
+    if (next_task == cpu->idle_task)
+    {
+        timer_idle_enter();
+    }
+    else
+    {
+        timer_idle_exit();
+    }
+
+    if (next_task->wake_tsc)
+    {
+        next_task->wake_latency = cpu_read_tsc() - next_task->wake_tsc;
+        next_task->wake_tsc = 0;
+    }
+
+    cpu->reschedule_requested = false;
+    return next_task;
+}
+
+void task_next()
+{
+    task_switch_to(task_pick_next(smp_cpu_current()));
+}
+
+void task_run(struct task* task)
+{
+    struct cpu* cpu = smp_cpu_current();
+    if (task->cpu != cpu && !task->on_cpu)
+    {
+        sched_dequeue(task);
+        task->cpu = cpu;
+        sched_enqueue(task);
+    }
+
+    timer_idle_exit();
+    task_switch_to(task);
+}
+
+void task_yield()
+{
+    struct task* task = task_current();
+    sched_dequeue(task);
+    sched_enqueue(task);
+    task_next();
+}
+
+void task_block(struct task* task)
+{
+    task->state = TASK_STATE_BLOCKED;
+    sched_dequeue(task);
+}
+
+void task_wake(struct task* task)
+{
+    if (task->state == TASK_STATE_RUNNABLE)
+    {
+        return;
+    }
+
+    task->state = TASK_STATE_RUNNABLE;
+    task->wake_tsc = cpu_read_tsc();
+
+    // The scheduler tells us which processor to kick, if any
+    struct cpu* cpu = sched_wake(task);
+    if (cpu)
+    {
+        smp_send_reschedule(cpu);
+    }
+}
+
+void task_tick()
+{
+    struct task* current_task = task_current();
+    if (!current_task || task_is_idle(current_task))
+    {
+        return;
+    }
+
+    if (sched_tick(current_task))
+    {
+        task_request_reschedule();
+    }
+}
+
+int task_set_nice(struct task* task, int nice)
+{
+    int res = sched_set_nice(task, nice);
+    if (res == 0)
+    {
+        // Somebody else may be more important now
+        smp_send_reschedule(task->cpu);
     }
 
-    task_switch(next_task);
-    task_return(&next_task->registers);
+    return res;
+}
+
+void task_request_reschedule()
+{
+    smp_cpu_current()->reschedule_requested = true;
+}
+
+void task_reschedule_if_requested()
+{
+    if (!smp_cpu_current()->reschedule_requested)
+    {
+        return;
+    }
+
+    task_next();
+}
+
+bool task_is_idle(struct task* task)
+{
+    return task->cpu && task == task->cpu->idle_task;
+}
+
+bool task_can_sleep()
+{
+    // Until the processor runs its first task the caller is boot code on the boot stack
+    struct cpu* cpu = smp_cpu_current();
+    return cpu->tasks_started && cpu->current_task && !task_is_idle(cpu->current_task);
 }
 
 int task_switch(struct task *task)
 {
-    current_task = task;
-    paging_switch(task->process->paging_desc);
+    struct cpu* cpu = smp_cpu_current();
+    struct task* prev = cpu->current_task;
+    if (prev && prev != task)
+    {
+        cpu->previous_task = prev;
+    }
+
+    task->on_cpu = true;
+    cpu->current_task = task;
+
+    // Interrupts from user land now arrive on the kernel stack of the task
+    cpu->tss.rsp0 = (uint64_t) task->kernel_stack + PEACHOS_TASK_KERNEL_STACK_SIZE;
+    fpu_task_switch(prev, task);
     return 0;
 }
 
 struct paging_desc* task_paging_desc(struct task* task)
 {
+    if (!task->process)
+    {
+        // Kernel tasks run on the kernel page tables
+        return kernel_desc();
+    }
+
     return task->process->paging_desc;
 }
 
 struct paging_desc* task_current_paging_desc()
 {
-    if (!current_task)
+    if (!task_current())
     {
         panic("NO task yet\n");
     }
 
-    return task_paging_desc(current_task);
+    return task_paging_desc(task_current());
 }
 
 
@@ -181,6 +547,14 @@ void task_save_state(struct task *task, struct interrupt_frame *frame)
     task->registers.rdi = frame->rdi;
     task->registers.rdx = frame->rdx;
     task->registers.rsi = frame->rsi;
+    task->registers.r8 = frame->r8;
+    task->registers.r9 = frame->r9;
+    task->registers.r10 = frame->r10;
+    task->registers.r11 = frame->r11;
+    task->registers.r12 = frame->r12;
+    task->registers.r13 = frame->r13;
+    task->registers.r14 = frame->r14;
+    task->registers.r15 = frame->r15;
 }
 int copy_string_from_task(struct task* task, void* virtual, void* phys, int max)
 {
@@ -241,7 +615,7 @@ void task_current_save_state(struct interrupt_frame *frame)
 int task_page()
 {
     user_registers();
-    task_switch(current_task);
+    paging_switch(task_current_paging_desc());
     return 0;
 }
 
@@ -254,13 +628,16 @@ int task_page_task(struct task* task)
 
 void task_run_first_ever_task()
 {
-    if (!current_task)
-    {
-        panic("task_run_first_ever_task(): No current task exists!\n");
-    }
-
-    task_switch(task_head);
-    task_return(&task_head->registers);
+    struct cpu* cpu = smp_cpu_current();
+    struct task* task = task_pick_next(cpu);
+
+    // The boot code is not a task, nothing needs to come back here
+    uint64_t boot_rsp = 0;
+    cpu->current_task = NULL;
+    cpu->tasks_started = true;
+    task_switch(task);
+    task_context_switch(&boot_rsp, task->kernel_rsp);
+    panic("task_run_first_ever_task(): Switched back to the boot stack\n");
 }
 
 int task_init(struct task *task, struct process *process)
@@ -277,6 +654,8 @@ int task_init(struct task *task, struct process *process)
     task->registers.cs = USER_CODE_SEGMENT;
     task->registers.rsp = PEACHOS_PROGRAM_VIRTUAL_STACK_ADDRESS_START;
     task->process = process;
+    task->state = TASK_STATE_RUNNABLE;
+    sched_task_init(task);
 
     return 0;
 }
@@ -301,4 +680,28 @@ void* task_get_stack_item(struct task* task, int index)
 void* task_virtual_address_to_physical(struct task* task, void* virtual_address)
 {
     return paging_get_physical_address(task->process->paging_desc, virtual_address);
-}
\ No newline at end of file
+}
+void task_idle_init()
+{
+    struct cpu* cpu = smp_cpu_current();
+    struct task* idle_task = kzalloc(sizeof(struct task));
+    if (!idle_task)
+    {
+        panic("Failed to allocate the idle task\n");
+    }
+
+    if (task_kernel_stack_new(idle_task) < 0)
+    {
+        panic("Failed to allocate the idle task stack\n");
+    }
+
+    // Runs in ring zero on the kernel page tables, it has no process.
+    // Being in ring zero its interrupts stay on its kernel stack.
+    idle_task->registers.ip = (uint64_t) task_idle_loop;
+    idle_task->registers.cs = KERNEL_LONG_MODE_CODE_SELECTOR;
+    idle_task->registers.ss = KERNEL_LONG_MODE_DATA_SELECTOR;
+    idle_task->registers.rsp = (uint64_t) idle_task->kernel_stack + PEACHOS_TASK_KERNEL_STACK_SIZE;
+    idle_task->state = TASK_STATE_RUNNABLE;
+    idle_task->cpu = cpu;
+    cpu->idle_task = idle_task;
+}
@@ -47,34 +47,150 @@ struct registers
     uint64_t flags;
     uint64_t rsp;
     uint64_t ss;
+
+    uint64_t r8;
+    uint64_t r9;
+    uint64_t r10;
+    uint64_t r11;
+    uint64_t r12;
+    uint64_t r13;
+    uint64_t r14;
+    uint64_t r15;
 };
 
 
+enum
+{
+    // The task can be picked by the scheduler
+    TASK_STATE_RUNNABLE,
+    // The task is waiting on a waitqueue and must not be scheduled
+    TASK_STATE_BLOCKED,
+    // The task has exited but may still be running on its kernel stack
+    TASK_STATE_DEAD
+};
+
+typedef int TASK_STATE;
+
+// Entry point of a kernel task, returning from it ends the task
+typedef void (*TASK_KERNEL_ENTRY)(void* arg);
+
 struct process;
+struct waitqueue;
+struct ktimer;
+struct cpu;
 struct task
 {
     // The registers of the task when the task is not running
     struct registers registers;
 
-    // The process of the task
+    // The process of the task, NULL for kernel tasks
     struct process* process;
 
-    // The next task in the linked list
+    // Index of the task in process->threads, zero for the main thread
+    int thread_id;
+
+    // Kernel tasks run this in ring zero instead of dropping to task->registers
+    TASK_KERNEL_ENTRY kernel_entry;
+    void* kernel_entry_arg;
+
+    // The next task in the same run queue level
     struct task* next;
 
-    // Previous task in the linked list
+    // Previous task in the same run queue level
     struct task* prev;
+
+    // True while the task is linked into the run queue
+    bool queued;
+
+    // The processor whose run queue the task is on, or last ran on while blocked
+    struct cpu* cpu;
+
+    // True while a processor is running the task, it must not migrate then
+    bool on_cpu;
+
+    // Nice level set by the user, -20 (most important) to 19
+    int nice;
+
+    // Interactivity bonus in priority levels, earned by sleeping and lost by using whole timeslices
+    int bonus;
+
+    // Effective priority and run queue level, zero is the most important
+    int priority;
+
+    // Ticks left before the task has to give up the CPU
+    int timeslice;
+
+    // The x87/SSE/AVX save area, NULL until the task first touches the FPU
+    void* fpu_state;
+
+    // The processor whose FPU registers were last loaded with our state
+    int fpu_cpu;
+
+    // RUNNABLE or BLOCKED
+    TASK_STATE state;
+
+    // The queue this task is blocked on, NULL when runnable
+    struct waitqueue* waitqueue;
+
+    // The next task waiting on the same waitqueue
+    struct task* wait_next;
+
+    // Physical address of the futex word while the task waits on a futex
+    uint64_t futex_key;
+
+    // The timer that wakes the task while it sleeps on the clock
+    struct ktimer* sleep_timer;
+
+    // Time stamp counter when the task was last woken, zero once it has run
+    uint64_t wake_tsc;
+
+    // Cycles between the last wake up and the task getting the CPU
+    uint64_t wake_latency;
+
+    // Lowest address of the kernel stack of the task, the first page is a guard page.
+    // Interrupts and system commands from user land run on this stack.
+    void* kernel_stack;
+
+    // Saved kernel stack pointer while the task is switched out
+    uint64_t kernel_rsp;
 };
 
 struct task* task_new(struct process* process);
+
+/**
+ * Creates another thread of the process, it starts in user land at entry
+ * with the given stack pointer and arg1, arg2 in RDI and RSI
+ */
+struct task* task_new_thread(struct process* process, uint64_t entry, uint64_t stack, uint64_t arg1, uint64_t arg2);
+
+/**
+ * Creates a task that runs entry(arg) in the kernel on the kernel page tables,
+ * it has no process. Kernel tasks are not preempted, they hold the kernel lock
+ * with interrupts off like a system command and must sleep or call task_yield()
+ * to let other tasks run.
+ */
+struct task* task_new_kernel(TASK_KERNEL_ENTRY entry, void* arg);
 struct task* task_current();
 struct task* task_get_next();
+/**
+ * Frees the task, or marks it dead when it is still running on a kernel
+ * stack in which case the processor frees it once it has switched away
+ */
 int task_free(struct task* task);
 
+/**
+ * Leaves the current task for good when it was freed by another processor
+ * while it was on its way into the kernel, call with the kernel lock held
+ */
+void task_exit_if_dead();
+
 int task_switch(struct task* task);
 int task_page();
 int task_page_task(struct task* task);
 
+/**
+ * Starts running tasks on the calling processor, never returns
+ */
 void task_run_first_ever_task();
 
 void task_return(struct registers* regs);
@@ -85,8 +201,74 @@ void task_current_save_state(struct interrupt_frame *frame);
 int copy_string_from_task(struct task* task, void* virtual, void* phys, int max);
 void* task_get_stack_item(struct task* task, int index);
 void* task_virtual_address_to_physical(struct task* task, void* virtual_address);
+/**
+ * Switches to the most important runnable task, or the idle task when there
+ * is none. Returns once the current task is picked again, which is never
+ * for a dead task.
+ */
 void task_next();
 
+/**
+ * Switches to the given task straight away, moving it to this processor.
+ * The current task stays runnable and returns from this call when it is
+ * next picked.
+ */
+void task_run(struct task* task);
+
+/**
+ * Moves the current task behind the others of the same priority and runs
+ * the next task, returns when the current task is picked again
+ */
+void task_yield();
+void task_wake(struct task* task);
+
+/**
+ * Marks the task blocked and takes it off the run queue
+ */
+void task_block(struct task* task);
+
+/**
+ * Charges the current task for a timer tick, ends its timeslice when used up
+ */
+void task_tick();
+
+/**
+ * Changes the nice level of the task
+ * \return Returns zero on success or a negative error code
+ */
+int task_set_nice(struct task* task, int nice);
+
+/**
+ * Asks for a task switch once the current interrupt has been handled
+ */
+void task_request_reschedule();
+
+/**
+ * Switches to the next task if a reschedule was requested, the state of the
+ * current task must already be saved. Does not return if a switch happens.
+ */
+void task_reschedule_if_requested();
+
+/**
+ * Creates the idle task of the calling processor, a ring zero task that halts
+ * the CPU until an interrupt arrives. It runs whenever no other task is runnable.
+ */
+void task_idle_init();
+bool task_is_idle(struct task* task);
+
+/**
+ * True when the caller runs on behalf of a task that may block, false
+ * for boot code and the idle task which must poll instead
+ */
+bool task_can_sleep();
+void task_idle_loop();
+
+/**
+ * Saves the callee saved registers and stack pointer of the running context
+ * into prev_rsp and continues the context saved at next_rsp
+ */
+void task_context_switch(uint64_t* prev_rsp, uint64_t next_rsp);
+
 struct paging_desc* task_paging_desc(struct task* task);
 struct paging_desc* task_current_paging_desc();
 #endif
\ No newline at end of file
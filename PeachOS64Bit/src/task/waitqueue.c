@@ -0,0 +1,142 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "waitqueue.h"
+#include "task.h"
+#include "kernel.h"
+
+void waitqueue_init(struct waitqueue* queue)
+{
+    queue->head = NULL;
+    queue->tail = NULL;
+}
+
+bool waitqueue_empty(struct waitqueue* queue)
+{
+    return queue->head == NULL;
+}
+
+void waitqueue_add(struct waitqueue* queue, struct task* task)
+{
+    if (task->waitqueue)
+    {
+        panic("waitqueue_add(): task is already waiting on a queue\n");
+    }
+
+    task->wait_next = NULL;
+    task->waitqueue = queue;
+    task_block(task);
+    if (!queue->tail)
+    {
+        queue->head = task;
+        queue->tail = task;
+        return;
+    }
+
+    queue->tail->wait_next = task;
+    queue->tail = task;
+}
+
+void waitqueue_remove(struct waitqueue* queue, struct task* task)
+{
+    struct task* prev = NULL;
+    struct task* current = queue->head;
+    while (current)
+    {
+        if (current == task)
+        {
+            if (prev)
+            {
+                prev->wait_next = current->wait_next;
+            }
+            else
+            {
+                queue->head = current->wait_next;
+            }
+
+            if (queue->tail == current)
+            {
+                queue->tail = prev;
+            }
+
+            task->wait_next = NULL;
+            task->waitqueue = NULL;
+            return;
+        }
+
+        prev = current;
+        current = current->wait_next;
+    }
+}
+
+void waitqueue_wait(struct waitqueue* queue)
+{
+    waitqueue_add(queue, task_current());
+    task_next();
+}
+
+static struct task* waitqueue_pop(struct waitqueue* queue)
+{
+    struct task* task = queue->head;
+    if (!task)
+    {
+        return NULL;
+    }
+
+    queue->head = task->wait_next;
+    if (!queue->head)
+    {
+        queue->tail = NULL;
+    }
+
+    task->wait_next = NULL;
+    task->waitqueue = NULL;
+    return task;
+}
+
+int waitqueue_wake_one(struct waitqueue* queue)
+{
+    struct task* task = waitqueue_pop(queue);
+    if (!task)
+    {
+        return 0;
+    }
+
+    task_wake(task);
+    return 1;
+}
+
+int waitqueue_wake_all(struct waitqueue* queue)
+{
+    int total = 0;
+    while (waitqueue_wake_one(queue))
+    {
+        total++;
+    }
+
+    return total;
+}
@@ -0,0 +1,79 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_WAITQUEUE_H
+#define KERNEL_WAITQUEUE_H
+
+#include <stdbool.h>
+
+struct task;
+
+/**
+ * A FIFO of tasks blocked waiting for some event, such as a key press.
+ * Tasks are linked through task->wait_next so queuing never allocates.
+ */
+struct waitqueue
+{
+    struct task* head;
+    struct task* tail;
+};
+
+void waitqueue_init(struct waitqueue* queue);
+bool waitqueue_empty(struct waitqueue* queue);
+
+/**
+ * Blocks the given task and appends it to the queue, the task will not be
+ * picked by the scheduler until it is woken.
+ */
+void waitqueue_add(struct waitqueue* queue, struct task* task);
+
+/**
+ * Removes the task from the queue it is waiting on without waking it,
+ * used when a blocked task is being freed.
+ */
+void waitqueue_remove(struct waitqueue* queue, struct task* task);
+
+/**
+ * Blocks the current task on the queue and switches to the next runnable task.
+ * Returns once the task is woken and scheduled again, the caller should check
+ * its condition again as another task may have got there first.
+ */
+void waitqueue_wait(struct waitqueue* queue);
+
+/**
+ * Makes the first waiting task runnable again
+ * \return Returns one if a task was woken, zero if the queue was empty
+ */
+int waitqueue_wake_one(struct waitqueue* queue);
+
+/**
+ * Makes every waiting task runnable again
+ * \return Returns the total number of woken tasks
+ */
+int waitqueue_wake_all(struct waitqueue* queue);
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "workqueue.h"
+#include "task.h"
+#include "kernel.h"
+#include "status.h"
+#include "memory/heap/kheap.h"
+#include "timer/timer.h"
+
+// The shared queue behind schedule_work()
+static struct workqueue* system_workqueue = NULL;
+
+void work_init(struct work* work, WORK_FUNCTION func)
+{
+    work->func = func;
+    work->next = NULL;
+    work->pending = false;
+}
+
+static void delayed_work_timer_expired(struct ktimer* timer)
+{
+    struct delayed_work* dwork = timer->data;
+    queue_work(dwork->workqueue, &dwork->work);
+}
+
+void delayed_work_init(struct delayed_work* dwork, WORK_FUNCTION func)
+{
+    work_init(&dwork->work, func);
+    dwork->workqueue = NULL;
+    ktimer_init(&dwork->timer, delayed_work_timer_expired, dwork);
+}
+
+struct delayed_work* to_delayed_work(struct work* work)
+{
+    // The work is the first member
+    return (struct delayed_work*) work;
+}
+
+/**
+ * Takes the first work item off the queue, the lock must be held
+ */
+static struct work* workqueue_pop(struct workqueue* workqueue)
+{
+    struct work* work = workqueue->head;
+    if (!work)
+    {
+        return NULL;
+    }
+
+    workqueue->head = work->next;
+    if (!workqueue->head)
+    {
+        workqueue->tail = NULL;
+    }
+
+    work->next = NULL;
+    return work;
+}
+
+/**
+ * The kernel task behind every workqueue, runs the queued work in order
+ * and sleeps while there is none
+ */
+static void workqueue_worker(void* arg)
+{
+    struct workqueue* workqueue = arg;
+    while (1)
+    {
+        uint64_t flags = spin_lock_irqsave(&workqueue->lock);
+        while (!workqueue->head)
+        {
+            waitqueue_add(&workqueue->worker_waiters, task_current());
+            spin_unlock_irqrestore(&workqueue->lock, flags);
+            task_next();
+            flags = spin_lock_irqsave(&workqueue->lock);
+        }
+
+        // Cleared first so the function may queue its own work again
+        struct work* work = workqueue_pop(workqueue);
+        work->pending = false;
+        spin_unlock_irqrestore(&workqueue->lock, flags);
+
+        work->func(work);
+
+        flags = spin_lock_irqsave(&workqueue->lock);
+        workqueue->completed++;
+        waitqueue_wake_all(&workqueue->flush_waiters);
+        spin_unlock_irqrestore(&workqueue->lock, flags);
+
+        // Nothing preempts kernel tasks, give the others a turn between items
+        task_yield();
+    }
+}
+
+struct workqueue* workqueue_create(const char* name)
+{
+    int res = 0;
+    struct workqueue* workqueue = kzalloc(sizeof(struct workqueue));
+    if (!workqueue)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    workqueue->name = name;
+    spinlock_init(&workqueue->lock, name);
+    waitqueue_init(&workqueue->worker_waiters);
+    waitqueue_init(&workqueue->flush_waiters);
+
+    struct task* worker = task_new_kernel(workqueue_worker, workqueue);
+    if (ISERR(worker))
+    {
+        res = ERROR_I(worker);
+        goto out;
+    }
+
+    workqueue->worker = worker;
+
+out:
+    if (res < 0)
+    {
+        if (workqueue)
+        {
+            kfree(workqueue);
+        }
+        return ERROR(res);
+    }
+
+    return workqueue;
+}
+
+bool queue_work(struct workqueue* workqueue, struct work* work)
+{
+    bool queued = false;
+    uint64_t flags = spin_lock_irqsave(&workqueue->lock);
+    if (work->pending)
+    {
+        goto out;
+    }
+
+    work->pending = true;
+    work->next = NULL;
+    if (workqueue->tail)
+    {
+        workqueue->tail->next = work;
+    }
+    else
+    {
+        workqueue->head = work;
+    }
+
+    workqueue->tail = work;
+    workqueue->queued++;
+    waitqueue_wake_one(&workqueue->worker_waiters);
+    queued = true;
+
+out:
+    spin_unlock_irqrestore(&workqueue->lock, flags);
+    return queued;
+}
+
+bool queue_delayed_work(struct workqueue* workqueue, struct delayed_work* dwork, uint64_t ticks)
+{
+    if (ticks == 0)
+    {
+        return queue_work(workqueue, &dwork->work);
+    }
+
+    if (dwork->work.pending || dwork->timer.pending)
+    {
+        return false;
+    }
+
+    dwork->workqueue = workqueue;
+    return ktimer_add(&dwork->timer, timer_ticks() + ticks);
+}
+
+void flush_workqueue(struct workqueue* workqueue)
+{
+    struct task* task = task_current();
+    if (task == workqueue->worker)
+    {
+        panic("flush_workqueue(): The worker would wait for itself\n");
+    }
+
+    uint64_t flags = spin_lock_irqsave(&workqueue->lock);
+    uint64_t target = workqueue->queued;
+    while (workqueue->completed < target)
+    {
+        waitqueue_add(&workqueue->flush_waiters, task);
+        spin_unlock_irqrestore(&workqueue->lock, flags);
+        task_next();
+        flags = spin_lock_irqsave(&workqueue->lock);
+    }
+    spin_unlock_irqrestore(&workqueue->lock, flags);
+}
+
+void workqueue_init()
+{
+    system_workqueue = workqueue_create("events");
+    if (ISERR(system_workqueue))
+    {
+        panic("Failed to create the system workqueue\n");
+    }
+}
+
+bool schedule_work(struct work* work)
+{
+    return queue_work(system_workqueue, work);
+}
+
+bool schedule_delayed_work(struct delayed_work* dwork, uint64_t ticks)
+{
+    return queue_delayed_work(system_workqueue, dwork, ticks);
+}
+
+void flush_scheduled_work()
+{
+    flush_workqueue(system_workqueue);
+}
@@ -0,0 +1,141 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_WORKQUEUE_H
+#define KERNEL_WORKQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lib/spinlock/spinlock.h"
+#include "task/waitqueue.h"
+#include "timer/ktimer.h"
+
+struct task;
+struct work;
+
+typedef void (*WORK_FUNCTION)(struct work* work);
+
+/**
+ * A function to call later from a kernel task. Embed it in the structure
+ * the function works on, queuing never allocates.
+ */
+struct work
+{
+    WORK_FUNCTION func;
+
+    // The next item on the same workqueue
+    struct work* next;
+
+    // True from queuing until the worker starts running the function
+    bool pending;
+};
+
+/**
+ * Work that is queued once a number of timer ticks have passed
+ */
+struct delayed_work
+{
+    struct work work;
+
+    // The queue the work goes on when the timer expires
+    struct workqueue* workqueue;
+
+    struct ktimer timer;
+};
+
+/**
+ * A FIFO of work items run one at a time by a dedicated kernel task.
+ * Interrupt handlers queue their slow work here so they return quickly.
+ */
+struct workqueue
+{
+    const char* name;
+
+    // Guards the list and the counters, taken from interrupt handlers
+    struct spinlock lock;
+    struct work* head;
+    struct work* tail;
+
+    // Work items queued and finished since creation, flushing waits for one to catch up with the other
+    uint64_t queued;
+    uint64_t completed;
+
+    // The worker sleeps here while the queue is empty
+    struct waitqueue worker_waiters;
+
+    // Tasks in flush_workqueue()
+    struct waitqueue flush_waiters;
+
+    struct task* worker;
+};
+
+/**
+ * Creates the workqueue and starts its worker task
+ * \return Returns the workqueue or an ERROR() pointer
+ */
+struct workqueue* workqueue_create(const char* name);
+
+void work_init(struct work* work, WORK_FUNCTION func);
+void delayed_work_init(struct delayed_work* dwork, WORK_FUNCTION func);
+
+/**
+ * Returns the delayed work a work function was handed
+ */
+struct delayed_work* to_delayed_work(struct work* work);
+
+/**
+ * Queues the work to run on the workqueue, safe to call from interrupt handlers
+ * \return Returns false when the work was already pending, it will still run only once
+ */
+bool queue_work(struct workqueue* workqueue, struct work* work);
+
+/**
+ * Queues the work once the given number of timer ticks have passed, zero queues it straight away
+ * \return Returns false when the work was already waiting on its timer or pending
+ */
+bool queue_delayed_work(struct workqueue* workqueue, struct delayed_work* dwork, uint64_t ticks);
+
+/**
+ * Sleeps until every work item queued before the call has finished running.
+ * Work still waiting on its timer is not waited for. Must not be called from
+ * the worker of the same queue.
+ */
+void flush_workqueue(struct workqueue* workqueue);
+
+/**
+ * Creates the system workqueue used by schedule_work()
+ */
+void workqueue_init();
+
+/**
+ * Queue work on the shared system workqueue, for short items that do not sleep for long
+ */
+bool schedule_work(struct work* work);
+bool schedule_delayed_work(struct delayed_work* dwork, uint64_t ticks);
+void flush_scheduled_work();
+
+#endif
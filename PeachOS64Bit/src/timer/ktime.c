@@ -0,0 +1,113 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "ktime.h"
+#include <stdbool.h>
+#include "timer.h"
+#include "config.h"
+#include "kernel.h"
+#include "status.h"
+#include "cpu/cpu.h"
+#include "string/string.h"
+
+static uint64_t ktime_tsc_base = 0;
+static uint64_t ktime_tsc_khz_value = 0;
+
+// Nanoseconds per cycle as a fixed point number with KTIME_SHIFT fraction bits
+static uint64_t ktime_mult = 0;
+
+void ktime_init()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+    bool invariant = false;
+    if (eax >= 0x80000007)
+    {
+        cpu_cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx);
+        invariant = edx & CPUID_APM_EDX_INVARIANT_TSC;
+    }
+
+    if (!invariant)
+    {
+        print("The TSC is not invariant, the clock drifts if the CPU changes speed\n");
+    }
+
+    uint64_t start = cpu_read_tsc();
+    timer_pit_delay_us(KTIME_CALIBRATION_US);
+    uint64_t cycles = cpu_read_tsc() - start;
+
+    ktime_tsc_khz_value = cycles / (KTIME_CALIBRATION_US / 1000);
+    if (ktime_tsc_khz_value == 0)
+    {
+        panic("ktime_init(): The TSC is not counting\n");
+    }
+
+    ktime_mult = (1000000ULL << KTIME_SHIFT) / ktime_tsc_khz_value;
+    ktime_tsc_base = start;
+
+    print("TSC MHz: ");
+    print(itoa(ktime_tsc_khz_value / 1000));
+    print("\n");
+}
+
+uint64_t ktime_tsc_khz()
+{
+    return ktime_tsc_khz_value;
+}
+
+uint64_t ktime_cycles_to_ns(uint64_t cycles)
+{
+    // The product needs more than 64 bits after a few hours of uptime
+    return (uint64_t)(((unsigned __int128) cycles * ktime_mult) >> KTIME_SHIFT);
+}
+
+uint64_t ktime_get_ns()
+{
+    return ktime_cycles_to_ns(cpu_read_tsc() - ktime_tsc_base);
+}
+
+uint64_t ktime_ns_to_ticks(uint64_t ns)
+{
+    uint64_t ns_per_tick = KTIME_NS_PER_SECOND / PEACHOS_TIMER_HZ;
+    return (ns + ns_per_tick - 1) / ns_per_tick;
+}
+
+void ktime_ns_to_timespec(uint64_t ns, struct timespec* ts)
+{
+    ts->tv_sec = ns / KTIME_NS_PER_SECOND;
+    ts->tv_nsec = ns % KTIME_NS_PER_SECOND;
+}
+
+int64_t ktime_timespec_to_ns(struct timespec* ts)
+{
+    if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= (int64_t) KTIME_NS_PER_SECOND)
+    {
+        return -EINVARG;
+    }
+
+    return ts->tv_sec * KTIME_NS_PER_SECOND + ts->tv_nsec;
+}
@@ -0,0 +1,82 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_KTIME_H
+#define KERNEL_KTIME_H
+
+#include <stdint.h>
+
+// How long the time stamp counter is measured against the PIT at boot
+#define KTIME_CALIBRATION_US 50000
+
+// Fraction bits of the cycles to nanoseconds multiplier
+#define KTIME_SHIFT 32
+
+#define KTIME_NS_PER_SECOND 1000000000ULL
+
+// The clocks of clock_gettime(), only the monotonic clock exists as there is no wall clock yet
+#define KTIME_CLOCK_MONOTONIC 1
+
+// CPUID 0x80000007 EDX, the TSC runs at a constant rate in every power state
+#define CPUID_APM_EDX_INVARIANT_TSC (1 << 8)
+
+// Keep in sync with the stdlib
+struct timespec
+{
+    int64_t tv_sec;
+    int64_t tv_nsec;
+};
+
+/**
+ * Calibrates the time stamp counter against PIT channel two, the
+ * monotonic clock starts at zero here. Every processor is assumed to
+ * have its TSC in step with the bootstrap processor.
+ */
+void ktime_init();
+
+/**
+ * Nanoseconds since ktime_init(), read straight from the TSC so it is
+ * cheap and has cycle resolution. It keeps counting while the tick is stopped.
+ */
+uint64_t ktime_get_ns();
+
+uint64_t ktime_tsc_khz();
+uint64_t ktime_cycles_to_ns(uint64_t cycles);
+
+/**
+ * Returns the number of timer ticks covering the duration, rounded up
+ */
+uint64_t ktime_ns_to_ticks(uint64_t ns);
+
+void ktime_ns_to_timespec(uint64_t ns, struct timespec* ts);
+
+/**
+ * \return Returns the nanoseconds or a negative error code when the timespec is invalid
+ */
+int64_t ktime_timespec_to_ns(struct timespec* ts);
+
+#endif
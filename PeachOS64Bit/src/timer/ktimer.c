@@ -0,0 +1,216 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "ktimer.h"
+#include "timer.h"
+#include "kernel.h"
+#include "task/task.h"
+#include "lib/spinlock/spinlock.h"
+
+static struct ktimer* ktimer_wheel[KTIMER_WHEEL_SLOTS];
+
+// The last tick whose slot has been run, timers are never added at or before it
+static uint64_t ktimer_last_run = 0;
+
+// Guards the wheel, timers are added from any processor and fired from the timer interrupt
+static struct spinlock ktimer_lock;
+
+void ktimer_system_init()
+{
+    spinlock_init(&ktimer_lock, "timers");
+}
+
+void ktimer_init(struct ktimer* timer, KTIMER_FUNCTION func, void* data)
+{
+    timer->func = func;
+    timer->data = data;
+    timer->expires = 0;
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->pending = false;
+}
+
+static struct ktimer** ktimer_slot(uint64_t tick)
+{
+    return &ktimer_wheel[tick & (KTIMER_WHEEL_SLOTS - 1)];
+}
+
+/**
+ * Takes the timer off its slot, the wheel lock must be held
+ */
+static void ktimer_unlink_locked(struct ktimer* timer)
+{
+    if (timer->prev)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        *ktimer_slot(timer->expires) = timer->next;
+    }
+
+    if (timer->next)
+    {
+        timer->next->prev = timer->prev;
+    }
+
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->pending = false;
+}
+
+bool ktimer_add(struct ktimer* timer, uint64_t expires)
+{
+    uint64_t flags = spin_lock_irqsave(&ktimer_lock);
+    if (timer->pending)
+    {
+        spin_unlock_irqrestore(&ktimer_lock, flags);
+        return false;
+    }
+
+    if (expires <= ktimer_last_run)
+    {
+        // That slot has been run already
+        expires = ktimer_last_run + 1;
+    }
+
+    struct ktimer** slot = ktimer_slot(expires);
+    timer->expires = expires;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot)
+    {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+    timer->pending = true;
+    spin_unlock_irqrestore(&ktimer_lock, flags);
+
+    // The clock may be stopped for idle with a later one shot armed
+    timer_event_added();
+    return true;
+}
+
+bool ktimer_del(struct ktimer* timer)
+{
+    bool removed = false;
+    uint64_t flags = spin_lock_irqsave(&ktimer_lock);
+    if (timer->pending)
+    {
+        ktimer_unlink_locked(timer);
+        removed = true;
+    }
+    spin_unlock_irqrestore(&ktimer_lock, flags);
+    return removed;
+}
+
+void ktimer_run(uint64_t now)
+{
+    // Collect the due timers first, their functions may add timers again
+    struct ktimer* expired = NULL;
+    uint64_t flags = spin_lock_irqsave(&ktimer_lock);
+    uint64_t ticks = now > ktimer_last_run ? now - ktimer_last_run : 0;
+    if (ticks > KTIMER_WHEEL_SLOTS)
+    {
+        // Every slot gets a look once, no need to go round twice
+        ticks = KTIMER_WHEEL_SLOTS;
+    }
+
+    for (uint64_t i = 1; i <= ticks; i++)
+    {
+        struct ktimer* timer = *ktimer_slot(ktimer_last_run + i);
+        while (timer)
+        {
+            struct ktimer* next = timer->next;
+            if (timer->expires <= now)
+            {
+                ktimer_unlink_locked(timer);
+                timer->next = expired;
+                expired = timer;
+            }
+            timer = next;
+        }
+    }
+
+    if (now > ktimer_last_run)
+    {
+        ktimer_last_run = now;
+    }
+    spin_unlock_irqrestore(&ktimer_lock, flags);
+
+    while (expired)
+    {
+        struct ktimer* timer = expired;
+        expired = timer->next;
+        timer->next = NULL;
+        timer->func(timer);
+    }
+}
+
+uint64_t ktimer_next_expiry()
+{
+    uint64_t next = TIMER_NO_EVENT;
+    uint64_t flags = spin_lock_irqsave(&ktimer_lock);
+    for (int i = 0; i < KTIMER_WHEEL_SLOTS; i++)
+    {
+        for (struct ktimer* timer = ktimer_wheel[i]; timer; timer = timer->next)
+        {
+            if (next == TIMER_NO_EVENT || timer->expires < next)
+            {
+                next = timer->expires;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&ktimer_lock, flags);
+    return next;
+}
+
+static void ktimer_sleep_wake(struct ktimer* timer)
+{
+    task_wake(timer->data);
+}
+
+void ktimer_sleep(uint64_t ticks)
+{
+    struct task* task = task_current();
+    if (!task || task_is_idle(task))
+    {
+        panic("ktimer_sleep(): There is no task to put to sleep\n");
+    }
+
+    // The timer lives on our kernel stack, task_free() takes it off the wheel if we are killed
+    struct ktimer timer;
+    ktimer_init(&timer, ktimer_sleep_wake, task);
+    task->sleep_timer = &timer;
+    task_block(task);
+    ktimer_add(&timer, timer_ticks() + ticks);
+    task_next();
+
+    // Nothing else wakes a sleeper today, but the timer must never outlive this frame
+    ktimer_del(&timer);
+    task->sleep_timer = NULL;
+}
@@ -0,0 +1,93 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_KTIMER_H
+#define KERNEL_KTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Slots of the timer wheel, one tick each, must be a power of two
+#define KTIMER_WHEEL_SLOTS 256
+
+struct ktimer;
+typedef void (*KTIMER_FUNCTION)(struct ktimer* timer);
+
+/**
+ * A function to call from the timer interrupt once the tick count reaches
+ * expires. Timers hang off a hashed wheel indexed by their expiry tick, so
+ * adding, removing and firing one is constant time whatever the number of
+ * pending timers. Timers further out than the wheel stay in their slot until
+ * the wheel has come round enough times.
+ */
+struct ktimer
+{
+    KTIMER_FUNCTION func;
+    void* data;
+
+    // The tick the timer fires at
+    uint64_t expires;
+
+    // Neighbours in the same wheel slot
+    struct ktimer* next;
+    struct ktimer* prev;
+
+    // True while the timer is on the wheel
+    bool pending;
+};
+
+void ktimer_system_init();
+void ktimer_init(struct ktimer* timer, KTIMER_FUNCTION func, void* data);
+
+/**
+ * Arms the timer to fire at the given tick, a tick already passed fires on the next one
+ * \return Returns false when the timer was already pending, it keeps its old expiry then
+ */
+bool ktimer_add(struct ktimer* timer, uint64_t expires);
+
+/**
+ * \return Returns true when the timer was pending and will now not fire
+ */
+bool ktimer_del(struct ktimer* timer);
+
+/**
+ * Fires every timer due by the given tick, called from the timer interrupt
+ */
+void ktimer_run(uint64_t now);
+
+/**
+ * Returns the tick of the earliest pending timer, TIMER_NO_EVENT when there is none.
+ * Walks the whole wheel, only used when the tick is about to stop for idle.
+ */
+uint64_t ktimer_next_expiry();
+
+/**
+ * Blocks the current task for the given number of ticks
+ */
+void ktimer_sleep(uint64_t ticks);
+
+#endif
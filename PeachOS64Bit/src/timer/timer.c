@@ -0,0 +1,260 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "timer.h"
+#include "config.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "idt/irq.h"
+#include "task/task.h"
+#include "timer/ktimer.h"
+#include "smp/smp.h"
+#include "apic/lapic.h"
+
+// Ticks since boot, advanced by the periodic tick and by one shot expiries
+static uint64_t timer_jiffies = 0;
+
+// True while the periodic tick is stopped because the system is idle
+static bool timer_tick_stopped = false;
+
+// Ticks covered by the armed one shot, zero when none is armed
+static uint64_t timer_oneshot_ticks = 0;
+
+static uint64_t timer_oneshot_elapsed();
+
+uint64_t timer_ticks()
+{
+    return timer_jiffies + timer_oneshot_elapsed();
+}
+
+static void timer_pit_program(uint8_t command, uint16_t count)
+{
+    outb(TIMER_PIT_COMMAND_PORT, command);
+    outb(TIMER_PIT_CHANNEL0_PORT, count & 0xFF);
+    outb(TIMER_PIT_CHANNEL0_PORT, (count >> 8) & 0xFF);
+}
+
+static uint16_t timer_pit_read_count()
+{
+    outb(TIMER_PIT_COMMAND_PORT, TIMER_PIT_COMMAND_LATCH);
+    uint16_t low = insb(TIMER_PIT_CHANNEL0_PORT);
+    uint16_t high = insb(TIMER_PIT_CHANNEL0_PORT);
+    return (high << 8) | low;
+}
+
+void timer_pit_delay_us(uint32_t us)
+{
+    uint64_t counts = ((uint64_t) us * TIMER_PIT_FREQUENCY) / 1000000;
+
+    // Gate channel two on but keep it away from the speaker
+    uint8_t control = insb(TIMER_PIT_CONTROL_PORT);
+    outb(TIMER_PIT_CONTROL_PORT, (control & ~TIMER_PIT_CONTROL_SPEAKER) | TIMER_PIT_CONTROL_GATE2);
+    while (counts)
+    {
+        uint16_t chunk = counts > TIMER_PIT_MAX_COUNT ? TIMER_PIT_MAX_COUNT : counts;
+        outb(TIMER_PIT_COMMAND_PORT, TIMER_PIT_COMMAND_CHANNEL2_ONESHOT);
+        outb(TIMER_PIT_CHANNEL2_PORT, chunk & 0xFF);
+        outb(TIMER_PIT_CHANNEL2_PORT, (chunk >> 8) & 0xFF);
+
+        // Reloading the count restarts the channel, its output goes high at terminal count
+        while (!(insb(TIMER_PIT_CONTROL_PORT) & TIMER_PIT_CONTROL_OUT2))
+        {
+        }
+
+        counts -= chunk;
+    }
+
+    outb(TIMER_PIT_CONTROL_PORT, control);
+}
+
+static uint16_t timer_pit_count_per_tick()
+{
+    return TIMER_PIT_FREQUENCY / PEACHOS_TIMER_HZ;
+}
+
+/**
+ * Returns the whole ticks of the armed one shot that have already passed,
+ * the jiffies only catch up when it expires or the idle period ends
+ */
+static uint64_t timer_oneshot_elapsed()
+{
+    if (!timer_oneshot_ticks)
+    {
+        return 0;
+    }
+
+    uint64_t programmed = timer_oneshot_ticks * timer_pit_count_per_tick();
+    uint64_t remaining = timer_pit_read_count();
+    if (remaining >= programmed)
+    {
+        return 0;
+    }
+
+    return (programmed - remaining) / timer_pit_count_per_tick();
+}
+
+/**
+ * Returns the tick at which the earliest timer event is due,
+ * or TIMER_NO_EVENT when nothing is waiting on the clock.
+ */
+static uint64_t timer_next_event()
+{
+    return ktimer_next_expiry();
+}
+
+static void timer_start_periodic()
+{
+    timer_oneshot_ticks = 0;
+    timer_tick_stopped = false;
+    timer_pit_program(TIMER_PIT_COMMAND_PERIODIC, timer_pit_count_per_tick());
+    IRQ_enable(IRQ_TIMER);
+}
+
+/**
+ * Arms a one shot for the next timer event, or leaves the timer
+ * completely silent when there is none.
+ */
+static void timer_program_oneshot()
+{
+    uint64_t deadline = timer_next_event();
+    if (deadline == TIMER_NO_EVENT)
+    {
+        // Nothing to wake up for, only a device interrupt can end the idle period
+        timer_oneshot_ticks = 0;
+        IRQ_disable(IRQ_TIMER);
+        return;
+    }
+
+    uint64_t ticks = 1;
+    if (deadline > timer_jiffies)
+    {
+        ticks = deadline - timer_jiffies;
+    }
+
+    // The counter is only 16 bits, far events take several one shots to reach
+    uint64_t max_ticks = TIMER_PIT_MAX_COUNT / timer_pit_count_per_tick();
+    if (ticks > max_ticks)
+    {
+        ticks = max_ticks;
+    }
+
+    timer_oneshot_ticks = ticks;
+    timer_pit_program(TIMER_PIT_COMMAND_ONESHOT, ticks * timer_pit_count_per_tick());
+    IRQ_enable(IRQ_TIMER);
+}
+
+void timer_idle_enter()
+{
+    struct cpu* cpu = smp_cpu_current();
+    if (!smp_cpu_is_bsp(cpu))
+    {
+        // Application processors only tick for the scheduler, nothing to wake up for
+        if (!cpu->tick_stopped)
+        {
+            cpu->tick_stopped = true;
+            lapic_timer_stop();
+        }
+        return;
+    }
+
+    if (timer_tick_stopped)
+    {
+        return;
+    }
+
+    timer_tick_stopped = true;
+    timer_program_oneshot();
+}
+
+void timer_idle_exit()
+{
+    struct cpu* cpu = smp_cpu_current();
+    if (!smp_cpu_is_bsp(cpu))
+    {
+        if (cpu->tick_stopped)
+        {
+            cpu->tick_stopped = false;
+            lapic_timer_start_periodic();
+        }
+        return;
+    }
+
+    if (!timer_tick_stopped)
+    {
+        return;
+    }
+
+    // Woken early by another interrupt, account for the part of the one shot that passed
+    timer_jiffies += timer_oneshot_elapsed();
+    timer_start_periodic();
+}
+
+void timer_event_added()
+{
+    if (!timer_tick_stopped)
+    {
+        // The periodic tick will see it
+        return;
+    }
+
+    timer_jiffies += timer_oneshot_elapsed();
+    timer_program_oneshot();
+}
+
+static void timer_interrupt_handler(struct interrupt_frame* frame)
+{
+    if (!timer_tick_stopped)
+    {
+        timer_jiffies++;
+        ktimer_run(timer_jiffies);
+        task_tick();
+        return;
+    }
+
+    // A one shot expired while idle
+    timer_jiffies += timer_oneshot_ticks;
+    timer_oneshot_ticks = 0;
+    ktimer_run(timer_jiffies);
+    timer_program_oneshot();
+    task_request_reschedule();
+}
+
+/**
+ * The local APIC timer of an application processor, the bootstrap
+ * processor keeps the PIT which also advances the jiffies
+ */
+static void timer_lapic_interrupt_handler(struct interrupt_frame* frame)
+{
+    task_tick();
+}
+
+void timer_init()
+{
+    idt_register_interrupt_callback(TIMER_INTERRUPT, timer_interrupt_handler);
+    idt_register_interrupt_callback(LAPIC_TIMER_VECTOR, timer_lapic_interrupt_handler);
+    timer_start_periodic();
+}
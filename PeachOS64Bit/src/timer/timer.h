@@ -0,0 +1,97 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_TIMER_H
+#define KERNEL_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// IRQ0 after the PIC remap
+#define TIMER_INTERRUPT 0x20
+
+// The programmable interval timer (8253/8254) runs from a fixed 1.193182 MHz clock
+#define TIMER_PIT_FREQUENCY 1193182
+#define TIMER_PIT_CHANNEL0_PORT 0x40
+#define TIMER_PIT_CHANNEL2_PORT 0x42
+#define TIMER_PIT_COMMAND_PORT 0x43
+
+// Keyboard controller port B, gates channel two and reads back its output
+#define TIMER_PIT_CONTROL_PORT 0x61
+#define TIMER_PIT_CONTROL_GATE2 0x01
+#define TIMER_PIT_CONTROL_SPEAKER 0x02
+#define TIMER_PIT_CONTROL_OUT2 0x20
+
+// Channel zero, lobyte/hibyte access, binary counting
+#define TIMER_PIT_COMMAND_ONESHOT 0x30      // Mode 0, interrupt on terminal count
+#define TIMER_PIT_COMMAND_PERIODIC 0x34     // Mode 2, rate generator
+#define TIMER_PIT_COMMAND_LATCH 0x00        // Latch the channel zero count for reading
+#define TIMER_PIT_COMMAND_CHANNEL2_ONESHOT 0xB0 // Channel two, mode 0, used for busy wait delays
+
+// The largest count the 16 bit PIT counter can be loaded with
+#define TIMER_PIT_MAX_COUNT 0xFFFF
+
+// Returned by timer_next_event() when nothing is waiting on the clock
+#define TIMER_NO_EVENT 0
+
+/**
+ * Starts the periodic scheduler tick at PEACHOS_TIMER_HZ
+ */
+void timer_init();
+
+/**
+ * Returns the number of ticks since boot. The tick does not fire while
+ * the system is idle with no timer events pending, so this only counts
+ * time the system was busy or waiting on a timer event such as delayed work.
+ */
+uint64_t timer_ticks();
+
+/**
+ * Busy waits for the given number of microseconds on PIT channel two,
+ * leaves channel zero and the scheduler tick untouched. Used to calibrate
+ * other clocks and for the processor start up delays.
+ */
+void timer_pit_delay_us(uint32_t us);
+
+/**
+ * Called when the scheduler switches to the idle task. Stops the periodic tick
+ * and programs a one shot interrupt for the next timer event, if there is one.
+ */
+void timer_idle_enter();
+
+/**
+ * Called when the scheduler leaves the idle task, restarts the periodic tick
+ */
+void timer_idle_exit();
+
+/**
+ * Called when a timer event was added, re-arms the one shot in case the
+ * new event is due before it while the tick is stopped
+ */
+void timer_event_added();
+
+#endif
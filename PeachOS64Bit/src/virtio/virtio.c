@@ -0,0 +1,287 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#include "virtio.h"
+#include "kernel.h"
+#include "status.h"
+#include "pci/pci.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+
+int virtio_device_init(struct virtio_device* device, struct pci_device* pci)
+{
+    memset(device, 0, sizeof(struct virtio_device));
+    device->pci = pci;
+
+    // The first capability of each type is the one to use
+    for (uint8_t cap = pci_next_capability(pci, PCI_CAPABILITY_VENDOR, 0); cap; cap = pci_next_capability(pci, PCI_CAPABILITY_VENDOR, cap))
+    {
+        uint8_t type = pci_config_read8(pci, cap + VIRTIO_PCI_CAP_CFG_TYPE);
+        uint8_t bar = pci_config_read8(pci, cap + VIRTIO_PCI_CAP_BAR);
+        uint32_t offset = pci_config_read32(pci, cap + VIRTIO_PCI_CAP_OFFSET);
+        uint32_t length = pci_config_read32(pci, cap + VIRTIO_PCI_CAP_LENGTH);
+        if (type == VIRTIO_PCI_CAP_COMMON_CFG && !device->common)
+        {
+            device->common = (volatile struct virtio_pci_common_cfg*) pci_map_bar(pci, bar, offset, length);
+        }
+        else if (type == VIRTIO_PCI_CAP_NOTIFY_CFG && !device->notify_base)
+        {
+            device->notify_base = pci_map_bar(pci, bar, offset, length);
+            device->notify_multiplier = pci_config_read32(pci, cap + VIRTIO_PCI_CAP_NOTIFY_MULTIPLIER);
+        }
+        else if (type == VIRTIO_PCI_CAP_ISR_CFG && !device->isr)
+        {
+            device->isr = (volatile uint8_t*) pci_map_bar(pci, bar, offset, length);
+        }
+        else if (type == VIRTIO_PCI_CAP_DEVICE_CFG && !device->device_cfg)
+        {
+            device->device_cfg = pci_map_bar(pci, bar, offset, length);
+        }
+    }
+
+    if (!device->common || !device->notify_base)
+    {
+        return -ENOTFOUND;
+    }
+
+    pci_enable(pci, PCI_COMMAND_MEMORY_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    // Writing zero resets the device, it reads back zero once the reset is done
+    device->common->device_status = 0;
+    while (device->common->device_status != 0)
+    {
+        __builtin_ia32_pause();
+    }
+
+    device->common->device_status = VIRTIO_STATUS_ACKNOWLEDGE;
+    device->common->device_status |= VIRTIO_STATUS_DRIVER;
+    return 0;
+}
+
+int virtio_negotiate(struct virtio_device* device, uint64_t wanted)
+{
+    volatile struct virtio_pci_common_cfg* common = device->common;
+    common->device_feature_select = 0;
+    uint64_t offered = common->device_feature;
+    common->device_feature_select = 1;
+    offered |= (uint64_t) common->device_feature << 32;
+    if (!(offered & VIRTIO_F_VERSION_1))
+    {
+        // A legacy only device, its layout is not the one we speak
+        virtio_device_failed(device);
+        return -EIO;
+    }
+
+    device->features = offered & (wanted | VIRTIO_F_VERSION_1);
+    common->driver_feature_select = 0;
+    common->driver_feature = device->features;
+    common->driver_feature_select = 1;
+    common->driver_feature = device->features >> 32;
+
+    common->device_status |= VIRTIO_STATUS_FEATURES_OK;
+    if (!(common->device_status & VIRTIO_STATUS_FEATURES_OK))
+    {
+        virtio_device_failed(device);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+int virtqueue_init(struct virtio_device* device, struct virtqueue* queue, int index, uint16_t max_size, uint16_t msix_entry)
+{
+    volatile struct virtio_pci_common_cfg* common = device->common;
+    common->queue_select = index;
+    uint16_t size = common->queue_size;
+    if (size == 0)
+    {
+        return -ENOTFOUND;
+    }
+
+    if (size > max_size)
+    {
+        size = max_size;
+    }
+
+    if (size > VIRTQUEUE_MAX_SIZE)
+    {
+        size = VIRTQUEUE_MAX_SIZE;
+    }
+
+    // A split queue is a power of two long, keep the highest bit
+    while (size & (size - 1))
+    {
+        size &= size - 1;
+    }
+
+    memset(queue, 0, sizeof(struct virtqueue));
+    queue->desc = kzalloc(PAGING_PAGE_SIZE);
+    queue->avail = kzalloc(PAGING_PAGE_SIZE);
+    queue->used = kzalloc(PAGING_PAGE_SIZE);
+    if (!queue->desc || !queue->avail || !queue->used)
+    {
+        return -ENOMEM;
+    }
+
+    queue->index = index;
+    queue->size = size;
+    queue->event_idx = device->features & VIRTIO_F_EVENT_IDX;
+
+    uint64_t desc = (uint64_t) paging_get_physical_address(kernel_desc(), queue->desc);
+    uint64_t avail = (uint64_t) paging_get_physical_address(kernel_desc(), queue->avail);
+    uint64_t used = (uint64_t) paging_get_physical_address(kernel_desc(), (void*) queue->used);
+    common->queue_size = size;
+    common->queue_desc_low = desc;
+    common->queue_desc_high = desc >> 32;
+    common->queue_driver_low = avail;
+    common->queue_driver_high = avail >> 32;
+    common->queue_device_low = used;
+    common->queue_device_high = used >> 32;
+
+    // The device answers with VIRTIO_MSI_NO_VECTOR when it could not take the entry
+    common->queue_msix_vector = msix_entry;
+    queue->msix_entry = common->queue_msix_vector;
+
+    queue->notify = (volatile uint16_t*)(device->notify_base + common->queue_notify_off * device->notify_multiplier);
+    common->queue_enable = 1;
+    return 0;
+}
+
+void virtio_device_ready(struct virtio_device* device)
+{
+    device->common->device_status |= VIRTIO_STATUS_DRIVER_OK;
+}
+
+void virtio_device_failed(struct virtio_device* device)
+{
+    device->common->device_status |= VIRTIO_STATUS_FAILED;
+}
+
+/**
+ * The used_event word at the end of the driver area, the device interrupts once it passes it
+ */
+static volatile uint16_t* virtqueue_used_event(struct virtqueue* queue)
+{
+    return &queue->avail->ring[queue->size];
+}
+
+/**
+ * The avail_event word at the end of the device area, the device wants a notification once we pass it
+ */
+static volatile uint16_t* virtqueue_avail_event(struct virtqueue* queue)
+{
+    return (volatile uint16_t*) &queue->used->ring[queue->size];
+}
+
+/**
+ * True when moving the index from old to new went past the event index
+ */
+static bool virtqueue_need_event(uint16_t event, uint16_t new, uint16_t old)
+{
+    return (uint16_t)(new - event - 1) < (uint16_t)(new - old);
+}
+
+void virtqueue_publish(struct virtqueue* queue, uint16_t head)
+{
+    queue->avail->ring[queue->avail_idx % queue->size] = head;
+    queue->avail_idx++;
+
+    // The entry must be seen before the index that hands it over
+    __sync_synchronize();
+    queue->avail->idx = queue->avail_idx;
+}
+
+void virtqueue_kick(struct virtqueue* queue)
+{
+    uint16_t old = queue->kicked_idx;
+    uint16_t new = queue->avail_idx;
+    if (old == new)
+    {
+        return;
+    }
+
+    queue->kicked_idx = new;
+
+    // The device must see the new index before we read what it asked for
+    __sync_synchronize();
+    bool needed = false;
+    if (queue->event_idx)
+    {
+        needed = virtqueue_need_event(*virtqueue_avail_event(queue), new, old);
+    }
+    else
+    {
+        needed = !(queue->used->flags & VIRTQ_USED_F_NO_NOTIFY);
+    }
+
+    if (needed)
+    {
+        *queue->notify = queue->index;
+    }
+}
+
+bool virtqueue_pop_used(struct virtqueue* queue, uint16_t* head_out, uint32_t* length_out)
+{
+    if (queue->used->idx == queue->last_used_idx)
+    {
+        return false;
+    }
+
+    // The element is only read after the index that covers it
+    __sync_synchronize();
+    volatile struct virtq_used_elem* elem = &queue->used->ring[queue->last_used_idx % queue->size];
+    *head_out = elem->id;
+    *length_out = elem->length;
+    queue->last_used_idx++;
+    return true;
+}
+
+bool virtqueue_enable_interrupts(struct virtqueue* queue)
+{
+    if (queue->event_idx)
+    {
+        *virtqueue_used_event(queue) = queue->last_used_idx;
+    }
+    else
+    {
+        queue->avail->flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
+
+    // The device may have used an entry before it saw the request
+    __sync_synchronize();
+    return queue->used->idx == queue->last_used_idx;
+}
+
+void virtqueue_disable_interrupts(struct virtqueue* queue)
+{
+    // With event indexes the used event is left behind, the device stays quiet until it is moved again
+    if (!queue->event_idx)
+    {
+        queue->avail->flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
+}
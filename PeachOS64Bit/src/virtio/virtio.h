@@ -0,0 +1,237 @@
+/*
+ * PeachOS 64-Bit Kernel Project
+ * Copyright (C) 2026 Daniel McCarthy <daniel@dragonzap.com>
+ *
+ * This file is part of the PeachOS 64-Bit Kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ *
+ * For full source code, documentation, and structured learning,
+ * see the official kernel development course part one:
+ * https://dragonzap.com/course/developing-a-multithreaded-kernel-from-scratch
+
+ * Get part one and part two module one, module two all peachos courses (69 hours of content): https://dragonzap.com/offer/kernel-development-from-scratch-69-hours
+
+ * Get the part two, module one and two modules: https://dragonzap.com/offer/developing-a-multithreaded-kernel-from-scratch-part-two-full-series
+ */
+
+#ifndef KERNEL_VIRTIO_H
+#define KERNEL_VIRTIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define VIRTIO_PCI_VENDOR 0x1AF4
+
+// Devices that predate virtio 1.0 keep their old ids, modern only ones are 0x1040 plus the device type
+#define VIRTIO_PCI_DEVICE_MODERN_BASE 0x1040
+#define VIRTIO_DEVICE_TYPE_BLOCK 2
+
+// Vendor capabilities describing where the modern register blocks are
+#define VIRTIO_PCI_CAP_COMMON_CFG 1
+#define VIRTIO_PCI_CAP_NOTIFY_CFG 2
+#define VIRTIO_PCI_CAP_ISR_CFG 3
+#define VIRTIO_PCI_CAP_DEVICE_CFG 4
+
+// Offsets into the vendor capability
+#define VIRTIO_PCI_CAP_CFG_TYPE 3
+#define VIRTIO_PCI_CAP_BAR 4
+#define VIRTIO_PCI_CAP_OFFSET 8
+#define VIRTIO_PCI_CAP_LENGTH 12
+#define VIRTIO_PCI_CAP_NOTIFY_MULTIPLIER 16
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER 0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FEATURES_OK 0x08
+#define VIRTIO_STATUS_FAILED 0x80
+
+// Feature bits shared by every device type
+#define VIRTIO_F_INDIRECT_DESC (1ULL << 28)
+#define VIRTIO_F_EVENT_IDX (1ULL << 29)
+#define VIRTIO_F_VERSION_1 (1ULL << 32)
+
+#define VIRTQ_DESC_F_NEXT 0x01
+#define VIRTQ_DESC_F_WRITE 0x02
+#define VIRTQ_DESC_F_INDIRECT 0x04
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 0x01
+#define VIRTQ_USED_F_NO_NOTIFY 0x01
+
+// No MSI-X vector for an event
+#define VIRTIO_MSI_NO_VECTOR 0xFFFF
+
+/**
+ * The common configuration block of a modern virtio PCI device
+ */
+struct virtio_pci_common_cfg
+{
+    uint32_t device_feature_select;
+    uint32_t device_feature;
+    uint32_t driver_feature_select;
+    uint32_t driver_feature;
+    uint16_t msix_config;
+    uint16_t num_queues;
+    uint8_t device_status;
+    uint8_t config_generation;
+    uint16_t queue_select;
+    uint16_t queue_size;
+    uint16_t queue_msix_vector;
+    uint16_t queue_enable;
+    uint16_t queue_notify_off;
+
+    // The 64 bit addresses are written as two halves, not every transport takes wider accesses
+    uint32_t queue_desc_low;
+    uint32_t queue_desc_high;
+    uint32_t queue_driver_low;
+    uint32_t queue_driver_high;
+    uint32_t queue_device_low;
+    uint32_t queue_device_high;
+} __attribute__((packed));
+
+struct virtq_desc
+{
+    uint64_t address;
+    uint32_t length;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed));
+
+/**
+ * Driver area, the used_event word follows the ring when VIRTIO_F_EVENT_IDX is on
+ */
+struct virtq_avail
+{
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];
+};
+
+struct virtq_used_elem
+{
+    uint32_t id;
+    uint32_t length;
+};
+
+/**
+ * Device area, the avail_event word follows the ring when VIRTIO_F_EVENT_IDX is on
+ */
+struct virtq_used
+{
+    uint16_t flags;
+    uint16_t idx;
+    struct virtq_used_elem ring[];
+};
+
+/**
+ * A split virtqueue. Every part lives in its own page so each is physically
+ * contiguous, which caps the queue at 256 entries.
+ */
+struct virtqueue
+{
+    int index;
+    uint16_t size;
+    struct virtq_desc* desc;
+    struct virtq_avail* avail;
+    volatile struct virtq_used* used;
+
+    // Where the device is told about new buffers
+    volatile uint16_t* notify;
+
+    bool event_idx;
+
+    // Index of the next available entry to be published, and of the next used one to reap
+    uint16_t avail_idx;
+    uint16_t last_used_idx;
+
+    // avail_idx when the device was last notified
+    uint16_t kicked_idx;
+
+    // The MSI-X entry the device took for the queue, VIRTIO_MSI_NO_VECTOR when it has none
+    uint16_t msix_entry;
+};
+
+#define VIRTQUEUE_MAX_SIZE 256
+
+struct pci_device;
+
+/**
+ * A virtio device behind the modern PCI transport
+ */
+struct virtio_device
+{
+    struct pci_device* pci;
+    volatile struct virtio_pci_common_cfg* common;
+    uintptr_t notify_base;
+    uint32_t notify_multiplier;
+    volatile uint8_t* isr;
+    uintptr_t device_cfg;
+
+    uint64_t features;
+};
+
+/**
+ * Finds the register blocks of the function, resets it and acknowledges it
+ * \return Returns -ENOTFOUND when the function has no modern interface
+ */
+int virtio_device_init(struct virtio_device* device, struct pci_device* pci);
+
+/**
+ * Accepts the wanted features the device offers, VIRTIO_F_VERSION_1 is always asked for
+ * \return Returns -EIO when the device does not take them
+ */
+int virtio_negotiate(struct virtio_device* device, uint64_t wanted);
+
+/**
+ * Sets up queue index with at most max_size entries
+ * \param msix_entry The MSI-X table entry completions are signalled on, VIRTIO_MSI_NO_VECTOR for none
+ */
+int virtqueue_init(struct virtio_device* device, struct virtqueue* queue, int index, uint16_t max_size, uint16_t msix_entry);
+
+/**
+ * Lets the device use its queues
+ */
+void virtio_device_ready(struct virtio_device* device);
+void virtio_device_failed(struct virtio_device* device);
+
+/**
+ * Makes the descriptor chain starting at head available to the device, the
+ * device is not told yet so several chains can be published at once
+ */
+void virtqueue_publish(struct virtqueue* queue, uint16_t head);
+
+/**
+ * Tells the device about everything published since the last kick, unless
+ * it asked not to be told
+ */
+void virtqueue_kick(struct virtqueue* queue);
+
+/**
+ * Takes the next finished chain off the used ring
+ * \return Returns false when the device has not finished anything new
+ */
+bool virtqueue_pop_used(struct virtqueue* queue, uint16_t* head_out, uint32_t* length_out);
+
+/**
+ * Asks for an interrupt on the next completion
+ * \return Returns false when a completion already came in, the caller should reap before sleeping
+ */
+bool virtqueue_enable_interrupts(struct virtqueue* queue);
+
+/**
+ * Asks the device not to interrupt, used while polling
+ */
+void virtqueue_disable_interrupts(struct virtqueue* queue);
+
+#endif
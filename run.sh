@@ -2,5 +2,6 @@ qemu-system-x86_64 \
   -machine pc \
   -drive file=./bin/os.img,format=raw,if=ide \
   -m 512M \
+  -smp 4 \
   -cpu qemu64 \
   -bios /usr/share/ovmf/OVMF.fd
\ No newline at end of file